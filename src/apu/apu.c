@@ -45,9 +45,6 @@ const uint16_t g_dmc_period_table[16] = {
     190, 160, 142, 128, 106, 84, 72, 54
 };
 
-/* Static APU bus */
-static apu_bus_t* g_apu_bus = NULL;
-
 /* LFSR Functions */
 uint16_t apu_lfsr_short(uint16_t lfsr) {
     uint16_t bit = ((lfsr & 1) ^ ((lfsr & 2) >> 1)) & 1;
@@ -111,10 +108,16 @@ static void square_clock(apu_square_t* sq, apu_sweep_t* sweep) {
     }
 }
 
+/* Timer expiry: the parts of each *_timer_clock after the reload */
+static inline void square_expire(apu_square_t* sq) {
+    sq->duty_index = (sq->duty_index + 1) & 7;
+}
+
 static void square_timer_clock(apu_square_t* sq, apu_sweep_t* sweep) {
+    (void)sweep;
     if (sq->timer_value == 0) {
         sq->timer_value = sq->timer_period;
-        sq->duty_index = (sq->duty_index + 1) & 7;
+        square_expire(sq);
     } else {
         sq->timer_value--;
     }
@@ -149,12 +152,16 @@ static void triangle_clock_linear(apu_triangle_t* tri) {
     }
 }
 
+static inline void triangle_expire(apu_triangle_t* tri) {
+    if (tri->length_counter > 0 && tri->linear_counter > 0) {
+        tri->sequencing = (tri->sequencing + 1) & 31;
+    }
+}
+
 static void triangle_timer_clock(apu_triangle_t* tri) {
     if (tri->timer_value == 0) {
         tri->timer_value = tri->timer_period;
-        if (tri->length_counter > 0 && tri->linear_counter > 0) {
-            tri->sequencing = (tri->sequencing + 1) & 31;
-        }
+        triangle_expire(tri);
     } else {
         tri->timer_value--;
     }
@@ -175,19 +182,23 @@ static void noise_clock(apu_noise_t* noise) {
     envelope_clock(&noise->envelope);
 }
 
+static inline void noise_expire(apu_noise_t* noise) {
+    /* LFSR step */
+    uint16_t bit = noise->lfsr & 1;
+    uint16_t feedback;
+    if (noise->mode) {
+        /* Short period mode */
+        feedback = bit ^ ((noise->lfsr >> 6) & 1);
+    } else {
+        /* Long period mode */
+        feedback = bit ^ ((noise->lfsr >> 1) & 1);
+    }
+    noise->lfsr = (noise->lfsr >> 1) | (feedback << 14);
+}
+
 static void noise_timer_clock(apu_noise_t* noise) {
     if (noise->timer_value == 0) {
-        /* LFSR step */
-        uint16_t bit = noise->lfsr & 1;
-        uint16_t feedback;
-        if (noise->mode) {
-            /* Short period mode */
-            feedback = bit ^ ((noise->lfsr >> 6) & 1);
-        } else {
-            /* Long period mode */
-            feedback = bit ^ ((noise->lfsr >> 1) & 1);
-        }
-        noise->lfsr = (noise->lfsr >> 1) | (feedback << 14);
+        noise_expire(noise);
         noise->timer_value = noise->period;
     } else {
         noise->timer_value--;
@@ -201,7 +212,7 @@ static uint8_t noise_output(apu_noise_t* noise) {
 }
 
 /* DMC Channel Helpers */
-static void dmc_clock_reader(void (*dmc_read)(void*, uint16_t, uint8_t*), void* ctx, apu_dmc_t* dmc) {
+static void dmc_clock_reader(const apu_bus_t* bus, apu_dmc_t* dmc) {
     if (!dmc->sample_buffer_empty) return;
 
     if (dmc->bytes_remaining == 0) {
@@ -214,10 +225,8 @@ static void dmc_clock_reader(void (*dmc_read)(void*, uint16_t, uint8_t*), void*
         return;
     }
 
-    if (dmc_read) {
-        dmc_read(ctx, dmc->current_addr, &dmc->sample_buffer);
-    } else if (g_apu_bus && g_apu_bus->read) {
-        dmc->sample_buffer = g_apu_bus->read(g_apu_bus->context, dmc->current_addr);
+    if (bus->read) {
+        dmc->sample_buffer = bus->read(bus->context, dmc->current_addr);
     }
     dmc->sample_buffer_empty = 0;
     dmc->current_addr = (dmc->current_addr + 1) | 0x8000;
@@ -236,23 +245,26 @@ static void dmc_clock_shifter(apu_dmc_t* dmc) {
     dmc->bits_remaining--;
 }
 
-static void dmc_timer_clock(apu_dmc_t* dmc) {
-    if (dmc->timer_value == 0) {
-        dmc->timer_value = dmc->timer_period;
-
-        if (dmc->bits_remaining == 0) {
-            dmc->bits_remaining = 8;
-            if (dmc->sample_buffer_empty) {
-                dmc->silence = 1;
-            } else {
-                dmc->silence = 0;
-                dmc->shift_register = dmc->sample_buffer;
-                dmc->sample_buffer_empty = 1;
-                dmc_clock_reader(NULL, NULL, dmc);
-            }
+static void dmc_expire(const apu_bus_t* bus, apu_dmc_t* dmc) {
+    if (dmc->bits_remaining == 0) {
+        dmc->bits_remaining = 8;
+        if (dmc->sample_buffer_empty) {
+            dmc->silence = 1;
+        } else {
+            dmc->silence = 0;
+            dmc->shift_register = dmc->sample_buffer;
+            dmc->sample_buffer_empty = 1;
+            dmc_clock_reader(bus, dmc);
         }
+    }
 
-        dmc_clock_shifter(dmc);
+    dmc_clock_shifter(dmc);
+}
+
+static void dmc_timer_clock(const apu_bus_t* bus, apu_dmc_t* dmc) {
+    if (dmc->timer_value == 0) {
+        dmc->timer_value = dmc->timer_period;
+        dmc_expire(bus, dmc);
     } else {
         dmc->timer_value--;
     }
@@ -277,11 +289,15 @@ static void frame_clock(nes_apu_t* apu, uint8_t step) {
     }
 }
 
+static void blip_build_tables(nes_apu_t* apu);
+
 /* Public API Implementation */
 
 void nes_apu_init(nes_apu_t* apu, apu_bus_t* bus) {
     memset(apu, 0, sizeof(nes_apu_t));
-    g_apu_bus = bus;
+    if (bus) {
+        apu->bus = *bus;
+    }
 
     /* Initialize LFSR */
     apu->noise.lfsr = 1;
@@ -290,6 +306,10 @@ void nes_apu_init(nes_apu_t* apu, apu_bus_t* bus) {
     apu->dmc.sample_addr = 0xC000;
     apu->dmc.sample_buffer_empty = 1;
     apu->dmc.bits_remaining = 8;
+
+    blip_build_tables(apu);
+    nes_apu_set_synthesis(apu, NES_APU_SYNTH_POINT, 0);
+    apu->output_enabled = 1;
 }
 
 void nes_apu_reset(nes_apu_t* apu) {
@@ -303,20 +323,16 @@ void nes_apu_reset(nes_apu_t* apu) {
     apu->frame.mode = 0;
     apu->cycle_count = 0;
     apu->frame_cycle = 0;
+    apu->sample_count = 0;
 }
 
-void nes_apu_step(nes_apu_t* apu) {
-    uint32_t cycle = apu->cycle_count++;
-    apu->frame_cycle = cycle;
-
-    /* Clock timers */
-    square_timer_clock(&apu->square1, &apu->square1.sweep);
-    square_timer_clock(&apu->square2, &apu->square2.sweep);
-    triangle_timer_clock(&apu->triangle);
-    noise_timer_clock(&apu->noise);
-    dmc_timer_clock(&apu->dmc);
+/* Frame sequencer steps, acted on when the cycle being run equals one */
+static const uint32_t g_frame_steps[2][5] = {
+    { 3729, 7457, 11186, 14915, 14915 },    /* 4-step */
+    { 3729, 7457, 11186, 14915, 18641 }     /* 5-step */
+};
 
-    /* Frame counter timing (every CPU cycle) */
+static void frame_sequencer(nes_apu_t* apu, uint32_t cycle) {
     if (apu->frame.mode == 0) {
         /* 4-step mode */
         if (cycle == 3729) {
@@ -330,7 +346,6 @@ void nes_apu_step(nes_apu_t* apu) {
             if (apu->frame.irq) {
                 /* Frame IRQ */
             }
-            cycle = 0;
             apu->cycle_count = 0;
         }
     } else {
@@ -345,16 +360,244 @@ void nes_apu_step(nes_apu_t* apu) {
             /* Cycle 4 in 5-step mode - no clock */
         } else if (cycle == 18641) {
             frame_clock(apu, 0);
-            cycle = 0;
             apu->cycle_count = 0;
         }
     }
 }
 
+/* Cycles to run up to and including the next sequencer step */
+static uint32_t frame_cycles_until_step(const nes_apu_t* apu) {
+    for (int i = 0; i < 5; i++) {
+        uint32_t step = g_frame_steps[apu->frame.mode & 1][i];
+        if (step >= apu->cycle_count) {
+            return step - apu->cycle_count + 1;
+        }
+    }
+    return UINT32_MAX;
+}
+
+/* Mixer through the lookup tables, same channel outputs as nes_apu_get_output */
+static inline float apu_mix(nes_apu_t* apu) {
+    int pulse = square_output(&apu->square1) + square_output(&apu->square2);
+    int tnd = 3 * triangle_output(&apu->triangle) + 2 * noise_output(&apu->noise) + apu->dmc.output;
+    return (apu->mix_pulse[pulse] + apu->mix_tnd[tnd]) * 2.0f;  /* Amplify */
+}
+
+/* Blip synthesis */
+
+static void blip_build_tables(nes_apu_t* apu) {
+    const double pi = 3.14159265358979323846;
+    const double cutoff = 0.9;      /* Of the output Nyquist frequency */
+
+    /* Band-limited impulse for a step at fraction p / PHASES into a sample,
+     * delayed by TAPS / 2 - 1 samples; Hann windowed, each phase sums to 1 */
+    for (int p = 0; p < APU_BLIP_PHASES; p++) {
+        double sum = 0.0;
+        double taps[APU_BLIP_TAPS];
+        for (int k = 0; k < APU_BLIP_TAPS; k++) {
+            double x = (double)k - (double)(APU_BLIP_TAPS / 2 - 1) - (double)p / APU_BLIP_PHASES;
+            double y = pi * cutoff * x;
+            double sinc = x == 0.0 ? 1.0 : sin(y) / y;
+            double window = 0.5 + 0.5 * cos(pi * x / (APU_BLIP_TAPS / 2));
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        for (int k = 0; k < APU_BLIP_TAPS; k++) {
+            apu->blip_kernel[p][k] = (float)(taps[k] / sum);
+        }
+    }
+
+    /* Approximations from the NESdev wiki; the pulse constant matches nes_apu_get_output */
+    apu->mix_pulse[0] = 0.0f;
+    for (int n = 1; n < 31; n++) {
+        apu->mix_pulse[n] = (float)(95.88 / (8128.0 / n + 100.0));
+    }
+    apu->mix_tnd[0] = 0.0f;
+    for (int n = 1; n < 203; n++) {
+        apu->mix_tnd[n] = (float)(163.67 / (24329.0 / n + 100.0));
+    }
+}
+
+static void blip_add_delta(nes_apu_t* apu, uint64_t pos, float delta) {
+    uint32_t index = (uint32_t)(pos >> APU_BLIP_FRAC);
+    uint32_t phase = (uint32_t)(((pos & (((uint64_t)1 << APU_BLIP_FRAC) - 1)) * APU_BLIP_PHASES) >> APU_BLIP_FRAC);
+    const float* kernel = apu->blip_kernel[phase];
+    float* out = apu->blip_buffer + index;
+    for (int k = 0; k < APU_BLIP_TAPS; k++) {
+        out[k] += delta * kernel[k];
+    }
+}
+
+/* Emit a step if the mixer level changed during cycle offset t of this batch */
+static inline void blip_update(nes_apu_t* apu, uint32_t t) {
+    if (!apu->output_enabled) {
+        return;
+    }
+    float level = apu_mix(apu);
+    if (level != apu->blip_level) {
+        blip_add_delta(apu, apu->blip_pos + (uint64_t)t * apu->blip_step, level - apu->blip_level);
+        apu->blip_level = level;
+    }
+}
+
+/* Integrate every sample no later delta can reach into the output queue */
+static void blip_flush(nes_apu_t* apu) {
+    uint32_t ready = (uint32_t)(apu->blip_pos >> APU_BLIP_FRAC);
+    const uint32_t size = APU_BLIP_BUFFER + APU_BLIP_TAPS;
+
+    for (uint32_t i = 0; i < ready; i++) {
+        apu->blip_sum += apu->blip_buffer[i];
+        if (apu->sample_count < APU_SAMPLE_CAPACITY) {
+            apu->samples[apu->sample_count++] = apu->blip_sum;
+        }
+    }
+
+    memmove(apu->blip_buffer, apu->blip_buffer + ready, (size - ready) * sizeof(float));
+    memset(apu->blip_buffer + size - ready, 0, ready * sizeof(float));
+    apu->blip_pos -= (uint64_t)ready << APU_BLIP_FRAC;
+}
+
+/* Run n cycles of all channel timers, jumping from one expiry to the next */
+static void blip_run_timers(nes_apu_t* apu, uint32_t n) {
+    uint32_t next[5] = {
+        apu->square1.timer_value, apu->square2.timer_value, apu->triangle.timer_value,
+        apu->noise.timer_value, apu->dmc.timer_value
+    };
+    const uint32_t period[5] = {
+        apu->square1.timer_period + 1u, apu->square2.timer_period + 1u,
+        apu->triangle.timer_period + 1u, apu->noise.period + 1u, apu->dmc.timer_period + 1u
+    };
+
+    for (;;) {
+        int c = 0;
+        for (int i = 1; i < 5; i++) {
+            if (next[i] < next[c]) {
+                c = i;
+            }
+        }
+        uint32_t t = next[c];
+        if (t >= n) {
+            break;
+        }
+
+        switch (c) {
+            case 0: square_expire(&apu->square1); break;
+            case 1: square_expire(&apu->square2); break;
+            case 2: triangle_expire(&apu->triangle); break;
+            case 3: noise_expire(&apu->noise); break;
+            default: dmc_expire(&apu->bus, &apu->dmc); break;
+        }
+        next[c] = t + period[c];
+        blip_update(apu, t);
+    }
+
+    apu->square1.timer_value = (uint16_t)(next[0] - n);
+    apu->square2.timer_value = (uint16_t)(next[1] - n);
+    apu->triangle.timer_value = (uint16_t)(next[2] - n);
+    apu->noise.timer_value = (uint16_t)(next[3] - n);
+    apu->dmc.timer_value = (uint8_t)(next[4] - n);
+}
+
+static void blip_execute_cycles(nes_apu_t* apu, uint32_t cycles) {
+    /* Register writes since the last batch take effect at its start */
+    blip_update(apu, 0);
+
+    while (cycles > 0) {
+        uint32_t n = frame_cycles_until_step(apu);
+        n = n < cycles ? n : cycles;
+        n = n < apu->blip_batch ? n : apu->blip_batch;
+
+        blip_run_timers(apu, n);
+
+        uint32_t cycle = apu->cycle_count + n - 1;
+        apu->cycle_count += n;
+        apu->frame_cycle = cycle;
+        frame_sequencer(apu, cycle);
+        blip_update(apu, n - 1);
+
+        if (apu->output_enabled) {
+            apu->blip_pos += (uint64_t)n * apu->blip_step;
+            blip_flush(apu);
+        }
+        cycles -= n;
+    }
+}
+
+void nes_apu_step(nes_apu_t* apu) {
+    uint32_t cycle = apu->cycle_count++;
+    apu->frame_cycle = cycle;
+
+    /* Clock timers */
+    square_timer_clock(&apu->square1, &apu->square1.sweep);
+    square_timer_clock(&apu->square2, &apu->square2.sweep);
+    triangle_timer_clock(&apu->triangle);
+    noise_timer_clock(&apu->noise);
+    dmc_timer_clock(&apu->bus, &apu->dmc);
+
+    /* Frame counter timing (every CPU cycle) */
+    frame_sequencer(apu, cycle);
+}
+
 void nes_apu_execute_cycles(nes_apu_t* apu, uint32_t cycles) {
+    if (apu->synth == NES_APU_SYNTH_BLIP) {
+        blip_execute_cycles(apu, cycles);
+        return;
+    }
+
     for (uint32_t i = 0; i < cycles; i++) {
         nes_apu_step(apu);
+        if (!apu->output_enabled) {
+            continue;
+        }
+
+        /* Point-sample once every APU_CPU_CLOCK_NTSC / sample_rate cycles */
+        apu->sample_phase += apu->sample_rate;
+        if (apu->sample_phase >= APU_CPU_CLOCK_NTSC) {
+            apu->sample_phase -= APU_CPU_CLOCK_NTSC;
+            if (apu->sample_count < APU_SAMPLE_CAPACITY) {
+                apu->samples[apu->sample_count++] = nes_apu_get_output(apu) * 2.0f;  /* Amplify */
+            }
+        }
+    }
+}
+
+void nes_apu_set_synthesis(nes_apu_t* apu, nes_apu_synth_t synth, uint32_t sample_rate) {
+    sample_rate = sample_rate ? sample_rate : APU_SAMPLE_RATE;
+    if (sample_rate > APU_CPU_CLOCK_NTSC / 4) {
+        sample_rate = APU_CPU_CLOCK_NTSC / 4;
     }
+
+    apu->synth = synth;
+    apu->sample_rate = sample_rate;
+    apu->sample_phase = 0;
+
+    apu->blip_step = ((uint64_t)sample_rate << APU_BLIP_FRAC) / APU_CPU_CLOCK_NTSC;
+    apu->blip_batch = (uint32_t)(((uint64_t)(APU_BLIP_BUFFER - 2) << APU_BLIP_FRAC) / apu->blip_step);
+    apu->blip_pos = 0;
+    apu->blip_level = 0.0f;
+    apu->blip_sum = 0.0f;
+    memset(apu->blip_buffer, 0, sizeof(apu->blip_buffer));
+}
+
+void nes_apu_set_output(nes_apu_t* apu, int enable) {
+    apu->output_enabled = enable ? 1 : 0;
+}
+
+uint32_t nes_apu_cycles_until_event(const nes_apu_t* apu) {
+    /* Frame sequencer: acts when the cycle being run equals a step */
+    uint32_t next = frame_cycles_until_step(apu);
+
+    /* DMC: the shift register reloads from a full buffer after the remaining
+     * bits have been clocked out, and the reader refills the buffer */
+    const apu_dmc_t* dmc = &apu->dmc;
+    if (!dmc->sample_buffer_empty && (dmc->bits_remaining == 0 || !dmc->silence)) {
+        uint32_t fetch = dmc->timer_value + 1u + dmc->bits_remaining * (dmc->timer_period + 1u);
+        if (fetch < next) {
+            next = fetch;
+        }
+    }
+
+    return next;
 }
 
 void nes_apu_cpu_write(nes_apu_t* apu, uint16_t addr, uint8_t val) {
@@ -541,24 +784,14 @@ float nes_apu_get_output(nes_apu_t* apu) {
 }
 
 int nes_apu_generate_samples(nes_apu_t* apu, float* buffer, int max_samples) {
-    /* Generate samples at 44.1kHz */
-    /* Each frame has ~29780.5 CPU cycles */
-    /* 44.1kHz samples per frame = 735 samples */
-
-    int samples = (APU_CPU_CLOCK_NTSC / APU_SAMPLE_RATE);
-    if (samples > max_samples) samples = max_samples;
-
-    float cpu_cycles_per_sample = (float)APU_CPU_CLOCK_NTSC / APU_SAMPLE_RATE;
-
-    for (int i = 0; i < samples; i++) {
-        uint32_t cycles_end = (uint32_t)((i + 1) * cpu_cycles_per_sample);
-        uint32_t cycles_start = (uint32_t)(i * cpu_cycles_per_sample);
-
-        nes_apu_execute_cycles(apu, cycles_end - cycles_start);
-
-        buffer[i] = nes_apu_get_output(apu) * 2.0f;  /* Amplify */
+    int samples = apu->sample_count < max_samples ? apu->sample_count : max_samples;
+    if (samples <= 0) {
+        return 0;
     }
 
+    memcpy(buffer, apu->samples, (size_t)samples * sizeof(float));
+    apu->sample_count -= samples;
+    memmove(apu->samples, apu->samples + samples, (size_t)apu->sample_count * sizeof(float));
     return samples;
 }
 
@@ -579,5 +812,8 @@ uint8_t nes_apu_dmc_output(nes_apu_t* apu) {
 }
 
 void nes_apu_set_bus(nes_apu_t* apu, apu_bus_t* bus) {
-    g_apu_bus = bus;
+    /* Copy bus configuration into the instance - caller's struct may be on the stack */
+    if (bus) {
+        apu->bus = *bus;
+    }
 }
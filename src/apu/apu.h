@@ -22,6 +22,19 @@ extern "C" {
 #define APU_CPU_CLOCK_NTSC 1789773
 #define APU_CPU_CYCLE_RATE 1789773.0
 #define APU_SAMPLES_PER_FRAME (APU_SAMPLE_RATE / APU_FRAME_RATE)
+#define APU_SAMPLE_CAPACITY   (APU_SAMPLES_PER_FRAME * 4)    /* Undrained samples kept */
+
+/* Band-limited step synthesis */
+#define APU_BLIP_TAPS       16      /* Kernel width in output samples */
+#define APU_BLIP_PHASES     32      /* Sub-sample kernel positions */
+#define APU_BLIP_BUFFER     128     /* Output samples per batch, plus kernel tail */
+#define APU_BLIP_FRAC       32      /* Fixed-point bits of the output position */
+
+/* How output samples are produced */
+typedef enum {
+    NES_APU_SYNTH_POINT = 0,    /* Step every cycle, sample the mixer (reference) */
+    NES_APU_SYNTH_BLIP          /* Run timers in batches, band-limited output deltas */
+} nes_apu_synth_t;
 
 /* APU Registers */
 #define APU_SQUARE1_CTRL    0x4000  /* $4000 */
@@ -143,6 +156,13 @@ typedef struct {
     uint8_t  counter;
 } apu_frame_counter_t;
 
+/* APU Bus Interface */
+typedef struct {
+    void*   context;
+    uint8_t (*read)(void* ctx, uint16_t addr);
+    void    (*write)(void* ctx, uint16_t addr, uint8_t val);
+} apu_bus_t;
+
 /* APU State */
 typedef struct nes_apu {
     /* Channels */
@@ -159,18 +179,43 @@ typedef struct nes_apu {
     uint32_t         cycle_count;
     uint32_t         frame_cycle;    /* Cycles in current frame */
 
+    /* Wiring below is not part of save states */
+
     /* External callbacks */
     void*            context;
     uint8_t (*read_dmc)(void* ctx, uint16_t addr);
     void (*irq_callback)(void* ctx);
+
+    /* Per-instance bus for DMC sample fetches */
+    apu_bus_t        bus;
+
+    /* Output produced at sample_rate while clocked, until drained
+     * With output_enabled clear the channels still run but no samples are
+     * made, and the synthesis state waits where output stopped */
+    nes_apu_synth_t  synth;
+    uint8_t          output_enabled;
+    uint32_t         sample_rate;
+    uint32_t         sample_phase;
+    int              sample_count;
+    float            samples[APU_SAMPLE_CAPACITY];
+
+    /* Blip synthesis: output deltas are summed into blip_buffer through a
+     * windowed-sinc kernel and integrated once no later delta can reach them */
+    uint64_t         blip_step;      /* Output samples per CPU cycle (APU_BLIP_FRAC fixed point) */
+    uint64_t         blip_pos;       /* Current cycle's position in blip_buffer */
+    uint32_t         blip_batch;     /* Most cycles whose output fits blip_buffer */
+    float            blip_level;     /* Mixer level the buffer has been given */
+    float            blip_sum;       /* Integrated output */
+    float            blip_buffer[APU_BLIP_BUFFER + APU_BLIP_TAPS];
+    float            blip_kernel[APU_BLIP_PHASES][APU_BLIP_TAPS];
+
+    /* Mixer lookup tables (pulse by summed level, TND by 3*tri + 2*noise + dmc) */
+    float            mix_pulse[31];
+    float            mix_tnd[203];
 } nes_apu_t;
 
-/* APU Bus Interface */
-typedef struct {
-    void*   context;
-    uint8_t (*read)(void* ctx, uint16_t addr);
-    void    (*write)(void* ctx, uint16_t addr, uint8_t val);
-} apu_bus_t;
+/* Bytes of plain (pointer-free) APU state at the start of nes_apu_t */
+#define NES_APU_STATE_SIZE offsetof(nes_apu_t, context)
 
 /* API Functions */
 
@@ -194,6 +239,24 @@ void nes_apu_step(nes_apu_t* apu);
  */
 void nes_apu_execute_cycles(nes_apu_t* apu, uint32_t cycles);
 
+/**
+ * Select how output samples are produced and their rate (0 = APU_SAMPLE_RATE)
+ * Both modes clock the channels identically; only the audio differs
+ */
+void nes_apu_set_synthesis(nes_apu_t* apu, nes_apu_synth_t synth, uint32_t sample_rate);
+
+/**
+ * Enable or suppress sample output (enabled after init)
+ * Channel state, IRQs and DMC fetches are the same either way
+ */
+void nes_apu_set_output(nes_apu_t* apu, int enable);
+
+/**
+ * CPU cycles until the next frame sequencer step or DMC sample fetch
+ * (UINT32_MAX if neither is pending)
+ */
+uint32_t nes_apu_cycles_until_event(const nes_apu_t* apu);
+
 /**
  * Write to APU register from CPU
  */
@@ -205,9 +268,10 @@ void nes_apu_cpu_write(nes_apu_t* apu, uint16_t addr, uint8_t val);
 uint8_t nes_apu_cpu_read(nes_apu_t* apu, uint16_t addr);
 
 /**
- * Generate audio samples for one frame
- * buffer must be at least APU_SAMPLES_PER_FRAME samples
- * Returns number of samples generated
+ * Drain the output samples captured while the APU was clocked
+ * (about APU_SAMPLES_PER_FRAME per emulated frame; the oldest are
+ * returned first and the rest stay queued)
+ * Returns number of samples written to buffer
  */
 int nes_apu_generate_samples(nes_apu_t* apu, float* buffer, int max_samples);
 
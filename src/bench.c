@@ -0,0 +1,535 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Benchmark and Regression Runner
+ *
+ * Runs fixed ROM / input movie pairs headless for a set number of frames,
+ * reports throughput and per-unit costs, and checks hashes of every
+ * frame's palette indices and audio samples against the expected values,
+ * so a speedup cannot silently change the output. Results can also be
+ * written as JSON to chart them across commits.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local headers */
+#include "cpu/cpu.h"
+#include "ppu/ppu.h"
+#include "apu/apu.h"
+#include "input/input.h"
+#include "memory/bus.h"
+#include "util/timer.h"
+
+#define NES_BENCH_DEFAULT_FRAMES 600
+#define NES_BENCH_MAX_CASES      256
+#define NES_BENCH_PATH_MAX       1024
+#define NES_BENCH_FNV_OFFSET     0xCBF29CE484222325ull
+#define NES_BENCH_FNV_PRIME      0x100000001B3ull
+
+/* Usage instructions */
+#define NES_BENCH_USAGE \
+    "Usage: nes_bench <corpus.txt | rom.nes [movie]> [options]\n" \
+    "\n" \
+    "A corpus file lists one case per line (paths relative to the file):\n" \
+    "  name  rom.nes  movie|-  frames  frame_hash|-  audio_hash|-\n" \
+    "A movie lists 'count buttons' lines: hold buttons (A B s S U D L R, . = none)\n" \
+    "for count frames; controller 1 is released after the last line.\n" \
+    "\n" \
+    "Options:\n" \
+    "  -n, --frames N    Override the frame count of every case\n" \
+    "  -r, --repeat N    Time N runs per case and keep the fastest (default: 3)\n" \
+    "  --json FILE       Write results as JSON to FILE\n" \
+    "  --blip            Band-limited batched audio synthesis\n" \
+    "  --scanline        Synchronize CPU and PPU at line ends\n" \
+    "  --catchup         Render whole lines when the PPU catches up\n" \
+    "  --no-idle         Execute idle loops instead of fast-forwarding them\n" \
+    "  -h, --help        Show this help\n" \
+    "\n" \
+    "Every frame must also start at the PPU position the first one did.\n" \
+    "\n" \
+    "Costs per CPU cycle, PPU dot and audio sample divide whole-frame time;\n" \
+    "instruction counts and each subsystem's own time per instruction, dot and\n" \
+    "sample need a NESPRESSO_STATS build (make STATS=1).\n" \
+    "\n" \
+    "Exit status: 0 = all hashes match (or are unchecked), 1 = error, 2 = mismatch\n"
+
+/* One benchmark case and its result */
+typedef struct {
+    char        name[64];
+    char        rom[NES_BENCH_PATH_MAX];
+    char        movie[NES_BENCH_PATH_MAX];  /* Empty = no input */
+    long        frames;
+    uint64_t    expect_frame;
+    uint64_t    expect_audio;
+    int         check_frame;
+    int         check_audio;
+
+    /* Result of the fastest run */
+    int         ran;
+    uint64_t    elapsed_ns;
+    uint64_t    frame_hash;
+    uint64_t    audio_hash;
+    uint64_t    cpu_cycles;
+    uint64_t    ppu_dots;
+    uint64_t    samples;
+    long        drift_frame;    /* First frame to start at another PPU position, -1 = none */
+    int         has_stats;
+    nes_sys_stats_t stats;
+} bench_case_t;
+
+/* Input movie: controller 1 mask per frame */
+typedef struct {
+    uint8_t*    masks;
+    long        count;
+} bench_movie_t;
+
+static float g_samples[APU_SAMPLE_CAPACITY];
+
+static uint64_t bench_fnv(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * NES_BENCH_FNV_PRIME;
+    }
+    return hash;
+}
+
+/* Path relative to the directory of base (unless already absolute)
+ * Returns 0 on success, -1 if it does not fit */
+static int bench_resolve(char* out, const char* base, const char* path) {
+    const char* slash = strrchr(base, '/');
+#ifdef _WIN32
+    const char* bslash = strrchr(base, '\\');
+    if (bslash && (!slash || bslash > slash)) {
+        slash = bslash;
+    }
+    int absolute = path[0] == '/' || path[0] == '\\' || (path[0] && path[1] == ':');
+#else
+    int absolute = path[0] == '/';
+#endif
+    int len;
+    if (absolute || !slash) {
+        len = snprintf(out, NES_BENCH_PATH_MAX, "%s", path);
+    } else {
+        len = snprintf(out, NES_BENCH_PATH_MAX, "%.*s/%s", (int)(slash - base), base, path);
+    }
+    return len >= 0 && len < NES_BENCH_PATH_MAX ? 0 : -1;
+}
+
+static int bench_parse_hash(const char* text, uint64_t* out) {
+    if (strcmp(text, "-") == 0) {
+        return 0;
+    }
+    char* end;
+    *out = strtoull(text, &end, 16);
+    return *end == '\0' ? 1 : -1;
+}
+
+/* Load a movie file; returns 0 on success */
+static int bench_load_movie(const char* filename, bench_movie_t* movie) {
+    movie->masks = NULL;
+    movie->count = 0;
+
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        return -1;
+    }
+
+    static const char buttons[] = "ABsSUDLR";  /* Bit order of nes_input_set_buttons */
+    char line[256];
+    long capacity = 0;
+    int status = 0;
+    while (status == 0 && fgets(line, sizeof(line), f)) {
+        long count;
+        char held[32];
+        if (line[0] == '#' || sscanf(line, "%ld %31s", &count, held) != 2) {
+            continue;
+        }
+
+        uint8_t mask = 0;
+        for (const char* c = held; *c && *c != '.'; c++) {
+            const char* bit = strchr(buttons, *c);
+            if (!bit) {
+                status = -1;
+                break;
+            }
+            mask |= (uint8_t)(1u << (bit - buttons));
+        }
+        if (status != 0 || count < 0) {
+            status = -1;
+            break;
+        }
+
+        if (movie->count + count > capacity) {
+            long grown = capacity ? capacity * 2 : 1024;
+            while (grown < movie->count + count) {
+                grown *= 2;
+            }
+            uint8_t* masks = (uint8_t*)realloc(movie->masks, (size_t)grown);
+            if (!masks) {
+                status = -1;
+                break;
+            }
+            movie->masks = masks;
+            capacity = grown;
+        }
+        memset(movie->masks + movie->count, mask, (size_t)count);
+        movie->count += count;
+    }
+
+    fclose(f);
+    if (status != 0) {
+        free(movie->masks);
+        movie->masks = NULL;
+        movie->count = 0;
+    }
+    return status;
+}
+
+/* Parse a corpus file; returns the number of cases or -1 */
+static int bench_load_corpus(const char* filename, bench_case_t* cases, int max_cases) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open corpus %s\n", filename);
+        return -1;
+    }
+
+    char line[3 * NES_BENCH_PATH_MAX];
+    int count = 0;
+    int line_number = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_number++;
+        char name[64], rom[NES_BENCH_PATH_MAX], movie[NES_BENCH_PATH_MAX];
+        char frame_hash[32] = "-", audio_hash[32] = "-";
+        long frames = NES_BENCH_DEFAULT_FRAMES;
+
+        char first[2];
+        if (sscanf(line, " %1s", first) != 1 || first[0] == '#') {
+            continue;
+        }
+        if (sscanf(line, "%63s %1023s %1023s %ld %31s %31s", name, rom, movie, &frames,
+                   frame_hash, audio_hash) < 3) {
+            fprintf(stderr, "%s:%d: expected 'name rom movie [frames frame_hash audio_hash]'\n",
+                    filename, line_number);
+            fclose(f);
+            return -1;
+        }
+        if (count == max_cases) {
+            fprintf(stderr, "%s: more than %d cases\n", filename, max_cases);
+            fclose(f);
+            return -1;
+        }
+
+        bench_case_t* c = &cases[count];
+        memset(c, 0, sizeof(*c));
+        snprintf(c->name, sizeof(c->name), "%s", name);
+        if (bench_resolve(c->rom, filename, rom) != 0 ||
+            (strcmp(movie, "-") != 0 && bench_resolve(c->movie, filename, movie) != 0)) {
+            fprintf(stderr, "%s:%d: path too long\n", filename, line_number);
+            fclose(f);
+            return -1;
+        }
+        c->frames = frames;
+        c->check_frame = bench_parse_hash(frame_hash, &c->expect_frame);
+        c->check_audio = bench_parse_hash(audio_hash, &c->expect_audio);
+        if (c->check_frame < 0 || c->check_audio < 0) {
+            fprintf(stderr, "%s:%d: hashes must be hex or '-'\n", filename, line_number);
+            fclose(f);
+            return -1;
+        }
+        count++;
+    }
+
+    fclose(f);
+    return count;
+}
+
+/* Run one case once from power-on; returns 0 on success */
+static int bench_run(bench_case_t* c, const bench_movie_t* movie, nes_sync_mode_t sync_mode,
+                     nes_apu_synth_t synth, int idle_skip, uint64_t* elapsed) {
+    static nes_system_t sys;
+    if (nes_sys_init(&sys) != 0 || nes_sys_load_rom(&sys, c->rom) != 0) {
+        nes_sys_free(&sys);
+        return -1;
+    }
+    nes_sys_set_sync_mode(&sys, sync_mode);
+    nes_apu_set_synthesis(sys.apu, synth, 0);
+    nes_cpu_set_idle_skip(sys.cpu, idle_skip);
+
+    uint64_t frame_hash = NES_BENCH_FNV_OFFSET;
+    uint64_t audio_hash = NES_BENCH_FNV_OFFSET;
+    uint64_t samples = 0;
+    uint64_t cycles = 0;
+    uint64_t dots = 0;
+
+    /* Every frame must start where the first one did */
+    uint16_t start_line = sys.ppu->scanline;
+    uint16_t start_dot = sys.ppu->cycle;
+    c->drift_frame = -1;
+
+    /* Only stepping and audio draining are timed; hashing is not */
+    *elapsed = 0;
+    for (long f = 0; f < c->frames; f++) {
+        nes_input_set_buttons(sys.input, 0, f < movie->count ? movie->masks[f] : 0);
+        if (c->drift_frame < 0 && (sys.ppu->scanline != start_line || sys.ppu->cycle != start_dot)) {
+            c->drift_frame = f;
+        }
+
+        uint32_t start_cycle = sys.cpu->cycle_count;
+        uint64_t start = nes_timer_now_ns();
+        int stepped = nes_sys_step_frame(&sys);
+        int count = nes_sys_get_audio(&sys, g_samples, APU_SAMPLE_CAPACITY);
+        *elapsed += nes_timer_now_ns() - start;
+        cycles += sys.cpu->cycle_count - start_cycle;
+        if (stepped) {
+            dots += sys.ppu_frame_dot;  /* Dots the bus actually stepped this frame */
+        }
+
+        frame_hash = bench_fnv(frame_hash, nes_sys_get_frame_buffer(&sys), NES_FRAME_PIXELS);
+        if (count > 0) {
+            audio_hash = bench_fnv(audio_hash, g_samples, (size_t)count * sizeof(float));
+            samples += (uint64_t)count;
+        }
+    }
+
+    c->frame_hash = frame_hash;
+    c->audio_hash = audio_hash;
+    c->samples = samples;
+    c->cpu_cycles = cycles;
+    c->ppu_dots = dots;
+    c->has_stats = nes_sys_get_stats(&sys, &c->stats) == 0;
+
+    nes_sys_free(&sys);
+    return 0;
+}
+
+static double bench_per(uint64_t ns, uint64_t units) {
+    return units ? (double)ns / (double)units : 0.0;
+}
+
+static int bench_case_ok(const bench_case_t* c) {
+    return (!c->check_frame || c->frame_hash == c->expect_frame) &&
+           (!c->check_audio || c->audio_hash == c->expect_audio) && c->drift_frame < 0;
+}
+
+static void bench_print(const bench_case_t* c) {
+    double seconds = (double)c->elapsed_ns / 1e9;
+    printf("%-16s %6ld frames %9.1f FPS %8.2f ns/cycle", c->name, c->frames,
+           seconds > 0.0 ? (double)c->frames / seconds : 0.0, bench_per(c->elapsed_ns, c->cpu_cycles));
+    if (c->has_stats) {
+        printf(" %7.2f ns/instr %6.2f ns/dot %7.1f ns/sample",
+               bench_per(c->stats.cpu_ns, c->stats.instructions),
+               bench_per(c->stats.ppu_ns, c->stats.ppu_dots),
+               bench_per(c->stats.apu_ns, c->samples));
+    }
+    printf("  frame %016llx audio %016llx", (unsigned long long)c->frame_hash,
+           (unsigned long long)c->audio_hash);
+    if (c->check_frame && c->frame_hash != c->expect_frame) {
+        printf("  FRAME MISMATCH (expected %016llx)", (unsigned long long)c->expect_frame);
+    }
+    if (c->check_audio && c->audio_hash != c->expect_audio) {
+        printf("  AUDIO MISMATCH (expected %016llx)", (unsigned long long)c->expect_audio);
+    }
+    if (c->drift_frame >= 0) {
+        printf("  FRAME START DRIFT (frame %ld)", c->drift_frame);
+    }
+    printf("\n");
+}
+
+static void bench_json_string(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', f);
+        }
+        if ((unsigned char)*s >= 0x20) {
+            fputc(*s, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static void bench_json_hash(FILE* f, const char* key, uint64_t value, int valid) {
+    if (valid) {
+        fprintf(f, "\"%s\": \"%016llx\"", key, (unsigned long long)value);
+    } else {
+        fprintf(f, "\"%s\": null", key);
+    }
+}
+
+/* Per-unit costs: whole-frame time per unit always; in NES_ENABLE_STATS builds
+ * also each subsystem's own time per instruction / dot / sample */
+static int bench_write_json(const char* filename, const bench_case_t* cases, int count, int repeat) {
+    FILE* f = fopen(filename, "w");
+    if (!f) {
+        return -1;
+    }
+
+    fprintf(f, "{\n  \"repeat\": %d,\n  \"stats\": %s,\n  \"cases\": [\n", repeat,
+            count > 0 && cases[0].has_stats ? "true" : "false");
+    for (int i = 0; i < count; i++) {
+        const bench_case_t* c = &cases[i];
+        double seconds = (double)c->elapsed_ns / 1e9;
+        fprintf(f, "    {\"name\": ");
+        bench_json_string(f, c->name);
+        fprintf(f, ", \"rom\": ");
+        bench_json_string(f, c->rom);
+        fprintf(f, ", \"frames\": %ld, \"seconds\": %.6f, \"fps\": %.2f", c->frames, seconds,
+                seconds > 0.0 ? (double)c->frames / seconds : 0.0);
+        fprintf(f, ", \"ns_per_frame\": %.1f, \"ns_per_cpu_cycle\": %.3f, \"ns_per_ppu_dot\": %.3f"
+                   ", \"ns_per_sample\": %.2f",
+                bench_per(c->elapsed_ns, (uint64_t)c->frames), bench_per(c->elapsed_ns, c->cpu_cycles),
+                bench_per(c->elapsed_ns, c->ppu_dots), bench_per(c->elapsed_ns, c->samples));
+        if (c->has_stats) {
+            fprintf(f, ", \"instructions\": %llu, \"ns_per_instruction\": %.3f"
+                       ", \"ppu_ns_per_dot\": %.3f, \"apu_ns_per_sample\": %.2f",
+                    (unsigned long long)c->stats.instructions,
+                    bench_per(c->stats.cpu_ns, c->stats.instructions),
+                    bench_per(c->stats.ppu_ns, c->stats.ppu_dots),
+                    bench_per(c->stats.apu_ns, c->samples));
+        } else {
+            fprintf(f, ", \"instructions\": null, \"ns_per_instruction\": null"
+                       ", \"ppu_ns_per_dot\": null, \"apu_ns_per_sample\": null");
+        }
+        fprintf(f, ", ");
+        bench_json_hash(f, "frame_hash", c->frame_hash, 1);
+        fprintf(f, ", ");
+        bench_json_hash(f, "audio_hash", c->audio_hash, 1);
+        fprintf(f, ", ");
+        bench_json_hash(f, "expected_frame_hash", c->expect_frame, c->check_frame);
+        fprintf(f, ", ");
+        bench_json_hash(f, "expected_audio_hash", c->expect_audio, c->check_audio);
+        fprintf(f, ", \"drift_frame\": %ld", c->drift_frame);
+        fprintf(f, ", \"match\": %s}%s\n", bench_case_ok(c) ? "true" : "false",
+                i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static int bench_is_rom(const char* filename) {
+    size_t len = strlen(filename);
+    return len > 4 && (strcmp(filename + len - 4, ".nes") == 0 || strcmp(filename + len - 4, ".NES") == 0);
+}
+
+int main(int argc, char* argv[]) {
+    const char* inputs[2] = { NULL, NULL };
+    int input_count = 0;
+    long frames = 0;    /* 0 = per case */
+    int repeat = 3;
+    const char* json = NULL;
+    nes_apu_synth_t synth = NES_APU_SYNTH_POINT;
+    nes_sync_mode_t sync_mode = NES_SYNC_DOT;
+    int idle_skip = 1;
+
+    /* Parse command line */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printf("%s", NES_BENCH_USAGE);
+            return 0;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--frames") == 0) && i + 1 < argc) {
+            frames = strtol(argv[++i], NULL, 10);
+        } else if ((strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--repeat") == 0) && i + 1 < argc) {
+            repeat = (int)strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json = argv[++i];
+        } else if (strcmp(argv[i], "--blip") == 0) {
+            synth = NES_APU_SYNTH_BLIP;
+        } else if (strcmp(argv[i], "--scanline") == 0) {
+            sync_mode = NES_SYNC_SCANLINE;
+        } else if (strcmp(argv[i], "--catchup") == 0) {
+            sync_mode = NES_SYNC_CATCHUP;
+        } else if (strcmp(argv[i], "--no-idle") == 0) {
+            idle_skip = 0;
+        } else if (argv[i][0] != '-' && input_count < 2) {
+            inputs[input_count++] = argv[i];
+        }
+    }
+
+    if (!inputs[0] || repeat <= 0 || frames < 0) {
+        fprintf(stderr, "Error: No corpus or ROM specified\n\n%s", NES_BENCH_USAGE);
+        return 1;
+    }
+
+    static bench_case_t cases[NES_BENCH_MAX_CASES];
+    int count;
+    if (bench_is_rom(inputs[0])) {
+        /* Single ROM (and optional movie), nothing to check against */
+        memset(&cases[0], 0, sizeof(cases[0]));
+        const char* base = strrchr(inputs[0], '/');
+        snprintf(cases[0].name, sizeof(cases[0].name), "%s", base ? base + 1 : inputs[0]);
+        snprintf(cases[0].rom, sizeof(cases[0].rom), "%s", inputs[0]);
+        if (inputs[1]) {
+            snprintf(cases[0].movie, sizeof(cases[0].movie), "%s", inputs[1]);
+        }
+        cases[0].frames = NES_BENCH_DEFAULT_FRAMES;
+        count = 1;
+    } else {
+        count = bench_load_corpus(inputs[0], cases, NES_BENCH_MAX_CASES);
+        if (count < 0) {
+            return 1;
+        }
+    }
+
+    int status = 0;
+    for (int i = 0; i < count; i++) {
+        bench_case_t* c = &cases[i];
+        if (frames > 0) {
+            /* Expected hashes only hold for the frame count they were taken at */
+            c->check_frame = c->check_frame && c->frames == frames;
+            c->check_audio = c->check_audio && c->frames == frames;
+            c->frames = frames;
+        }
+
+        bench_movie_t movie = { NULL, 0 };
+        if (c->movie[0] && bench_load_movie(c->movie, &movie) != 0) {
+            fprintf(stderr, "%s: cannot read movie %s\n", c->name, c->movie);
+            status = 1;
+            continue;
+        }
+
+        /* Keep the fastest run; every run must produce the same output */
+        for (int r = 0; r < repeat; r++) {
+            bench_case_t run = *c;
+            uint64_t elapsed;
+            if (bench_run(&run, &movie, sync_mode, synth, idle_skip, &elapsed) != 0) {
+                fprintf(stderr, "%s: cannot load %s\n", c->name, c->rom);
+                status = 1;
+                break;
+            }
+            if (c->ran && (run.frame_hash != c->frame_hash || run.audio_hash != c->audio_hash)) {
+                fprintf(stderr, "%s: output differs between runs\n", c->name);
+                status = 1;
+            }
+            if (!c->ran || elapsed < c->elapsed_ns) {
+                run.elapsed_ns = elapsed;
+                run.ran = 1;
+                *c = run;
+            }
+        }
+        free(movie.masks);
+    }
+
+    /* Results after all loading chatter */
+    printf("\n");
+    int ran = 0;
+    for (int i = 0; i < count; i++) {
+        if (cases[i].ran) {
+            bench_print(&cases[i]);
+            cases[ran++] = cases[i];
+            if (status == 0 && !bench_case_ok(&cases[i])) {
+                status = 2;
+            }
+        }
+    }
+
+    if (json && bench_write_json(json, cases, ran, repeat) != 0) {
+        fprintf(stderr, "Failed to write %s\n", json);
+        status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,626 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Cartridge Module - ROM Library Index Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "library.h"
+#include "../util/crc32.h"
+#include "../util/thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#define LIBRARY_BUFFER_SIZE     (128 * 1024)    /* Per-thread read buffer */
+#define LIBRARY_TRAINER_SIZE    512
+#define LIBRARY_PATH_MAX        4096            /* Longer paths are not indexed */
+#define LIBRARY_FNV_OFFSET      0x811C9DC5u
+#define LIBRARY_FNV_PRIME       0x01000193u
+
+/* Index file header, followed by count records */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t record_size;
+} library_file_header_t;
+
+/* One entry on disk (host byte order), followed by path_length path bytes */
+typedef struct {
+    uint64_t            mtime;
+    uint64_t            size;
+    uint32_t            crc32;
+    uint16_t            status;
+    uint16_t            path_length;
+    nes_rom_header_t    header;
+} library_record_t;
+
+/* A record read by nes_library_load_index, not yet applied */
+typedef struct {
+    library_record_t    record;
+    char*               path;
+} library_staged_t;
+
+typedef struct {
+    nes_library_entry_t entry;
+    uint32_t            hash;       /* Of entry.path */
+    int                 known;      /* mtime, size, header and crc32 are valid */
+    int                 gone;       /* File vanished during the last scan */
+} library_item_t;
+
+struct nes_library {
+    library_item_t*     items;
+    size_t              count;
+    size_t              capacity;
+
+    /* Open-addressed path lookup: item index + 1, 0 = empty; power of two */
+    uint32_t*           slots;
+    size_t              slot_count;
+};
+
+/* Shared by the threads of one nes_library_scan */
+typedef struct {
+    nes_library_t*      lib;
+    nes_mutex_t         lock;
+    size_t              next;       /* Next item to check */
+} library_scan_t;
+
+typedef struct {
+    library_scan_t*     scan;
+    nes_thread_t        thread;
+    uint8_t*            buffer;
+    int                 read;       /* Files this worker reread */
+} library_worker_t;
+
+static uint32_t library_hash(const char* path) {
+    uint32_t hash = LIBRARY_FNV_OFFSET;
+    while (*path) {
+        hash = (hash ^ (uint8_t)*path++) * LIBRARY_FNV_PRIME;
+    }
+    return hash;
+}
+
+/* Path lookup */
+
+static library_item_t* library_find(const nes_library_t* lib, const char* path, uint32_t hash) {
+    if (!lib->slot_count) {
+        return NULL;
+    }
+    size_t mask = lib->slot_count - 1;
+    for (size_t i = hash & mask; lib->slots[i]; i = (i + 1) & mask) {
+        library_item_t* item = &lib->items[lib->slots[i] - 1];
+        if (item->hash == hash && strcmp(item->entry.path, path) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+static void library_insert_slot(nes_library_t* lib, size_t index) {
+    size_t mask = lib->slot_count - 1;
+    size_t i = lib->items[index].hash & mask;
+    while (lib->slots[i]) {
+        i = (i + 1) & mask;
+    }
+    lib->slots[i] = (uint32_t)(index + 1);
+}
+
+/* Size the lookup for at least count items at half load and refill it */
+static int library_rehash(nes_library_t* lib, size_t count) {
+    size_t slot_count = lib->slot_count ? lib->slot_count : 64;
+    while (slot_count < count * 2) {
+        slot_count *= 2;
+    }
+    if (slot_count != lib->slot_count) {
+        uint32_t* slots = (uint32_t*)malloc(slot_count * sizeof(uint32_t));
+        if (!slots) {
+            return -1;
+        }
+        free(lib->slots);
+        lib->slots = slots;
+        lib->slot_count = slot_count;
+    }
+    memset(lib->slots, 0, lib->slot_count * sizeof(uint32_t));
+    for (size_t i = 0; i < lib->count; i++) {
+        library_insert_slot(lib, i);
+    }
+    return 0;
+}
+
+/* Make room for count items, so appending up to count cannot fail */
+static int library_reserve(nes_library_t* lib, size_t count) {
+    if (count > lib->capacity) {
+        size_t capacity = lib->capacity ? lib->capacity : 256;
+        while (capacity < count) {
+            capacity *= 2;
+        }
+        library_item_t* items = (library_item_t*)realloc(lib->items, capacity * sizeof(library_item_t));
+        if (!items) {
+            return -1;
+        }
+        lib->items = items;
+        lib->capacity = capacity;
+    }
+    if (count * 2 > lib->slot_count && library_rehash(lib, count) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Append an item owning path (freed here on failure) */
+static library_item_t* library_append(nes_library_t* lib, char* path, uint32_t hash) {
+    if (library_reserve(lib, lib->count + 1) != 0) {
+        free(path);
+        return NULL;
+    }
+
+    library_item_t* item = &lib->items[lib->count];
+    memset(item, 0, sizeof(*item));
+    item->entry.path = path;
+    item->entry.status = NES_ROM_ERROR_FILE_NOT_FOUND;
+    item->hash = hash;
+    library_insert_slot(lib, lib->count++);
+    return item;
+}
+
+static char* library_strdup(const char* s, size_t length) {
+    char* copy = (char*)malloc(length + 1);
+    if (copy) {
+        memcpy(copy, s, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+/* Platform file access */
+
+typedef enum {
+    LIBRARY_MISSING,
+    LIBRARY_FILE,
+    LIBRARY_DIRECTORY
+} library_file_kind_t;
+
+static library_file_kind_t library_stat(const char* path, uint64_t* mtime, uint64_t* size) {
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path, &st) != 0) {
+        return LIBRARY_MISSING;
+    }
+    if (st.st_mode & _S_IFDIR) {
+        return LIBRARY_DIRECTORY;
+    }
+#else
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return LIBRARY_MISSING;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        return LIBRARY_DIRECTORY;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        return LIBRARY_MISSING;
+    }
+#endif
+    *mtime = (uint64_t)st.st_mtime;
+    *size = (uint64_t)st.st_size;
+    return LIBRARY_FILE;
+}
+
+static int library_is_rom_name(const char* name) {
+    size_t length = strlen(name);
+    return length > 4 && name[length - 4] == '.' && tolower((unsigned char)name[length - 3]) == 'n' &&
+           tolower((unsigned char)name[length - 2]) == 'e' && tolower((unsigned char)name[length - 1]) == 's';
+}
+
+/* dir/name in a new string */
+static char* library_join(const char* dir, const char* name) {
+    size_t dir_length = strlen(dir);
+    while (dir_length > 1 && (dir[dir_length - 1] == '/' || dir[dir_length - 1] == '\\')) {
+        dir_length--;
+    }
+    size_t name_length = strlen(name);
+    char* path = (char*)malloc(dir_length + name_length + 2);
+    if (path) {
+        memcpy(path, dir, dir_length);
+        path[dir_length] = '/';
+        memcpy(path + dir_length + 1, name, name_length + 1);
+    }
+    return path;
+}
+
+/* Add a directory entry: recurse into directories, add ROM files */
+static int library_add_child(nes_library_t* lib, const char* dir, const char* name, int is_dir, int* found) {
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0 || (!is_dir && !library_is_rom_name(name))) {
+        return 0;
+    }
+    char* path = library_join(dir, name);
+    if (!path) {
+        return -1;
+    }
+    int status = 0;
+    if (is_dir) {
+        int count = nes_library_add_directory(lib, path);
+        *found += count > 0 ? count : 0;
+    } else if (nes_library_add_file(lib, path) == 0) {
+        (*found)++;
+    } else {
+        status = -1;
+    }
+    free(path);
+    return status;
+}
+
+int nes_library_add_directory(nes_library_t* lib, const char* dir) {
+    int found = 0;
+#ifdef _WIN32
+    char* pattern = library_join(dir, "*");
+    if (!pattern) {
+        return -1;
+    }
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    free(pattern);
+    if (find == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+    do {
+        /* Reparse points (junctions, symlinks) are not followed, so cycles cannot recurse */
+        int is_dir = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+                     !(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT);
+        if (library_add_child(lib, dir, data.cFileName, is_dir, &found) != 0) {
+            FindClose(find);
+            return -1;
+        }
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    DIR* handle = opendir(dir);
+    if (!handle) {
+        return -1;
+    }
+    struct dirent* ent;
+    while ((ent = readdir(handle)) != NULL) {
+        /* Symlinked directories are not followed, so cycles cannot recurse */
+        int is_dir;
+#ifdef DT_DIR
+        if (ent->d_type != DT_UNKNOWN) {
+            is_dir = ent->d_type == DT_DIR;
+        } else
+#endif
+        {
+            struct stat st;
+            char* path = library_join(dir, ent->d_name);
+            is_dir = path && lstat(path, &st) == 0 && S_ISDIR(st.st_mode);
+            free(path);
+        }
+        if (library_add_child(lib, dir, ent->d_name, is_dir, &found) != 0) {
+            closedir(handle);
+            return -1;
+        }
+    }
+    closedir(handle);
+#endif
+    return found;
+}
+
+/* Lifetime */
+
+nes_library_t* nes_library_create(void) {
+    return (nes_library_t*)calloc(1, sizeof(nes_library_t));
+}
+
+void nes_library_destroy(nes_library_t* lib) {
+    if (!lib) {
+        return;
+    }
+    for (size_t i = 0; i < lib->count; i++) {
+        free(lib->items[i].entry.path);
+    }
+    free(lib->items);
+    free(lib->slots);
+    free(lib);
+}
+
+int nes_library_add_file(nes_library_t* lib, const char* path) {
+    uint32_t hash = library_hash(path);
+    if (library_find(lib, path, hash)) {
+        return 0;
+    }
+    char* copy = library_strdup(path, strlen(path));
+    return copy && library_append(lib, copy, hash) ? 0 : -1;
+}
+
+size_t nes_library_count(const nes_library_t* lib) {
+    return lib->count;
+}
+
+const nes_library_entry_t* nes_library_get(const nes_library_t* lib, size_t index) {
+    return index < lib->count ? &lib->items[index].entry : NULL;
+}
+
+/* Index file */
+
+/* Free the records nes_library_load_index read before it gave up */
+static void library_free_staged(library_staged_t* staged, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(staged[i].path);
+    }
+    free(staged);
+}
+
+int nes_library_load_index(nes_library_t* lib, const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return -1;
+    }
+
+    library_file_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != NES_LIBRARY_MAGIC ||
+        header.version != NES_LIBRARY_VERSION || header.record_size != sizeof(library_record_t)) {
+        fclose(file);
+        return -1;
+    }
+
+    /* Read the whole file first; the library only changes once it all checks out */
+    library_staged_t* staged = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    char path[LIBRARY_PATH_MAX];
+    for (uint32_t i = 0; i < header.count; i++) {
+        library_record_t record;
+        if (fread(&record, sizeof(record), 1, file) != 1 || record.path_length == 0 ||
+            record.path_length >= sizeof(path) || fread(path, record.path_length, 1, file) != 1) {
+            library_free_staged(staged, count);
+            fclose(file);
+            return -1;
+        }
+
+        if (count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 256;
+            library_staged_t* more = (library_staged_t*)realloc(staged, grown * sizeof(library_staged_t));
+            if (!more) {
+                library_free_staged(staged, count);
+                fclose(file);
+                return -1;
+            }
+            staged = more;
+            capacity = grown;
+        }
+        staged[count].record = record;
+        staged[count].path = library_strdup(path, record.path_length);
+        if (!staged[count].path) {
+            library_free_staged(staged, count);
+            fclose(file);
+            return -1;
+        }
+        count++;
+    }
+    fclose(file);
+
+    if (library_reserve(lib, lib->count + count) != 0) {
+        library_free_staged(staged, count);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        /* Paths added before the index was loaded take its data too */
+        char* staged_path = staged[i].path;
+        uint32_t hash = library_hash(staged_path);
+        library_item_t* item = library_find(lib, staged_path, hash);
+        if (item) {
+            free(staged_path);
+            if (item->known) {
+                continue;
+            }
+        } else {
+            item = library_append(lib, staged_path, hash);      /* Reserved above */
+        }
+        const library_record_t* record = &staged[i].record;
+        item->entry.mtime = record->mtime;
+        item->entry.size = record->size;
+        item->entry.crc32 = record->crc32;
+        item->entry.status = (nes_rom_result_t)record->status;
+        item->entry.header = record->header;
+        item->known = 1;
+    }
+    free(staged);
+    return 0;
+}
+
+/* Entries worth writing: scanned, with a path that fits a record */
+static int library_saved(const library_item_t* item) {
+    return item->known && strlen(item->entry.path) < LIBRARY_PATH_MAX;
+}
+
+int nes_library_save_index(const nes_library_t* lib, const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return -1;
+    }
+
+    library_file_header_t header = { NES_LIBRARY_MAGIC, NES_LIBRARY_VERSION, 0,
+                                     (uint32_t)sizeof(library_record_t) };
+    for (size_t i = 0; i < lib->count; i++) {
+        header.count += library_saved(&lib->items[i]);
+    }
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    for (size_t i = 0; ok && i < lib->count; i++) {
+        const library_item_t* item = &lib->items[i];
+        if (!library_saved(item)) {
+            continue;
+        }
+        size_t length = strlen(item->entry.path);
+        library_record_t record;
+        memset(&record, 0, sizeof(record));
+        record.mtime = item->entry.mtime;
+        record.size = item->entry.size;
+        record.crc32 = item->entry.crc32;
+        record.status = (uint16_t)item->entry.status;
+        record.path_length = (uint16_t)length;
+        record.header = item->entry.header;
+        ok = fwrite(&record, sizeof(record), 1, file) == 1 &&
+             fwrite(item->entry.path, length, 1, file) == 1;
+    }
+
+    if (fclose(file) != 0 || !ok) {
+        remove(filename);
+        return -1;
+    }
+    return 0;
+}
+
+/* Scanning */
+
+/* Read the header and stream the CRC32 of PRG/CHR-ROM, as the loader sees them */
+static nes_rom_result_t library_read_file(nes_library_entry_t* entry, uint8_t* buffer) {
+    FILE* file = fopen(entry->path, "rb");
+    if (!file) {
+        return NES_ROM_ERROR_FILE_NOT_FOUND;
+    }
+
+    memset(&entry->header, 0, sizeof(entry->header));
+    entry->crc32 = 0;
+    if (fread(&entry->header, sizeof(entry->header), 1, file) != 1) {
+        fclose(file);
+        return NES_ROM_ERROR_TRUNCATED;
+    }
+
+    nes_cartridge_t cart;
+    nes_rom_result_t result = nes_cartridge_parse_header(&cart, &entry->header);
+    if (result != NES_ROM_OK) {
+        fclose(file);
+        return result;
+    }
+
+    uint64_t offset = sizeof(nes_rom_header_t) + (cart.info.has_trainer ? LIBRARY_TRAINER_SIZE : 0);
+    uint64_t remaining = cart.prg_rom_size + (cart.info.chr_rom_banks > 0 ? cart.chr_rom_size : 0);
+    if (entry->size < offset + remaining ||
+        (cart.info.has_trainer && fseek(file, LIBRARY_TRAINER_SIZE, SEEK_CUR) != 0)) {
+        fclose(file);
+        return NES_ROM_ERROR_TRUNCATED;
+    }
+
+    uint32_t crc = 0;
+    while (remaining) {
+        size_t chunk = remaining < LIBRARY_BUFFER_SIZE ? (size_t)remaining : LIBRARY_BUFFER_SIZE;
+        if (fread(buffer, 1, chunk, file) != chunk) {
+            fclose(file);
+            return NES_ROM_ERROR_TRUNCATED;
+        }
+        crc = nes_crc32_update(crc, buffer, chunk);
+        remaining -= chunk;
+    }
+    fclose(file);
+
+    entry->crc32 = crc;
+    return NES_ROM_OK;
+}
+
+static void library_worker_main(void* arg) {
+    library_worker_t* worker = (library_worker_t*)arg;
+    library_scan_t* scan = worker->scan;
+
+    for (;;) {
+        nes_mutex_lock(&scan->lock);
+        size_t index = scan->next++;
+        nes_mutex_unlock(&scan->lock);
+        if (index >= scan->lib->count) {
+            break;
+        }
+
+        library_item_t* item = &scan->lib->items[index];
+        uint64_t mtime, size;
+        if (library_stat(item->entry.path, &mtime, &size) != LIBRARY_FILE) {
+            item->gone = 1;
+            continue;
+        }
+        if (item->known && item->entry.mtime == mtime && item->entry.size == size) {
+            continue;
+        }
+
+        item->entry.mtime = mtime;
+        item->entry.size = size;
+        item->entry.status = library_read_file(&item->entry, worker->buffer);
+        item->known = 1;
+        worker->read++;
+    }
+}
+
+int nes_library_scan(nes_library_t* lib, int threads) {
+    if (threads <= 0) {
+        threads = nes_thread_cpu_count();
+    }
+    if ((size_t)threads > lib->count) {
+        threads = lib->count ? (int)lib->count : 1;
+    }
+
+    library_scan_t scan;
+    scan.lib = lib;
+    scan.next = 0;
+    library_worker_t* workers = (library_worker_t*)calloc((size_t)threads, sizeof(library_worker_t));
+    if (!workers || nes_mutex_init(&scan.lock) != 0) {
+        free(workers);
+        return -1;
+    }
+    workers[0].scan = &scan;
+    workers[0].buffer = (uint8_t*)malloc(LIBRARY_BUFFER_SIZE);
+    if (!workers[0].buffer) {
+        nes_mutex_destroy(&scan.lock);
+        free(workers);
+        return -1;
+    }
+
+    /* The caller is worker 0; fewer helpers than asked for only slow the scan */
+    int started = 1;
+    while (started < threads) {
+        library_worker_t* worker = &workers[started];
+        worker->scan = &scan;
+        worker->buffer = (uint8_t*)malloc(LIBRARY_BUFFER_SIZE);
+        if (!worker->buffer || nes_thread_create(&worker->thread, library_worker_main, worker) != 0) {
+            free(worker->buffer);
+            break;
+        }
+        started++;
+    }
+    library_worker_main(&workers[0]);
+
+    int read = 0;
+    for (int i = 0; i < started; i++) {
+        if (i > 0) {
+            nes_thread_join(&workers[i].thread);
+        }
+        read += workers[i].read;
+        free(workers[i].buffer);
+    }
+    nes_mutex_destroy(&scan.lock);
+    free(workers);
+
+    /* Remove vanished files, keeping the rest in order */
+    size_t kept = 0;
+    for (size_t i = 0; i < lib->count; i++) {
+        if (lib->items[i].gone) {
+            free(lib->items[i].entry.path);
+        } else {
+            lib->items[kept++] = lib->items[i];
+        }
+    }
+    if (kept != lib->count) {
+        lib->count = kept;
+        library_rehash(lib, kept);
+    }
+    return read;
+}
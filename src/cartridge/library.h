@@ -0,0 +1,98 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Cartridge Module - ROM Library Index
+ *
+ * Lists a ROM collection without loading it: each file contributes its
+ * 16-byte iNES header and the CRC32 of its PRG/CHR-ROM, streamed through a
+ * small buffer by several threads at once. The results persist in a compact
+ * index file keyed by path and modification time (plus size), so a later
+ * scan only rereads files that were added or changed since and drops files
+ * that are gone.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_LIBRARY_H
+#define NESPRESSO_LIBRARY_H
+
+#include "rom.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Index file identification ("NESL" in host byte order) */
+#define NES_LIBRARY_MAGIC       0x4C53454Eu
+#define NES_LIBRARY_VERSION     1
+
+/* One ROM file */
+typedef struct {
+    char*               path;
+    uint64_t            mtime;      /* Last modification, seconds since the epoch */
+    uint64_t            size;       /* File size in bytes */
+    nes_rom_header_t    header;     /* As read from the file */
+    uint32_t            crc32;      /* Same value as nes_cartridge_calc_crc32 */
+    nes_rom_result_t    status;     /* NES_ROM_OK, or why the file would not load */
+} nes_library_entry_t;
+
+typedef struct nes_library nes_library_t;
+
+/**
+ * Create an empty library
+ * Returns NULL on failure
+ */
+nes_library_t* nes_library_create(void);
+
+/**
+ * Free a library and all its entries
+ */
+void nes_library_destroy(nes_library_t* lib);
+
+/**
+ * Add the entries of an index written by nes_library_save_index; they are
+ * trusted until nes_library_scan finds their file changed
+ * Returns 0 on success, -1 if the file is missing or not a valid index
+ * (the library is then left as it was)
+ */
+int nes_library_load_index(nes_library_t* lib, const char* filename);
+
+/**
+ * Write every entry to an index file
+ * Returns 0 on success, -1 on failure
+ */
+int nes_library_save_index(const nes_library_t* lib, const char* filename);
+
+/**
+ * Add one file; a path already in the library is kept as it is
+ * Returns 0 on success, -1 on failure
+ */
+int nes_library_add_file(nes_library_t* lib, const char* path);
+
+/**
+ * Add every .nes file in dir and its subdirectories
+ * Returns the number of files found, -1 if dir cannot be read
+ */
+int nes_library_add_directory(nes_library_t* lib, const char* dir);
+
+/**
+ * Bring every entry up to date: files whose modification time or size no
+ * longer match are reread, new ones read for the first time, missing ones
+ * removed. threads: worker threads (0 = one per CPU)
+ * Returns the number of files read, -1 on failure
+ */
+int nes_library_scan(nes_library_t* lib, int threads);
+
+/**
+ * Number of entries, and entry index (0 to count - 1) in the order added
+ */
+size_t nes_library_count(const nes_library_t* lib);
+const nes_library_entry_t* nes_library_get(const nes_library_t* lib, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_LIBRARY_H */
@@ -6,56 +6,38 @@
  */
 
 #include "rom.h"
+#include "rom_store.h"
 #include "../mapper/mapper.h"
+#include "../util/crc32.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define NES_ROM_HEADER_SIZE  16  /* iNES header size */
 
-/* CRC32 Lookup Table */
-static uint32_t g_crc32_table[256];
-
-static void init_crc32_table(void) {
-    static int initialized = 0;
-    if (initialized) return;
-    initialized = 1;
-
-    for (uint32_t i = 0; i < 256; i++) {
-        uint32_t crc = i;
-        for (int j = 0; j < 8; j++) {
-            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
-        }
-        g_crc32_table[i] = crc;
-    }
-}
-
-static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t length) {
-    crc = ~crc;
-    for (size_t i = 0; i < length; i++) {
-        crc = g_crc32_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
-    }
-    return ~crc;
-}
-
 void nes_cartridge_init(nes_cartridge_t* cart) {
     memset(cart, 0, sizeof(nes_cartridge_t));
-    init_crc32_table();
 }
 
 void nes_cartridge_free(nes_cartridge_t* cart) {
-    if (cart->prg_rom) {
+    /* Shared ROM images belong to the source cartridge */
+    if (cart->prg_rom && !cart->rom_shared) {
         free(cart->prg_rom);
-        cart->prg_rom = NULL;
     }
-    if (cart->chr_rom) {
+    cart->prg_rom = NULL;
+    if (cart->chr_rom && (!cart->rom_shared || cart->info.has_chrram)) {
         free(cart->chr_rom);
-        cart->chr_rom = NULL;
     }
+    cart->chr_rom = NULL;
+    cart->rom_shared = 0;
     if (cart->prg_ram) {
         free(cart->prg_ram);
         cart->prg_ram = NULL;
     }
+    if (cart->rom_entry) {
+        nes_rom_store_release(cart->rom_entry);
+        cart->rom_entry = NULL;
+    }
 }
 
 /* Parse header and extract info */
@@ -112,41 +94,22 @@ static nes_rom_result_t parse_header(const nes_rom_header_t* header, nes_cartrid
     /* PAL detection */
     cart->info.is_pal = (header->flags10 & FLAGS10_TV_SYSTEM) & 0x01;
 
-    /* Allocate PRG-ROM */
-    cart->prg_rom = (uint8_t*)malloc(cart->prg_rom_size);
-    if (!cart->prg_rom) {
-        return NES_ROM_ERROR_MEMORY;
-    }
-
-    /* Allocate CHR or CHR-RAM */
-    if (cart->chr_rom_size > 0) {
-        cart->chr_rom = (uint8_t*)malloc(cart->chr_rom_size);
-        if (!cart->chr_rom) {
-            free(cart->prg_rom);
-            cart->prg_rom = NULL;
-            return NES_ROM_ERROR_MEMORY;
-        }
-    } else {
-        /* CHR-RAM: allocate 8KB */
+    /* CHR-RAM: 8KB */
+    if (cart->info.has_chrram) {
         cart->chr_rom_size = NES_CHR_ROM_SIZE;
-        cart->chr_rom = (uint8_t*)calloc(1, cart->chr_rom_size);
-        if (!cart->chr_rom) {
-            free(cart->prg_rom);
-            cart->prg_rom = NULL;
-            return NES_ROM_ERROR_MEMORY;
-        }
-    }
-
-    /* Allocate PRG-RAM (save RAM) */
-    if (cart->info.has_battery || 1) {
-        cart->prg_ram_size = NES_PRG_RAM_SIZE;
-        cart->prg_ram = (uint8_t*)calloc(1, cart->prg_ram_size);
     }
 
     return NES_ROM_OK;
 }
 
-nes_rom_result_t nes_cartridge_load_memory(nes_cartridge_t* cart, const uint8_t* data, size_t size) {
+nes_rom_result_t nes_cartridge_parse_header(nes_cartridge_t* cart, const nes_rom_header_t* header) {
+    nes_cartridge_init(cart);
+    return parse_header(header, cart);
+}
+
+/* Parse the header and locate PRG/CHR-ROM inside the image */
+static nes_rom_result_t parse_image(nes_cartridge_t* cart, const uint8_t* data, size_t size,
+                                    const uint8_t** prg, const uint8_t** chr) {
     if (size < NES_ROM_HEADER_SIZE) {
         return NES_ROM_ERROR_TRUNCATED;
     }
@@ -169,25 +132,80 @@ nes_rom_result_t nes_cartridge_load_memory(nes_cartridge_t* cart, const uint8_t*
 
     /* Check if we have enough data */
     if (size < rom_size) {
-        nes_cartridge_free(cart);
         return NES_ROM_ERROR_TRUNCATED;
     }
 
-    /* Copy PRG-ROM */
-    memcpy(cart->prg_rom, data + offset, cart->prg_rom_size);
-    offset += cart->prg_rom_size;
+    *prg = data + offset;
+    *chr = cart->info.chr_rom_banks > 0 ? data + offset + cart->prg_rom_size : NULL;
+    return NES_ROM_OK;
+}
 
-    /* Copy CHR-ROM */
-    if (cart->info.chr_rom_banks > 0) {
-        memcpy(cart->chr_rom, data + offset, cart->chr_rom_size);
+/* Per-instance memory: CHR-RAM (when the board has no CHR-ROM) and PRG-RAM */
+static nes_rom_result_t alloc_ram(nes_cartridge_t* cart) {
+    if (cart->info.has_chrram) {
+        cart->chr_rom = (uint8_t*)calloc(1, cart->chr_rom_size);
+        if (!cart->chr_rom) {
+            return NES_ROM_ERROR_MEMORY;
+        }
+    }
+
+    /* Allocate PRG-RAM (save RAM) */
+    if (cart->info.has_battery || 1) {
+        cart->prg_ram_size = NES_PRG_RAM_SIZE;
+        cart->prg_ram = (uint8_t*)calloc(1, cart->prg_ram_size);
+    }
+
+    return NES_ROM_OK;
+}
+
+nes_rom_result_t nes_cartridge_load_memory(nes_cartridge_t* cart, const uint8_t* data, size_t size) {
+    const uint8_t* prg;
+    const uint8_t* chr;
+    nes_rom_result_t result = parse_image(cart, data, size, &prg, &chr);
+    if (result != NES_ROM_OK) {
+        return result;
+    }
+
+    /* Copy PRG-ROM and CHR-ROM */
+    cart->prg_rom = (uint8_t*)malloc(cart->prg_rom_size);
+    if (chr) {
+        cart->chr_rom = (uint8_t*)malloc(cart->chr_rom_size);
+    }
+    if (!cart->prg_rom || (chr && !cart->chr_rom) || alloc_ram(cart) != NES_ROM_OK) {
+        nes_cartridge_free(cart);
+        return NES_ROM_ERROR_MEMORY;
+    }
+    memcpy(cart->prg_rom, prg, cart->prg_rom_size);
+    if (chr) {
+        memcpy(cart->chr_rom, chr, cart->chr_rom_size);
     }
 
     /* Calculate CRC32 */
-    cart->info.crc32 = crc32_update(0, cart->prg_rom, cart->prg_rom_size);
-    if (cart->info.chr_rom_banks > 0) {
-        cart->info.crc32 = crc32_update(cart->info.crc32, cart->chr_rom, cart->chr_rom_size);
+    cart->info.crc32 = nes_cartridge_calc_crc32(cart);
+
+    return NES_ROM_OK;
+}
+
+nes_rom_result_t nes_cartridge_load_view(nes_cartridge_t* cart, const uint8_t* data, size_t size) {
+    const uint8_t* prg;
+    const uint8_t* chr;
+    nes_rom_result_t result = parse_image(cart, data, size, &prg, &chr);
+    if (result != NES_ROM_OK) {
+        return result;
+    }
+
+    /* Read-only PRG/CHR-ROM stay in the caller's image */
+    cart->rom_shared = 1;
+    cart->prg_rom = (uint8_t*)prg;
+    if (chr) {
+        cart->chr_rom = (uint8_t*)chr;
+    }
+    if (alloc_ram(cart) != NES_ROM_OK) {
+        nes_cartridge_free(cart);
+        return NES_ROM_ERROR_MEMORY;
     }
 
+    cart->info.crc32 = nes_cartridge_calc_crc32(cart);
     return NES_ROM_OK;
 }
 
@@ -228,6 +246,47 @@ nes_rom_result_t nes_cartridge_load(nes_cartridge_t* cart, const char* filename)
     return result;
 }
 
+nes_rom_result_t nes_cartridge_share(nes_cartridge_t* cart, const nes_cartridge_t* src) {
+    if (!src->prg_rom || !src->chr_rom) {
+        return NES_ROM_ERROR_INVALID_HEADER;
+    }
+
+    nes_cartridge_free(cart);
+    cart->info = src->info;
+    cart->prg_rom_size = src->prg_rom_size;
+    cart->chr_rom_size = src->chr_rom_size;
+    cart->rom_shared = 1;
+
+    /* PRG-ROM is read-only - point at the source image */
+    cart->prg_rom = src->prg_rom;
+
+    /* CHR-ROM is shared, CHR-RAM is per instance */
+    if (src->info.has_chrram) {
+        cart->chr_rom = (uint8_t*)calloc(1, cart->chr_rom_size);
+    } else {
+        cart->chr_rom = src->chr_rom;
+    }
+
+    /* PRG-RAM is always per instance */
+    cart->prg_ram_size = src->prg_ram_size;
+    if (cart->prg_ram_size > 0) {
+        cart->prg_ram = (uint8_t*)calloc(1, cart->prg_ram_size);
+    }
+
+    if (!cart->chr_rom || (cart->prg_ram_size > 0 && !cart->prg_ram)) {
+        nes_cartridge_free(cart);
+        return NES_ROM_ERROR_MEMORY;
+    }
+
+    /* Keep a stored image mapped for as long as any sharer uses it */
+    if (src->rom_entry) {
+        nes_rom_store_retain(src->rom_entry);
+        cart->rom_entry = src->rom_entry;
+    }
+
+    return NES_ROM_OK;
+}
+
 int nes_cartridge_get_mapper(const nes_cartridge_t* cart) {
     return cart->info.mapper;
 }
@@ -309,9 +368,9 @@ int nes_cartridge_save_sram(const nes_cartridge_t* cart, const char* filename) {
 }
 
 uint32_t nes_cartridge_calc_crc32(const nes_cartridge_t* cart) {
-    uint32_t crc = crc32_update(0, cart->prg_rom, cart->prg_rom_size);
+    uint32_t crc = nes_crc32_update(0, cart->prg_rom, cart->prg_rom_size);
     if (cart->info.chr_rom_banks > 0) {
-        crc = crc32_update(crc, cart->chr_rom, cart->chr_rom_size);
+        crc = nes_crc32_update(crc, cart->chr_rom, cart->chr_rom_size);
     }
     return crc;
 }
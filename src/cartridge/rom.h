@@ -82,6 +82,9 @@ typedef struct {
     char            title[256];     /* ROM title (from database) */
 } nes_rom_info_t;
 
+/* Stored ROM image (rom_store.h) */
+typedef struct nes_rom_entry nes_rom_entry_t;
+
 /* Cartridge Structure */
 typedef struct nes_cartridge {
     nes_rom_info_t  info;
@@ -91,6 +94,8 @@ typedef struct nes_cartridge {
     size_t          prg_rom_size;
     size_t          chr_rom_size;
     size_t          prg_ram_size;
+    int             rom_shared;     /* PRG/CHR-ROM borrowed from another cartridge */
+    nes_rom_entry_t* rom_entry;     /* Reference on the stored image it borrows, if any */
 } nes_cartridge_t;
 
 /* Loading Result */
@@ -110,6 +115,15 @@ void nes_cartridge_init(nes_cartridge_t* cart);
 void nes_cartridge_free(nes_cartridge_t* cart);
 nes_rom_result_t nes_cartridge_load(nes_cartridge_t* cart, const char* filename);
 nes_rom_result_t nes_cartridge_load_memory(nes_cartridge_t* cart, const uint8_t* data, size_t size);
+/* Like nes_cartridge_load_memory, but PRG/CHR-ROM point into data instead of
+ * being copied; data must outlive the cartridge and is never written */
+nes_rom_result_t nes_cartridge_load_view(nes_cartridge_t* cart, const uint8_t* data, size_t size);
+/* Share src's read-only PRG/CHR-ROM; PRG-RAM and CHR-RAM are allocated per instance.
+ * src must stay loaded for as long as cart uses it. */
+nes_rom_result_t nes_cartridge_share(nes_cartridge_t* cart, const nes_cartridge_t* src);
+/* Fill cart's info and ROM sizes from a header alone; nothing is allocated,
+ * so cart needs no nes_cartridge_free. Enough for nes_cartridge_get_info_string */
+nes_rom_result_t nes_cartridge_parse_header(nes_cartridge_t* cart, const nes_rom_header_t* header);
 int nes_cartridge_get_mapper(const nes_cartridge_t* cart);
 int nes_cartridge_has_battery(const nes_cartridge_t* cart);
 mirroring_t nes_cartridge_get_mirroring(const nes_cartridge_t* cart);
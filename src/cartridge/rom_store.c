@@ -0,0 +1,389 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Cartridge Module - Shared ROM Store Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "rom_store.h"
+#include "../util/thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Sub-second modification time, so a rewrite within the same second is a new file */
+#if defined(__APPLE__)
+#define ROM_STORE_MTIME_NS(st) ((st).st_mtimespec.tv_nsec)
+#else
+#define ROM_STORE_MTIME_NS(st) ((st).st_mtim.tv_nsec)
+#endif
+#endif
+
+/* One loaded file image, shared by every cartridge that references it */
+struct nes_rom_entry {
+    nes_rom_store_t*        store;
+    int                     refs;
+    nes_cartridge_t         image;      /* PRG/CHR-ROM point into data */
+    const uint8_t*          data;
+    size_t                  size;
+    int                     mapped;     /* Else data was malloc'd */
+#ifdef _WIN32
+    HANDLE                  mapping;
+#endif
+    uint64_t                id[4];      /* File identity: device, inode, mtime (ns), size */
+    int                     has_id;
+    struct nes_rom_entry*   next;
+};
+
+struct nes_rom_store {
+    nes_mutex_t         lock;
+    int                 refs;           /* Creator + one per entry */
+    nes_rom_entry_t*    entries;
+    size_t              count;
+};
+
+/* An open ROM file being loaded */
+typedef struct {
+#ifdef _WIN32
+    HANDLE      handle;
+#else
+    int         fd;
+#endif
+    size_t      size;
+    uint64_t    id[4];
+    int         has_id;
+} rom_store_file_t;
+
+/* Platform file access */
+
+#ifdef _WIN32
+
+static int rom_store_open(rom_store_file_t* file, const char* filename) {
+    file->handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file->handle == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(file->handle, &info)) {
+        CloseHandle(file->handle);
+        return -1;
+    }
+    file->size = (size_t)(((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow);
+    file->id[0] = info.dwVolumeSerialNumber;
+    file->id[1] = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    file->id[2] = ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) |
+                  info.ftLastWriteTime.dwLowDateTime;     /* 100 ns units */
+    file->id[3] = (uint64_t)file->size;
+    file->has_id = 1;
+    return 0;
+}
+
+static void rom_store_close(rom_store_file_t* file) {
+    CloseHandle(file->handle);
+}
+
+static int rom_store_map(rom_store_file_t* file, nes_rom_entry_t* entry) {
+    entry->mapping = CreateFileMappingA(file->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!entry->mapping) {
+        return -1;
+    }
+    entry->data = (const uint8_t*)MapViewOfFile(entry->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!entry->data) {
+        CloseHandle(entry->mapping);
+        return -1;
+    }
+    return 0;
+}
+
+static void rom_store_unmap(nes_rom_entry_t* entry) {
+    UnmapViewOfFile(entry->data);
+    CloseHandle(entry->mapping);
+}
+
+static int rom_store_read(rom_store_file_t* file, uint8_t* buffer) {
+    size_t done = 0;
+    while (done < file->size) {
+        DWORD chunk = file->size - done > 0x40000000 ? 0x40000000 : (DWORD)(file->size - done);
+        DWORD got = 0;
+        if (!ReadFile(file->handle, buffer + done, chunk, &got, NULL) || got == 0) {
+            return -1;
+        }
+        done += got;
+    }
+    return 0;
+}
+
+#else
+
+static int rom_store_open(rom_store_file_t* file, const char* filename) {
+    file->fd = open(filename, O_RDONLY);
+    if (file->fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(file->fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(file->fd);
+        return -1;
+    }
+    file->size = (size_t)st.st_size;
+    file->id[0] = (uint64_t)st.st_dev;
+    file->id[1] = (uint64_t)st.st_ino;
+    file->id[2] = (uint64_t)st.st_mtime * 1000000000u + (uint64_t)ROM_STORE_MTIME_NS(st);
+    file->id[3] = (uint64_t)file->size;
+    file->has_id = 1;
+    return 0;
+}
+
+static void rom_store_close(rom_store_file_t* file) {
+    close(file->fd);
+}
+
+static int rom_store_map(rom_store_file_t* file, nes_rom_entry_t* entry) {
+    void* base = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    entry->data = (const uint8_t*)base;
+    return 0;
+}
+
+static void rom_store_unmap(nes_rom_entry_t* entry) {
+    munmap((void*)entry->data, entry->size);
+}
+
+static int rom_store_read(rom_store_file_t* file, uint8_t* buffer) {
+    size_t done = 0;
+    while (done < file->size) {
+        ssize_t got = read(file->fd, buffer + done, file->size - done);
+        if (got <= 0) {
+            return -1;
+        }
+        done += (size_t)got;
+    }
+    return 0;
+}
+
+#endif
+
+/* Entry lifetime */
+
+static void rom_store_unref(nes_rom_store_t* store) {
+    nes_mutex_lock(&store->lock);
+    int refs = --store->refs;
+    nes_mutex_unlock(&store->lock);
+
+    if (refs == 0) {
+        nes_mutex_destroy(&store->lock);
+        free(store);
+    }
+}
+
+/* Release the image's memory (entry must already be unlinked) */
+static void rom_store_free_entry(nes_rom_entry_t* entry) {
+    nes_cartridge_free(&entry->image);
+    if (entry->mapped) {
+        rom_store_unmap(entry);
+    } else {
+        free((void*)entry->data);
+    }
+    free(entry);
+}
+
+/* Same PRG/CHR-ROM contents (CRC32 alone may collide) */
+static int rom_store_same_rom(const nes_cartridge_t* a, const nes_cartridge_t* b) {
+    if (a->info.crc32 != b->info.crc32 || a->prg_rom_size != b->prg_rom_size ||
+        a->info.chr_rom_banks != b->info.chr_rom_banks || a->chr_rom_size != b->chr_rom_size) {
+        return 0;
+    }
+    if (memcmp(a->prg_rom, b->prg_rom, a->prg_rom_size) != 0) {
+        return 0;
+    }
+    return a->info.chr_rom_banks == 0 || memcmp(a->chr_rom, b->chr_rom, a->chr_rom_size) == 0;
+}
+
+/* Find an entry with this file identity (lock held) */
+static nes_rom_entry_t* rom_store_find_file(nes_rom_store_t* store, const rom_store_file_t* file) {
+    if (!file->has_id) {
+        return NULL;
+    }
+    for (nes_rom_entry_t* e = store->entries; e; e = e->next) {
+        if (e->has_id && memcmp(e->id, file->id, sizeof(e->id)) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Find an entry holding the same PRG/CHR-ROM, header included (lock held) */
+static nes_rom_entry_t* rom_store_find_image(nes_rom_store_t* store, const nes_rom_entry_t* entry) {
+    for (nes_rom_entry_t* e = store->entries; e; e = e->next) {
+        if (memcmp(e->data, entry->data, sizeof(nes_rom_header_t)) == 0 &&
+            rom_store_same_rom(&e->image, &entry->image)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Map (or read) the file and parse it into a new, unlinked entry */
+static nes_rom_result_t rom_store_open_entry(rom_store_file_t* file, nes_rom_entry_t** out) {
+    if (file->size < sizeof(nes_rom_header_t)) {
+        return NES_ROM_ERROR_TRUNCATED;
+    }
+
+    nes_rom_entry_t* entry = (nes_rom_entry_t*)calloc(1, sizeof(nes_rom_entry_t));
+    if (!entry) {
+        return NES_ROM_ERROR_MEMORY;
+    }
+    entry->size = file->size;
+    memcpy(entry->id, file->id, sizeof(entry->id));
+    entry->has_id = file->has_id;
+
+    if (rom_store_map(file, entry) == 0) {
+        entry->mapped = 1;
+    } else {
+        /* No mapping (pipes, some network file systems): keep one private copy */
+        uint8_t* buffer = (uint8_t*)malloc(file->size);
+        if (!buffer || rom_store_read(file, buffer) != 0) {
+            free(buffer);
+            free(entry);
+            return buffer ? NES_ROM_ERROR_TRUNCATED : NES_ROM_ERROR_MEMORY;
+        }
+        entry->data = buffer;
+    }
+
+    nes_cartridge_init(&entry->image);
+    nes_rom_result_t result = nes_cartridge_load_view(&entry->image, entry->data, entry->size);
+    if (result != NES_ROM_OK) {
+        rom_store_free_entry(entry);
+        return result;
+    }
+
+    *out = entry;
+    return NES_ROM_OK;
+}
+
+/* Public API Implementation */
+
+nes_rom_store_t* nes_rom_store_create(void) {
+    nes_rom_store_t* store = (nes_rom_store_t*)calloc(1, sizeof(nes_rom_store_t));
+    if (!store) {
+        return NULL;
+    }
+    if (nes_mutex_init(&store->lock) != 0) {
+        free(store);
+        return NULL;
+    }
+    store->refs = 1;
+    return store;
+}
+
+void nes_rom_store_destroy(nes_rom_store_t* store) {
+    if (store) {
+        rom_store_unref(store);
+    }
+}
+
+nes_rom_result_t nes_rom_store_load(nes_rom_store_t* store, nes_cartridge_t* cart, const char* filename) {
+    rom_store_file_t file;
+    memset(&file, 0, sizeof(file));
+    if (rom_store_open(&file, filename) != 0) {
+        return NES_ROM_ERROR_FILE_NOT_FOUND;
+    }
+
+    /* Same file already loaded: no need to map it again */
+    nes_mutex_lock(&store->lock);
+    nes_rom_entry_t* entry = rom_store_find_file(store, &file);
+    if (entry) {
+        entry->refs++;
+    }
+    nes_mutex_unlock(&store->lock);
+
+    if (!entry) {
+        nes_rom_entry_t* fresh = NULL;
+        nes_rom_result_t result = rom_store_open_entry(&file, &fresh);
+        if (result != NES_ROM_OK) {
+            rom_store_close(&file);
+            return result;
+        }
+
+        /* Another path to an image we hold (or another thread beat us) */
+        nes_mutex_lock(&store->lock);
+        entry = rom_store_find_image(store, fresh);
+        if (entry) {
+            entry->refs++;
+        } else {
+            fresh->store = store;
+            fresh->refs = 1;
+            fresh->next = store->entries;
+            store->entries = fresh;
+            store->count++;
+            store->refs++;
+            entry = fresh;
+            fresh = NULL;
+        }
+        nes_mutex_unlock(&store->lock);
+
+        if (fresh) {
+            rom_store_free_entry(fresh);
+        }
+    }
+    rom_store_close(&file);
+
+    /* The cartridge takes over the reference taken above */
+    nes_rom_result_t result = nes_cartridge_share(cart, &entry->image);
+    if (result == NES_ROM_OK) {
+        cart->rom_entry = entry;
+    } else {
+        nes_rom_store_release(entry);
+    }
+    return result;
+}
+
+size_t nes_rom_store_count(nes_rom_store_t* store) {
+    nes_mutex_lock(&store->lock);
+    size_t count = store->count;
+    nes_mutex_unlock(&store->lock);
+    return count;
+}
+
+void nes_rom_store_retain(nes_rom_entry_t* entry) {
+    nes_mutex_lock(&entry->store->lock);
+    entry->refs++;
+    nes_mutex_unlock(&entry->store->lock);
+}
+
+void nes_rom_store_release(nes_rom_entry_t* entry) {
+    nes_rom_store_t* store = entry->store;
+
+    nes_mutex_lock(&store->lock);
+    int refs = --entry->refs;
+    if (refs == 0) {
+        nes_rom_entry_t** link = &store->entries;
+        while (*link != entry) {
+            link = &(*link)->next;
+        }
+        *link = entry->next;
+        store->count--;
+    }
+    nes_mutex_unlock(&store->lock);
+
+    if (refs == 0) {
+        rom_store_free_entry(entry);
+        rom_store_unref(store);
+    }
+}
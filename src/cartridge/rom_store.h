@@ -0,0 +1,68 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Cartridge Module - Shared ROM Store
+ *
+ * Loads each ROM image once, no matter how many instances run it. The
+ * file is mapped read-only (read into memory where mapping fails) and
+ * every cartridge loaded through the store points its PRG/CHR-ROM into
+ * that one image. PRG-RAM and CHR-RAM stay private to each cartridge.
+ * Images are looked up by file identity first, then by CRC32 of their
+ * PRG/CHR-ROM, so copies of one ROM under different paths share one
+ * image. An image is unmapped when its last cartridge is freed.
+ *
+ * A mapped file must be replaced (written elsewhere, then renamed over),
+ * never rewritten in place while loaded: the read-only private mapping
+ * still shows in-place writes, so running cartridges would see them.
+ * A replaced file has a new identity and loads as a new image.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_ROM_STORE_H
+#define NESPRESSO_ROM_STORE_H
+
+#include "rom.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct nes_rom_store nes_rom_store_t;
+
+/**
+ * Create an empty store
+ * Returns NULL on failure
+ */
+nes_rom_store_t* nes_rom_store_create(void);
+
+/**
+ * Drop the caller's reference; the store itself lives on until every
+ * cartridge loaded through it has been freed
+ */
+void nes_rom_store_destroy(nes_rom_store_t* store);
+
+/**
+ * Load filename into cart, sharing its PRG/CHR-ROM with every other
+ * cartridge loaded from the same image. Safe to call from several threads.
+ */
+nes_rom_result_t nes_rom_store_load(nes_rom_store_t* store, nes_cartridge_t* cart, const char* filename);
+
+/**
+ * Number of distinct images currently held
+ */
+size_t nes_rom_store_count(nes_rom_store_t* store);
+
+/**
+ * Take / drop a reference on a stored image (used by nes_cartridge_share
+ * and nes_cartridge_free)
+ */
+void nes_rom_store_retain(nes_rom_entry_t* entry);
+void nes_rom_store_release(nes_rom_entry_t* entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_ROM_STORE_H */
@@ -9,8 +9,59 @@
  */
 
 #include "cpu.h"
+#include "../trace/trace.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+
+/* Interpreter core, chosen at build time (NESPRESSO_CPU_CORE):
+ *   NES_CPU_CORE_SWITCH - reference: one switch, generic addressing (default)
+ *   NES_CPU_CORE_TABLE  - one handler per opcode, called through a table
+ *   NES_CPU_CORE_GOTO   - the same handlers, direct-threaded with computed goto
+ *   NES_CPU_CORE_CACHED - PRG-ROM decoded once into blocks of micro-ops,
+ *                         everything else on the table handlers */
+/* Idle-loop fast-forward, tried on every taken backward jump (see cpu_idle_loop) */
+static void cpu_idle_loop(nes_cpu_t* cpu, uint16_t jump_pc);
+
+#define CPU_IDLE_JUMP(cpu, jump_pc)                                             \
+    do {                                                                        \
+        if ((cpu)->idle_skip && (cpu)->reg.pc <= (uint16_t)(jump_pc)) {         \
+            cpu_idle_loop((cpu), (uint16_t)(jump_pc));                          \
+        }                                                                       \
+    } while (0)
+
+/* Log the instruction at pc before it executes when a trace is attached */
+#if NES_TRACE_ENABLED
+static void cpu_trace(nes_cpu_t* cpu, uint16_t pc, uint8_t opcode) {
+    nes_trace_record_t record;
+    record.cycle = cpu->cycle_count;
+    record.addr = pc;
+    record.type = NES_TRACE_CPU;
+    record.value = opcode;
+    record.cpu.a = cpu->reg.a;
+    record.cpu.x = cpu->reg.x;
+    record.cpu.y = cpu->reg.y;
+    record.cpu.p = cpu->reg.p;
+    record.cpu.sp = cpu->reg.sp;
+    memset(record.cpu.reserved, 0, sizeof(record.cpu.reserved));
+    nes_trace_write(cpu->trace, &record);
+}
+#endif
+
+#define CPU_TRACE(cpu, pc, opcode) NES_TRACE(if ((cpu)->trace) cpu_trace((cpu), (pc), (opcode)))
+
+#if defined(NES_CPU_CORE_GOTO) && !defined(__GNUC__)
+#error "NES_CPU_CORE_GOTO needs computed goto (GCC or Clang)"
+#endif
+#if !defined(NES_CPU_CORE_TABLE) && !defined(NES_CPU_CORE_GOTO) && !defined(NES_CPU_CORE_CACHED)
+#ifndef NES_CPU_CORE_SWITCH
+#define NES_CPU_CORE_SWITCH
+#endif
+#elif defined(NES_CPU_CORE_CACHED)
+#include "cpu_block.h"
+#else
+#include "cpu_ops.h"
+#endif
 
 /* Opcode table with mnemonics, addressing modes, cycles, and lengths */
 static const opcode_info_t g_opcode_table[256] = {
@@ -287,23 +338,17 @@ static const opcode_info_t g_opcode_table[256] = {
     /* $FF */ {"??? ", MODE_IMPLIED, 2, 1},
 };
 
-/* Global bus pointer - static storage that persists beyond function calls */
-static cpu_bus_t g_cpu_bus_static = {NULL, NULL, NULL};
-
-/* Global bus pointer (accessed via extern declaration in header) */
-cpu_bus_t* g_bus = &g_cpu_bus_static;
+#ifdef NES_CPU_CORE_SWITCH
 
 /* Helper functions */
 
 static void read8(nes_cpu_t* cpu, uint16_t addr, uint8_t* out) {
-    (void)cpu;
-    *out = g_bus->read(g_bus->context, addr);
+    *out = nes_cpu_bus_read(cpu, addr);
 }
 
 static void read16(nes_cpu_t* cpu, uint16_t addr, uint16_t* out) {
-    (void)cpu;
-    *out = g_bus->read(g_bus->context, addr);
-    *out |= ((uint16_t)g_bus->read(g_bus->context, addr + 1)) << 8;
+    *out = nes_cpu_bus_read(cpu, addr);
+    *out |= ((uint16_t)nes_cpu_bus_read(cpu, addr + 1)) << 8;
 }
 
 /* Get effective address based on addressing mode */
@@ -313,15 +358,15 @@ static uint16_t get_effective_address(nes_cpu_t* cpu, addr_mode_t mode) {
             return cpu->reg.pc++;
 
         case MODE_ZERO_PAGE: {
-            return g_bus->read(g_bus->context, cpu->reg.pc++);
+            return nes_cpu_bus_read(cpu, cpu->reg.pc++);
         }
 
         case MODE_ZERO_PAGE_X: {
-            return (g_bus->read(g_bus->context, cpu->reg.pc++) + cpu->reg.x) & 0xFF;
+            return (nes_cpu_bus_read(cpu, cpu->reg.pc++) + cpu->reg.x) & 0xFF;
         }
 
         case MODE_ZERO_PAGE_Y: {
-            return (g_bus->read(g_bus->context, cpu->reg.pc++) + cpu->reg.y) & 0xFF;
+            return (nes_cpu_bus_read(cpu, cpu->reg.pc++) + cpu->reg.y) & 0xFF;
         }
 
         case MODE_ABSOLUTE: {
@@ -360,22 +405,22 @@ static uint16_t get_effective_address(nes_cpu_t* cpu, addr_mode_t mode) {
             read16(cpu, cpu->reg.pc, &ptr);
             cpu->reg.pc += 2;
             /* Indirect JMP bug: low byte high byte from same page */
-            uint16_t addr = g_bus->read(g_bus->context, ptr);
-            addr |= ((uint16_t)g_bus->read(g_bus->context, (ptr & 0xFF00) | ((ptr + 1) & 0xFF))) << 8;
+            uint16_t addr = nes_cpu_bus_read(cpu, ptr);
+            addr |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr & 0xFF00) | ((ptr + 1) & 0xFF))) << 8;
             return addr;
         }
 
         case MODE_INDEXED_INDIRECT: {  /* (Indirect,X) */
-            uint8_t ptr = (g_bus->read(g_bus->context, cpu->reg.pc++) + cpu->reg.x) & 0xFF;
-            uint16_t addr = g_bus->read(g_bus->context, ptr);
-            addr |= ((uint16_t)g_bus->read(g_bus->context, (ptr + 1) & 0xFF)) << 8;
+            uint8_t ptr = (nes_cpu_bus_read(cpu, cpu->reg.pc++) + cpu->reg.x) & 0xFF;
+            uint16_t addr = nes_cpu_bus_read(cpu, ptr);
+            addr |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr + 1) & 0xFF)) << 8;
             return addr;
         }
 
         case MODE_INDIRECT_INDEXED: {  /* (Indirect),Y */
-            uint8_t ptr = g_bus->read(g_bus->context, cpu->reg.pc++);
-            uint16_t base = g_bus->read(g_bus->context, ptr);
-            base |= ((uint16_t)g_bus->read(g_bus->context, (ptr + 1) & 0xFF)) << 8;
+            uint8_t ptr = nes_cpu_bus_read(cpu, cpu->reg.pc++);
+            uint16_t base = nes_cpu_bus_read(cpu, ptr);
+            base |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr + 1) & 0xFF)) << 8;
             uint16_t addr = base + cpu->reg.y;
             /* Page boundary penalty */
             if ((base & 0xFF00) != (addr & 0xFF00)) {
@@ -385,7 +430,7 @@ static uint16_t get_effective_address(nes_cpu_t* cpu, addr_mode_t mode) {
         }
 
         case MODE_RELATIVE: {
-            int8_t offset = (int8_t)g_bus->read(g_bus->context, cpu->reg.pc++);
+            int8_t offset = (int8_t)nes_cpu_bus_read(cpu, cpu->reg.pc++);
             return cpu->reg.pc + offset;
         }
 
@@ -400,10 +445,10 @@ static uint8_t load_byte(nes_cpu_t* cpu, addr_mode_t mode) {
         case MODE_ACCUMULATOR:
             return cpu->reg.a;
         case MODE_IMMEDIATE:
-            return g_bus->read(g_bus->context, cpu->reg.pc++);
+            return nes_cpu_bus_read(cpu, cpu->reg.pc++);
         default: {
             uint16_t addr = get_effective_address(cpu, mode);
-            return g_bus->read(g_bus->context, addr);
+            return nes_cpu_bus_read(cpu, addr);
         }
     }
 }
@@ -411,12 +456,12 @@ static uint8_t load_byte(nes_cpu_t* cpu, addr_mode_t mode) {
 /* Store a byte to memory based on addressing mode */
 static void store_byte(nes_cpu_t* cpu, addr_mode_t mode, uint8_t value) {
     uint16_t addr = get_effective_address(cpu, mode);
-    g_bus->write(g_bus->context, addr, value);
+    nes_cpu_bus_write(cpu, addr, value);
 }
 
 /* Branch instruction helper */
 static void do_branch(nes_cpu_t* cpu, int condition) {
-    int8_t offset = (int8_t)g_bus->read(g_bus->context, cpu->reg.pc++);
+    int8_t offset = (int8_t)nes_cpu_bus_read(cpu, cpu->reg.pc++);
     if (condition) {
         uint16_t old_pc = cpu->reg.pc;
         cpu->reg.pc += offset;
@@ -424,6 +469,7 @@ static void do_branch(nes_cpu_t* cpu, int condition) {
         if ((old_pc & 0xFF00) != (cpu->reg.pc & 0xFF00)) {
             cpu->stall_cycles = 1;
         }
+        CPU_IDLE_JUMP(cpu, old_pc - 2);
     }
 }
 
@@ -476,42 +522,11 @@ static uint8_t do_lsr_cpu(uint8_t value, uint8_t* carry_out) {
     return value >> 1;
 }
 
-/* Public API Implementation */
-
-void nes_cpu_init(nes_cpu_t* cpu, cpu_bus_t* bus) {
-    memset(cpu, 0, sizeof(nes_cpu_t));
-    cpu->opcode_table = g_opcode_table;
-    g_bus = bus;
-    if (bus) {
-        nes_cpu_reset(cpu);
-    }
-}
-
-void nes_cpu_reset(nes_cpu_t* cpu) {
-    printf("  nes_cpu_reset called, cpu=%p, g_bus=%p\n", (void*)cpu, (void*)g_bus);
-    cpu->reg.p = FLAG_UNUSED | FLAG_INTERRUPT;
-    cpu->reg.sp = 0xFD;
-    cpu->stall_cycles = 0;
-    cpu->cycle_count = 0;
-    cpu->pending_nmi = 0;
-    cpu->pending_irq = 0;
-
-    /* Read reset vector - only if bus is available */
-    if (g_bus && g_bus->read && g_bus->context) {
-        printf("    Reading reset vector from bus...\n");
-        uint16_t reset_addr = g_bus->read(g_bus->context, NES_VECTOR_RESET);
-        reset_addr |= ((uint16_t)g_bus->read(g_bus->context, NES_VECTOR_RESET + 1)) << 8;
-        cpu->reg.pc = reset_addr;
-        printf("    Reset vector: 0x%04X\n", reset_addr);
-    } else {
-        /* Default reset vector for when bus not available */
-        printf("    No bus available, using default PC=0x8000\n");
-        cpu->reg.pc = 0x8000;  /* Fall back to start of PRG-ROM */
-    }
-    printf("    CPU reset complete, PC=0x%04X\n", cpu->reg.pc);
-}
+#endif /* NES_CPU_CORE_SWITCH */
 
-uint8_t nes_cpu_step(nes_cpu_t* cpu) {
+/* Stall cycles and interrupts due before the next instruction
+ * Returns the cycles spent, 0 if an instruction should be fetched */
+static inline uint8_t cpu_service_pending(nes_cpu_t* cpu) {
     /* Handle any stall cycles from previous instruction */
     if (cpu->stall_cycles > 0) {
         cpu->stall_cycles--;
@@ -522,13 +537,15 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
     /* Check for interrupts */
     if (cpu->pending_nmi) {
         cpu->pending_nmi = 0;
+        cpu->idle_armed = 0;
+        NES_STAT(cpu->stats.nmis++);
         /* NMI takes 7 cycles */
         nes_cpu_push_word(cpu, cpu->reg.pc);
         uint8_t status = cpu->reg.p | FLAG_UNUSED;
         nes_cpu_push(cpu, status);
 
-        uint16_t nmi_addr = g_bus->read(g_bus->context, NES_VECTOR_NMI);
-        nmi_addr |= ((uint16_t)g_bus->read(g_bus->context, NES_VECTOR_NMI + 1)) << 8;
+        uint16_t nmi_addr = nes_cpu_bus_read(cpu, NES_VECTOR_NMI);
+        nmi_addr |= ((uint16_t)nes_cpu_bus_read(cpu, NES_VECTOR_NMI + 1)) << 8;
         cpu->reg.pc = nmi_addr;
 
         cpu->reg.p |= FLAG_INTERRUPT;
@@ -536,15 +553,17 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         return 7;
     }
 
+    /* The lines stay asserted until their sources release them */
     if (cpu->pending_irq && !nes_cpu_get_flag(cpu, FLAG_INTERRUPT)) {
-        cpu->pending_irq = 0;
+        cpu->idle_armed = 0;
+        NES_STAT(cpu->stats.irqs++);
         /* IRQ takes 7 cycles */
         nes_cpu_push_word(cpu, cpu->reg.pc);
         uint8_t status = cpu->reg.p | FLAG_UNUSED;
         nes_cpu_push(cpu, status);
 
-        uint16_t irq_addr = g_bus->read(g_bus->context, NES_VECTOR_IRQ_BRK);
-        irq_addr |= ((uint16_t)g_bus->read(g_bus->context, NES_VECTOR_IRQ_BRK + 1)) << 8;
+        uint16_t irq_addr = nes_cpu_bus_read(cpu, NES_VECTOR_IRQ_BRK);
+        irq_addr |= ((uint16_t)nes_cpu_bus_read(cpu, NES_VECTOR_IRQ_BRK + 1)) << 8;
         cpu->reg.pc = irq_addr;
 
         cpu->reg.p |= FLAG_INTERRUPT;
@@ -552,13 +571,426 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         return 7;
     }
 
+    return 0;
+}
+
+/* Account an executed instruction: base cycles plus any page-cross penalty */
+static inline uint8_t cpu_retire(nes_cpu_t* cpu, uint8_t cycles) {
+    uint8_t total_cycles = cycles + cpu->stall_cycles;
+    NES_STAT(cpu->stats.instructions++);
+    cpu->cycle_count += total_cycles;
+    cpu->stall_cycles = 0;
+    return total_cycles;
+}
+
+/* Idle-loop detection
+ *
+ * A loop such as "wait: LDA flag / BEQ wait" or "forever: JMP forever"
+ * cannot leave until an interrupt changes something. When one closes with a
+ * taken backward jump, one pass of its body is checked: straight-line code
+ * from the target to the jump, only reads of RAM/ROM (no bus handlers, so no
+ * side effects and nothing that could raise an interrupt), no writes, and
+ * every register or flag it reads is either left alone or redefined earlier
+ * in the pass. After one whole pass without an interrupt, every further
+ * pass starts from the same state and takes the jump again, so whole passes
+ * are skipped up to the end of the run and the last one executes normally. */
+
+#define CPU_IDLE_MAX_BYTES  32
+
+/* Registers and flags an instruction reads (uses) and writes (defs) */
+#define IDLE_A  0x01
+#define IDLE_X  0x02
+#define IDLE_Y  0x04
+#define IDLE_N  0x08
+#define IDLE_Z  0x10
+#define IDLE_C  0x20
+#define IDLE_V  0x40
+#define IDLE_NZ (IDLE_N | IDLE_Z)
+
+typedef struct {
+    uint8_t uses;
+    uint8_t defs;
+    uint8_t ok;         /* 1 = allowed in a loop body, 2 = closes a loop */
+} cpu_idle_op_t;
+
+#define IDLE_OP(uses, defs)   { (uses), (defs), 1 }
+#define IDLE_CLOSE(uses)      { (uses), 0, 2 }
+
+static const cpu_idle_op_t g_cpu_idle_ops[256] = {
+    /* Loads */
+    [0xA9] = IDLE_OP(0, IDLE_A | IDLE_NZ), [0xA5] = IDLE_OP(0, IDLE_A | IDLE_NZ),
+    [0xB5] = IDLE_OP(0, IDLE_A | IDLE_NZ), [0xAD] = IDLE_OP(0, IDLE_A | IDLE_NZ),
+    [0xBD] = IDLE_OP(0, IDLE_A | IDLE_NZ), [0xB9] = IDLE_OP(0, IDLE_A | IDLE_NZ),
+    [0xA2] = IDLE_OP(0, IDLE_X | IDLE_NZ), [0xA6] = IDLE_OP(0, IDLE_X | IDLE_NZ),
+    [0xB6] = IDLE_OP(0, IDLE_X | IDLE_NZ), [0xAE] = IDLE_OP(0, IDLE_X | IDLE_NZ),
+    [0xBE] = IDLE_OP(0, IDLE_X | IDLE_NZ),
+    [0xA0] = IDLE_OP(0, IDLE_Y | IDLE_NZ), [0xA4] = IDLE_OP(0, IDLE_Y | IDLE_NZ),
+    [0xB4] = IDLE_OP(0, IDLE_Y | IDLE_NZ), [0xAC] = IDLE_OP(0, IDLE_Y | IDLE_NZ),
+    [0xBC] = IDLE_OP(0, IDLE_Y | IDLE_NZ),
+
+    /* Compares and BIT */
+    [0xC9] = IDLE_OP(IDLE_A, IDLE_NZ | IDLE_C), [0xC5] = IDLE_OP(IDLE_A, IDLE_NZ | IDLE_C),
+    [0xD5] = IDLE_OP(IDLE_A, IDLE_NZ | IDLE_C), [0xCD] = IDLE_OP(IDLE_A, IDLE_NZ | IDLE_C),
+    [0xDD] = IDLE_OP(IDLE_A, IDLE_NZ | IDLE_C), [0xD9] = IDLE_OP(IDLE_A, IDLE_NZ | IDLE_C),
+    [0xE0] = IDLE_OP(IDLE_X, IDLE_NZ | IDLE_C), [0xE4] = IDLE_OP(IDLE_X, IDLE_NZ | IDLE_C),
+    [0xEC] = IDLE_OP(IDLE_X, IDLE_NZ | IDLE_C),
+    [0xC0] = IDLE_OP(IDLE_Y, IDLE_NZ | IDLE_C), [0xC4] = IDLE_OP(IDLE_Y, IDLE_NZ | IDLE_C),
+    [0xCC] = IDLE_OP(IDLE_Y, IDLE_NZ | IDLE_C),
+    [0x24] = IDLE_OP(IDLE_A, IDLE_NZ | IDLE_V), [0x2C] = IDLE_OP(IDLE_A, IDLE_NZ | IDLE_V),
+
+    /* Logic on A */
+    [0x29] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x25] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x35] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x2D] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x3D] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x39] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x09] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x05] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x15] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x0D] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x1D] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x19] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x49] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x45] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x55] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x4D] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x5D] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ), [0x59] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ),
+    [0x0A] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ | IDLE_C),
+    [0x4A] = IDLE_OP(IDLE_A, IDLE_A | IDLE_NZ | IDLE_C),
+    [0x2A] = IDLE_OP(IDLE_A | IDLE_C, IDLE_A | IDLE_NZ | IDLE_C),
+    [0x6A] = IDLE_OP(IDLE_A | IDLE_C, IDLE_A | IDLE_NZ | IDLE_C),
+
+    /* Transfers, flags, NOP */
+    [0xAA] = IDLE_OP(IDLE_A, IDLE_X | IDLE_NZ), [0xA8] = IDLE_OP(IDLE_A, IDLE_Y | IDLE_NZ),
+    [0x8A] = IDLE_OP(IDLE_X, IDLE_A | IDLE_NZ), [0x98] = IDLE_OP(IDLE_Y, IDLE_A | IDLE_NZ),
+    [0x18] = IDLE_OP(0, IDLE_C), [0x38] = IDLE_OP(0, IDLE_C), [0xB8] = IDLE_OP(0, IDLE_V),
+    [0xEA] = IDLE_OP(0, 0),
+
+    /* Loop closers */
+    [0x10] = IDLE_CLOSE(IDLE_N), [0x30] = IDLE_CLOSE(IDLE_N),
+    [0x50] = IDLE_CLOSE(IDLE_V), [0x70] = IDLE_CLOSE(IDLE_V),
+    [0x90] = IDLE_CLOSE(IDLE_C), [0xB0] = IDLE_CLOSE(IDLE_C),
+    [0xD0] = IDLE_CLOSE(IDLE_Z), [0xF0] = IDLE_CLOSE(IDLE_Z),
+    [0x4C] = IDLE_CLOSE(0),
+};
+
+/* Side-effect-free read through the page table; -1 if addr needs a bus handler */
+static int cpu_idle_peek(const nes_cpu_t* cpu, uint16_t addr) {
+    const uint8_t* page = cpu->bus.read_map[addr >> 8];
+    return page ? page[addr & 0xFF] : -1;
+}
+
+/* Cycles one pass of the loop at pc..jump_pc takes, 0 if it is not idle */
+static uint32_t cpu_idle_period(const nes_cpu_t* cpu, uint16_t pc, uint16_t jump_pc) {
+    uint16_t start = pc;
+    uint8_t defined = 0, all_defs = 0, indexes = 0;
+    uint8_t early_uses = 0;    /* Read before this pass defined them */
+    uint32_t period = 0;
+
+    for (;;) {
+        int opcode = cpu_idle_peek(cpu, pc);
+        if (opcode < 0) {
+            return 0;
+        }
+        const cpu_idle_op_t* idle = &g_cpu_idle_ops[opcode];
+        const opcode_info_t* info = &cpu->opcode_table[opcode];
+        if (!idle->ok || (idle->ok == 2) != (pc == jump_pc)) {
+            return 0;
+        }
+
+        uint32_t length = 2;
+        if (info->mode == MODE_IMPLIED || info->mode == MODE_ACCUMULATOR) {
+            length = 1;
+        } else if (info->mode == MODE_ABSOLUTE || info->mode == MODE_ABSOLUTE_X ||
+                   info->mode == MODE_ABSOLUTE_Y) {
+            length = 3;
+        }
+        if ((uint32_t)pc + length > 0x10000) {
+            return 0;
+        }
+        int lo = length > 1 ? cpu_idle_peek(cpu, (uint16_t)(pc + 1)) : 0;
+        int hi = length > 2 ? cpu_idle_peek(cpu, (uint16_t)(pc + 2)) : 0;
+        if (lo < 0 || hi < 0) {
+            return 0;
+        }
+
+        /* Memory operand: must be plain RAM/ROM, at a loop-invariant address */
+        uint16_t base = (uint16_t)(lo | (hi << 8));
+        int addr = -1;
+        switch (idle->ok == 1 ? info->mode : MODE_IMPLIED) {
+            case MODE_ZERO_PAGE:   addr = lo; break;
+            case MODE_ZERO_PAGE_X: addr = (lo + cpu->reg.x) & 0xFF; indexes |= IDLE_X; break;
+            case MODE_ZERO_PAGE_Y: addr = (lo + cpu->reg.y) & 0xFF; indexes |= IDLE_Y; break;
+            case MODE_ABSOLUTE:    addr = base; break;
+            case MODE_ABSOLUTE_X:  addr = (uint16_t)(base + cpu->reg.x); indexes |= IDLE_X; break;
+            case MODE_ABSOLUTE_Y:  addr = (uint16_t)(base + cpu->reg.y); indexes |= IDLE_Y; break;
+            default: break;
+        }
+        if ((info->mode == MODE_ABSOLUTE_X || info->mode == MODE_ABSOLUTE_Y) &&
+            (base & 0xFF00) != (addr & 0xFF00)) {
+            period++;   /* Page boundary penalty, the same every pass */
+        }
+        if (addr >= 0 && cpu_idle_peek(cpu, (uint16_t)addr) < 0) {
+            return 0;
+        }
+
+        early_uses |= idle->uses & ~defined;
+        defined |= idle->defs;
+        all_defs |= idle->defs;
+        period += info->cycles;
+
+        if (pc == jump_pc) {
+            if (info->mode == MODE_RELATIVE && (start & 0xFF00) != ((pc + 2) & 0xFF00)) {
+                period++;   /* Branch into the previous page */
+            }
+            break;
+        }
+        if ((uint32_t)pc + length > jump_pc) {
+            return 0;   /* Stepped over the closing jump */
+        }
+        pc = (uint16_t)(pc + length);
+    }
+
+    /* Loop-carried state (read, then changed) or a moving index: not idle */
+    if ((early_uses | indexes) & all_defs) {
+        return 0;
+    }
+    return period;
+}
+
+/* Called from a taken backward jump at jump_pc, PC already at the target */
+static void cpu_idle_loop(nes_cpu_t* cpu, uint16_t jump_pc) {
+    uint16_t loop_pc = cpu->reg.pc;
+    if (!cpu->in_run || !cpu->bus.read_map || jump_pc - loop_pc > CPU_IDLE_MAX_BYTES) {
+        return;
+    }
+    /* An interrupt is taken right after this jump */
+    if (cpu->pending_nmi || (cpu->pending_irq && !(cpu->reg.p & FLAG_INTERRUPT))) {
+        return;
+    }
+
+    /* The pass that just ended may have been cut by an interrupt (the load
+     * before it read memory the handler then changed); wait for one whole pass */
+    if (!cpu->idle_armed || cpu->idle_jump != jump_pc) {
+        cpu->idle_jump = jump_pc;
+        cpu->idle_armed = 1;
+        return;
+    }
+
+    const uint8_t* page = cpu->bus.read_map[jump_pc >> 8];
+    unsigned slot = jump_pc & (NES_CPU_IDLE_REJECTS - 1);
+    if (!page || (cpu->idle_reject[slot] == jump_pc && cpu->idle_reject_page[slot] == page)) {
+        return;
+    }
+
+    uint32_t period = cpu_idle_period(cpu, loop_pc, jump_pc);
+    if (period == 0) {
+        cpu->idle_reject[slot] = jump_pc;
+        cpu->idle_reject_page[slot] = page;
+        return;
+    }
+
+    /* The jump itself retires after this; stop a partial pass short of the target */
+    uint32_t now = cpu->cycle_count + cpu->opcode_table[page[jump_pc & 0xFF]].cycles + cpu->stall_cycles;
+    int32_t remaining = (int32_t)(cpu->run_target - now);
+    if (remaining <= (int32_t)period) {
+        return;
+    }
+    uint32_t skipped = ((uint32_t)remaining - 1) / period * period;
+    cpu->cycle_count += skipped;
+    NES_STAT(cpu->stats.idle_cycles += skipped);
+}
+
+#if defined(NES_CPU_CORE_TABLE) || defined(NES_CPU_CORE_CACHED)
+
+typedef void (*cpu_handler_t)(nes_cpu_t* cpu);
+
+#define CPU_HANDLER(op, kind, fn, mode) \
+    static void cpu_handler_##op(nes_cpu_t* cpu) { CPU_BODY_##kind(fn, mode) }
+NES_CPU_OPCODES(CPU_HANDLER)
+#undef CPU_HANDLER
+
+#define CPU_HANDLER_ENTRY(op, kind, fn, mode) [0x##op] = cpu_handler_##op,
+static const cpu_handler_t g_cpu_handlers[256] = {
+    NES_CPU_OPCODES(CPU_HANDLER_ENTRY)
+};
+#undef CPU_HANDLER_ENTRY
+
+#endif
+
+#if defined(NES_CPU_CORE_CACHED)
+
+uint8_t nes_cpu_step(nes_cpu_t* cpu);
+
+/* Run instructions until cycle_count reaches cpu->run_target
+ * Interrupts, stalls and the run target are checked between every two
+ * micro-ops exactly as between interpreted instructions, so bus events
+ * land on the same cycles as with the other cores */
+static void cpu_run_cached(nes_cpu_t* cpu) {
+    if (!cpu->block_cache) {
+        cpu->block_cache = (struct nes_cpu_block_cache*)calloc(1, sizeof(struct nes_cpu_block_cache));
+    }
+
+    while ((int32_t)(cpu->run_target - cpu->cycle_count) > 0) {
+        if ((cpu->stall_cycles | cpu->pending_nmi | cpu->pending_irq) && cpu_service_pending(cpu)) {
+            continue;
+        }
+
+#if NES_TRACE_ENABLED
+        /* Traced instructions are logged one by one by nes_cpu_step */
+        const cpu_block_t* block = cpu->trace ? NULL : cpu_block_lookup(cpu, cpu->reg.pc);
+#else
+        const cpu_block_t* block = cpu_block_lookup(cpu, cpu->reg.pc);
+#endif
+        if (!block) {
+            nes_cpu_step(cpu);
+            continue;
+        }
+
+        const cpu_uop_t* op = block->ops;
+        const cpu_uop_t* end = op + block->count;
+        for (;;) {
+            NES_STAT(cpu->stats.reads[(uint16_t)(op->next_pc - op->length) >> 13] += op->length);
+            cpu->reg.pc = op->next_pc;
+            op->fn(cpu, op);
+            cpu_retire(cpu, op->cycles);
+
+            if (op->store && !cpu_block_mapped(cpu, block)) {
+                break;
+            }
+            if (++op == end || (int32_t)(cpu->run_target - cpu->cycle_count) <= 0) {
+                break;
+            }
+            if (cpu->stall_cycles | cpu->pending_nmi |
+                (cpu->pending_irq && !(cpu->reg.p & FLAG_INTERRUPT))) {
+                break;
+            }
+        }
+    }
+}
+
+#elif defined(NES_CPU_CORE_GOTO)
+
+/* Run instructions until cycle_count reaches cpu->run_target
+ * Every handler ends in its own copy of the dispatch, so each indirect
+ * jump is predicted from the opcode that precedes it */
+static void cpu_run_threaded(nes_cpu_t* cpu) {
+#define CPU_LABEL_ENTRY(op, kind, fn, mode) [0x##op] = &&op_##op,
+    static const void* const dispatch[256] = {
+        NES_CPU_OPCODES(CPU_LABEL_ENTRY)
+    };
+#undef CPU_LABEL_ENTRY
+
+    uint8_t opcode;
+
+#define CPU_NEXT()                                                              \
+    do {                                                                        \
+        if ((int32_t)(cpu->run_target - cpu->cycle_count) <= 0) {               \
+            return;                                                             \
+        }                                                                       \
+        if (cpu->stall_cycles | cpu->pending_nmi | cpu->pending_irq) {          \
+            goto pending;                                                       \
+        }                                                                       \
+        opcode = nes_cpu_bus_read(cpu, cpu->reg.pc++);                          \
+        CPU_TRACE(cpu, cpu->reg.pc - 1, opcode);                                \
+        goto *dispatch[opcode];                                                 \
+    } while (0)
+
+    CPU_NEXT();
+
+pending:
+    if (cpu_service_pending(cpu)) {
+        CPU_NEXT();
+    }
+    /* IRQ masked - execute normally */
+    opcode = nes_cpu_bus_read(cpu, cpu->reg.pc++);
+    CPU_TRACE(cpu, cpu->reg.pc - 1, opcode);
+    goto *dispatch[opcode];
+
+#define CPU_LABEL(op, kind, fn, mode) \
+op_##op:                                                                        \
+    CPU_BODY_##kind(fn, mode)                                                   \
+    cpu_retire(cpu, g_opcode_table[0x##op].cycles);                             \
+    CPU_NEXT();
+    NES_CPU_OPCODES(CPU_LABEL)
+#undef CPU_LABEL
+#undef CPU_NEXT
+}
+
+#endif
+
+/* Forget every decoded block (cached core only) */
+static void cpu_flush_blocks(nes_cpu_t* cpu) {
+#if defined(NES_CPU_CORE_CACHED)
+    if (cpu->block_cache) {
+        memset(cpu->block_cache, 0, sizeof(*cpu->block_cache));
+    }
+#else
+    (void)cpu;
+#endif
+}
+
+/* Public API Implementation */
+
+void nes_cpu_init(nes_cpu_t* cpu, cpu_bus_t* bus) {
+    memset(cpu, 0, sizeof(nes_cpu_t));
+    cpu->opcode_table = g_opcode_table;
+    cpu->idle_skip = 1;
+    if (bus) {
+        cpu->bus = *bus;
+        nes_cpu_reset(cpu);
+    }
+}
+
+void nes_cpu_free(nes_cpu_t* cpu) {
+    free(cpu->block_cache);
+    cpu->block_cache = NULL;
+}
+
+void nes_cpu_reset(nes_cpu_t* cpu) {
+    printf("  nes_cpu_reset called, cpu=%p\n", (void*)cpu);
+    /* Blocks and rejected loops point into the cartridge image, which may have changed */
+    cpu_flush_blocks(cpu);
+    memset(cpu->idle_reject_page, 0, sizeof(cpu->idle_reject_page));
+    cpu->idle_armed = 0;
+    cpu->reg.p = FLAG_UNUSED | FLAG_INTERRUPT;
+    cpu->reg.sp = 0xFD;
+    cpu->stall_cycles = 0;
+    cpu->cycle_count = 0;
+    cpu->pending_nmi = 0;
+    cpu->pending_irq = 0;
+
+    /* Read reset vector - only if bus is available */
+    if (cpu->bus.read && cpu->bus.context) {
+        printf("    Reading reset vector from bus...\n");
+        uint16_t reset_addr = nes_cpu_bus_read(cpu, NES_VECTOR_RESET);
+        reset_addr |= ((uint16_t)nes_cpu_bus_read(cpu, NES_VECTOR_RESET + 1)) << 8;
+        cpu->reg.pc = reset_addr;
+        printf("    Reset vector: 0x%04X\n", reset_addr);
+    } else {
+        /* Default reset vector for when bus not available */
+        printf("    No bus available, using default PC=0x8000\n");
+        cpu->reg.pc = 0x8000;  /* Fall back to start of PRG-ROM */
+    }
+    printf("    CPU reset complete, PC=0x%04X\n", cpu->reg.pc);
+}
+
+uint8_t nes_cpu_step(nes_cpu_t* cpu) {
+#if defined(NES_CPU_CORE_GOTO)
+    uint32_t start = cpu->cycle_count;
+    cpu->run_target = start + 1;
+    cpu_run_threaded(cpu);
+    return (uint8_t)(cpu->cycle_count - start);
+#else
+    uint8_t spent = cpu_service_pending(cpu);
+    if (spent) {
+        return spent;
+    }
+
     /* Fetch opcode */
-    uint8_t opcode = g_bus->read(g_bus->context, cpu->reg.pc);
+    uint8_t opcode = nes_cpu_bus_read(cpu, cpu->reg.pc);
     const opcode_info_t* info = &g_opcode_table[opcode];
+    CPU_TRACE(cpu, cpu->reg.pc, opcode);
     cpu->reg.pc++;
 
     uint8_t cycles = info->cycles;
 
+#if defined(NES_CPU_CORE_TABLE) || defined(NES_CPU_CORE_CACHED)
+    g_cpu_handlers[opcode](cpu);
+#else
     /* Execute instruction */
     switch (opcode) {
         /* ADC - Add with Carry */
@@ -584,10 +1016,10 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         }
         case 0x06: case 0x16: case 0x0E: case 0x1E: {
             uint16_t addr = get_effective_address(cpu, info->mode);
-            uint8_t val = g_bus->read(g_bus->context, addr);
+            uint8_t val = nes_cpu_bus_read(cpu, addr);
             uint8_t carry;
             val = do_asl_cpu(val, &carry);
-            g_bus->write(g_bus->context, addr, val);
+            nes_cpu_bus_write(cpu, addr, val);
             nes_cpu_set_flag(cpu, FLAG_CARRY, carry);
             nes_cpu_update_zn(cpu, val);
             break;
@@ -639,8 +1071,8 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
             nes_cpu_push_word(cpu, cpu->reg.pc);
             uint8_t status = cpu->reg.p | FLAG_BREAK | FLAG_UNUSED;
             nes_cpu_push(cpu, status);
-            uint16_t brk_addr = g_bus->read(g_bus->context, NES_VECTOR_IRQ_BRK);
-            brk_addr |= ((uint16_t)g_bus->read(g_bus->context, NES_VECTOR_IRQ_BRK + 1)) << 8;
+            uint16_t brk_addr = nes_cpu_bus_read(cpu, NES_VECTOR_IRQ_BRK);
+            brk_addr |= ((uint16_t)nes_cpu_bus_read(cpu, NES_VECTOR_IRQ_BRK + 1)) << 8;
             cpu->reg.pc = brk_addr;
             cpu->reg.p |= FLAG_INTERRUPT;
             break;
@@ -694,8 +1126,8 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         /* DEC - Decrement Memory */
         case 0xC6: case 0xD6: case 0xCE: case 0xDE: {
             uint16_t addr = get_effective_address(cpu, info->mode);
-            uint8_t val = (g_bus->read(g_bus->context, addr) - 1) & 0xFF;
-            g_bus->write(g_bus->context, addr, val);
+            uint8_t val = (nes_cpu_bus_read(cpu, addr) - 1) & 0xFF;
+            nes_cpu_bus_write(cpu, addr, val);
             nes_cpu_update_zn(cpu, val);
             break;
         }
@@ -722,8 +1154,8 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         /* INC - Increment Memory */
         case 0xE6: case 0xF6: case 0xEE: case 0xFE: {
             uint16_t addr = get_effective_address(cpu, info->mode);
-            uint8_t val = (g_bus->read(g_bus->context, addr) + 1) & 0xFF;
-            g_bus->write(g_bus->context, addr, val);
+            uint8_t val = (nes_cpu_bus_read(cpu, addr) + 1) & 0xFF;
+            nes_cpu_bus_write(cpu, addr, val);
             nes_cpu_update_zn(cpu, val);
             break;
         }
@@ -743,7 +1175,9 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         /* JMP - Jump */
         case 0x4C: {
             uint16_t addr = get_effective_address(cpu, MODE_ABSOLUTE);
+            uint16_t jump_pc = cpu->reg.pc - 3;
             cpu->reg.pc = addr;
+            CPU_IDLE_JUMP(cpu, jump_pc);
             break;
         }
         case 0x6C: {
@@ -790,10 +1224,10 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         }
         case 0x46: case 0x56: case 0x4E: case 0x5E: {
             uint16_t addr = get_effective_address(cpu, info->mode);
-            uint8_t val = g_bus->read(g_bus->context, addr);
+            uint8_t val = nes_cpu_bus_read(cpu, addr);
             uint8_t carry;
             val = do_lsr_cpu(val, &carry);
-            g_bus->write(g_bus->context, addr, val);
+            nes_cpu_bus_write(cpu, addr, val);
             nes_cpu_set_flag(cpu, FLAG_CARRY, carry);
             nes_cpu_update_zn(cpu, val);
             break;
@@ -844,11 +1278,11 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         }
         case 0x26: case 0x36: case 0x2E: case 0x3E: {
             uint16_t addr = get_effective_address(cpu, info->mode);
-            uint8_t val = g_bus->read(g_bus->context, addr);
+            uint8_t val = nes_cpu_bus_read(cpu, addr);
             uint8_t carry_in = nes_cpu_get_flag(cpu, FLAG_CARRY);
             uint8_t carry_out;
             val = do_rol(val, carry_in, &carry_out);
-            g_bus->write(g_bus->context, addr, val);
+            nes_cpu_bus_write(cpu, addr, val);
             nes_cpu_set_flag(cpu, FLAG_CARRY, carry_out);
             nes_cpu_update_zn(cpu, val);
             break;
@@ -865,11 +1299,11 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
         }
         case 0x66: case 0x76: case 0x6E: case 0x7E: {
             uint16_t addr = get_effective_address(cpu, info->mode);
-            uint8_t val = g_bus->read(g_bus->context, addr);
+            uint8_t val = nes_cpu_bus_read(cpu, addr);
             uint8_t carry_in = nes_cpu_get_flag(cpu, FLAG_CARRY);
             uint8_t carry_out;
             val = do_ror(val, carry_in, &carry_out);
-            g_bus->write(g_bus->context, addr, val);
+            nes_cpu_bus_write(cpu, addr, val);
             nes_cpu_set_flag(cpu, FLAG_CARRY, carry_out);
             nes_cpu_update_zn(cpu, val);
             break;
@@ -969,42 +1403,71 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu) {
             /* Most unofficial opcodes behave as NOP or have unstable behavior */
             break;
     }
+#endif
 
-    cpu->cycle_count += cycles + cpu->stall_cycles;
-    uint8_t total_cycles = cycles + cpu->stall_cycles;
-    cpu->stall_cycles = 0;
-    return total_cycles;
+    return cpu_retire(cpu, cycles);
+#endif
 }
 
 void nes_cpu_execute_cycles(nes_cpu_t* cpu, uint32_t cycles) {
-    uint32_t executed = 0;
-    while (executed < cycles) {
-        executed += nes_cpu_step(cpu);
+    nes_cpu_run_until(cpu, cpu->cycle_count + cycles);
+}
+
+void nes_cpu_run_until(nes_cpu_t* cpu, uint32_t target_cycle) {
+    cpu->run_target = target_cycle;
+    cpu->in_run = 1;
+#if defined(NES_CPU_CORE_GOTO)
+    cpu_run_threaded(cpu);
+#elif defined(NES_CPU_CORE_CACHED)
+    cpu_run_cached(cpu);
+#else
+    while ((int32_t)(cpu->run_target - cpu->cycle_count) > 0) {
+        nes_cpu_step(cpu);
+    }
+#endif
+    cpu->in_run = 0;
+}
+
+void nes_cpu_stop_at(nes_cpu_t* cpu, uint32_t target_cycle) {
+    if ((int32_t)(target_cycle - cpu->run_target) < 0) {
+        cpu->run_target = target_cycle;
     }
 }
 
+void nes_cpu_set_idle_skip(nes_cpu_t* cpu, int enable) {
+    cpu->idle_skip = enable ? 1 : 0;
+}
+
+void nes_cpu_stall(nes_cpu_t* cpu, uint32_t cycles) {
+    cpu->cycle_count += cycles;
+}
+
 void nes_cpu_trigger_nmi(nes_cpu_t* cpu) {
     cpu->pending_nmi = 1;
 }
 
-void nes_cpu_trigger_irq(nes_cpu_t* cpu) {
-    cpu->pending_irq = 1;
+void nes_cpu_set_irq(nes_cpu_t* cpu, uint8_t line) {
+    cpu->pending_irq |= line;
+}
+
+void nes_cpu_clear_irq(nes_cpu_t* cpu, uint8_t line) {
+    cpu->pending_irq &= (uint8_t)~line;
 }
 
 void nes_cpu_set_bus(nes_cpu_t* cpu, cpu_bus_t* bus) {
-    /* Copy bus configuration to static storage */
+    /* Copy bus configuration into the instance - caller's struct may be on the stack */
     if (bus) {
-        g_cpu_bus_static.context = bus->context;
-        g_cpu_bus_static.read = bus->read;
-        g_cpu_bus_static.write = bus->write;
+        cpu->bus = *bus;
     }
-    g_bus = &g_cpu_bus_static;
-    (void)cpu;  /* unused */
+    cpu_flush_blocks(cpu);
+}
+
+const opcode_info_t* nes_cpu_opcode_info(uint8_t opcode) {
+    return &g_opcode_table[opcode];
 }
 
 void nes_cpu_disassemble(nes_cpu_t* cpu, uint16_t addr, char* buffer, size_t buffer_size) {
-    (void)cpu;  /* unused */
-    uint8_t opcode = g_bus->read(g_bus->context, addr);
+    uint8_t opcode = nes_cpu_bus_read(cpu, addr);
     const opcode_info_t* info = &g_opcode_table[opcode];
 
     int len = snprintf(buffer, buffer_size, "$%04X: %s ", addr, info->mnemonic);
@@ -1015,53 +1478,53 @@ void nes_cpu_disassemble(nes_cpu_t* cpu, uint16_t addr, char* buffer, size_t buf
             snprintf(buffer + len, buffer_size - len, "A");
             break;
         case MODE_IMMEDIATE:
-            snprintf(buffer + len, buffer_size - len, "#$%02X", g_bus->read(g_bus->context, addr + 1));
+            snprintf(buffer + len, buffer_size - len, "#$%02X", nes_cpu_bus_read(cpu, addr + 1));
             break;
         case MODE_ZERO_PAGE:
-            snprintf(buffer + len, buffer_size - len, "$%02X", g_bus->read(g_bus->context, addr + 1));
+            snprintf(buffer + len, buffer_size - len, "$%02X", nes_cpu_bus_read(cpu, addr + 1));
             break;
         case MODE_ZERO_PAGE_X:
-            snprintf(buffer + len, buffer_size - len, "$%02X,X", g_bus->read(g_bus->context, addr + 1));
+            snprintf(buffer + len, buffer_size - len, "$%02X,X", nes_cpu_bus_read(cpu, addr + 1));
             break;
         case MODE_ZERO_PAGE_Y:
-            snprintf(buffer + len, buffer_size - len, "$%02X,Y", g_bus->read(g_bus->context, addr + 1));
+            snprintf(buffer + len, buffer_size - len, "$%02X,Y", nes_cpu_bus_read(cpu, addr + 1));
             break;
         case MODE_ABSOLUTE: {
-            uint16_t addr16 = g_bus->read(g_bus->context, addr + 1);
-            addr16 |= (uint16_t)g_bus->read(g_bus->context, addr + 2) << 8;
+            uint16_t addr16 = nes_cpu_bus_read(cpu, addr + 1);
+            addr16 |= (uint16_t)nes_cpu_bus_read(cpu, addr + 2) << 8;
             snprintf(buffer + len, buffer_size - len, "$%04X", addr16);
             break;
         }
         case MODE_ABSOLUTE_X: {
-            uint16_t addr16 = g_bus->read(g_bus->context, addr + 1);
-            addr16 |= (uint16_t)g_bus->read(g_bus->context, addr + 2) << 8;
+            uint16_t addr16 = nes_cpu_bus_read(cpu, addr + 1);
+            addr16 |= (uint16_t)nes_cpu_bus_read(cpu, addr + 2) << 8;
             snprintf(buffer + len, buffer_size - len, "$%04X,X", addr16);
             break;
         }
         case MODE_ABSOLUTE_Y: {
-            uint16_t addr16 = g_bus->read(g_bus->context, addr + 1);
-            addr16 |= (uint16_t)g_bus->read(g_bus->context, addr + 2) << 8;
+            uint16_t addr16 = nes_cpu_bus_read(cpu, addr + 1);
+            addr16 |= (uint16_t)nes_cpu_bus_read(cpu, addr + 2) << 8;
             snprintf(buffer + len, buffer_size - len, "$%04X,Y", addr16);
             break;
         }
         case MODE_INDIRECT: {
-            uint16_t addr16 = g_bus->read(g_bus->context, addr + 1);
-            addr16 |= (uint16_t)g_bus->read(g_bus->context, addr + 2) << 8;
+            uint16_t addr16 = nes_cpu_bus_read(cpu, addr + 1);
+            addr16 |= (uint16_t)nes_cpu_bus_read(cpu, addr + 2) << 8;
             snprintf(buffer + len, buffer_size - len, "($%04X)", addr16);
             break;
         }
         case MODE_INDEXED_INDIRECT: {
-            uint16_t ptr = g_bus->read(g_bus->context, addr + 1);
+            uint16_t ptr = nes_cpu_bus_read(cpu, addr + 1);
             snprintf(buffer + len, buffer_size - len, "($%02X,X)", ptr);
             break;
         }
         case MODE_INDIRECT_INDEXED: {
-            uint16_t ptr = g_bus->read(g_bus->context, addr + 1);
+            uint16_t ptr = nes_cpu_bus_read(cpu, addr + 1);
             snprintf(buffer + len, buffer_size - len, "($%02X),Y", ptr);
             break;
         }
         case MODE_RELATIVE: {
-            int8_t offset = (int8_t)g_bus->read(g_bus->context, addr + 1);
+            int8_t offset = (int8_t)nes_cpu_bus_read(cpu, addr + 1);
             snprintf(buffer + len, buffer_size - len, "$%04X", (uint16_t)(addr + 2 + offset));
             break;
         }
@@ -11,6 +11,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include "../util/stats.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -71,16 +72,6 @@ typedef struct {
     uint8_t       length;
 } opcode_info_t;
 
-/* CPU State */
-typedef struct nes_cpu {
-    cpu_registers_t  reg;
-    uint32_t         cycle_count;
-    uint8_t          pending_nmi;
-    uint8_t          pending_irq;
-    uint8_t          stall_cycles;
-    const opcode_info_t* opcode_table;
-} nes_cpu_t;
-
 /* Memory Read/Write Callback Types */
 typedef uint8_t (*cpu_read_func)(void* ctx, uint16_t addr);
 typedef void  (*cpu_write_func)(void* ctx, uint16_t addr, uint8_t val);
@@ -89,8 +80,58 @@ typedef struct {
     void*           context;
     cpu_read_func   read;
     cpu_write_func  write;
+
+    /* Optional 256-byte page tables (NULL entry or table = use read/write) */
+    const uint8_t* const* read_map;
+    uint8_t* const*       write_map;
 } cpu_bus_t;
 
+/* Performance counters (NES_ENABLE_STATS builds only) */
+#define NES_CPU_STATS_BLOCKS 8     /* Bus accesses per 8KB block of the address space */
+
+typedef struct {
+    uint64_t instructions;
+    uint64_t nmis;
+    uint64_t irqs;
+    uint64_t reads[NES_CPU_STATS_BLOCKS];
+    uint64_t writes[NES_CPU_STATS_BLOCKS];
+    uint64_t idle_cycles;          /* Cycles fast-forwarded through idle loops */
+} nes_cpu_stats_t;
+
+#define NES_CPU_IDLE_REJECTS 4     /* Remembered loops that cannot be skipped */
+
+/* Decoded-block cache of the cached core (see cpu_block.h) */
+struct nes_cpu_block_cache;
+
+/* Event log the CPU records instructions into (see trace/trace.h) */
+struct nes_trace;
+
+/* CPU State */
+typedef struct nes_cpu {
+    cpu_registers_t  reg;
+    uint32_t         cycle_count;
+    uint8_t          pending_nmi;
+    uint8_t          pending_irq;   /* IRQ lines held asserted (NES_IRQ_*) */
+    uint8_t          stall_cycles;
+
+    /* Wiring below is not part of save states */
+    const opcode_info_t* opcode_table;
+    cpu_bus_t        bus;           /* Per-instance memory bus */
+    uint32_t         run_target;    /* cycle_count the current run stops at */
+    uint8_t          in_run;        /* Inside nes_cpu_run_until */
+    uint8_t          idle_skip;     /* Fast-forward idle loops (default on) */
+    uint8_t          idle_armed;    /* idle_jump closed a pass with no interrupt since */
+    uint16_t         idle_jump;
+    uint16_t         idle_reject[NES_CPU_IDLE_REJECTS];
+    const uint8_t*   idle_reject_page[NES_CPU_IDLE_REJECTS];
+    nes_cpu_stats_t  stats;
+    struct nes_cpu_block_cache* block_cache;  /* NES_CPU_CORE_CACHED only, allocated on first run */
+    struct nes_trace* trace;        /* NULL = not tracing (NES_ENABLE_TRACE builds) */
+} nes_cpu_t;
+
+/* Bytes of plain (pointer-free) CPU state at the start of nes_cpu_t */
+#define NES_CPU_STATE_SIZE offsetof(nes_cpu_t, opcode_table)
+
 /* CPU API */
 
 /**
@@ -98,6 +139,11 @@ typedef struct {
  */
 void nes_cpu_init(nes_cpu_t* cpu, cpu_bus_t* bus);
 
+/**
+ * Release memory the CPU allocated for itself (the block cache)
+ */
+void nes_cpu_free(nes_cpu_t* cpu);
+
 /**
  * Reset the CPU to initial state
  */
@@ -114,15 +160,57 @@ uint8_t nes_cpu_step(nes_cpu_t* cpu);
  */
 void nes_cpu_execute_cycles(nes_cpu_t* cpu, uint32_t cycles);
 
+/**
+ * Run whole instructions until cycle_count reaches target_cycle
+ * The last instruction may overshoot; the excess stays in cycle_count,
+ * so the next run starts exactly where this one ended.
+ */
+void nes_cpu_run_until(nes_cpu_t* cpu, uint32_t target_cycle);
+
+/**
+ * Pull the current run's end in to target_cycle (from a bus callback)
+ * Has no effect if the run already ends earlier.
+ */
+void nes_cpu_stop_at(nes_cpu_t* cpu, uint32_t target_cycle);
+
+/**
+ * Enable or disable idle-loop fast-forwarding (on by default)
+ * A short backward loop that only reads RAM/ROM and whose registers come
+ * out of every pass unchanged cannot leave until an interrupt, so whole
+ * passes are skipped up to the end of the current run. The result is
+ * cycle-identical to executing them.
+ */
+void nes_cpu_set_idle_skip(nes_cpu_t* cpu, int enable);
+
+/**
+ * Suspend the CPU for cycles (e.g. OAM DMA)
+ */
+void nes_cpu_stall(nes_cpu_t* cpu, uint32_t cycles);
+
 /**
  * Trigger a Non-Maskable Interrupt (NMI)
  */
 void nes_cpu_trigger_nmi(nes_cpu_t* cpu);
 
+/* IRQ sources - the 6502's IRQ input is level-triggered, so each source
+ * holds its line until it is acknowledged at the source */
+#define NES_IRQ_MAPPER  0x01
+
+/**
+ * Assert an IRQ line (can be masked); the CPU keeps taking the IRQ while
+ * any line is asserted and I is clear
+ */
+void nes_cpu_set_irq(nes_cpu_t* cpu, uint8_t line);
+
+/**
+ * Release an IRQ line (the source was acknowledged or disabled)
+ */
+void nes_cpu_clear_irq(nes_cpu_t* cpu, uint8_t line);
+
 /**
- * Trigger an IRQ (can be masked)
+ * Mnemonic, addressing mode, base cycles and length of an opcode
  */
-void nes_cpu_trigger_irq(nes_cpu_t* cpu);
+const opcode_info_t* nes_cpu_opcode_info(uint8_t opcode);
 
 /**
  * Disassemble instruction at address for debugging
@@ -134,9 +222,6 @@ void nes_cpu_disassemble(nes_cpu_t* cpu, uint16_t addr, char* buffer, size_t buf
  */
 void nes_cpu_set_bus(nes_cpu_t* cpu, cpu_bus_t* bus);
 
-/* Global CPU bus pointer (defined in cpu.c) */
-extern cpu_bus_t* g_bus;
-
 /* Address mode helpers */
 
 static inline uint8_t nes_cpu_get_flag(nes_cpu_t* cpu, uint8_t flag) {
@@ -160,14 +245,35 @@ static inline void nes_cpu_update_zn(nes_cpu_t* cpu, uint8_t val) {
     nes_cpu_set_flag(cpu, FLAG_NEGATIVE, (val & 0x80) != 0);
 }
 
+/* Bus access - direct page pointer when mapped, else the bus callback */
+
+static inline uint8_t nes_cpu_bus_read(nes_cpu_t* cpu, uint16_t addr) {
+    NES_STAT(cpu->stats.reads[addr >> 13]++);
+    const uint8_t* page = cpu->bus.read_map ? cpu->bus.read_map[addr >> 8] : NULL;
+    if (page) {
+        return page[addr & 0xFF];
+    }
+    return cpu->bus.read(cpu->bus.context, addr);
+}
+
+static inline void nes_cpu_bus_write(nes_cpu_t* cpu, uint16_t addr, uint8_t val) {
+    NES_STAT(cpu->stats.writes[addr >> 13]++);
+    uint8_t* page = cpu->bus.write_map ? cpu->bus.write_map[addr >> 8] : NULL;
+    if (page) {
+        page[addr & 0xFF] = val;
+        return;
+    }
+    cpu->bus.write(cpu->bus.context, addr, val);
+}
+
 /* Stack operations */
 
 static inline void nes_cpu_push(nes_cpu_t* cpu, uint8_t val) {
-    g_bus->write(g_bus->context, NES_STACK_BASE + cpu->reg.sp--, val);
+    nes_cpu_bus_write(cpu, NES_STACK_BASE + cpu->reg.sp--, val);
 }
 
 static inline uint8_t nes_cpu_pop(nes_cpu_t* cpu) {
-    return g_bus->read(g_bus->context, NES_STACK_BASE + ++cpu->reg.sp);
+    return nes_cpu_bus_read(cpu, NES_STACK_BASE + ++cpu->reg.sp);
 }
 
 static inline void nes_cpu_push_word(nes_cpu_t* cpu, uint16_t val) {
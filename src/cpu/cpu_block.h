@@ -0,0 +1,262 @@
+/**
+ * NESPRESSO - NES Emulator
+ * CPU Module - Basic-Block Cache for the Cached Core
+ *
+ * Straight-line runs of PRG-ROM code are decoded once into arrays of
+ * micro-ops: the opcode's handler, its operand bytes (branches: the
+ * target) and its base cycles, so executing them skips fetch and decode.
+ * Blocks never leave the 256-byte page they start in and are keyed by
+ * the PC and the host address of their first byte. A bank switch maps
+ * other host memory under the PC, so stale blocks simply stop matching
+ * and no mapper has to invalidate anything. Only read-only mapped pages
+ * (PRG-ROM) are cached; code in RAM is interpreted.
+ * Internal to cpu.c - not part of the public API.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_CPU_BLOCK_H
+#define NESPRESSO_CPU_BLOCK_H
+
+#include "cpu_ops.h"
+#include <stdlib.h>
+
+#define NES_CPU_BLOCK_SLOTS 512    /* Direct-mapped, power of two */
+#define NES_CPU_BLOCK_OPS   16     /* Longest block in instructions */
+
+typedef struct cpu_uop cpu_uop_t;
+typedef void (*cpu_uop_fn)(nes_cpu_t* cpu, const cpu_uop_t* op);
+
+/* One pre-decoded instruction */
+struct cpu_uop {
+    cpu_uop_fn  fn;
+    uint16_t    operand;    /* Operand byte/word, or branch target */
+    uint16_t    next_pc;    /* PC after the instruction */
+    uint8_t     cycles;     /* Base cycles from the opcode table */
+    uint8_t     length;
+    uint8_t     store;      /* May write through a bus handler (bank switch) */
+    uint8_t     reserved;
+};
+
+typedef struct {
+    const uint8_t*  host;   /* Code bytes the block was decoded from, NULL = empty */
+    uint16_t        pc;
+    uint8_t         count;
+    cpu_uop_t       ops[NES_CPU_BLOCK_OPS];
+} cpu_block_t;
+
+struct nes_cpu_block_cache {
+    cpu_block_t     blocks[NES_CPU_BLOCK_SLOTS];
+};
+
+/* Addressing modes - effective address from the pre-decoded operand */
+
+static inline uint16_t cpu_uaddr_zp(nes_cpu_t* cpu, const cpu_uop_t* op) {
+    (void)cpu;
+    return op->operand;
+}
+
+static inline uint16_t cpu_uaddr_zpx(nes_cpu_t* cpu, const cpu_uop_t* op) {
+    return (op->operand + cpu->reg.x) & 0xFF;
+}
+
+static inline uint16_t cpu_uaddr_zpy(nes_cpu_t* cpu, const cpu_uop_t* op) {
+    return (op->operand + cpu->reg.y) & 0xFF;
+}
+
+static inline uint16_t cpu_uaddr_abs(nes_cpu_t* cpu, const cpu_uop_t* op) {
+    (void)cpu;
+    return op->operand;
+}
+
+static inline uint16_t cpu_uaddr_abx(nes_cpu_t* cpu, const cpu_uop_t* op) {
+    return cpu_index(cpu, op->operand, cpu->reg.x);
+}
+
+static inline uint16_t cpu_uaddr_aby(nes_cpu_t* cpu, const cpu_uop_t* op) {
+    return cpu_index(cpu, op->operand, cpu->reg.y);
+}
+
+static inline uint16_t cpu_uaddr_ind(nes_cpu_t* cpu, const cpu_uop_t* op) {
+    uint16_t ptr = op->operand;
+    /* Indirect JMP bug: high byte is read from the same page */
+    uint16_t addr = nes_cpu_bus_read(cpu, ptr);
+    addr |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr & 0xFF00) | ((ptr + 1) & 0xFF))) << 8;
+    return addr;
+}
+
+static inline uint16_t cpu_uaddr_izx(nes_cpu_t* cpu, const cpu_uop_t* op) {  /* (Indirect,X) */
+    uint8_t ptr = (op->operand + cpu->reg.x) & 0xFF;
+    uint16_t addr = nes_cpu_bus_read(cpu, ptr);
+    addr |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr + 1) & 0xFF)) << 8;
+    return addr;
+}
+
+static inline uint16_t cpu_uaddr_izy(nes_cpu_t* cpu, const cpu_uop_t* op) {  /* (Indirect),Y */
+    uint8_t ptr = (uint8_t)op->operand;
+    uint16_t base = nes_cpu_bus_read(cpu, ptr);
+    base |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr + 1) & 0xFF)) << 8;
+    return cpu_index(cpu, base, cpu->reg.y);
+}
+
+/* Operand value for read operations (immediates are already decoded) */
+#define CPU_UVAL(mode) CPU_UVAL_##mode
+#define CPU_UVAL_imm ((uint8_t)op->operand)
+#define CPU_UVAL_zp  nes_cpu_bus_read(cpu, cpu_uaddr_zp(cpu, op))
+#define CPU_UVAL_zpx nes_cpu_bus_read(cpu, cpu_uaddr_zpx(cpu, op))
+#define CPU_UVAL_zpy nes_cpu_bus_read(cpu, cpu_uaddr_zpy(cpu, op))
+#define CPU_UVAL_abs nes_cpu_bus_read(cpu, cpu_uaddr_abs(cpu, op))
+#define CPU_UVAL_abx nes_cpu_bus_read(cpu, cpu_uaddr_abx(cpu, op))
+#define CPU_UVAL_aby nes_cpu_bus_read(cpu, cpu_uaddr_aby(cpu, op))
+#define CPU_UVAL_izx nes_cpu_bus_read(cpu, cpu_uaddr_izx(cpu, op))
+#define CPU_UVAL_izy nes_cpu_bus_read(cpu, cpu_uaddr_izy(cpu, op))
+
+/* Micro-op bodies by kind - PC already points past the instruction */
+#define CPU_UBODY_R(fn, mode) cpu_op_##fn(cpu, CPU_UVAL(mode));
+#define CPU_UBODY_W(fn, mode) { uint16_t addr = cpu_uaddr_##mode(cpu, op); nes_cpu_bus_write(cpu, addr, cpu->reg.fn); }
+#define CPU_UBODY_M(fn, mode) { uint16_t addr = cpu_uaddr_##mode(cpu, op); \
+                                nes_cpu_bus_write(cpu, addr, cpu_op_##fn(cpu, nes_cpu_bus_read(cpu, addr))); }
+#define CPU_UBODY_A(fn, mode) (void)op; cpu->reg.a = cpu_op_##fn(cpu, cpu->reg.a);
+#define CPU_UBODY_J(fn, mode) cpu_op_##fn(cpu, cpu_uaddr_##mode(cpu, op));
+#define CPU_UBODY_I(fn, mode) (void)op; cpu_op_##fn(cpu);
+
+#define CPU_UOP(op_, kind, fn, mode) \
+    static void cpu_uop_##op_(nes_cpu_t* cpu, const cpu_uop_t* op) { CPU_UBODY_##kind(fn, mode) }
+NES_CPU_OPCODES(CPU_UOP)
+#undef CPU_UOP
+
+/* Branches take their decoded target instead of fetching an offset */
+static inline void cpu_ubranch(nes_cpu_t* cpu, const cpu_uop_t* op, int condition) {
+    if (condition) {
+        /* Page boundary penalty */
+        if ((cpu->reg.pc & 0xFF00) != (op->operand & 0xFF00)) {
+            cpu->stall_cycles = 1;
+        }
+        cpu->reg.pc = op->operand;
+        CPU_IDLE_JUMP(cpu, op->next_pc - 2);
+    }
+}
+
+static void cpu_uop_bpl(nes_cpu_t* cpu, const cpu_uop_t* op) { cpu_ubranch(cpu, op, !(cpu->reg.p & FLAG_NEGATIVE)); }
+static void cpu_uop_bmi(nes_cpu_t* cpu, const cpu_uop_t* op) { cpu_ubranch(cpu, op, cpu->reg.p & FLAG_NEGATIVE); }
+static void cpu_uop_bvc(nes_cpu_t* cpu, const cpu_uop_t* op) { cpu_ubranch(cpu, op, !(cpu->reg.p & FLAG_OVERFLOW)); }
+static void cpu_uop_bvs(nes_cpu_t* cpu, const cpu_uop_t* op) { cpu_ubranch(cpu, op, cpu->reg.p & FLAG_OVERFLOW); }
+static void cpu_uop_bcc(nes_cpu_t* cpu, const cpu_uop_t* op) { cpu_ubranch(cpu, op, !(cpu->reg.p & FLAG_CARRY)); }
+static void cpu_uop_bcs(nes_cpu_t* cpu, const cpu_uop_t* op) { cpu_ubranch(cpu, op, cpu->reg.p & FLAG_CARRY); }
+static void cpu_uop_bne(nes_cpu_t* cpu, const cpu_uop_t* op) { cpu_ubranch(cpu, op, !(cpu->reg.p & FLAG_ZERO)); }
+static void cpu_uop_beq(nes_cpu_t* cpu, const cpu_uop_t* op) { cpu_ubranch(cpu, op, cpu->reg.p & FLAG_ZERO); }
+
+/* Branch opcodes are $10, $30, ... $F0, in this order */
+static const cpu_uop_fn g_cpu_uop_branches[8] = {
+    cpu_uop_bpl, cpu_uop_bmi, cpu_uop_bvc, cpu_uop_bvs,
+    cpu_uop_bcc, cpu_uop_bcs, cpu_uop_bne, cpu_uop_beq
+};
+
+static inline int cpu_uop_is_branch(uint8_t opcode) {
+    return (opcode & 0x1F) == 0x10;
+}
+
+/* Per-opcode decode tables */
+#define CPU_ULEN_imp 1
+#define CPU_ULEN_acc 1
+#define CPU_ULEN_imm 2
+#define CPU_ULEN_zp  2
+#define CPU_ULEN_zpx 2
+#define CPU_ULEN_zpy 2
+#define CPU_ULEN_izx 2
+#define CPU_ULEN_izy 2
+#define CPU_ULEN_abs 3
+#define CPU_ULEN_abx 3
+#define CPU_ULEN_aby 3
+#define CPU_ULEN_ind 3
+
+#define CPU_USTORE_R 0
+#define CPU_USTORE_W 1
+#define CPU_USTORE_M 1
+#define CPU_USTORE_A 0
+#define CPU_USTORE_J 0
+#define CPU_USTORE_I 0
+
+#define CPU_UOP_ENTRY(op_, kind, fn, mode) \
+    [0x##op_] = { cpu_uop_##op_, 0, 0, 0, CPU_ULEN_##mode, CPU_USTORE_##kind, 0 },
+static const cpu_uop_t g_cpu_uop_templates[256] = {
+    NES_CPU_OPCODES(CPU_UOP_ENTRY)
+};
+#undef CPU_UOP_ENTRY
+
+/* Instructions after which execution does not fall through */
+static inline int cpu_uop_ends_block(uint8_t opcode) {
+    return cpu_uop_is_branch(opcode) || opcode == 0x00 || opcode == 0x20 || opcode == 0x40 ||
+           opcode == 0x4C || opcode == 0x60 || opcode == 0x6C;
+}
+
+/* Decode the run of instructions starting at pc (page is its mapped page) */
+static void cpu_block_build(nes_cpu_t* cpu, cpu_block_t* block, uint16_t pc, const uint8_t* page) {
+    unsigned offset = pc & 0xFF;
+
+    block->host = page + offset;
+    block->pc = pc;
+    block->count = 0;
+
+    while (block->count < NES_CPU_BLOCK_OPS) {
+        uint8_t opcode = page[offset];
+        cpu_uop_t* op = &block->ops[block->count];
+        *op = g_cpu_uop_templates[opcode];
+        if (cpu_uop_is_branch(opcode)) {
+            op->fn = g_cpu_uop_branches[opcode >> 5];
+            op->length = 2;
+        }
+
+        /* Operands must come from this page too */
+        if (offset + op->length > 0x100) {
+            break;
+        }
+        if (op->length == 2) {
+            op->operand = page[offset + 1];
+        } else if (op->length == 3) {
+            op->operand = page[offset + 1] | (page[offset + 2] << 8);
+        }
+        op->next_pc = (uint16_t)(pc + op->length);
+        if (cpu_uop_is_branch(opcode)) {
+            op->operand = (uint16_t)(op->next_pc + (int8_t)page[offset + 1]);
+        }
+        op->cycles = cpu->opcode_table[opcode].cycles;
+
+        block->count++;
+        offset += op->length;
+        pc = op->next_pc;
+        if (cpu_uop_ends_block(opcode)) {
+            break;
+        }
+    }
+}
+
+/* Block for the code at pc, decoding it on a miss
+ * Returns NULL where pc is not cacheable (RAM, I/O, unmapped, page straddle) */
+static inline const cpu_block_t* cpu_block_lookup(nes_cpu_t* cpu, uint16_t pc) {
+    struct nes_cpu_block_cache* cache = cpu->block_cache;
+    if (!cache || !cpu->bus.read_map) {
+        return NULL;
+    }
+
+    const uint8_t* page = cpu->bus.read_map[pc >> 8];
+    if (!page || (cpu->bus.write_map && cpu->bus.write_map[pc >> 8])) {
+        return NULL;
+    }
+
+    const uint8_t* host = page + (pc & 0xFF);
+    uintptr_t key = (uintptr_t)host;
+    cpu_block_t* block = &cache->blocks[(key ^ (key >> 9) ^ ((uintptr_t)pc << 3)) & (NES_CPU_BLOCK_SLOTS - 1)];
+    if (block->host != host || block->pc != pc) {
+        cpu_block_build(cpu, block, pc, page);
+    }
+    return block->count ? block : NULL;
+}
+
+/* Still mapped at its PC? (a store may have switched the block's bank) */
+static inline int cpu_block_mapped(const nes_cpu_t* cpu, const cpu_block_t* block) {
+    return cpu->bus.read_map[block->pc >> 8] == block->host - (block->pc & 0xFF);
+}
+
+#endif /* NESPRESSO_CPU_BLOCK_H */
@@ -0,0 +1,546 @@
+/**
+ * NESPRESSO - NES Emulator
+ * CPU Module - Per-Opcode Handlers for the Table and Threaded Cores
+ *
+ * Every opcode gets its own handler with the addressing mode inlined,
+ * built from the NES_CPU_OPCODES list. Semantics (bus access order,
+ * page-cross penalties, flags) match the reference switch in cpu.c.
+ * Internal to cpu.c (which defines CPU_IDLE_JUMP) - not part of the public API.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_CPU_OPS_H
+#define NESPRESSO_CPU_OPS_H
+
+#include "cpu.h"
+
+/* Addressing modes - return the effective address, advancing PC past the operand */
+
+static inline uint16_t cpu_addr_imm(nes_cpu_t* cpu) {
+    return cpu->reg.pc++;
+}
+
+static inline uint16_t cpu_addr_zp(nes_cpu_t* cpu) {
+    return nes_cpu_bus_read(cpu, cpu->reg.pc++);
+}
+
+static inline uint16_t cpu_addr_zpx(nes_cpu_t* cpu) {
+    return (nes_cpu_bus_read(cpu, cpu->reg.pc++) + cpu->reg.x) & 0xFF;
+}
+
+static inline uint16_t cpu_addr_zpy(nes_cpu_t* cpu) {
+    return (nes_cpu_bus_read(cpu, cpu->reg.pc++) + cpu->reg.y) & 0xFF;
+}
+
+static inline uint16_t cpu_fetch16(nes_cpu_t* cpu) {
+    uint16_t value = nes_cpu_bus_read(cpu, cpu->reg.pc);
+    value |= ((uint16_t)nes_cpu_bus_read(cpu, cpu->reg.pc + 1)) << 8;
+    cpu->reg.pc += 2;
+    return value;
+}
+
+static inline uint16_t cpu_addr_abs(nes_cpu_t* cpu) {
+    return cpu_fetch16(cpu);
+}
+
+/* Base + index with the page boundary penalty */
+static inline uint16_t cpu_index(nes_cpu_t* cpu, uint16_t base, uint8_t index) {
+    uint16_t addr = base + index;
+    if ((base & 0xFF00) != (addr & 0xFF00)) {
+        cpu->stall_cycles = 1;
+    }
+    return addr;
+}
+
+static inline uint16_t cpu_addr_abx(nes_cpu_t* cpu) {
+    return cpu_index(cpu, cpu_fetch16(cpu), cpu->reg.x);
+}
+
+static inline uint16_t cpu_addr_aby(nes_cpu_t* cpu) {
+    return cpu_index(cpu, cpu_fetch16(cpu), cpu->reg.y);
+}
+
+static inline uint16_t cpu_addr_ind(nes_cpu_t* cpu) {
+    uint16_t ptr = cpu_fetch16(cpu);
+    /* Indirect JMP bug: high byte is read from the same page */
+    uint16_t addr = nes_cpu_bus_read(cpu, ptr);
+    addr |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr & 0xFF00) | ((ptr + 1) & 0xFF))) << 8;
+    return addr;
+}
+
+static inline uint16_t cpu_addr_izx(nes_cpu_t* cpu) {  /* (Indirect,X) */
+    uint8_t ptr = (nes_cpu_bus_read(cpu, cpu->reg.pc++) + cpu->reg.x) & 0xFF;
+    uint16_t addr = nes_cpu_bus_read(cpu, ptr);
+    addr |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr + 1) & 0xFF)) << 8;
+    return addr;
+}
+
+static inline uint16_t cpu_addr_izy(nes_cpu_t* cpu) {  /* (Indirect),Y */
+    uint8_t ptr = nes_cpu_bus_read(cpu, cpu->reg.pc++);
+    uint16_t base = nes_cpu_bus_read(cpu, ptr);
+    base |= ((uint16_t)nes_cpu_bus_read(cpu, (ptr + 1) & 0xFF)) << 8;
+    return cpu_index(cpu, base, cpu->reg.y);
+}
+
+/* Read operations - take the operand value */
+
+static inline void cpu_op_adc(nes_cpu_t* cpu, uint8_t value) {
+    uint16_t result = cpu->reg.a + value + nes_cpu_get_flag(cpu, FLAG_CARRY);
+    nes_cpu_set_flag(cpu, FLAG_CARRY, result > 0xFF);
+    nes_cpu_set_flag(cpu, FLAG_OVERFLOW,
+        ((~(cpu->reg.a ^ value) & (cpu->reg.a ^ result)) & 0x80) != 0);
+    cpu->reg.a = (uint8_t)result;
+    nes_cpu_update_zn(cpu, cpu->reg.a);
+}
+
+static inline void cpu_op_sbc(nes_cpu_t* cpu, uint8_t value) {
+    cpu_op_adc(cpu, (uint8_t)~value);
+}
+
+static inline void cpu_op_and(nes_cpu_t* cpu, uint8_t value) {
+    cpu->reg.a &= value;
+    nes_cpu_update_zn(cpu, cpu->reg.a);
+}
+
+static inline void cpu_op_ora(nes_cpu_t* cpu, uint8_t value) {
+    cpu->reg.a |= value;
+    nes_cpu_update_zn(cpu, cpu->reg.a);
+}
+
+static inline void cpu_op_eor(nes_cpu_t* cpu, uint8_t value) {
+    cpu->reg.a ^= value;
+    nes_cpu_update_zn(cpu, cpu->reg.a);
+}
+
+static inline void cpu_op_bit(nes_cpu_t* cpu, uint8_t value) {
+    nes_cpu_set_flag(cpu, FLAG_ZERO, (cpu->reg.a & value) == 0);
+    nes_cpu_set_flag(cpu, FLAG_OVERFLOW, (value & 0x40) != 0);
+    nes_cpu_set_flag(cpu, FLAG_NEGATIVE, (value & 0x80) != 0);
+}
+
+static inline void cpu_compare(nes_cpu_t* cpu, uint8_t reg_val, uint8_t mem_val) {
+    uint8_t result = reg_val - mem_val;
+    nes_cpu_set_flag(cpu, FLAG_CARRY, reg_val >= mem_val);
+    nes_cpu_set_flag(cpu, FLAG_ZERO, (result == 0));
+    nes_cpu_set_flag(cpu, FLAG_NEGATIVE, (result & 0x80) != 0);
+}
+
+static inline void cpu_op_cmp(nes_cpu_t* cpu, uint8_t value) { cpu_compare(cpu, cpu->reg.a, value); }
+static inline void cpu_op_cpx(nes_cpu_t* cpu, uint8_t value) { cpu_compare(cpu, cpu->reg.x, value); }
+static inline void cpu_op_cpy(nes_cpu_t* cpu, uint8_t value) { cpu_compare(cpu, cpu->reg.y, value); }
+
+static inline void cpu_op_lda(nes_cpu_t* cpu, uint8_t value) { cpu->reg.a = value; nes_cpu_update_zn(cpu, value); }
+static inline void cpu_op_ldx(nes_cpu_t* cpu, uint8_t value) { cpu->reg.x = value; nes_cpu_update_zn(cpu, value); }
+static inline void cpu_op_ldy(nes_cpu_t* cpu, uint8_t value) { cpu->reg.y = value; nes_cpu_update_zn(cpu, value); }
+
+/* Read-modify-write operations - return the new value (memory or A) */
+
+static inline uint8_t cpu_op_asl(nes_cpu_t* cpu, uint8_t value) {
+    nes_cpu_set_flag(cpu, FLAG_CARRY, (value & 0x80) != 0);
+    value <<= 1;
+    nes_cpu_update_zn(cpu, value);
+    return value;
+}
+
+static inline uint8_t cpu_op_lsr(nes_cpu_t* cpu, uint8_t value) {
+    nes_cpu_set_flag(cpu, FLAG_CARRY, value & 1);
+    value >>= 1;
+    nes_cpu_update_zn(cpu, value);
+    return value;
+}
+
+static inline uint8_t cpu_op_rol(nes_cpu_t* cpu, uint8_t value) {
+    uint8_t result = (uint8_t)((value << 1) | nes_cpu_get_flag(cpu, FLAG_CARRY));
+    nes_cpu_set_flag(cpu, FLAG_CARRY, (value & 0x80) != 0);
+    nes_cpu_update_zn(cpu, result);
+    return result;
+}
+
+static inline uint8_t cpu_op_ror(nes_cpu_t* cpu, uint8_t value) {
+    uint8_t result = (uint8_t)((value >> 1) | (nes_cpu_get_flag(cpu, FLAG_CARRY) << 7));
+    nes_cpu_set_flag(cpu, FLAG_CARRY, value & 1);
+    nes_cpu_update_zn(cpu, result);
+    return result;
+}
+
+static inline uint8_t cpu_op_inc(nes_cpu_t* cpu, uint8_t value) {
+    value++;
+    nes_cpu_update_zn(cpu, value);
+    return value;
+}
+
+static inline uint8_t cpu_op_dec(nes_cpu_t* cpu, uint8_t value) {
+    value--;
+    nes_cpu_update_zn(cpu, value);
+    return value;
+}
+
+/* Jumps - take the effective address */
+
+static inline void cpu_op_jmp(nes_cpu_t* cpu, uint16_t addr) {
+    uint16_t jump_pc = cpu->reg.pc - 3;
+    cpu->reg.pc = addr;
+    CPU_IDLE_JUMP(cpu, jump_pc);
+}
+
+static inline void cpu_op_jsr(nes_cpu_t* cpu, uint16_t addr) {
+    cpu->reg.pc--;  /* JSR pushes return address - 1 */
+    nes_cpu_push_word(cpu, cpu->reg.pc);
+    cpu->reg.pc = addr + 1;
+}
+
+/* Branches - fetch their own offset */
+
+static inline void cpu_branch(nes_cpu_t* cpu, int condition) {
+    int8_t offset = (int8_t)nes_cpu_bus_read(cpu, cpu->reg.pc++);
+    if (condition) {
+        uint16_t old_pc = cpu->reg.pc;
+        cpu->reg.pc += offset;
+        /* Page boundary penalty */
+        if ((old_pc & 0xFF00) != (cpu->reg.pc & 0xFF00)) {
+            cpu->stall_cycles = 1;
+        }
+        CPU_IDLE_JUMP(cpu, old_pc - 2);
+    }
+}
+
+static inline void cpu_op_bcc(nes_cpu_t* cpu) { cpu_branch(cpu, !(cpu->reg.p & FLAG_CARRY)); }
+static inline void cpu_op_bcs(nes_cpu_t* cpu) { cpu_branch(cpu, cpu->reg.p & FLAG_CARRY); }
+static inline void cpu_op_bne(nes_cpu_t* cpu) { cpu_branch(cpu, !(cpu->reg.p & FLAG_ZERO)); }
+static inline void cpu_op_beq(nes_cpu_t* cpu) { cpu_branch(cpu, cpu->reg.p & FLAG_ZERO); }
+static inline void cpu_op_bpl(nes_cpu_t* cpu) { cpu_branch(cpu, !(cpu->reg.p & FLAG_NEGATIVE)); }
+static inline void cpu_op_bmi(nes_cpu_t* cpu) { cpu_branch(cpu, cpu->reg.p & FLAG_NEGATIVE); }
+static inline void cpu_op_bvc(nes_cpu_t* cpu) { cpu_branch(cpu, !(cpu->reg.p & FLAG_OVERFLOW)); }
+static inline void cpu_op_bvs(nes_cpu_t* cpu) { cpu_branch(cpu, cpu->reg.p & FLAG_OVERFLOW); }
+
+/* Implied operations */
+
+static inline void cpu_op_brk(nes_cpu_t* cpu) {
+    cpu->reg.pc++;
+    nes_cpu_push_word(cpu, cpu->reg.pc);
+    nes_cpu_push(cpu, cpu->reg.p | FLAG_BREAK | FLAG_UNUSED);
+    uint16_t addr = nes_cpu_bus_read(cpu, NES_VECTOR_IRQ_BRK);
+    addr |= ((uint16_t)nes_cpu_bus_read(cpu, NES_VECTOR_IRQ_BRK + 1)) << 8;
+    cpu->reg.pc = addr;
+    cpu->reg.p |= FLAG_INTERRUPT;
+}
+
+static inline void cpu_op_rti(nes_cpu_t* cpu) {
+    uint8_t status = nes_cpu_pop(cpu);
+    cpu->reg.p = (status & ~(FLAG_BREAK | FLAG_UNUSED)) | FLAG_UNUSED;
+    cpu->reg.pc = nes_cpu_pop_word(cpu);
+}
+
+static inline void cpu_op_rts(nes_cpu_t* cpu) {
+    cpu->reg.pc = nes_cpu_pop_word(cpu) + 1;
+}
+
+static inline void cpu_op_pha(nes_cpu_t* cpu) { nes_cpu_push(cpu, cpu->reg.a); }
+static inline void cpu_op_php(nes_cpu_t* cpu) { nes_cpu_push(cpu, cpu->reg.p | FLAG_BREAK | FLAG_UNUSED); }
+
+static inline void cpu_op_pla(nes_cpu_t* cpu) {
+    cpu->reg.a = nes_cpu_pop(cpu);
+    nes_cpu_update_zn(cpu, cpu->reg.a);
+}
+
+static inline void cpu_op_plp(nes_cpu_t* cpu) {
+    uint8_t status = nes_cpu_pop(cpu);
+    cpu->reg.p = (status & ~(FLAG_BREAK | FLAG_UNUSED)) | FLAG_UNUSED;
+}
+
+static inline void cpu_op_clc(nes_cpu_t* cpu) { cpu->reg.p &= ~FLAG_CARRY; }
+static inline void cpu_op_cld(nes_cpu_t* cpu) { cpu->reg.p &= ~FLAG_DECIMAL; }
+static inline void cpu_op_cli(nes_cpu_t* cpu) { cpu->reg.p &= ~FLAG_INTERRUPT; }
+static inline void cpu_op_clv(nes_cpu_t* cpu) { cpu->reg.p &= ~FLAG_OVERFLOW; }
+static inline void cpu_op_sec(nes_cpu_t* cpu) { cpu->reg.p |= FLAG_CARRY; }
+static inline void cpu_op_sed(nes_cpu_t* cpu) { cpu->reg.p |= FLAG_DECIMAL; }
+static inline void cpu_op_sei(nes_cpu_t* cpu) { cpu->reg.p |= FLAG_INTERRUPT; }
+
+static inline void cpu_op_dex(nes_cpu_t* cpu) { cpu->reg.x--; nes_cpu_update_zn(cpu, cpu->reg.x); }
+static inline void cpu_op_dey(nes_cpu_t* cpu) { cpu->reg.y--; nes_cpu_update_zn(cpu, cpu->reg.y); }
+static inline void cpu_op_inx(nes_cpu_t* cpu) { cpu->reg.x++; nes_cpu_update_zn(cpu, cpu->reg.x); }
+static inline void cpu_op_iny(nes_cpu_t* cpu) { cpu->reg.y++; nes_cpu_update_zn(cpu, cpu->reg.y); }
+
+static inline void cpu_op_tax(nes_cpu_t* cpu) { cpu->reg.x = cpu->reg.a; nes_cpu_update_zn(cpu, cpu->reg.x); }
+static inline void cpu_op_tay(nes_cpu_t* cpu) { cpu->reg.y = cpu->reg.a; nes_cpu_update_zn(cpu, cpu->reg.y); }
+static inline void cpu_op_tsx(nes_cpu_t* cpu) { cpu->reg.x = cpu->reg.sp; nes_cpu_update_zn(cpu, cpu->reg.x); }
+static inline void cpu_op_txa(nes_cpu_t* cpu) { cpu->reg.a = cpu->reg.x; nes_cpu_update_zn(cpu, cpu->reg.a); }
+static inline void cpu_op_tya(nes_cpu_t* cpu) { cpu->reg.a = cpu->reg.y; nes_cpu_update_zn(cpu, cpu->reg.a); }
+static inline void cpu_op_txs(nes_cpu_t* cpu) { cpu->reg.sp = cpu->reg.x; }  /* No flags */
+
+/* Unofficial opcodes behave as 1-byte NOPs */
+static inline void cpu_op_nop(nes_cpu_t* cpu) { (void)cpu; }
+
+/* Handler bodies by kind - fn names the operation (or register for W) */
+#define CPU_BODY_R(fn, mode) cpu_op_##fn(cpu, nes_cpu_bus_read(cpu, cpu_addr_##mode(cpu)));
+#define CPU_BODY_W(fn, mode) { uint16_t addr = cpu_addr_##mode(cpu); nes_cpu_bus_write(cpu, addr, cpu->reg.fn); }
+#define CPU_BODY_M(fn, mode) { uint16_t addr = cpu_addr_##mode(cpu); \
+                               nes_cpu_bus_write(cpu, addr, cpu_op_##fn(cpu, nes_cpu_bus_read(cpu, addr))); }
+#define CPU_BODY_A(fn, mode) cpu->reg.a = cpu_op_##fn(cpu, cpu->reg.a);
+#define CPU_BODY_J(fn, mode) cpu_op_##fn(cpu, cpu_addr_##mode(cpu));
+#define CPU_BODY_I(fn, mode) cpu_op_##fn(cpu);
+
+/* All 256 opcodes: X(hex, kind, fn, mode)
+ * R = read, W = store register, M = read-modify-write, A = accumulator,
+ * J = jump to address, I = implied (branches fetch their own offset) */
+#define NES_CPU_OPCODES(X) \
+    X(00, I, brk, imp) \
+    X(01, R, ora, izx) \
+    X(02, I, nop, imp) \
+    X(03, I, nop, imp) \
+    X(04, I, nop, imp) \
+    X(05, R, ora, zp) \
+    X(06, M, asl, zp) \
+    X(07, I, nop, imp) \
+    X(08, I, php, imp) \
+    X(09, R, ora, imm) \
+    X(0A, A, asl, acc) \
+    X(0B, I, nop, imp) \
+    X(0C, I, nop, imp) \
+    X(0D, R, ora, abs) \
+    X(0E, M, asl, abs) \
+    X(0F, I, nop, imp) \
+    X(10, I, bpl, imp) \
+    X(11, R, ora, izy) \
+    X(12, I, nop, imp) \
+    X(13, I, nop, imp) \
+    X(14, I, nop, imp) \
+    X(15, R, ora, zpx) \
+    X(16, M, asl, zpx) \
+    X(17, I, nop, imp) \
+    X(18, I, clc, imp) \
+    X(19, R, ora, aby) \
+    X(1A, I, nop, imp) \
+    X(1B, I, nop, imp) \
+    X(1C, I, nop, imp) \
+    X(1D, R, ora, abx) \
+    X(1E, M, asl, abx) \
+    X(1F, I, nop, imp) \
+    X(20, J, jsr, abs) \
+    X(21, R, and, izx) \
+    X(22, I, nop, imp) \
+    X(23, I, nop, imp) \
+    X(24, R, bit, zp) \
+    X(25, R, and, zp) \
+    X(26, M, rol, zp) \
+    X(27, I, nop, imp) \
+    X(28, I, plp, imp) \
+    X(29, R, and, imm) \
+    X(2A, A, rol, acc) \
+    X(2B, I, nop, imp) \
+    X(2C, R, bit, abs) \
+    X(2D, R, and, abs) \
+    X(2E, M, rol, abs) \
+    X(2F, I, nop, imp) \
+    X(30, I, bmi, imp) \
+    X(31, R, and, izy) \
+    X(32, I, nop, imp) \
+    X(33, I, nop, imp) \
+    X(34, I, nop, imp) \
+    X(35, R, and, zpx) \
+    X(36, M, rol, zpx) \
+    X(37, I, nop, imp) \
+    X(38, I, sec, imp) \
+    X(39, R, and, aby) \
+    X(3A, I, nop, imp) \
+    X(3B, I, nop, imp) \
+    X(3C, I, nop, imp) \
+    X(3D, R, and, abx) \
+    X(3E, M, rol, abx) \
+    X(3F, I, nop, imp) \
+    X(40, I, rti, imp) \
+    X(41, R, eor, izx) \
+    X(42, I, nop, imp) \
+    X(43, I, nop, imp) \
+    X(44, I, nop, imp) \
+    X(45, R, eor, zp) \
+    X(46, M, lsr, zp) \
+    X(47, I, nop, imp) \
+    X(48, I, pha, imp) \
+    X(49, R, eor, imm) \
+    X(4A, A, lsr, acc) \
+    X(4B, I, nop, imp) \
+    X(4C, J, jmp, abs) \
+    X(4D, R, eor, abs) \
+    X(4E, M, lsr, abs) \
+    X(4F, I, nop, imp) \
+    X(50, I, bvc, imp) \
+    X(51, R, eor, izy) \
+    X(52, I, nop, imp) \
+    X(53, I, nop, imp) \
+    X(54, I, nop, imp) \
+    X(55, R, eor, zpx) \
+    X(56, M, lsr, zpx) \
+    X(57, I, nop, imp) \
+    X(58, I, cli, imp) \
+    X(59, R, eor, aby) \
+    X(5A, I, nop, imp) \
+    X(5B, I, nop, imp) \
+    X(5C, I, nop, imp) \
+    X(5D, R, eor, abx) \
+    X(5E, M, lsr, abx) \
+    X(5F, I, nop, imp) \
+    X(60, I, rts, imp) \
+    X(61, R, adc, izx) \
+    X(62, I, nop, imp) \
+    X(63, I, nop, imp) \
+    X(64, I, nop, imp) \
+    X(65, R, adc, zp) \
+    X(66, M, ror, zp) \
+    X(67, I, nop, imp) \
+    X(68, I, pla, imp) \
+    X(69, R, adc, imm) \
+    X(6A, A, ror, acc) \
+    X(6B, I, nop, imp) \
+    X(6C, J, jmp, ind) \
+    X(6D, R, adc, abs) \
+    X(6E, M, ror, abs) \
+    X(6F, I, nop, imp) \
+    X(70, I, bvs, imp) \
+    X(71, R, adc, izy) \
+    X(72, I, nop, imp) \
+    X(73, I, nop, imp) \
+    X(74, I, nop, imp) \
+    X(75, R, adc, zpx) \
+    X(76, M, ror, zpx) \
+    X(77, I, nop, imp) \
+    X(78, I, sei, imp) \
+    X(79, R, adc, aby) \
+    X(7A, I, nop, imp) \
+    X(7B, I, nop, imp) \
+    X(7C, I, nop, imp) \
+    X(7D, R, adc, abx) \
+    X(7E, M, ror, abx) \
+    X(7F, I, nop, imp) \
+    X(80, I, nop, imp) \
+    X(81, W, a, izx) \
+    X(82, I, nop, imp) \
+    X(83, I, nop, imp) \
+    X(84, W, y, zp) \
+    X(85, W, a, zp) \
+    X(86, W, x, zp) \
+    X(87, I, nop, imp) \
+    X(88, I, dey, imp) \
+    X(89, I, nop, imp) \
+    X(8A, I, txa, imp) \
+    X(8B, I, nop, imp) \
+    X(8C, W, y, abs) \
+    X(8D, W, a, abs) \
+    X(8E, W, x, abs) \
+    X(8F, I, nop, imp) \
+    X(90, I, bcc, imp) \
+    X(91, W, a, izy) \
+    X(92, I, nop, imp) \
+    X(93, I, nop, imp) \
+    X(94, W, y, zpx) \
+    X(95, W, a, zpx) \
+    X(96, W, x, zpy) \
+    X(97, I, nop, imp) \
+    X(98, I, tya, imp) \
+    X(99, W, a, aby) \
+    X(9A, I, txs, imp) \
+    X(9B, I, nop, imp) \
+    X(9C, I, nop, imp) \
+    X(9D, W, a, abx) \
+    X(9E, I, nop, imp) \
+    X(9F, I, nop, imp) \
+    X(A0, R, ldy, imm) \
+    X(A1, R, lda, izx) \
+    X(A2, R, ldx, imm) \
+    X(A3, I, nop, imp) \
+    X(A4, R, ldy, zp) \
+    X(A5, R, lda, zp) \
+    X(A6, R, ldx, zp) \
+    X(A7, I, nop, imp) \
+    X(A8, I, tay, imp) \
+    X(A9, R, lda, imm) \
+    X(AA, I, tax, imp) \
+    X(AB, I, nop, imp) \
+    X(AC, R, ldy, abs) \
+    X(AD, R, lda, abs) \
+    X(AE, R, ldx, abs) \
+    X(AF, I, nop, imp) \
+    X(B0, I, bcs, imp) \
+    X(B1, R, lda, izy) \
+    X(B2, I, nop, imp) \
+    X(B3, I, nop, imp) \
+    X(B4, R, ldy, zpx) \
+    X(B5, R, lda, zpx) \
+    X(B6, R, ldx, zpy) \
+    X(B7, I, nop, imp) \
+    X(B8, I, clv, imp) \
+    X(B9, R, lda, aby) \
+    X(BA, I, tsx, imp) \
+    X(BB, I, nop, imp) \
+    X(BC, R, ldy, abx) \
+    X(BD, R, lda, abx) \
+    X(BE, R, ldx, aby) \
+    X(BF, I, nop, imp) \
+    X(C0, R, cpy, imm) \
+    X(C1, R, cmp, izx) \
+    X(C2, I, nop, imp) \
+    X(C3, I, nop, imp) \
+    X(C4, R, cpy, zp) \
+    X(C5, R, cmp, zp) \
+    X(C6, M, dec, zp) \
+    X(C7, I, nop, imp) \
+    X(C8, I, iny, imp) \
+    X(C9, R, cmp, imm) \
+    X(CA, I, dex, imp) \
+    X(CB, I, nop, imp) \
+    X(CC, R, cpy, abs) \
+    X(CD, R, cmp, abs) \
+    X(CE, M, dec, abs) \
+    X(CF, I, nop, imp) \
+    X(D0, I, bne, imp) \
+    X(D1, R, cmp, izy) \
+    X(D2, I, nop, imp) \
+    X(D3, I, nop, imp) \
+    X(D4, I, nop, imp) \
+    X(D5, R, cmp, zpx) \
+    X(D6, M, dec, zpx) \
+    X(D7, I, nop, imp) \
+    X(D8, I, cld, imp) \
+    X(D9, R, cmp, aby) \
+    X(DA, I, nop, imp) \
+    X(DB, I, nop, imp) \
+    X(DC, I, nop, imp) \
+    X(DD, R, cmp, abx) \
+    X(DE, M, dec, abx) \
+    X(DF, I, nop, imp) \
+    X(E0, R, cpx, imm) \
+    X(E1, R, sbc, izx) \
+    X(E2, I, nop, imp) \
+    X(E3, I, nop, imp) \
+    X(E4, R, cpx, zp) \
+    X(E5, R, sbc, zp) \
+    X(E6, M, inc, zp) \
+    X(E7, I, nop, imp) \
+    X(E8, I, inx, imp) \
+    X(E9, R, sbc, imm) \
+    X(EA, I, nop, imp) \
+    X(EB, I, nop, imp) \
+    X(EC, R, cpx, abs) \
+    X(ED, R, sbc, abs) \
+    X(EE, M, inc, abs) \
+    X(EF, I, nop, imp) \
+    X(F0, I, beq, imp) \
+    X(F1, R, sbc, izy) \
+    X(F2, I, nop, imp) \
+    X(F3, I, nop, imp) \
+    X(F4, I, nop, imp) \
+    X(F5, R, sbc, zpx) \
+    X(F6, M, inc, zpx) \
+    X(F7, I, nop, imp) \
+    X(F8, I, sed, imp) \
+    X(F9, R, sbc, aby) \
+    X(FA, I, nop, imp) \
+    X(FB, I, nop, imp) \
+    X(FC, I, nop, imp) \
+    X(FD, R, sbc, abx) \
+    X(FE, M, inc, abx) \
+    X(FF, I, nop, imp)
+
+#endif /* NESPRESSO_CPU_OPS_H */
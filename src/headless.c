@@ -0,0 +1,423 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Headless Runner
+ *
+ * Runs the emulation core without a window, vsync or frame pacing and
+ * reports raw throughput. Links only against the SDL-free core library.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local headers */
+#include "cpu/cpu.h"
+#include "ppu/ppu.h"
+#include "apu/apu.h"
+#include "cartridge/rom_store.h"
+#include "memory/bus.h"
+#include "pool/pool.h"
+#include "rewind/rewind.h"
+#include "runahead/runahead.h"
+#include "shm/shm.h"
+#include "trace/trace.h"
+#include "util/timer.h"
+
+#define NESPRESSO_HEADLESS_DEFAULT_FRAMES 3600
+
+/* Usage instructions */
+#define NESPRESSO_HEADLESS_USAGE \
+    "Usage: nespresso_headless <rom_file> [options]\n" \
+    "\n" \
+    "Options:\n" \
+    "  -n, --frames N    Number of frames to run (default: 3600)\n" \
+    "  --render          Convert every frame to RGBA (measures conversion cost)\n" \
+    "  --format F        Pixel format for --render: rgba, rgb565 or indexed\n" \
+    "  --audio           Generate one frame of audio samples per frame\n" \
+    "  --blip            Band-limited batched audio synthesis (implies --audio)\n" \
+    "  --rewind KB       Record every frame into a KB-sized rewind buffer\n" \
+    "  --shm NAME        Publish frames and audio to the shared-memory ring NAME\n" \
+    "  --trace FILE      Log instructions, PPU writes and bank switches to FILE\n" \
+    "                    (needs a NES_ENABLE_TRACE build; decode with nes_tracedump)\n" \
+    "  --scanline        Synchronize CPU and PPU at line ends; render whole lines\n" \
+    "  --catchup         Render whole lines when the PPU catches up with the CPU\n" \
+    "  --no-idle         Execute idle loops instead of fast-forwarding them\n" \
+    "  --render-every N  Draw pixels only every Nth frame (0 = never; default: 1)\n" \
+    "  --run-ahead N     Present each frame N frames ahead (1-8; replaces --render-every)\n" \
+    "  --run-ahead-instance  Run ahead on a second instance instead of rolling back\n" \
+    "  --instances N     Run N independent instances sharing the ROM (default: 1)\n" \
+    "  -j, --threads N   Step instances on an N-worker pool (0 = one per CPU)\n" \
+    "  --obs             Pool mode: use the batch API and copy every frame to an observation array\n" \
+    "  --stats           Print performance counters (needs a NES_ENABLE_STATS build)\n" \
+    "  -h, --help        Show this help\n"
+
+/* Frame sink for --render: every frame is converted into one capture buffer */
+static void* capture_acquire(void* ctx, size_t* pitch) {
+    *pitch = 0;
+    return ctx;
+}
+
+/* Performance counters summed over all instances */
+static void print_stats(nes_system_t* systems, long instances) {
+    static const char* const regions[NES_STATS_REGION_COUNT] = { "RAM", "PPU", "APU", "Mapper" };
+    nes_sys_stats_t total, stats;
+    memset(&total, 0, sizeof(total));
+
+    for (long i = 0; i < instances; i++) {
+        if (nes_sys_get_stats(&systems[i], &stats) != 0) {
+            printf("Stats: not compiled in (build with -DNESPRESSO_STATS=ON or make STATS=1)\n");
+            return;
+        }
+        /* Every field is a uint64_t counter */
+        const uint64_t* src = (const uint64_t*)&stats;
+        uint64_t* dst = (uint64_t*)&total;
+        for (size_t k = 0; k < sizeof(stats) / sizeof(uint64_t); k++) {
+            dst[k] += src[k];
+        }
+    }
+
+    double frames = total.frames ? (double)total.frames : 1.0;
+    printf("Stats over %llu frames (per frame):\n", (unsigned long long)total.frames);
+    printf("  Instructions: %12llu (%.0f)\n", (unsigned long long)total.instructions, total.instructions / frames);
+    printf("  CPU cycles:   %12llu (%.0f)\n", (unsigned long long)total.cpu_cycles, total.cpu_cycles / frames);
+    printf("  Idle skipped: %12llu (%.0f)\n", (unsigned long long)total.idle_cycles, total.idle_cycles / frames);
+    printf("  PPU dots:     %12llu (%.0f)\n", (unsigned long long)total.ppu_dots, total.ppu_dots / frames);
+    for (int r = 0; r < NES_STATS_REGION_COUNT; r++) {
+        printf("  %-6s reads: %10llu (%.0f), writes: %10llu (%.0f)\n", regions[r],
+               (unsigned long long)total.reads[r], total.reads[r] / frames,
+               (unsigned long long)total.writes[r], total.writes[r] / frames);
+    }
+    printf("  Bank switches: %llu, NMIs: %llu, IRQs: %llu, OAM DMAs: %llu\n",
+           (unsigned long long)total.bank_switches, (unsigned long long)total.nmis,
+           (unsigned long long)total.irqs, (unsigned long long)total.oam_dmas);
+    printf("  Time per frame: CPU %.1f us, PPU %.1f us, APU %.1f us, present %.1f us\n",
+           total.cpu_ns / frames / 1e3, total.ppu_ns / frames / 1e3,
+           total.apu_ns / frames / 1e3, total.present_ns / frames / 1e3);
+}
+
+/* Step all instances on the pool, one frame per batch, and report per-worker counters */
+static int run_pool(nes_system_t* systems, long instances, long frames, long threads, int obs,
+                    long render_every) {
+    nes_pool_t* pool = nes_pool_create((int)threads);
+    if (!pool) {
+        fprintf(stderr, "Failed to create worker pool\n");
+        return 1;
+    }
+
+    /* Batch buffers are allocated once, as a training loop would */
+    uint8_t* inputs = NULL;
+    uint8_t* observations = NULL;
+    if (obs) {
+        inputs = (uint8_t*)calloc((size_t)instances, 1);
+        observations = (uint8_t*)malloc((size_t)instances * NES_FRAME_PIXELS);
+        if (!inputs || !observations) {
+            fprintf(stderr, "Failed to allocate observation buffers\n");
+            free(inputs);
+            free(observations);
+            nes_pool_destroy(pool);
+            return 1;
+        }
+    }
+
+    uint64_t start = nes_timer_now_ns();
+    for (long f = 0; f < frames; f++) {
+        if (render_every != 1) {
+            for (long i = 0; i < instances; i++) {
+                nes_sys_set_render(&systems[i], render_every > 0 && f % render_every == 0);
+            }
+        }
+        if (obs) {
+            nes_pool_step_frames_batch(pool, systems, (size_t)instances, inputs, observations);
+        } else {
+            nes_pool_step_frames(pool, systems, (size_t)instances, 1);
+        }
+    }
+    uint64_t elapsed = nes_timer_now_ns() - start;
+    free(inputs);
+    free(observations);
+
+    double seconds = (double)elapsed / 1e9;
+    double total = (double)frames * (double)instances;
+    double fps = seconds > 0.0 ? total / seconds : 0.0;
+    printf("Instances: %ld, Workers: %d\n", instances, nes_pool_num_workers(pool));
+    printf("Frames: %.0f\n", total);
+    printf("Time: %.3f s\n", seconds);
+    printf("FPS: %.1f (%.1fx realtime)\n", fps, fps / NES_FRAMES_PER_SECOND);
+
+    for (int w = 0; w < nes_pool_num_workers(pool); w++) {
+        nes_pool_stats_t stats;
+        nes_pool_get_stats(pool, w, &stats);
+        double busy = (double)stats.busy_ns / 1e9;
+        printf("  Worker %2d: %8llu frames, %6llu steals, %5.1f%% busy, %.1f FPS\n", w,
+               (unsigned long long)stats.frames, (unsigned long long)stats.steals,
+               seconds > 0.0 ? 100.0 * busy / seconds : 0.0,
+               busy > 0.0 ? (double)stats.frames / busy : 0.0);
+    }
+
+    nes_pool_destroy(pool);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* rom_filename = NULL;
+    long frames = NESPRESSO_HEADLESS_DEFAULT_FRAMES;
+    int render = 0;
+    nes_pixel_format_t format = NES_PIXEL_RGBA8888;
+    int audio = 0;
+    nes_apu_synth_t synth = NES_APU_SYNTH_POINT;
+    long instances = 1;
+    long threads = -1;  /* -1 = no pool */
+    int obs = 0;
+    int stats = 0;
+    long rewind_kb = 0;
+    const char* shm_name = NULL;
+    const char* trace_name = NULL;
+    nes_sync_mode_t sync_mode = NES_SYNC_DOT;
+    int idle_skip = 1;
+    long render_every = 1;
+    long run_ahead = 0;
+    int run_ahead_instance = 0;
+
+    /* Parse command line */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printf("%s", NESPRESSO_HEADLESS_USAGE);
+            return 0;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--frames") == 0) && i + 1 < argc) {
+            frames = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--render") == 0) {
+            render = 1;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            if (strcmp(name, "rgb565") == 0) {
+                format = NES_PIXEL_RGB565;
+            } else if (strcmp(name, "indexed") == 0) {
+                format = NES_PIXEL_INDEXED;
+            } else {
+                format = NES_PIXEL_RGBA8888;
+            }
+            render = 1;
+        } else if (strcmp(argv[i], "--audio") == 0) {
+            audio = 1;
+        } else if (strcmp(argv[i], "--blip") == 0) {
+            synth = NES_APU_SYNTH_BLIP;
+            audio = 1;
+        } else if (strcmp(argv[i], "--rewind") == 0 && i + 1 < argc) {
+            rewind_kb = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_name = argv[++i];
+        } else if (strcmp(argv[i], "--scanline") == 0) {
+            sync_mode = NES_SYNC_SCANLINE;
+        } else if (strcmp(argv[i], "--catchup") == 0) {
+            sync_mode = NES_SYNC_CATCHUP;
+        } else if (strcmp(argv[i], "--no-idle") == 0) {
+            idle_skip = 0;
+        } else if (strcmp(argv[i], "--render-every") == 0 && i + 1 < argc) {
+            render_every = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc) {
+            run_ahead = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--run-ahead-instance") == 0) {
+            run_ahead_instance = 1;
+        } else if (strcmp(argv[i], "--obs") == 0) {
+            obs = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = 1;
+        } else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+            instances = strtol(argv[++i], NULL, 10);
+        } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--threads") == 0) && i + 1 < argc) {
+            threads = strtol(argv[++i], NULL, 10);
+        } else if (argv[i][0] != '-') {
+            rom_filename = argv[i];
+        }
+    }
+
+    if (!rom_filename || frames <= 0 || instances <= 0) {
+        fprintf(stderr, "Error: No ROM file specified\n\n%s", NESPRESSO_HEADLESS_USAGE);
+        return 1;
+    }
+
+    nes_system_t* systems = (nes_system_t*)calloc((size_t)instances, sizeof(nes_system_t));
+    if (!systems) {
+        fprintf(stderr, "Failed to allocate %ld instances\n", instances);
+        return 1;
+    }
+
+    /* Every instance shares the one mapped ROM image */
+    nes_rom_store_t* store = nes_rom_store_create();
+    if (!store) {
+        fprintf(stderr, "Failed to create ROM store\n");
+        free(systems);
+        return 1;
+    }
+
+    long ready = 0;
+    int status = 0;
+    for (; ready < instances; ready++) {
+        if (nes_sys_init(&systems[ready]) != 0) {
+            fprintf(stderr, "Failed to initialize NES system\n");
+            status = 1;
+            break;
+        }
+        if (nes_sys_load_rom_store(&systems[ready], store, rom_filename) != 0) {
+            fprintf(stderr, "Failed to load ROM\n");
+            nes_sys_free(&systems[ready]);
+            status = 1;
+            break;
+        }
+        nes_sys_set_sync_mode(&systems[ready], sync_mode);
+        nes_apu_set_synthesis(systems[ready].apu, synth, 0);
+        nes_cpu_set_idle_skip(systems[ready].cpu, idle_skip);
+    }
+
+    if (status == 0 && (instances > 1 || threads >= 0 || obs)) {
+        if (render || audio || shm_name || trace_name || run_ahead) {
+            fprintf(stderr, "Note: --render/--audio/--shm/--trace/--run-ahead are ignored in pool mode\n");
+        }
+        status = run_pool(systems, instances, frames, threads < 0 ? 0 : threads, obs, render_every);
+    } else if (status == 0) {
+        uint32_t* frame_buffer = NULL;
+        if (render) {
+            frame_buffer = (uint32_t*)malloc(PPU_WIDTH * PPU_HEIGHT * sizeof(uint32_t));
+            if (!frame_buffer) {
+                fprintf(stderr, "Failed to allocate frame buffer\n");
+                status = 1;
+            } else {
+                nes_frame_sink_t sink = { frame_buffer, format, capture_acquire, NULL };
+                nes_sys_set_frame_sink(&systems[0], &sink);
+            }
+        }
+        float samples[APU_SAMPLES_PER_FRAME];
+
+        nes_rewind_t* rewind = NULL;
+        if (rewind_kb > 0) {
+            rewind = nes_rewind_create((size_t)rewind_kb * 1024, 0);
+            if (!rewind) {
+                fprintf(stderr, "Failed to allocate rewind buffer\n");
+                status = 1;
+            }
+        }
+
+        nes_shm_ring_t* ring = NULL;
+        if (shm_name) {
+            ring = nes_shm_ring_create(shm_name, 0, 0);
+            if (!ring) {
+                fprintf(stderr, "Failed to create shared-memory ring %s\n", shm_name);
+                status = 1;
+            }
+        }
+
+        nes_trace_t* trace = NULL;
+        if (trace_name) {
+            if (!NES_TRACE_ENABLED) {
+                fprintf(stderr, "Trace: not compiled in (build with -DNESPRESSO_TRACE=ON or make TRACE=1)\n");
+                status = 1;
+            } else if (!(trace = nes_trace_create(0)) || nes_trace_start_file(trace, trace_name) != 0) {
+                fprintf(stderr, "Failed to start trace %s\n", trace_name);
+                status = 1;
+            } else {
+                nes_sys_set_trace(&systems[0], trace);
+            }
+        }
+
+        nes_runahead_t* runahead = NULL;
+        if (status == 0 && run_ahead) {
+            runahead = nes_runahead_create(&systems[0], (int)run_ahead, run_ahead_instance);
+            if (!runahead) {
+                fprintf(stderr, "Failed to set up run-ahead of %ld frames (1-%d)\n",
+                        run_ahead, NES_RUNAHEAD_MAX_FRAMES);
+                status = 1;
+            }
+        }
+
+        /* Run as fast as possible - no pacing */
+        uint64_t start = nes_timer_now_ns();
+        long frame_count = 0;
+        while (status == 0 && frame_count < frames && systems[0].running) {
+            if (runahead) {
+                if (nes_runahead_step_frame(runahead) < 0) {
+                    fprintf(stderr, "Run-ahead failed at frame %ld\n", frame_count);
+                    status = 1;
+                    break;
+                }
+            } else {
+                if (render_every != 1) {
+                    nes_sys_set_render(&systems[0], render_every > 0 && frame_count % render_every == 0);
+                }
+                nes_sys_step_frame(&systems[0]);
+            }
+            int sample_count = 0;
+            if (audio || ring) {
+                sample_count = nes_sys_get_audio(&systems[0], samples, APU_SAMPLES_PER_FRAME);
+            }
+            if (ring) {
+                const uint8_t* frame = runahead ? nes_runahead_get_frame_buffer(runahead)
+                                                : nes_sys_get_frame_buffer(&systems[0]);
+                nes_shm_ring_publish(ring, frame, samples,
+                                     sample_count > 0 ? (uint32_t)sample_count : 0);
+            }
+            if (rewind) {
+                nes_rewind_push(rewind, &systems[0]);
+            }
+            frame_count++;
+        }
+        uint64_t elapsed = nes_timer_now_ns() - start;
+
+        if (status == 0) {
+            double seconds = (double)elapsed / 1e9;
+            double fps = seconds > 0.0 ? (double)frame_count / seconds : 0.0;
+            printf("Frames: %ld\n", frame_count);
+            printf("Time: %.3f s\n", seconds);
+            printf("FPS: %.1f (%.1fx realtime)\n", fps, fps / NES_FRAMES_PER_SECOND);
+        }
+        if (runahead) {
+            if (status == 0) {
+                printf("Run-ahead: %ld frames, %llu of %ld steps resynchronized\n", run_ahead,
+                       (unsigned long long)nes_runahead_resyncs(runahead), frame_count);
+            }
+            nes_runahead_destroy(runahead);
+        }
+        if (rewind) {
+            size_t count = nes_rewind_count(rewind);
+            size_t used = nes_rewind_bytes_used(rewind);
+            printf("Rewind: %zu frames in %.1f KB (%.0f bytes/frame, raw %zu)\n", count,
+                   (double)used / 1024.0, count ? (double)used / (double)count : 0.0,
+                   nes_sys_snapshot_size(&systems[0]));
+            nes_rewind_destroy(rewind);
+        }
+        if (ring) {
+            printf("Shm: %llu frames published to %s\n",
+                   (unsigned long long)nes_shm_ring_header(ring)->published, shm_name);
+            nes_shm_ring_close(ring);
+        }
+        if (trace) {
+            nes_sys_set_trace(&systems[0], NULL);
+            nes_trace_stop_file(trace);
+            if (status == 0) {
+                printf("Trace: written to %s, %llu records dropped\n", trace_name,
+                       (unsigned long long)nes_trace_dropped(trace));
+            }
+            nes_trace_destroy(trace);
+        }
+        free(frame_buffer);
+    }
+
+    if (status == 0) {
+        printf("ROM store: %zu image(s)\n", nes_rom_store_count(store));
+        if (stats) {
+            print_stats(systems, ready);
+        }
+    }
+
+    /* The image is unmapped once the store and its last cartridge are gone */
+    nes_rom_store_destroy(store);
+    while (ready-- > 0) {
+        nes_sys_free(&systems[ready]);
+    }
+    free(systems);
+    return status;
+}
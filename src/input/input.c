@@ -35,6 +35,14 @@ void nes_input_set_button(nes_input_t* input, int controller, int button, int pr
     }
 }
 
+void nes_input_set_buttons(nes_input_t* input, int controller, uint8_t mask) {
+    if (controller >= 0 && controller < 2) {
+        for (int i = 0; i < NUM_BUTTONS; i++) {
+            input->buttons[controller][i] = (mask >> i) & 1;
+        }
+    }
+}
+
 int nes_input_get_button(const nes_input_t* input, int controller, int button) {
     if (controller >= 0 && controller < 2 && button >= 0 && button < NUM_BUTTONS) {
         return input->buttons[controller][button] != 0;
@@ -73,6 +73,12 @@ void nes_input_reset(nes_input_t* input);
  */
 void nes_input_set_button(nes_input_t* input, int controller, int button, int pressed);
 
+/**
+ * Set all 8 buttons of a controller at once
+ * Bit N of mask is button N (bit 0 = A ... bit 7 = Right, the $4016 read order)
+ */
+void nes_input_set_buttons(nes_input_t* input, int controller, uint8_t mask);
+
 /**
  * Get button state
  */
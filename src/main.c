@@ -23,10 +23,14 @@
 
 /* Local headers */
 #include "ppu/ppu.h"
+#include "apu/apu.h"
 #include "cartridge/rom.h"
 #include "memory/bus.h"
 #include "platform/platform.h"
 #include "input/input.h"
+#include "runahead/runahead.h"
+#include "util/atomic.h"
+#include "util/thread.h"
 
 /* Version info */
 #define NESPRESSO_VERSION "0.9.0"
@@ -49,6 +53,9 @@
     "Compiler: " __DATE__ "\n" \
     "Brewing Nostalgia One Frame at a Time!\n"
 
+/* Per-game run-ahead settings: "<ROM CRC32 in hex> <frames> [instance]" per line */
+#define NESPRESSO_RUNAHEAD_CONFIG "runahead.cfg"
+
 /* Usage instructions */
 #define NESPRESSO_USAGE \
     "Usage: nespresso <rom_file> [options]\n" \
@@ -59,6 +66,9 @@
     "  --pal             Force PAL timing\n" \
     "  --ntsc            Force NTSC timing (default)\n" \
     "  --no-audio        Disable audio\n" \
+    "  --run-ahead N     Run N frames ahead to cut input lag (0 = off, max 8)\n" \
+    "  --run-ahead-instance  Run ahead on a second instance instead of rolling back\n" \
+    "                    (defaults for both come from " NESPRESSO_RUNAHEAD_CONFIG " per game)\n" \
     "  -h, --help        Show this help\n" \
     "\n" \
     "Controls:\n" \
@@ -79,6 +89,8 @@
 /* Global state */
 static nes_system_t g_system;
 static nes_platform_t g_platform;
+static nes_runahead_t* g_runahead = NULL;
+static float g_audio_samples[APU_SAMPLE_CAPACITY];
 
 /* Initialize save directory */
 static int create_save_directory(void) {
@@ -91,11 +103,93 @@ static int create_save_directory(void) {
     return 0;
 }
 
+/* Look up the run-ahead settings for a ROM in NESPRESSO_RUNAHEAD_CONFIG
+ * Returns 1 if the game has an entry, 0 otherwise */
+static int load_run_ahead_config(uint32_t crc32, int* frames, int* instance) {
+    FILE* file = fopen(NESPRESSO_RUNAHEAD_CONFIG, "r");
+    if (!file) {
+        return 0;
+    }
+
+    char line[256];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file)) {
+        unsigned int crc;
+        int count;
+        char mode[32] = "";
+        if (line[0] == '#' || sscanf(line, "%x %d %31s", &crc, &count, mode) < 2 || crc != crc32) {
+            continue;
+        }
+        *frames = count;
+        *instance = strcmp(mode, "instance") == 0;
+        found = 1;
+    }
+    fclose(file);
+    return found;
+}
+
+/* Emulation thread - runs, paces and hands off frames until told to stop */
+static void emulation_main(void* arg) {
+    (void)arg;
+    uint64_t frame_count = 0;
+    uint64_t perf_start = nes_platform_get_time_us();
+    g_platform.last_time = perf_start;
+
+    while (g_system.running && nes_platform_apply_input(&g_platform, &g_system)) {
+        /* Run one frame; the frame sink publishes it to the presenter */
+        if (g_runahead) {
+            nes_runahead_step_frame(g_runahead);
+        } else {
+            nes_sys_step_frame(&g_system);
+        }
+
+        /* Hand this frame's samples to the audio callback */
+        int sample_count = nes_sys_get_audio(&g_system, g_audio_samples, APU_SAMPLE_CAPACITY);
+        nes_platform_submit_audio(&g_platform, g_audio_samples, sample_count);
+
+        frame_count++;
+
+        /* Calculate and display FPS every 60 frames */
+        if (frame_count % 60 == 0) {
+            uint64_t now = nes_platform_get_time_us();
+            uint64_t elapsed = now - perf_start;
+            if (elapsed > 0) {
+                uint32_t fps = (uint32_t)(frame_count * 1000000 / elapsed);
+                /* Only print FPS occasionally to avoid spam */
+                if (frame_count % 360 == 0) {
+                    printf("FPS: %d\n", fps);
+
+                    /* Where the time went since the last report (NES_ENABLE_STATS builds) */
+                    nes_sys_stats_t stats;
+                    if (nes_sys_get_stats(&g_system, &stats) == 0 && stats.frames > 0) {
+                        double n = (double)stats.frames;
+                        printf("  Per frame: %.0f instructions, CPU %.0f us, PPU %.0f us, "
+                               "APU %.0f us, present %.0f us, %.1f bank switches\n",
+                               stats.instructions / n, stats.cpu_ns / n / 1e3, stats.ppu_ns / n / 1e3,
+                               stats.apu_ns / n / 1e3, stats.present_ns / n / 1e3, stats.bank_switches / n);
+                        nes_sys_reset_stats(&g_system);
+                    }
+                }
+            }
+        }
+
+        /* Timing - the audio queue paces emulation; without audio, frame deadlines on the clock */
+        if (nes_platform_wait_audio(&g_platform) != 0) {
+            nes_platform_wait_frame(&g_platform);
+        }
+    }
+
+    /* Stopped on its own: take the main thread down too */
+    nes_atomic_store_u32(&g_platform.quit, 1);
+}
+
 /* Main function */
 int main(int argc, char* argv[]) {
     int scale = 3;
     int fullscreen = 0;
     int audio_enabled = 1;
+    int run_ahead = -1;             /* -1 = per-game setting */
+    int run_ahead_instance = -1;
     char* rom_filename = NULL;
 
     /* Parse command line */
@@ -115,6 +209,10 @@ int main(int argc, char* argv[]) {
             fullscreen = 1;
         } else if (strcmp(argv[i], "--no-audio") == 0) {
             audio_enabled = 0;
+        } else if (strcmp(argv[i], "--run-ahead") == 0 && i + 1 < argc) {
+            run_ahead = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--run-ahead-instance") == 0) {
+            run_ahead_instance = 1;
         } else if (argv[i][0] != '-') {
             rom_filename = argv[i];
         }
@@ -180,53 +278,53 @@ int main(int argc, char* argv[]) {
     printf("Controls: Arrows=D-Pad, Z=A, X=B, Enter=Start, Tab=Select\n");
     printf("Hotkeys: F1=Reset, F5=Save, F9=Load, F11=Fullscreen, ESC=Exit\n");
 
-    /* Frame buffer for rendering */
-    uint32_t frame_buffer[PPU_WIDTH * PPU_HEIGHT];
+    /* Band-limited audio for the speakers */
+    nes_apu_set_synthesis(g_system.apu, NES_APU_SYNTH_BLIP, 0);
 
-    /* Set system as audio user data */
-    g_platform.audio.device = (void*)&g_system;
+    /* Frames are rendered straight into the window texture */
+    nes_platform_set_frame_sink(&g_platform, &g_system);
 
-    /* Main loop */
-    printf("\n--- Running (press ESC to exit) ---\n\n");
-    uint64_t frame_count = 0;
-    uint64_t perf_start = nes_platform_get_time_us();
+    /* Run-ahead - the command line overrides the game's entry */
+    int game_frames = 0;
+    int game_instance = 0;
+    load_run_ahead_config(g_system.cartridge->info.crc32, &game_frames, &game_instance);
+    if (run_ahead < 0) {
+        run_ahead = game_frames;
+    }
+    if (run_ahead_instance < 0) {
+        run_ahead_instance = game_instance;
+    }
 
-    while (g_system.running) {
-        /* Process events */
-        if (!nes_platform_process_events(&g_platform, &g_system)) {
-            break;
+    if (run_ahead > 0) {
+        g_runahead = nes_runahead_create(&g_system, run_ahead, run_ahead_instance);
+        if (g_runahead) {
+            printf("Run-ahead: %d frame(s)%s\n", run_ahead, run_ahead_instance ? " on a second instance" : "");
+        } else {
+            printf("Warning: Run-ahead of %d frames is not available, running without\n", run_ahead);
         }
+    }
+    printf("ROM CRC32: %08X (per-game settings go in %s)\n",
+           (unsigned int)g_system.cartridge->info.crc32, NESPRESSO_RUNAHEAD_CONFIG);
 
-        /* Run one frame */
-        nes_sys_step_frame(&g_system);
-
-        /* Render frame */
-        nes_sys_render_frame(&g_system, frame_buffer);
-        nes_platform_present_frame(&g_platform, frame_buffer);
-
-        frame_count++;
-
-        /* Calculate and display FPS every 60 frames */
-        if (frame_count % 60 == 0) {
-            uint64_t now = nes_platform_get_time_us();
-            uint64_t elapsed = now - perf_start;
-            if (elapsed > 0) {
-                uint32_t fps = (uint32_t)(frame_count * 1000000 / elapsed);
-                /* Only print FPS occasionally to avoid spam */
-                if (frame_count % 360 == 0) {
-                    printf("FPS: %d\n", fps);
-                }
-            }
-        }
+    /* Emulation runs on its own thread; this one only handles events and
+     * presents, so a slow present or a vsync stall never holds up emulation */
+    printf("\n--- Running (press ESC to exit) ---\n\n");
+    nes_thread_t emulation_thread;
+    if (nes_thread_create(&emulation_thread, emulation_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start emulation thread\n");
+        nes_runahead_destroy(g_runahead);
+        nes_sys_free(&g_system);
+        nes_platform_shutdown(&g_platform);
+        return 1;
+    }
 
-        /* Timing - target 60 FPS */
-        uint64_t frame_time = (uint64_t)(1000000 / 60);
-        uint64_t elapsed = nes_platform_get_time_us() - g_platform.last_time;
-        if (elapsed < frame_time) {
-            nes_platform_sleep_us(frame_time - elapsed);
+    while (nes_platform_process_events(&g_platform)) {
+        /* Presenting blocks on vsync; with nothing new, wait for the next frame */
+        if (!nes_platform_present_latest(&g_platform)) {
+            nes_thread_sleep_ms(1);
         }
-        g_platform.last_time = nes_platform_get_time_us();
     }
+    nes_thread_join(&emulation_thread);
 
     /* Shutdown */
     printf("\nShutting down...\n");
@@ -237,6 +335,7 @@ int main(int argc, char* argv[]) {
         nes_cartridge_save_sram(g_system.cartridge, "save/sram.sav");
     }
 
+    nes_runahead_destroy(g_runahead);
     nes_sys_free(&g_system);
     nes_platform_shutdown(&g_platform);
 
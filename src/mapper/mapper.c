@@ -7,32 +7,128 @@
 
 #include "mapper.h"
 #include "../cartridge/rom.h"
+#include "../ppu/ppu.h"
+#include "../util/stats.h"
+#include "../trace/trace.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 
-/* Global PPU reference for mirroring control */
-static nes_ppu_t* g_ppu = NULL;
+/* Save-state helpers - each context keeps its pointers first, plain state after */
+#define MAPPER_STATE_SIZE(type, first) (sizeof(type) - offsetof(type, first))
+
+static void mapper_state_store(mapper_buffer_t* out, const void* state, size_t size) {
+    memcpy(out->data, state, size);
+    out->size = (uint8_t)size;
+}
+
+static int mapper_state_fetch(const mapper_buffer_t* in, void* state, size_t size) {
+    if (in->size != size) {
+        return -1;
+    }
+    memcpy(state, in->data, size);
+    return 0;
+}
+
+/* Effective banking, recomputed whenever a bank register is written:
+ * PRG-ROM offset of each 8KB window at $8000-$FFFF and CHR offset of each
+ * 1KB pattern page, already wrapped to the ROM size. PRG and CHR sizes are
+ * multiples of the window sizes, so every window is contiguous */
+#define MAPPER_PRG_WINDOW_SHIFT 13
+#define MAPPER_PRG_WINDOWS      4
+
+typedef struct {
+    uint32_t prg[MAPPER_PRG_WINDOWS];
+    uint32_t chr[NES_CHR_PAGES];
+} mapper_banks_t;
+
+/* PRG-ROM byte of a CPU address in $8000-$FFFF */
+static inline uint8_t mapper_read_prg(const nes_cartridge_t* cart, const mapper_banks_t* banks, uint16_t addr) {
+    return cart->prg_rom[banks->prg[(addr >> MAPPER_PRG_WINDOW_SHIFT) & (MAPPER_PRG_WINDOWS - 1)] +
+                         (addr & ((1u << MAPPER_PRG_WINDOW_SHIFT) - 1))];
+}
+
+/* CHR byte of a PPU address in $0000-$1FFF */
+static inline uint8_t mapper_read_chr(const nes_cartridge_t* cart, const mapper_banks_t* banks, uint16_t addr) {
+    return cart->chr_rom[banks->chr[addr >> NES_CHR_PAGE_SHIFT] + (addr & 0x3FF)];
+}
+
+/* CHR-RAM write through the same banking as reads */
+static inline void mapper_write_chr(nes_cartridge_t* cart, const mapper_banks_t* banks, uint16_t addr, uint8_t val) {
+    if (addr < 0x2000 && cart->info.has_chrram) {
+        cart->chr_rom[banks->chr[addr >> NES_CHR_PAGE_SHIFT] + (addr & 0x3FF)] = val;
+    }
+}
+
+/* PRG-ROM offset of a CPU address in $8000-$FFFF under the current banking */
+typedef uint32_t (*mapper_prg_offset_t)(void* ctx, uint16_t addr);
+
+/* CHR offset of a PPU address in $0000-$1FFF under the current banking */
+typedef uint32_t (*mapper_chr_offset_t)(void* ctx, uint16_t addr);
+
+/* Count a bank register update for nes_sys_get_stats() and log it to the trace */
+static inline void mapper_bank_switched(nes_memory_map_t* map, uint16_t addr, uint8_t val) {
+    NES_STAT(if (map) map->bank_switches++);
+    NES_TRACE(if (map && map->trace) nes_trace_event(map->trace, NES_TRACE_BANK_SWITCH, addr, val));
+#if !NES_TRACE_ENABLED
+    (void)map;
+    (void)addr;
+    (void)val;
+#endif
+}
+
+/* Recompute banks from the mapper's offset functions and point the
+ * $8000-$FFFF read pages and the PPU's pattern pages straight at them */
+static void mapper_set_banks(mapper_banks_t* banks, nes_memory_map_t* map, const nes_cartridge_t* cart,
+                             mapper_prg_offset_t prg, mapper_chr_offset_t chr, void* ctx) {
+    for (int window = 0; window < MAPPER_PRG_WINDOWS; window++) {
+        uint16_t addr = (uint16_t)(0x8000 + (window << MAPPER_PRG_WINDOW_SHIFT));
+        banks->prg[window] = cart->prg_rom && cart->prg_rom_size ? prg(ctx, addr) % cart->prg_rom_size : 0;
+    }
+    for (int page = 0; page < NES_CHR_PAGES; page++) {
+        uint16_t addr = (uint16_t)(page << NES_CHR_PAGE_SHIFT);
+        banks->chr[page] = cart->chr_rom && cart->chr_rom_size ? chr(ctx, addr) % cart->chr_rom_size : 0;
+    }
+
+    if (!map) {
+        return;
+    }
+    for (int page = 0x80; page < NES_MAP_PAGES; page++) {
+        int window = (page >> (MAPPER_PRG_WINDOW_SHIFT - NES_MAP_PAGE_SHIFT)) & (MAPPER_PRG_WINDOWS - 1);
+        uint32_t offset = (uint32_t)(page << NES_MAP_PAGE_SHIFT) & ((1u << MAPPER_PRG_WINDOW_SHIFT) - 1);
+        map->read[page] = cart->prg_rom && cart->prg_rom_size ? cart->prg_rom + banks->prg[window] + offset : NULL;
+    }
+    for (int page = 0; page < NES_CHR_PAGES; page++) {
+        map->chr[page] = cart->chr_rom && cart->chr_rom_size ? cart->chr_rom + banks->chr[page] : NULL;
+    }
+}
+
+/* Unbanked 8KB of CHR - mappers 0, 2 and 7 */
+static uint32_t mapper_fixed_chr_offset(void* ctx, uint16_t addr) {
+    (void)ctx;
+    return addr;
+}
 
 /* Mapper 0 (NROM) - No mapping */
 
 typedef struct {
     nes_cartridge_t* cart;
+    nes_memory_map_t* map;
+    mapper_banks_t   banks;
 } mapper_0_ctx_t;
 
-static mapper_0_ctx_t g_mapper_0_ctx = {NULL};
+static uint32_t mapper_0_prg_offset(void* ctx, uint16_t addr) {
+    (void)ctx;
+    /* 32KB PRG-ROM mapping, 16KB ROMs mirror */
+    return addr & 0x7FFF;
+}
 
 static uint8_t mapper_0_cpu_read(void* ctx, uint16_t addr) {
     mapper_0_ctx_t* m = (mapper_0_ctx_t*)ctx;
-    uint32_t prg_addr;
 
     if (addr >= 0x8000) {
-        /* 32KB PRG-ROM mapping */
-        prg_addr = addr & 0x7FFF;
-        if (prg_addr < m->cart->prg_rom_size) {
-            return m->cart->prg_rom[prg_addr];
-        }
-        /* Mirror for 16KB ROMs */
-        return m->cart->prg_rom[prg_addr % m->cart->prg_rom_size];
+        return mapper_read_prg(m->cart, &m->banks, addr);
     }
     return 0;
 }
@@ -47,31 +143,38 @@ static void mapper_0_cpu_write(void* ctx, uint16_t addr, uint8_t val) {
 static uint8_t mapper_0_ppu_read(void* ctx, uint16_t addr) {
     mapper_0_ctx_t* m = (mapper_0_ctx_t*)ctx;
     if (addr < 0x2000 && m->cart->chr_rom) {
-        return m->cart->chr_rom[addr & (m->cart->chr_rom_size - 1)];
+        return mapper_read_chr(m->cart, &m->banks, addr);
     }
     return 0;
 }
 
 static void mapper_0_ppu_write(void* ctx, uint16_t addr, uint8_t val) {
     mapper_0_ctx_t* m = (mapper_0_ctx_t*)ctx;
-    if (addr < 0x2000) {
-        /* CHR-RAM */
-        m->cart->chr_rom[addr & (m->cart->chr_rom_size - 1)] = val;
-    }
+    mapper_write_chr(m->cart, &m->banks, addr, val);    /* CHR-RAM */
 }
 
-int mapper_0_init(nes_cartridge_t* cart, nes_mapper_t* mapper) {
-    g_mapper_0_ctx.cart = cart;
+int mapper_0_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_memory_map_t* map) {
+    mapper_0_ctx_t* m = (mapper_0_ctx_t*)calloc(1, sizeof(mapper_0_ctx_t));
+    if (!m) {
+        return -1;
+    }
+    m->cart = cart;
+    m->map = map;
+    mapper_set_banks(&m->banks, map, cart, mapper_0_prg_offset, mapper_fixed_chr_offset, m);
 
     mapper->number = 0;
     mapper->cpu_read = mapper_0_cpu_read;
     mapper->cpu_write = mapper_0_cpu_write;
     mapper->ppu_read = mapper_0_ppu_read;
     mapper->ppu_write = mapper_0_ppu_write;
-    mapper->context = &g_mapper_0_ctx;
+    mapper->context = m;
     mapper->reset = NULL;
     mapper->scanline = NULL;
     mapper->clock_irq = NULL;
+    mapper->a12_rise = NULL;
+    mapper->irq_line = NULL;
+    mapper->save_state = NULL;  /* NROM has no registers */
+    mapper->load_state = NULL;
 
     return 0;
 }
@@ -88,6 +191,9 @@ int mapper_0_init(nes_cartridge_t* cart, nes_mapper_t* mapper) {
 
 typedef struct {
     nes_cartridge_t* cart;
+    nes_ppu_t*       ppu;               /* Mirroring control */
+    nes_memory_map_t* map;              /* Page tables (may be NULL) */
+    mapper_banks_t   banks;
     uint8_t  shift_reg;          /* 5-bit shift register */
     uint8_t  shift_count;        /* Number of bits in shift register */
     uint8_t  control;            /* Control register */
@@ -100,60 +206,64 @@ typedef struct {
     uint8_t  prg_ram_disabled;   /* PRG-RAM disable */
 } mapper_1_ctx_t;
 
-static mapper_1_ctx_t g_mapper_1_ctx;
-
 static inline uint8_t mmc1_get_bank(nes_cartridge_t* cart, uint8_t bank) {
     int num_banks = cart->info.prg_rom_banks;
     if (num_banks <= 1) return 0;
     return bank & (num_banks - 1);
 }
 
+static uint32_t mapper_1_prg_offset(void* ctx, uint16_t addr) {
+    mapper_1_ctx_t* m = (mapper_1_ctx_t*)ctx;
+    nes_cartridge_t* cart = m->cart;
+
+    switch (m->prg_mode) {
+        case MMC1_PRG_MODE_0:
+        case MMC1_PRG_MODE_1: {
+            /* 32KB mode: address lines A14 select bank */
+            uint8_t bank = mmc1_get_bank(cart, (m->prg_bank & 0x0E) | ((addr >> 14) & 1));
+            return (bank * NES_PRG_ROM_SIZE) + (addr & 0x7FFF);
+        }
+
+        case MMC1_PRG_MODE_2:
+            /* Fix first bank, switch last */
+            if (addr < 0xC000) {
+                return addr & 0x3FFF;  /* First bank */
+            }
+            return (m->prg_bank * NES_PRG_ROM_SIZE) + (addr & 0x3FFF);
+
+        default:
+            /* Switch first bank, fix last */
+            if (addr < 0xC000) {
+                return (m->prg_bank * NES_PRG_ROM_SIZE) + (addr & 0x3FFF);
+            }
+            return (cart->info.prg_rom_banks - 1) * NES_PRG_ROM_SIZE + (addr & 0x3FFF);  /* Last bank */
+    }
+}
+
+static uint32_t mapper_1_chr_offset(void* ctx, uint16_t addr) {
+    mapper_1_ctx_t* m = (mapper_1_ctx_t*)ctx;
+
+    if (m->chr_mode == MMC1_CHR_MODE_0) {
+        /* 8KB mode */
+        uint8_t bank = m->chr_bank_0 & 0x1E;
+        return (bank * NES_CHR_ROM_SIZE) + addr;
+    }
+
+    /* 4KB mode */
+    uint8_t bank = (addr < 0x1000) ? m->chr_bank_0 : m->chr_bank_1;
+    return (bank * NES_CHR_ROM_SIZE) + (addr & 0x0FFF);
+}
+
+static void mapper_1_map(mapper_1_ctx_t* m) {
+    mapper_set_banks(&m->banks, m->map, m->cart, mapper_1_prg_offset, mapper_1_chr_offset, m);
+}
+
 static uint8_t mapper_1_cpu_read(void* ctx, uint16_t addr) {
     mapper_1_ctx_t* m = (mapper_1_ctx_t*)ctx;
     nes_cartridge_t* cart = m->cart;
 
     if (addr >= 0x8000) {
-        uint8_t bank;
-        uint32_t base;
-
-        switch (m->prg_mode) {
-            case MMC1_PRG_MODE_0:
-            case MMC1_PRG_MODE_1:
-                /* 32KB mode: address lines A14 select bank */
-                bank = mmc1_get_bank(cart, (m->prg_bank & 0x0E) | ((addr >> 14) & 1));
-                base = (bank * NES_PRG_ROM_SIZE) + (addr & 0x7FFF);
-                if (base < cart->prg_rom_size) {
-                    return cart->prg_rom[base];
-                }
-                return cart->prg_rom[base % cart->prg_rom_size];
-
-            case MMC1_PRG_MODE_2:
-                /* Fix first bank, switch last */
-                if (addr < 0xC000) {
-                    base = 0;  /* First bank */
-                } else {
-                    bank = m->prg_bank;
-                    base = (bank * NES_PRG_ROM_SIZE) + (addr & 0x3FFF);
-                }
-                if (base < cart->prg_rom_size) {
-                    return cart->prg_rom[base];
-                }
-                return cart->prg_rom[base % cart->prg_rom_size];
-
-            case MMC1_PRG_MODE_3:
-                /* Switch first bank, fix last */
-                if (addr < 0xC000) {
-                    bank = m->prg_bank;
-                    base = (bank * NES_PRG_ROM_SIZE) + (addr & 0x3FFF);
-                } else {
-                    base = (cart->info.prg_rom_banks - 1) * NES_PRG_ROM_SIZE;  /* Last bank */
-                    base += (addr & 0x3FFF);
-                }
-                if (base < cart->prg_rom_size) {
-                    return cart->prg_rom[base];
-                }
-                return cart->prg_rom[base % cart->prg_rom_size];
-        }
+        return mapper_read_prg(cart, &m->banks, addr);
     }
 
     /* PRG-RAM @ $6000-$7FFF */
@@ -167,6 +277,11 @@ static uint8_t mapper_1_cpu_read(void* ctx, uint16_t addr) {
 static void mapper_1_write(void* ctx, uint16_t addr, uint8_t val) {
     mapper_1_ctx_t* m = (mapper_1_ctx_t*)ctx;
 
+    /* Registers live at $8000-$FFFF; PRG-RAM writes are handled by the bus */
+    if (addr < 0x8000) {
+        return;
+    }
+
     /* Determine register based on address */
     int reg;
     if (addr < 0xA000) reg = 0;      /* Control */
@@ -179,6 +294,8 @@ static void mapper_1_write(void* ctx, uint16_t addr, uint8_t val) {
         m->shift_reg = 0x10;
         m->shift_count = 0;
         m->prg_mode = 3;
+        mapper_bank_switched(m->map, addr, val);
+        mapper_1_map(m);
         return;
     }
 
@@ -197,8 +314,9 @@ static void mapper_1_write(void* ctx, uint16_t addr, uint8_t val) {
                 m->chr_mode = (data >> 4) & 1;
 
                 /* Apply mirror mode to PPU */
-                extern void nes_ppu_set_mirror_mode(uint8_t);
-                nes_ppu_set_mirror_mode(m->mirroring);
+                if (m->ppu) {
+                    nes_ppu_set_mirror_mode(m->ppu, m->mirroring);
+                }
                 break;
 
             case 1: /* CHR bank 0 */
@@ -217,6 +335,8 @@ static void mapper_1_write(void* ctx, uint16_t addr, uint8_t val) {
 
         m->shift_reg = 0x10;
         m->shift_count = 0;
+        mapper_bank_switched(m->map, addr, val);
+        mapper_1_map(m);
     }
 }
 
@@ -225,72 +345,63 @@ static uint8_t mapper_1_ppu_read(void* ctx, uint16_t addr) {
     nes_cartridge_t* cart = m->cart;
 
     if (addr < 0x2000 && cart->chr_rom) {
-        if (m->chr_mode == MMC1_CHR_MODE_0) {
-            /* 8KB mode */
-            uint8_t bank = m->chr_bank_0 & 0x1E;
-            uint32_t base = (bank * NES_CHR_ROM_SIZE) + addr;
-            if (base < cart->chr_rom_size) {
-                return cart->chr_rom[base];
-            }
-            return cart->chr_rom[base % cart->chr_rom_size];
-        } else {
-            /* 4KB mode */
-            uint8_t bank;
-            if (addr < 0x1000) {
-                bank = m->chr_bank_0;
-            } else {
-                bank = m->chr_bank_1;
-            }
-            uint32_t base = (bank * NES_CHR_ROM_SIZE) + (addr & 0x0FFF);
-            if (base < cart->chr_rom_size) {
-                return cart->chr_rom[base];
-            }
-            return cart->chr_rom[base % cart->chr_rom_size];
-        }
+        return mapper_read_chr(cart, &m->banks, addr);
     }
     return 0;
 }
 
 static void mapper_1_ppu_write(void* ctx, uint16_t addr, uint8_t val) {
     mapper_1_ctx_t* m = (mapper_1_ctx_t*)ctx;
-    nes_cartridge_t* cart = m->cart;
+    mapper_write_chr(m->cart, &m->banks, addr, val);
+}
 
-    if (addr < 0x2000 && cart->info.has_chrram) {
-        if (m->chr_mode == MMC1_CHR_MODE_0) {
-            uint8_t bank = (m->chr_bank_0 >> 1) & 0x1F;
-            uint32_t base = (bank * NES_CHR_ROM_SIZE) + addr;
-            cart->chr_rom[base % cart->chr_rom_size] = val;
-        } else {
-            uint8_t bank = (addr < 0x1000) ? m->chr_bank_0 : m->chr_bank_1;
-            uint32_t base = (bank * NES_CHR_ROM_SIZE) + (addr & 0x0FFF);
-            cart->chr_rom[base % cart->chr_rom_size] = val;
-        }
+static void mapper_1_save_state(void* ctx, mapper_buffer_t* out) {
+    mapper_1_ctx_t* m = (mapper_1_ctx_t*)ctx;
+    mapper_state_store(out, &m->shift_reg, MAPPER_STATE_SIZE(mapper_1_ctx_t, shift_reg));
+}
+
+static int mapper_1_load_state(void* ctx, const mapper_buffer_t* in) {
+    mapper_1_ctx_t* m = (mapper_1_ctx_t*)ctx;
+    if (mapper_state_fetch(in, &m->shift_reg, MAPPER_STATE_SIZE(mapper_1_ctx_t, shift_reg)) != 0) {
+        return -1;
     }
+    mapper_1_map(m);
+    return 0;
 }
 
-int mapper_1_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu) {
-    g_ppu = ppu;
-    g_mapper_1_ctx.cart = cart;
-    g_mapper_1_ctx.shift_reg = 0x10;
-    g_mapper_1_ctx.shift_count = 0;
-    g_mapper_1_ctx.control = 0x0C;
-    g_mapper_1_ctx.chr_bank_0 = 0;
-    g_mapper_1_ctx.chr_bank_1 = 0;
-    g_mapper_1_ctx.prg_bank = 0;
-    g_mapper_1_ctx.prg_mode = 3;
-    g_mapper_1_ctx.chr_mode = 0;
-    g_mapper_1_ctx.mirroring = 2;
-    g_mapper_1_ctx.prg_ram_disabled = 0;
+int mapper_1_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu, nes_memory_map_t* map) {
+    mapper_1_ctx_t* m = (mapper_1_ctx_t*)calloc(1, sizeof(mapper_1_ctx_t));
+    if (!m) {
+        return -1;
+    }
+    m->cart = cart;
+    m->ppu = ppu;
+    m->map = map;
+    m->shift_reg = 0x10;
+    m->shift_count = 0;
+    m->control = 0x0C;
+    m->chr_bank_0 = 0;
+    m->chr_bank_1 = 0;
+    m->prg_bank = 0;
+    m->prg_mode = 3;
+    m->chr_mode = 0;
+    m->mirroring = 2;
+    m->prg_ram_disabled = 0;
+    mapper_1_map(m);
 
     mapper->number = 1;
     mapper->cpu_read = mapper_1_cpu_read;
     mapper->cpu_write = mapper_1_write;
     mapper->ppu_read = mapper_1_ppu_read;
     mapper->ppu_write = mapper_1_ppu_write;
-    mapper->context = &g_mapper_1_ctx;
+    mapper->context = m;
     mapper->reset = NULL;
     mapper->scanline = NULL;
     mapper->clock_irq = NULL;
+    mapper->a12_rise = NULL;
+    mapper->irq_line = NULL;
+    mapper->save_state = mapper_1_save_state;
+    mapper->load_state = mapper_1_load_state;
 
     return 0;
 }
@@ -299,32 +410,38 @@ int mapper_1_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu) {
 
 typedef struct {
     nes_cartridge_t* cart;
+    nes_memory_map_t* map;
+    mapper_banks_t   banks;
     uint8_t  bank_select;
 } mapper_2_ctx_t;
 
-static mapper_2_ctx_t g_mapper_2_ctx = {NULL, 0};
+static uint32_t mapper_2_prg_offset(void* ctx, uint16_t addr) {
+    mapper_2_ctx_t* m = (mapper_2_ctx_t*)ctx;
+    nes_cartridge_t* cart = m->cart;
+    uint32_t base;
+
+    if (addr < 0xC000) {
+        /* Switchable 16KB @ $8000 */
+        uint8_t bank = m->bank_select & (cart->info.prg_rom_banks - 1);
+        base = (bank * NES_PRG_ROM_SIZE) + (addr & 0x3FFF);
+    } else {
+        /* Fixed 16KB @ $C000 (last bank) */
+        base = (cart->info.prg_rom_banks - 1) * NES_PRG_ROM_SIZE;
+        base += (addr & 0x3FFF);
+    }
+    return base;
+}
+
+static void mapper_2_map(mapper_2_ctx_t* m) {
+    mapper_set_banks(&m->banks, m->map, m->cart, mapper_2_prg_offset, mapper_fixed_chr_offset, m);
+}
 
 static uint8_t mapper_2_cpu_read(void* ctx, uint16_t addr) {
     mapper_2_ctx_t* m = (mapper_2_ctx_t*)ctx;
     nes_cartridge_t* cart = m->cart;
 
     if (addr >= 0x8000) {
-        uint32_t base;
-
-        if (addr < 0xC000) {
-            /* Switchable 16KB @ $8000 */
-            uint8_t bank = m->bank_select & (cart->info.prg_rom_banks - 1);
-            base = (bank * NES_PRG_ROM_SIZE) + (addr & 0x3FFF);
-        } else {
-            /* Fixed 16KB @ $C000 (last bank) */
-            base = (cart->info.prg_rom_banks - 1) * NES_PRG_ROM_SIZE;
-            base += (addr & 0x3FFF);
-        }
-
-        if (base < cart->prg_rom_size) {
-            return cart->prg_rom[base];
-        }
-        return cart->prg_rom[base % cart->prg_rom_size];
+        return mapper_read_prg(cart, &m->banks, addr);
     }
 
     /* PRG-RAM @ $6000-$7FFF */
@@ -340,6 +457,8 @@ static void mapper_2_cpu_write(void* ctx, uint16_t addr, uint8_t val) {
 
     if (addr >= 0x8000) {
         m->bank_select = val;
+        mapper_bank_switched(m->map, addr, val);
+        mapper_2_map(m);
     } else if (addr >= 0x6000 && addr < 0x8000 && m->cart->prg_ram) {
         m->cart->prg_ram[addr & 0x1FFF] = val;
     }
@@ -348,31 +467,53 @@ static void mapper_2_cpu_write(void* ctx, uint16_t addr, uint8_t val) {
 static uint8_t mapper_2_ppu_read(void* ctx, uint16_t addr) {
     mapper_2_ctx_t* m = (mapper_2_ctx_t*)ctx;
     if (addr < 0x2000 && m->cart->chr_rom) {
-        return m->cart->chr_rom[addr & (m->cart->chr_rom_size - 1)];
+        return mapper_read_chr(m->cart, &m->banks, addr);
     }
     return 0;
 }
 
 static void mapper_2_ppu_write(void* ctx, uint16_t addr, uint8_t val) {
     mapper_2_ctx_t* m = (mapper_2_ctx_t*)ctx;
-    if (addr < 0x2000 && m->cart->info.has_chrram) {
-        m->cart->chr_rom[addr & (m->cart->chr_rom_size - 1)] = val;
+    mapper_write_chr(m->cart, &m->banks, addr, val);
+}
+
+static void mapper_2_save_state(void* ctx, mapper_buffer_t* out) {
+    mapper_2_ctx_t* m = (mapper_2_ctx_t*)ctx;
+    mapper_state_store(out, &m->bank_select, MAPPER_STATE_SIZE(mapper_2_ctx_t, bank_select));
+}
+
+static int mapper_2_load_state(void* ctx, const mapper_buffer_t* in) {
+    mapper_2_ctx_t* m = (mapper_2_ctx_t*)ctx;
+    if (mapper_state_fetch(in, &m->bank_select, MAPPER_STATE_SIZE(mapper_2_ctx_t, bank_select)) != 0) {
+        return -1;
     }
+    mapper_2_map(m);
+    return 0;
 }
 
-int mapper_2_init(nes_cartridge_t* cart, nes_mapper_t* mapper) {
-    g_mapper_2_ctx.cart = cart;
-    g_mapper_2_ctx.bank_select = 0;
+int mapper_2_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_memory_map_t* map) {
+    mapper_2_ctx_t* m = (mapper_2_ctx_t*)calloc(1, sizeof(mapper_2_ctx_t));
+    if (!m) {
+        return -1;
+    }
+    m->cart = cart;
+    m->map = map;
+    m->bank_select = 0;
+    mapper_2_map(m);
 
     mapper->number = 2;
     mapper->cpu_read = mapper_2_cpu_read;
     mapper->cpu_write = mapper_2_cpu_write;
     mapper->ppu_read = mapper_2_ppu_read;
     mapper->ppu_write = mapper_2_ppu_write;
-    mapper->context = &g_mapper_2_ctx;
+    mapper->context = m;
     mapper->reset = NULL;
     mapper->scanline = NULL;
     mapper->clock_irq = NULL;
+    mapper->a12_rise = NULL;
+    mapper->irq_line = NULL;
+    mapper->save_state = mapper_2_save_state;
+    mapper->load_state = mapper_2_load_state;
 
     return 0;
 }
@@ -381,21 +522,32 @@ int mapper_2_init(nes_cartridge_t* cart, nes_mapper_t* mapper) {
 
 typedef struct {
     nes_cartridge_t* cart;
+    nes_memory_map_t* map;
+    mapper_banks_t   banks;
     uint8_t  chr_bank;
 } mapper_3_ctx_t;
 
-static mapper_3_ctx_t g_mapper_3_ctx = {NULL, 0};
+static uint32_t mapper_3_prg_offset(void* ctx, uint16_t addr) {
+    (void)ctx;
+    return addr & 0x7FFF;  /* Fixed 32KB, 16KB ROMs mirror */
+}
+
+static uint32_t mapper_3_chr_offset(void* ctx, uint16_t addr) {
+    mapper_3_ctx_t* m = (mapper_3_ctx_t*)ctx;
+    uint8_t bank = m->chr_bank & (m->cart->info.chr_rom_banks - 1);
+    return (bank * NES_CHR_ROM_SIZE) + addr;
+}
+
+static void mapper_3_map(mapper_3_ctx_t* m) {
+    mapper_set_banks(&m->banks, m->map, m->cart, mapper_3_prg_offset, mapper_3_chr_offset, m);
+}
 
 static uint8_t mapper_3_cpu_read(void* ctx, uint16_t addr) {
     mapper_3_ctx_t* m = (mapper_3_ctx_t*)ctx;
     nes_cartridge_t* cart = m->cart;
 
     if (addr >= 0x8000) {
-        uint32_t base = addr & 0x7FFF;
-        if (base < cart->prg_rom_size) {
-            return cart->prg_rom[base];
-        }
-        return cart->prg_rom[base % cart->prg_rom_size];
+        return mapper_read_prg(cart, &m->banks, addr);
     }
 
     if (addr >= 0x6000 && addr < 0x8000 && cart->prg_ram) {
@@ -410,6 +562,8 @@ static void mapper_3_cpu_write(void* ctx, uint16_t addr, uint8_t val) {
 
     if (addr >= 0x8000) {
         m->chr_bank = val & 0x03;
+        mapper_bank_switched(m->map, addr, val);
+        mapper_3_map(m);
     } else if (addr >= 0x6000 && addr < 0x8000 && m->cart->prg_ram) {
         m->cart->prg_ram[addr & 0x1FFF] = val;
     }
@@ -420,38 +574,53 @@ static uint8_t mapper_3_ppu_read(void* ctx, uint16_t addr) {
     nes_cartridge_t* cart = m->cart;
 
     if (addr < 0x2000 && cart->chr_rom) {
-        uint8_t bank = m->chr_bank & (cart->info.chr_rom_banks - 1);
-        uint32_t base = (bank * NES_CHR_ROM_SIZE) + addr;
-        if (base < cart->chr_rom_size) {
-            return cart->chr_rom[base];
-        }
-        return cart->chr_rom[base % cart->chr_rom_size];
+        return mapper_read_chr(cart, &m->banks, addr);
     }
     return 0;
 }
 
 static void mapper_3_ppu_write(void* ctx, uint16_t addr, uint8_t val) {
     mapper_3_ctx_t* m = (mapper_3_ctx_t*)ctx;
-    if (addr < 0x2000 && m->cart->info.has_chrram) {
-        uint8_t bank = (m->chr_bank >> 3) & 0x03;
-        uint32_t base = (bank * NES_CHR_ROM_SIZE) + addr;
-        m->cart->chr_rom[base % m->cart->chr_rom_size] = val;
+    mapper_write_chr(m->cart, &m->banks, addr, val);
+}
+
+static void mapper_3_save_state(void* ctx, mapper_buffer_t* out) {
+    mapper_3_ctx_t* m = (mapper_3_ctx_t*)ctx;
+    mapper_state_store(out, &m->chr_bank, MAPPER_STATE_SIZE(mapper_3_ctx_t, chr_bank));
+}
+
+static int mapper_3_load_state(void* ctx, const mapper_buffer_t* in) {
+    mapper_3_ctx_t* m = (mapper_3_ctx_t*)ctx;
+    if (mapper_state_fetch(in, &m->chr_bank, MAPPER_STATE_SIZE(mapper_3_ctx_t, chr_bank)) != 0) {
+        return -1;
     }
+    mapper_3_map(m);
+    return 0;
 }
 
-int mapper_3_init(nes_cartridge_t* cart, nes_mapper_t* mapper) {
-    g_mapper_3_ctx.cart = cart;
-    g_mapper_3_ctx.chr_bank = 0;
+int mapper_3_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_memory_map_t* map) {
+    mapper_3_ctx_t* m = (mapper_3_ctx_t*)calloc(1, sizeof(mapper_3_ctx_t));
+    if (!m) {
+        return -1;
+    }
+    m->cart = cart;
+    m->map = map;
+    m->chr_bank = 0;
+    mapper_3_map(m);
 
     mapper->number = 3;
     mapper->cpu_read = mapper_3_cpu_read;
     mapper->cpu_write = mapper_3_cpu_write;
     mapper->ppu_read = mapper_3_ppu_read;
     mapper->ppu_write = mapper_3_ppu_write;
-    mapper->context = &g_mapper_3_ctx;
+    mapper->context = m;
     mapper->reset = NULL;
     mapper->scanline = NULL;
     mapper->clock_irq = NULL;
+    mapper->a12_rise = NULL;
+    mapper->irq_line = NULL;
+    mapper->save_state = mapper_3_save_state;
+    mapper->load_state = mapper_3_load_state;
 
     return 0;
 }
@@ -460,6 +629,9 @@ int mapper_3_init(nes_cartridge_t* cart, nes_mapper_t* mapper) {
 
 typedef struct {
     nes_cartridge_t* cart;
+    nes_ppu_t*       ppu;               /* Mirroring control */
+    nes_memory_map_t* map;              /* Page tables (may be NULL) */
+    mapper_banks_t   banks;
     uint8_t  registers[8];
     uint8_t  bank_select;
     uint8_t  irq_counter;
@@ -468,53 +640,52 @@ typedef struct {
     uint8_t  irq_reload;
     uint8_t  prg_mode;
     uint8_t  chr_mode;
+    uint8_t  irq_asserted;              /* Held until $E000 acknowledges it */
 } mapper_4_ctx_t;
 
-static mapper_4_ctx_t g_mapper_4_ctx;
+static uint32_t mapper_4_prg_offset(void* ctx, uint16_t addr) {
+    mapper_4_ctx_t* m = (mapper_4_ctx_t*)ctx;
+    uint32_t banks = (uint32_t)m->cart->info.prg_rom_banks * 2;    /* 8KB banks */
+    uint32_t bank;
 
-static uint8_t mapper_4_cpu_read(void* ctx, uint16_t addr) {
+    /* R6 and the second-to-last bank swap places with the PRG mode */
+    if (addr < 0xA000) {
+        bank = m->prg_mode ? banks - 2 : m->registers[6];           /* $8000-$9FFF */
+    } else if (addr < 0xC000) {
+        bank = m->registers[7];                                     /* $A000-$BFFF */
+    } else if (addr < 0xE000) {
+        bank = m->prg_mode ? m->registers[6] : banks - 2;           /* $C000-$DFFF */
+    } else {
+        bank = banks - 1;                                           /* Fixed $E000-$FFFF */
+    }
+
+    return (bank & (banks - 1)) * 0x2000 + (addr & 0x1FFF);
+}
+
+static uint32_t mapper_4_chr_offset(void* ctx, uint16_t addr) {
     mapper_4_ctx_t* m = (mapper_4_ctx_t*)ctx;
-    nes_cartridge_t* cart = m->cart;
 
-    /* IRQ acknowledge at $E000-$FFFF */
-    if (addr == 0xE000) {
-        m->irq_enabled = 0;
-    } else if (addr == 0xE001) {
-        m->irq_enabled = 1;
+    /* Two 2KB banks (R0, R1) in one half and four 1KB banks (R2-R5) in the
+     * other; CHR mode inverts A12, putting the 2KB banks at $1000 */
+    if (m->chr_mode) {
+        addr ^= 0x1000;
+    }
+    if (addr < 0x1000) {
+        return (uint32_t)(m->registers[addr >> 11] & 0xFE) * 0x400 + (addr & 0x7FF);
     }
+    return (uint32_t)m->registers[2 + ((addr >> 10) & 3)] * 0x400 + (addr & 0x3FF);
+}
 
-    if (addr >= 0x8000) {
-        uint32_t base;
-        uint8_t bank;
-
-        /* Determine bank and mode */
-        if (m->prg_mode == 0) {
-            if (addr < 0xA000) {
-                bank = m->registers[6];  /* $8000-$9FFF */
-            } else if (addr < 0xC000) {
-                bank = m->registers[7];  /* $A000-$BFFF */
-            } else if (addr < 0xE000) {
-                bank = (cart->info.prg_rom_banks - 2);  /* Fixed $C000-$DFFF */
-            } else {
-                bank = (cart->info.prg_rom_banks - 1);  /* Fixed $E000-$FFFF */
-            }
-        } else {
-            if (addr < 0xA000) {
-                bank = (cart->info.prg_rom_banks - 2);  /* Fixed $8000-$9FFF */
-            } else if (addr < 0xC000) {
-                bank = m->registers[7];  /* $A000-$BFFF */
-            } else if (addr < 0xE000) {
-                bank = m->registers[6];  /* $C000-$DFFF */
-            } else {
-                bank = (cart->info.prg_rom_banks - 1);  /* Fixed $E000-$FFFF */
-            }
-        }
+static void mapper_4_map(mapper_4_ctx_t* m) {
+    mapper_set_banks(&m->banks, m->map, m->cart, mapper_4_prg_offset, mapper_4_chr_offset, m);
+}
 
-        base = (bank * NES_PRG_ROM_SIZE) * 8 + (addr & 0x1FFF);
-        if (base < cart->prg_rom_size) {
-            return cart->prg_rom[base];
-        }
-        return cart->prg_rom[base % cart->prg_rom_size];
+static uint8_t mapper_4_cpu_read(void* ctx, uint16_t addr) {
+    mapper_4_ctx_t* m = (mapper_4_ctx_t*)ctx;
+    nes_cartridge_t* cart = m->cart;
+
+    if (addr >= 0x8000) {
+        return mapper_read_prg(cart, &m->banks, addr);
     }
 
     if (addr >= 0x6000 && addr < 0x8000 && cart->prg_ram) {
@@ -528,40 +699,54 @@ static void mapper_4_write(void* ctx, uint16_t addr, uint8_t val) {
     mapper_4_ctx_t* m = (mapper_4_ctx_t*)ctx;
     nes_cartridge_t* cart = m->cart;
 
-    if (addr >= 0x8000 && addr < 0xA001) {
-        if (addr & 1) {
+    if (addr < 0x8000) {
+        if (addr >= 0x6000 && cart->prg_ram) {
+            cart->prg_ram[addr & 0x1FFF] = val;
+        }
+        return;
+    }
+
+    /* Each 8KB window holds a register pair, even and odd addresses */
+    switch (addr & 0xE001) {
+        case 0x8000: /* Bank select */
             m->bank_select = val;
             m->prg_mode = (val >> 6) & 1;
             m->chr_mode = (val >> 7) & 1;
-        } else {
-            /* Mirroring control */
-            if (val & 1) {
-                /* Horizontal */
-            } else {
-                /* Vertical */
+            mapper_bank_switched(m->map, addr, val);
+            mapper_4_map(m);
+            break;
+
+        case 0x8001: /* Bank data */
+            m->registers[m->bank_select & 7] = val;
+            mapper_bank_switched(m->map, addr, val);
+            mapper_4_map(m);
+            break;
+
+        case 0xA000: /* Mirroring, fixed on four-screen boards */
+            if (m->ppu && cart->info.mirroring != MIRROR_FOUR_SCREEN) {
+                nes_ppu_set_mirror_mode(m->ppu, (val & 1) ? MIRROR_HORIZONTAL : MIRROR_VERTICAL);
             }
-        }
-    }
-    else if (addr >= 0xA000 && addr < 0xC001) {
-        int reg = m->bank_select & 7;
-        m->registers[reg] = val;
-    }
-    else if (addr >= 0xC000 && addr < 0xE001) {
-        if (addr & 1) {
-            m->irq_reload = 1;
-        } else {
+            break;
+
+        case 0xA001: /* PRG-RAM protect - not emulated */
+            break;
+
+        case 0xC000: /* IRQ latch */
             m->irq_latch = val;
-        }
-    }
-    else if (addr >= 0xE000 && addr < 0x10001) {
-        if (addr & 1) {
-            m->irq_enabled = 1;
-        } else {
+            break;
+
+        case 0xC001: /* IRQ reload */
+            m->irq_reload = 1;
+            break;
+
+        case 0xE000: /* IRQ disable and acknowledge */
             m->irq_enabled = 0;
-        }
-    }
-    else if (addr >= 0x6000 && addr < 0x8000 && cart->prg_ram) {
-        cart->prg_ram[addr & 0x1FFF] = val;
+            m->irq_asserted = 0;
+            break;
+
+        case 0xE001: /* IRQ enable */
+            m->irq_enabled = 1;
+            break;
     }
 }
 
@@ -570,62 +755,83 @@ static uint8_t mapper_4_ppu_read(void* ctx, uint16_t addr) {
     nes_cartridge_t* cart = m->cart;
 
     if (addr < 0x2000 && cart->chr_rom) {
-        uint8_t bank;
-        if (m->chr_mode == 0) {
-            /* 2KB mode */
-            if (addr < 0x0800) bank = m->registers[0] & 0xFE;
-            else if (addr < 0x1000) bank = m->registers[1] & 0xFE;
-            else if (addr < 0x1400) bank = m->registers[2] & 0xFE;
-            else if (addr < 0x1800) bank = m->registers[3] & 0xFE;
-            else if (addr < 0x1C00) bank = m->registers[4] & 0xFE;
-            else bank = m->registers[5] & 0xFE;
-        } else {
-            /* 1KB mode */
-            if (addr < 0x0400) bank = m->registers[0];
-            else if (addr < 0x0800) bank = m->registers[1];
-            else if (addr < 0x0C00) bank = m->registers[2];
-            else if (addr < 0x1000) bank = m->registers[3];
-            else if (addr < 0x1400) bank = m->registers[4];
-            else bank = m->registers[5];
-        }
-
-        uint32_t base = (bank * NES_CHR_ROM_SIZE) + addr;
-        if (base < cart->chr_rom_size) {
-            return cart->chr_rom[base];
-        }
-        return cart->chr_rom[base % cart->chr_rom_size];
+        return mapper_read_chr(cart, &m->banks, addr);
     }
     return 0;
 }
 
 static void mapper_4_ppu_write(void* ctx, uint16_t addr, uint8_t val) {
     mapper_4_ctx_t* m = (mapper_4_ctx_t*)ctx;
-    if (addr < 0x2000 && m->cart->info.has_chrram) {
-        m->cart->chr_rom[addr & (m->cart->chr_rom_size - 1)] = val;
+    mapper_write_chr(m->cart, &m->banks, addr, val);
+}
+
+/* Scanline counter, clocked by each rise of PPU A12 (once per rendered line
+ * with the usual split of background and sprite pattern tables) */
+static int mapper_4_a12_rise(void* ctx) {
+    mapper_4_ctx_t* m = (mapper_4_ctx_t*)ctx;
+
+    if (m->irq_counter == 0 || m->irq_reload) {
+        m->irq_counter = m->irq_latch;
+        m->irq_reload = 0;
+    } else {
+        m->irq_counter--;
+    }
+    if (m->irq_counter == 0 && m->irq_enabled) {
+        m->irq_asserted = 1;
     }
+    return m->irq_asserted;
 }
 
-int mapper_4_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu) {
-    g_ppu = ppu;
-    g_mapper_4_ctx.cart = cart;
-    memset(g_mapper_4_ctx.registers, 0, sizeof(g_mapper_4_ctx.registers));
-    g_mapper_4_ctx.bank_select = 0;
-    g_mapper_4_ctx.irq_counter = 0;
-    g_mapper_4_ctx.irq_latch = 0;
-    g_mapper_4_ctx.irq_enabled = 0;
-    g_mapper_4_ctx.irq_reload = 0;
-    g_mapper_4_ctx.prg_mode = 0;
-    g_mapper_4_ctx.chr_mode = 0;
+static int mapper_4_irq_line(void* ctx) {
+    return ((mapper_4_ctx_t*)ctx)->irq_asserted;
+}
+
+static void mapper_4_save_state(void* ctx, mapper_buffer_t* out) {
+    mapper_4_ctx_t* m = (mapper_4_ctx_t*)ctx;
+    mapper_state_store(out, &m->registers, MAPPER_STATE_SIZE(mapper_4_ctx_t, registers));
+}
+
+static int mapper_4_load_state(void* ctx, const mapper_buffer_t* in) {
+    mapper_4_ctx_t* m = (mapper_4_ctx_t*)ctx;
+    if (mapper_state_fetch(in, &m->registers, MAPPER_STATE_SIZE(mapper_4_ctx_t, registers)) != 0) {
+        return -1;
+    }
+    mapper_4_map(m);
+    return 0;
+}
+
+int mapper_4_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu, nes_memory_map_t* map) {
+    mapper_4_ctx_t* m = (mapper_4_ctx_t*)calloc(1, sizeof(mapper_4_ctx_t));
+    if (!m) {
+        return -1;
+    }
+    m->cart = cart;
+    m->ppu = ppu;
+    m->map = map;
+    memset(m->registers, 0, sizeof(m->registers));
+    m->bank_select = 0;
+    m->irq_counter = 0;
+    m->irq_latch = 0;
+    m->irq_enabled = 0;
+    m->irq_reload = 0;
+    m->irq_asserted = 0;
+    m->prg_mode = 0;
+    m->chr_mode = 0;
+    mapper_4_map(m);
 
     mapper->number = 4;
     mapper->cpu_read = mapper_4_cpu_read;
     mapper->cpu_write = mapper_4_write;
     mapper->ppu_read = mapper_4_ppu_read;
     mapper->ppu_write = mapper_4_ppu_write;
-    mapper->context = &g_mapper_4_ctx;
+    mapper->context = m;
     mapper->reset = NULL;
     mapper->scanline = NULL;
     mapper->clock_irq = NULL;
+    mapper->a12_rise = mapper_4_a12_rise;
+    mapper->irq_line = mapper_4_irq_line;
+    mapper->save_state = mapper_4_save_state;
+    mapper->load_state = mapper_4_load_state;
 
     return 0;
 }
@@ -634,22 +840,27 @@ int mapper_4_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu) {
 
 typedef struct {
     nes_cartridge_t* cart;
+    nes_ppu_t*       ppu;
+    nes_memory_map_t* map;
+    mapper_banks_t   banks;
     uint8_t  prg_bank;
 } mapper_7_ctx_t;
 
-static mapper_7_ctx_t g_mapper_7_ctx = {NULL, 0};
+static uint32_t mapper_7_prg_offset(void* ctx, uint16_t addr) {
+    mapper_7_ctx_t* m = (mapper_7_ctx_t*)ctx;
+    uint8_t bank = m->prg_bank & (m->cart->info.prg_rom_banks - 1);
+    return (bank * NES_PRG_ROM_SIZE) + (addr & 0x7FFF);
+}
+
+static void mapper_7_map(mapper_7_ctx_t* m) {
+    mapper_set_banks(&m->banks, m->map, m->cart, mapper_7_prg_offset, mapper_fixed_chr_offset, m);
+}
 
 static uint8_t mapper_7_cpu_read(void* ctx, uint16_t addr) {
     mapper_7_ctx_t* m = (mapper_7_ctx_t*)ctx;
-    nes_cartridge_t* cart = m->cart;
 
     if (addr >= 0x8000) {
-        uint8_t bank = m->prg_bank & (cart->info.prg_rom_banks - 1);
-        uint32_t base = (bank * NES_PRG_ROM_SIZE) + (addr & 0x7FFF);
-        if (base < cart->prg_rom_size) {
-            return cart->prg_rom[base];
-        }
-        return cart->prg_rom[base % cart->prg_rom_size];
+        return mapper_read_prg(m->cart, &m->banks, addr);
     }
 
     return 0;
@@ -659,48 +870,75 @@ static void mapper_7_cpu_write(void* ctx, uint16_t addr, uint8_t val) {
     if (addr >= 0x8000) {
         mapper_7_ctx_t* m = (mapper_7_ctx_t*)ctx;
         m->prg_bank = val & 0x07;
+        mapper_bank_switched(m->map, addr, val);
+        mapper_7_map(m);
 
         /* Single screen mirroring */
-        extern void nes_ppu_set_mirror_mode(uint8_t);
-        nes_ppu_set_mirror_mode(val & 0x10 ? 3 : 2);  /* Upper/lower screen */
+        if (m->ppu) {
+            nes_ppu_set_mirror_mode(m->ppu, val & 0x10 ? 3 : 2);  /* Upper/lower screen */
+        }
     }
 }
 
 static uint8_t mapper_7_ppu_read(void* ctx, uint16_t addr) {
     mapper_7_ctx_t* m = (mapper_7_ctx_t*)ctx;
     if (addr < 0x2000 && m->cart->chr_rom) {
-        return m->cart->chr_rom[addr & (m->cart->chr_rom_size - 1)];
+        return mapper_read_chr(m->cart, &m->banks, addr);
     }
     return 0;
 }
 
 static void mapper_7_ppu_write(void* ctx, uint16_t addr, uint8_t val) {
     mapper_7_ctx_t* m = (mapper_7_ctx_t*)ctx;
-    if (addr < 0x2000 && m->cart->info.has_chrram) {
-        m->cart->chr_rom[addr & (m->cart->chr_rom_size - 1)] = val;
+    mapper_write_chr(m->cart, &m->banks, addr, val);
+}
+
+static void mapper_7_save_state(void* ctx, mapper_buffer_t* out) {
+    mapper_7_ctx_t* m = (mapper_7_ctx_t*)ctx;
+    mapper_state_store(out, &m->prg_bank, MAPPER_STATE_SIZE(mapper_7_ctx_t, prg_bank));
+}
+
+static int mapper_7_load_state(void* ctx, const mapper_buffer_t* in) {
+    mapper_7_ctx_t* m = (mapper_7_ctx_t*)ctx;
+    if (mapper_state_fetch(in, &m->prg_bank, MAPPER_STATE_SIZE(mapper_7_ctx_t, prg_bank)) != 0) {
+        return -1;
     }
+    mapper_7_map(m);
+    return 0;
 }
 
-int mapper_7_init(nes_cartridge_t* cart, nes_mapper_t* mapper) {
-    g_mapper_7_ctx.cart = cart;
-    g_mapper_7_ctx.prg_bank = 0;
+int mapper_7_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu, nes_memory_map_t* map) {
+    mapper_7_ctx_t* m = (mapper_7_ctx_t*)calloc(1, sizeof(mapper_7_ctx_t));
+    if (!m) {
+        return -1;
+    }
+    m->cart = cart;
+    m->ppu = ppu;
+    m->map = map;
+    m->prg_bank = 0;
+    mapper_7_map(m);
 
     mapper->number = 7;
     mapper->cpu_read = mapper_7_cpu_read;
     mapper->cpu_write = mapper_7_cpu_write;
     mapper->ppu_read = mapper_7_ppu_read;
     mapper->ppu_write = mapper_7_ppu_write;
-    mapper->context = &g_mapper_7_ctx;
+    mapper->context = m;
     mapper->reset = NULL;
     mapper->scanline = NULL;
     mapper->clock_irq = NULL;
+    mapper->a12_rise = NULL;
+    mapper->irq_line = NULL;
+    mapper->save_state = mapper_7_save_state;
+    mapper->load_state = mapper_7_load_state;
 
     return 0;
 }
 
 /* Mapper creation factory */
 
-int nes_mapper_create(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu) {
+int nes_mapper_create(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu,
+                      nes_memory_map_t* map) {
     printf("nes_mapper_create: cart=%p, mapper=%p, ppu=%p\n", (void*)cart, (void*)mapper, (void*)ppu);
 
     if (!cart || !mapper) {
@@ -708,28 +946,31 @@ int nes_mapper_create(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* pp
         return -1;
     }
 
+    /* Release the previous cartridge's mapper state */
+    nes_mapper_destroy(mapper);
+
     int mapper_num = cart->info.mapper;
     printf("Mapper number: %d\n", mapper_num);
 
     switch (mapper_num) {
         case 0:
             printf("Initializing mapper 0...\n");
-            return mapper_0_init(cart, mapper);
+            return mapper_0_init(cart, mapper, map);
         case 1:
             printf("Initializing mapper 1...\n");
-            return mapper_1_init(cart, mapper, ppu);
+            return mapper_1_init(cart, mapper, ppu, map);
         case 2:
             printf("Initializing mapper 2...\n");
-            return mapper_2_init(cart, mapper);
+            return mapper_2_init(cart, mapper, map);
         case 3:
             printf("Initializing mapper 3...\n");
-            return mapper_3_init(cart, mapper);
+            return mapper_3_init(cart, mapper, map);
         case 4:
             printf("Initializing mapper 4...\n");
-            return mapper_4_init(cart, mapper, ppu);
+            return mapper_4_init(cart, mapper, ppu, map);
         case 7:
             printf("Initializing mapper 7...\n");
-            return mapper_7_init(cart, mapper);
+            return mapper_7_init(cart, mapper, ppu, map);
         default:
             printf("Unsupported mapper: %d\n", mapper_num);
             return -1;
@@ -737,10 +978,15 @@ int nes_mapper_create(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* pp
 }
 
 void nes_mapper_destroy(nes_mapper_t* mapper) {
+    free(mapper->context);
+    mapper->save_state = NULL;
+    mapper->load_state = NULL;
     mapper->cpu_read = NULL;
     mapper->cpu_write = NULL;
     mapper->ppu_read = NULL;
     mapper->ppu_write = NULL;
+    mapper->a12_rise = NULL;
+    mapper->irq_line = NULL;
     mapper->context = NULL;
 }
 
@@ -749,3 +995,17 @@ void nes_mapper_reset(nes_mapper_t* mapper) {
         mapper->reset(mapper->context);
     }
 }
+
+void nes_mapper_save_state(nes_mapper_t* mapper) {
+    mapper->state.size = 0;
+    if (mapper->save_state) {
+        mapper->save_state(mapper->context, &mapper->state);
+    }
+}
+
+int nes_mapper_load_state(nes_mapper_t* mapper) {
+    if (mapper->load_state) {
+        return mapper->load_state(mapper->context, &mapper->state);
+    }
+    return mapper->state.size == 0 ? 0 : -1;
+}
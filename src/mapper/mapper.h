@@ -19,6 +19,7 @@ extern "C" {
 /* Forward declarations */
 typedef struct nes_cartridge nes_cartridge_t;
 typedef struct nes_ppu nes_ppu_t;
+struct nes_trace;
 
 /* Mapper Callback Types */
 typedef uint8_t (*mapper_read_cpu_t)(void* ctx, uint16_t addr);
@@ -26,6 +27,27 @@ typedef void    (*mapper_write_cpu_t)(void* ctx, uint16_t addr, uint8_t val);
 typedef uint8_t (*mapper_read_ppu_t)(void* ctx, uint16_t addr);
 typedef void    (*mapper_write_ppu_t)(void* ctx, uint16_t addr, uint8_t val);
 
+/* CPU memory map in 256-byte pages, shared by the bus and the mapper
+ * A non-NULL entry points at the page's first byte; NULL pages go through
+ * the bus handlers (I/O registers, mapper registers, side-effecting reads) */
+#define NES_MAP_PAGE_SHIFT  8
+#define NES_MAP_PAGES       256
+
+/* PPU pattern tables ($0000-$1FFF) in 1KB pages, kept in sync with CHR
+ * banking by the mapper. A non-NULL entry points at the page's first byte of
+ * CHR memory (CHR-RAM writes still go through ppu_write); NULL pages go
+ * through ppu_read */
+#define NES_CHR_PAGE_SHIFT  10
+#define NES_CHR_PAGES       8
+
+typedef struct nes_memory_map {
+    const uint8_t*  read[NES_MAP_PAGES];
+    uint8_t*        write[NES_MAP_PAGES];
+    const uint8_t*  chr[NES_CHR_PAGES];
+    uint64_t        bank_switches;  /* Bank register updates (NES_ENABLE_STATS builds) */
+    struct nes_trace* trace;        /* Bank switch log (NES_ENABLE_TRACE builds) */
+} nes_memory_map_t;
+
 /* Mapper State Buffer (for save states) */
 typedef struct {
     uint8_t data[256];  /* Internal mapper state */
@@ -48,8 +70,14 @@ typedef struct nes_mapper {
     void (*reset)(void* ctx);
     void (*scanline)(void* ctx);       /* Called at end of scanline */
     void (*clock_irq)(void* ctx);      /* For MMC3 IRQ, etc. */
+    int  (*a12_rise)(void* ctx);       /* PPU A12 rose - returns 1 to raise IRQ (NULL = not watched) */
+    int  (*irq_line)(void* ctx);       /* Level of the IRQ output after a register write (NULL = no IRQ) */
+
+    /* Save-state hooks (NULL = no mapper state) - load returns -1 on size mismatch */
+    void (*save_state)(void* ctx, mapper_buffer_t* out);
+    int  (*load_state)(void* ctx, const mapper_buffer_t* in);
 
-    /* Context pointer */
+    /* Per-instance context (heap allocated, released by nes_mapper_destroy) */
     void*   context;
 
     /* State for save/load */
@@ -60,8 +88,11 @@ typedef struct nes_mapper {
 
 /**
  * Create mapper instance for a given cartridge
+ * map (may be NULL) gets its $8000-$FFFF read pages and CHR pages kept in sync
+ * with PRG and CHR banking
  */
-int nes_mapper_create(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu);
+int nes_mapper_create(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu,
+                      nes_memory_map_t* map);
 
 /**
  * Destroy mapper instance
@@ -73,25 +104,36 @@ void nes_mapper_destroy(nes_mapper_t* mapper);
  */
 void nes_mapper_reset(nes_mapper_t* mapper);
 
+/**
+ * Capture mapper registers into mapper->state
+ */
+void nes_mapper_save_state(nes_mapper_t* mapper);
+
+/**
+ * Restore mapper registers from mapper->state
+ * Returns 0 on success, -1 if the state does not fit this mapper
+ */
+int nes_mapper_load_state(nes_mapper_t* mapper);
+
 /* Individual mapper implementations */
 
 /* Mapper 0 (NROM) */
-int mapper_0_init(nes_cartridge_t* cart, nes_mapper_t* mapper);
+int mapper_0_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_memory_map_t* map);
 
 /* Mapper 1 (MMC1) */
-int mapper_1_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu);
+int mapper_1_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu, nes_memory_map_t* map);
 
 /* Mapper 2 (UxROM) */
-int mapper_2_init(nes_cartridge_t* cart, nes_mapper_t* mapper);
+int mapper_2_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_memory_map_t* map);
 
 /* Mapper 3 (CNROM) */
-int mapper_3_init(nes_cartridge_t* cart, nes_mapper_t* mapper);
+int mapper_3_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_memory_map_t* map);
 
 /* Mapper 4 (MMC3) */
-int mapper_4_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu);
+int mapper_4_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu, nes_memory_map_t* map);
 
 /* Mapper 7 (AxROM) */
-int mapper_7_init(nes_cartridge_t* cart, nes_mapper_t* mapper);
+int mapper_7_init(nes_cartridge_t* cart, nes_mapper_t* mapper, nes_ppu_t* ppu, nes_memory_map_t* map);
 
 /* Helper for mapper-specific mirroring */
 void nes_mapper_set_mirroring(nes_mapper_t* mapper, int mode);
@@ -11,27 +11,29 @@
 #include "../apu/apu.h"
 #include "../input/input.h"
 #include "../cartridge/rom.h"
+#include "../cartridge/rom_store.h"
 #include "../mapper/mapper.h"
+#include "../util/stats.h"
+#include "../util/timer.h"
+#include "../trace/trace.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-/* Global running flag */
-static nes_system_t* g_system = NULL;
-
 int nes_sys_init(nes_system_t* sys) {
     memset(sys, 0, sizeof(nes_system_t));
 
-    /* Allocate components */
-    sys->cpu = (nes_cpu_t*)malloc(sizeof(nes_cpu_t));
-    sys->ppu = (nes_ppu_t*)malloc(sizeof(nes_ppu_t));
-    sys->apu = (nes_apu_t*)malloc(sizeof(nes_apu_t));
-    sys->input = (nes_input_t*)malloc(sizeof(nes_input_t));
-    sys->cartridge = (nes_cartridge_t*)malloc(sizeof(nes_cartridge_t));
-    sys->mapper = (nes_mapper_t*)malloc(sizeof(nes_mapper_t));
+    /* Allocate components - each system owns all of its state */
+    sys->cpu = (nes_cpu_t*)calloc(1, sizeof(nes_cpu_t));
+    sys->ppu = (nes_ppu_t*)calloc(1, sizeof(nes_ppu_t));
+    sys->apu = (nes_apu_t*)calloc(1, sizeof(nes_apu_t));
+    sys->input = (nes_input_t*)calloc(1, sizeof(nes_input_t));
+    sys->cartridge = (nes_cartridge_t*)calloc(1, sizeof(nes_cartridge_t));
+    sys->mapper = (nes_mapper_t*)calloc(1, sizeof(nes_mapper_t));
+    sys->map = (nes_memory_map_t*)calloc(1, sizeof(nes_memory_map_t));
 
     if (!sys->cpu || !sys->ppu || !sys->apu || !sys->input ||
-        !sys->cartridge || !sys->mapper) {
+        !sys->cartridge || !sys->mapper || !sys->map) {
         nes_sys_free(sys);
         return -1;
     }
@@ -43,14 +45,20 @@ int nes_sys_init(nes_system_t* sys) {
     nes_input_init(sys->input);
     nes_cartridge_init(sys->cartridge);
 
-    /* Set global reference */
-    g_system = sys;
+    /* Internal RAM and its mirrors are always mapped */
+    for (int page = 0; page < (NES_RAM_MIRRORS + 1) >> NES_MAP_PAGE_SHIFT; page++) {
+        uint8_t* ram = &sys->ram[(page << NES_MAP_PAGE_SHIFT) & NES_RAM_END];
+        sys->map->read[page] = ram;
+        sys->map->write[page] = ram;
+    }
 
     /* Set up bus */
     cpu_bus_t cpu_bus = {
         .context = sys,
         .read = (cpu_read_func)nes_sys_cpu_read,
-        .write = (cpu_write_func)nes_sys_cpu_write
+        .write = (cpu_write_func)nes_sys_cpu_write,
+        .read_map = sys->map->read,
+        .write_map = sys->map->write
     };
     nes_cpu_set_bus(sys->cpu, &cpu_bus);
 
@@ -58,10 +66,18 @@ int nes_sys_init(nes_system_t* sys) {
         .context = sys,
         .read_chr = (uint8_t (*)(void*, uint16_t))nes_sys_ppu_read,
         .write_chr = (void (*)(void*, uint16_t, uint8_t))nes_sys_ppu_write,
+        .chr_map = sys->map->chr,
         .ppu_write_cpu = NULL,  /* Not currently used in callbacks */
     };
     nes_ppu_set_bus(sys->ppu, &ppu_bus);
-    /* Note: APU uses system bus for DMA - set separately if needed */
+
+    /* DMC sample fetches go through the CPU address space */
+    apu_bus_t apu_bus = {
+        .context = sys,
+        .read = (uint8_t (*)(void*, uint16_t))nes_sys_cpu_read,
+        .write = (void (*)(void*, uint16_t, uint8_t))nes_sys_cpu_write
+    };
+    nes_apu_set_bus(sys->apu, &apu_bus);
 
     sys->cpu_cycles_per_frame = NES_CPU_CYCLES_PER_FRAME;
     sys->ppu_cycles_per_frame = NES_PPU_CYCLES_PER_FRAME;
@@ -80,10 +96,14 @@ void nes_sys_free(nes_system_t* sys) {
         nes_mapper_destroy(sys->mapper);
         free(sys->mapper);
     }
-    if (sys->cpu) free(sys->cpu);
+    if (sys->cpu) {
+        nes_cpu_free(sys->cpu);
+        free(sys->cpu);
+    }
     if (sys->ppu) free(sys->ppu);
     if (sys->apu) free(sys->apu);
     if (sys->input) free(sys->input);
+    if (sys->map) free(sys->map);
 
     memset(sys, 0, sizeof(nes_system_t));
 }
@@ -94,6 +114,7 @@ void nes_sys_reset(nes_system_t* sys) {
            (void*)sys->cpu, (void*)sys->ppu, (void*)sys->apu, (void*)sys->input, (void*)sys->mapper);
 
     if (sys->cpu) { printf("  Calling nes_cpu_reset...\n"); nes_cpu_reset(sys->cpu); }
+    memset(&sys->timing, 0, sizeof(sys->timing));
     if (sys->ppu) { printf("  Calling nes_ppu_reset...\n"); nes_ppu_reset(sys->ppu); }
     if (sys->apu) { printf("  Calling nes_apu_reset...\n"); nes_apu_reset(sys->apu); }
     if (sys->input) { printf("  Calling nes_input_reset...\n"); nes_input_reset(sys->input); }
@@ -101,34 +122,62 @@ void nes_sys_reset(nes_system_t* sys) {
     printf("nes_sys_reset complete\n");
 }
 
-int nes_sys_load_rom(nes_system_t* sys, const char* filename) {
-    printf("Loading ROM from: %s\n", filename);
+/* Unmap everything above internal RAM before the cartridge goes away */
+static void sys_unmap_cartridge(nes_system_t* sys) {
+    for (int page = (NES_RAM_MIRRORS + 1) >> NES_MAP_PAGE_SHIFT; page < NES_MAP_PAGES; page++) {
+        sys->map->read[page] = NULL;
+        sys->map->write[page] = NULL;
+    }
+    for (int page = 0; page < NES_CHR_PAGES; page++) {
+        sys->map->chr[page] = NULL;
+    }
+}
 
-    nes_rom_result_t result = nes_cartridge_load(sys->cartridge, filename);
-    if (result != NES_ROM_OK) {
-        fprintf(stderr, "Failed to load ROM: %d\n", result);
-        return -1;
+/* A12 rise from the PPU - the mapper counts it and may raise IRQ */
+static void sys_ppu_a12_rise(void* ctx) {
+    nes_system_t* sys = (nes_system_t*)ctx;
+    if (sys->mapper->a12_rise(sys->mapper->context)) {
+        nes_cpu_set_irq(sys->cpu, NES_IRQ_MAPPER);
     }
-    printf("ROM loaded, mapper=%d\n", sys->cartridge->info.mapper);
+}
+
+/* Attach the freshly loaded cartridge: create mapper, set mirroring, reset */
+static int sys_attach_cartridge(nes_system_t* sys) {
+    nes_cartridge_t* cart = sys->cartridge;
+    printf("ROM loaded, mapper=%d\n", cart->info.mapper);
 
-    /* Create mapper */
+    /* Create mapper - it maps its PRG-ROM pages */
     printf("Creating mapper...\n");
-    if (nes_mapper_create(sys->cartridge, sys->mapper, sys->ppu) != 0) {
-        fprintf(stderr, "Failed to create mapper (mapper %d may not be supported yet)\n", sys->cartridge->info.mapper);
+    if (nes_mapper_create(cart, sys->mapper, sys->ppu, sys->map) != 0) {
+        fprintf(stderr, "Failed to create mapper (mapper %d may not be supported yet)\n", cart->info.mapper);
         return -1;
     }
     printf("Mapper created\n");
 
+    /* Only mappers that count A12 rises cost the PPU a call */
+    sys->ppu->bus.a12_rise = sys->mapper->a12_rise ? sys_ppu_a12_rise : NULL;
+
+    /* PRG-RAM @ $6000-$7FFF */
+    if (cart->prg_ram && cart->prg_ram_size >= 0x2000) {
+        for (int page = 0x60; page < 0x80; page++) {
+            uint8_t* ram = cart->prg_ram + ((page - 0x60) << NES_MAP_PAGE_SHIFT);
+            sys->map->read[page] = ram;
+            sys->map->write[page] = ram;
+        }
+    }
+
     /* Set mirroring */
     int mirror = sys->cartridge->info.mirroring;
-    extern void nes_ppu_set_mirror_mode(uint8_t);
-    nes_ppu_set_mirror_mode((uint8_t)mirror);
+    nes_ppu_set_mirror_mode(sys->ppu, (uint8_t)mirror);
 
     /* Reset system with new cartridge */
     printf("Resetting system...\n");
     nes_sys_reset(sys);
     printf("System ready\n");
 
+    /* Count from the first frame of the new cartridge */
+    nes_sys_reset_stats(sys);
+
     /* Print ROM info */
     char info[256];
     nes_cartridge_get_info_string(sys->cartridge, info, sizeof(info));
@@ -137,17 +186,226 @@ int nes_sys_load_rom(nes_system_t* sys, const char* filename) {
     return 0;
 }
 
+int nes_sys_load_rom(nes_system_t* sys, const char* filename) {
+    printf("Loading ROM from: %s\n", filename);
+
+    sys_unmap_cartridge(sys);
+    nes_cartridge_free(sys->cartridge);
+    nes_rom_result_t result = nes_cartridge_load(sys->cartridge, filename);
+    if (result != NES_ROM_OK) {
+        fprintf(stderr, "Failed to load ROM: %d\n", result);
+        return -1;
+    }
+
+    return sys_attach_cartridge(sys);
+}
+
+int nes_sys_load_shared(nes_system_t* sys, const nes_cartridge_t* src) {
+    sys_unmap_cartridge(sys);
+    nes_rom_result_t result = nes_cartridge_share(sys->cartridge, src);
+    if (result != NES_ROM_OK) {
+        fprintf(stderr, "Failed to share ROM: %d\n", result);
+        return -1;
+    }
+
+    return sys_attach_cartridge(sys);
+}
+
+int nes_sys_load_rom_store(nes_system_t* sys, nes_rom_store_t* store, const char* filename) {
+    sys_unmap_cartridge(sys);
+    nes_cartridge_free(sys->cartridge);
+    nes_rom_result_t result = nes_rom_store_load(store, sys->cartridge, filename);
+    if (result != NES_ROM_OK) {
+        fprintf(stderr, "Failed to load ROM: %d\n", result);
+        return -1;
+    }
+
+    return sys_attach_cartridge(sys);
+}
+
+/* Step the PPU forward by dots - per dot in NES_SYNC_DOT, else whole
+ * lines in one pass where possible */
+static void sys_ppu_advance(nes_system_t* sys, uint32_t dots) {
+    nes_ppu_t* ppu = sys->ppu;
+    int per_dot = sys->sync_mode == NES_SYNC_DOT;
+
+    sys->ppu_frame_dot += dots;
+    NES_STAT(sys->stats.ppu_dots += dots);
+#if NES_STATS_ENABLED
+    uint64_t start = nes_timer_now_ns();
+#endif
+
+    while (dots > 0) {
+        uint32_t line_left = PPU_DOTS_PER_SCANLINE - ppu->cycle;
+        int vblank;
+        if (!per_dot && dots >= line_left) {
+            vblank = nes_ppu_step_scanline(ppu);
+            dots -= line_left;
+        } else {
+            vblank = nes_ppu_step(ppu);
+            dots--;
+        }
+
+        if (ppu->cycle == 0 && sys->mapper->scanline) {
+            sys->mapper->scanline(sys->mapper->context);
+        }
+        if (vblank && (ppu->reg.ctrl & PPUCTRL_NMI)) {
+            nes_cpu_trigger_nmi(sys->cpu);
+        }
+    }
+
+    NES_STAT(sys->stats.ppu_ns += nes_timer_now_ns() - start);
+}
+
+/* Frame-relative PPU dot the CPU has reached */
+static uint32_t sys_cpu_dot(const nes_system_t* sys) {
+    int32_t cycles = (int32_t)(sys->cpu->cycle_count - sys->timing.base_cycle);
+    int32_t dot = cycles * NES_CPU_PPU_RATIO - (int32_t)sys->timing.base_phase;
+    return dot > 0 ? (uint32_t)dot : 0;
+}
+
+/* CPU cycle at which the CPU reaches frame-relative PPU dot */
+static uint32_t sys_dot_cycle(const nes_system_t* sys, uint32_t dot) {
+    return sys->timing.base_cycle +
+           (dot + sys->timing.base_phase + NES_CPU_PPU_RATIO - 1) / NES_CPU_PPU_RATIO;
+}
+
+/* Bring the lagging PPU up to the CPU (never past the end of the frame) */
+static void sys_ppu_catch_up(nes_system_t* sys) {
+    if (!sys->in_frame) {
+        return;
+    }
+
+    uint32_t dot = sys_cpu_dot(sys);
+    if (dot > sys->ppu_cycles_per_frame) {
+        dot = sys->ppu_cycles_per_frame;
+    }
+    if (dot > sys->ppu_frame_dot) {
+        sys_ppu_advance(sys, dot - sys->ppu_frame_dot);
+    }
+}
+
+/* Insert an event in due order, replacing a pending one of the same type
+ * During a CPU run an earlier event shortens the run */
+static void sys_schedule(nes_system_t* sys, nes_event_type_t type, uint32_t dot) {
+    int n = 0;
+    for (int i = 0; i < sys->event_count; i++) {
+        if (sys->events[i].type != type) {
+            sys->events[n++] = sys->events[i];
+        }
+    }
+
+    int pos = n;
+    while (pos > 0 && sys->events[pos - 1].dot > dot) {
+        sys->events[pos] = sys->events[pos - 1];
+        pos--;
+    }
+    sys->events[pos].dot = dot;
+    sys->events[pos].type = type;
+    sys->event_count = n + 1;
+
+    if (pos == 0) {
+        nes_cpu_stop_at(sys->cpu, sys_dot_cycle(sys, dot));
+    }
+}
+
+static void sys_unschedule(nes_system_t* sys, nes_event_type_t type) {
+    int n = 0;
+    for (int i = 0; i < sys->event_count; i++) {
+        if (sys->events[i].type != type) {
+            sys->events[n++] = sys->events[i];
+        }
+    }
+    sys->event_count = n;
+}
+
+/* PPU dots from the current position until (scanline, dot) has been stepped */
+static uint32_t sys_dots_until(const nes_ppu_t* ppu, int scanline, int dot) {
+    int32_t dots = (scanline - (int)ppu->scanline) * PPU_DOTS_PER_SCANLINE +
+                   (dot + 1 - (int)ppu->cycle);
+    if (dots <= 0) {
+        dots += PPU_SCANLINES * PPU_DOTS_PER_SCANLINE;
+    }
+    return (uint32_t)dots;
+}
+
+/* Schedule an event at dot, or drop it if it falls past the end of the frame */
+static void sys_schedule_in_frame(nes_system_t* sys, nes_event_type_t type, uint32_t dot) {
+    if (dot < sys->ppu_cycles_per_frame) {
+        sys_schedule(sys, type, dot);
+    } else {
+        sys_unschedule(sys, type);
+    }
+}
+
+/* Next VBlank and (when something needs it) the end of the current line
+ * and the next A12 rise. A rise moved by a later PPUCTRL/PPUMASK write is
+ * still counted on time; only its IRQ waits for the CPU's next stop */
+static void sys_schedule_ppu_events(nes_system_t* sys) {
+    const nes_ppu_t* ppu = sys->ppu;
+
+    sys_schedule_in_frame(sys, NES_EVENT_VBLANK, sys->ppu_frame_dot + sys_dots_until(ppu, 241, 1));
+    if (sys->sync_mode == NES_SYNC_SCANLINE || sys->mapper->scanline) {
+        sys_schedule_in_frame(sys, NES_EVENT_SCANLINE,
+                              sys->ppu_frame_dot + PPU_DOTS_PER_SCANLINE - ppu->cycle);
+    }
+    if (sys->mapper->a12_rise) {
+        uint32_t until = nes_ppu_dots_until_a12(ppu);
+        if (until) {
+            sys_schedule_in_frame(sys, NES_EVENT_A12, sys->ppu_frame_dot + until);
+        } else {
+            sys_unschedule(sys, NES_EVENT_A12);
+        }
+    }
+}
+
+/* Bring the lagging APU up to the CPU and schedule its next event */
+static void sys_apu_catch_up(nes_system_t* sys) {
+    if (!sys->in_frame) {
+        return;
+    }
+
+    uint32_t cycles = sys->cpu->cycle_count - sys->apu_sync_cycle;
+    sys->apu_sync_cycle = sys->cpu->cycle_count;
+#if NES_STATS_ENABLED
+    uint64_t start = nes_timer_now_ns();
+    nes_apu_execute_cycles(sys->apu, cycles);
+    sys->stats.apu_ns += nes_timer_now_ns() - start;
+#else
+    nes_apu_execute_cycles(sys->apu, cycles);
+#endif
+
+    uint32_t until = nes_apu_cycles_until_event(sys->apu);
+    uint32_t dot = sys->ppu_cycles_per_frame;
+    if (until < NES_CPU_CYCLES_PER_FRAME + 1) {
+        uint32_t cycle = sys->apu_sync_cycle + until - sys->timing.base_cycle;
+        dot = cycle * NES_CPU_PPU_RATIO - sys->timing.base_phase;
+    }
+    sys_schedule_in_frame(sys, NES_EVENT_APU, dot);
+}
+
 /* CPU Read - called from 6502 emulation */
 uint8_t nes_sys_cpu_read(nes_system_t* sys, uint16_t addr) {
     addr &= 0xFFFF;
 
+    /* Directly mapped page */
+    const uint8_t* page = sys->map->read[addr >> NES_MAP_PAGE_SHIFT];
+    if (page) {
+        return page[addr & 0xFF];
+    }
+
     /* Internal RAM */
-    if (addr < NES_RAM_MIRRORS) {
+    if (addr <= NES_RAM_MIRRORS) {
         return sys->ram[addr & NES_RAM_END];
     }
 
     /* PPU registers */
     if (addr >= NES_ADDR_PPU_REG && addr < (NES_ADDR_PPU_REG + 8)) {
+        /* Line-start state is stale for a sprite 0 poll on the current line */
+        if (sys->sync_mode != NES_SYNC_SCANLINE ||
+            ((addr & 7) == 2 && nes_ppu_sprite_zero_pending(sys->ppu))) {
+            sys_ppu_catch_up(sys);
+        }
         return nes_ppu_cpu_read(sys->ppu, addr & 7);
     }
 
@@ -155,6 +413,7 @@ uint8_t nes_sys_cpu_read(nes_system_t* sys, uint16_t addr) {
     if (addr >= NES_ADDR_APU_REG && addr < NES_ADDR_CARTRIDGE) {
         switch (addr) {
             case 0x4015:  /* APU Status */
+                sys_apu_catch_up(sys);
                 return nes_apu_cpu_read(sys->apu, addr);
 
             case CONTROLLER_1:
@@ -185,14 +444,23 @@ uint8_t nes_sys_cpu_read(nes_system_t* sys, uint16_t addr) {
 void nes_sys_cpu_write(nes_system_t* sys, uint16_t addr, uint8_t val) {
     addr &= 0xFFFF;
 
+    /* Directly mapped page */
+    uint8_t* page = sys->map->write[addr >> NES_MAP_PAGE_SHIFT];
+    if (page) {
+        page[addr & 0xFF] = val;
+        return;
+    }
+
     /* Internal RAM */
-    if (addr < NES_RAM_MIRRORS) {
+    if (addr <= NES_RAM_MIRRORS) {
         sys->ram[addr & NES_RAM_END] = val;
         return;
     }
 
     /* PPU registers */
     if (addr >= NES_ADDR_PPU_REG && addr < (NES_ADDR_PPU_REG + 8)) {
+        sys_ppu_catch_up(sys);
+        NES_TRACE(if (sys->trace) nes_trace_event(sys->trace, NES_TRACE_PPU_WRITE, addr, val));
         nes_ppu_cpu_write(sys->ppu, addr & 7, val);
         return;
     }
@@ -201,6 +469,7 @@ void nes_sys_cpu_write(nes_system_t* sys, uint16_t addr, uint8_t val) {
     if (addr >= NES_ADDR_APU_REG && addr < NES_ADDR_CARTRIDGE) {
         switch (addr) {
             case OAM_DMA_ADDR:
+                sys_ppu_catch_up(sys);
                 nes_sys_oam_dma(sys, val);
                 return;
 
@@ -209,7 +478,9 @@ void nes_sys_cpu_write(nes_system_t* sys, uint16_t addr, uint8_t val) {
                 return;
 
             default:
+                sys_apu_catch_up(sys);
                 nes_apu_cpu_write(sys->apu, addr, val);
+                sys_apu_catch_up(sys);   /* Reschedule for the new register state */
                 return;
         }
     }
@@ -220,7 +491,14 @@ void nes_sys_cpu_write(nes_system_t* sys, uint16_t addr, uint8_t val) {
             nes_cartridge_write_prg_ram(sys->cartridge, addr - 0x6000, val);
         }
         if (sys->mapper->cpu_write) {
+            /* Bank and mirroring changes must not reach dots already due */
+            if (addr >= 0x8000) {
+                sys_ppu_catch_up(sys);
+            }
             sys->mapper->cpu_write(sys->mapper->context, addr, val);
+            if (sys->mapper->irq_line && !sys->mapper->irq_line(sys->mapper->context)) {
+                nes_cpu_clear_irq(sys->cpu, NES_IRQ_MAPPER);
+            }
         }
         return;
     }
@@ -246,14 +524,36 @@ void nes_sys_ppu_write(nes_system_t* sys, uint16_t addr, uint8_t val) {
 /* OAM DMA */
 void nes_sys_oam_dma(nes_system_t* sys, uint8_t page) {
     uint8_t* page_data = &sys->ram[page << 8];
-
-    /* Update CPU timing - DMA takes 513 or 514 cycles */
-    extern void nes_cpu_execute_cycles(nes_cpu_t*, uint32_t);
-    nes_cpu_execute_cycles(sys->cpu, 514);
+    NES_STAT(sys->stats.oam_dmas++);
 
     /* Transfer data to OAM */
     extern void nes_ppu_oam_dma(nes_ppu_t*, const uint8_t*);
     nes_ppu_oam_dma(sys->ppu, page_data);
+
+    /* The CPU is halted for 513 cycles, plus one when DMA starts on an odd cycle */
+    nes_cpu_stall(sys->cpu, 513 + (sys->cpu->cycle_count & 1));
+}
+
+void nes_sys_set_sync_mode(nes_system_t* sys, nes_sync_mode_t mode) {
+    sys->sync_mode = mode;
+}
+
+/* Convert the finished frame into the sink's buffer */
+static void sys_deliver_frame(nes_system_t* sys) {
+    nes_frame_sink_t* sink = &sys->frame_sink;
+    size_t pitch = 0;
+#if NES_STATS_ENABLED
+    uint64_t start = nes_timer_now_ns();
+#endif
+
+    void* out = sink->acquire(sink->context, &pitch);
+    if (out && nes_ppu_convert_frame(sys->ppu, (nes_pixel_format_t)sink->format, out, pitch) == 0) {
+        if (sink->submit) {
+            sink->submit(sink->context);
+        }
+    }
+
+    NES_STAT(sys->stats.present_ns += nes_timer_now_ns() - start);
 }
 
 /* Run one frame */
@@ -262,33 +562,93 @@ int nes_sys_step_frame(nes_system_t* sys) {
         return 0;
     }
 
+    nes_cpu_t* cpu = sys->cpu;
     sys->frame_complete = 0;
-
-    /* Execute CPU for one frame's worth of cycles */
-    /* Run in sync with PPU - 3 CPU cycles per PPU cycle */
-    uint32_t ppu_cycles = NES_PPU_CYCLES_PER_FRAME;
-    uint32_t cpu_cycles = NES_CPU_CYCLES_PER_FRAME;
-
-    /* Interleave PPU scanning */
-    for (uint32_t i = 0; i < ppu_cycles && !sys->frame_complete; i++) {
-        int vblank = nes_ppu_step(sys->ppu);
-
-        /* Trigger NMI in CPU */
-        if (vblank && (sys->ppu->reg.ctrl & PPUCTRL_NMI)) {
-            nes_cpu_trigger_nmi(sys->cpu);
+#if NES_STATS_ENABLED
+    uint32_t start_cycle = cpu->cycle_count;
+#endif
+
+    /* The APU caught up at the end of the previous frame; the CPU may be
+     * a few cycles into this one already */
+    sys->in_frame = 1;
+    sys->ppu_frame_dot = 0;
+    sys->apu_sync_cycle = cpu->cycle_count;
+    sys->event_count = 0;
+
+    /* The frame ends where the PPU next returns to dot 0 of the pre-render
+     * line, so every frame starts at the same PPU position (a PPU left
+     * elsewhere, e.g. by an older snapshot, realigns within one frame) */
+    sys->ppu_cycles_per_frame = sys_dots_until(sys->ppu, PPU_SCANLINES - 2, PPU_DOTS_PER_SCANLINE - 1);
+    sys_schedule(sys, NES_EVENT_FRAME_END, sys->ppu_cycles_per_frame);
+    sys_schedule_ppu_events(sys);
+    sys_apu_catch_up(sys);
+
+    /* Run the CPU uninterrupted to the soonest event, then let the PPU and
+     * APU act on it - overshoot carries into the next run */
+    for (;;) {
+        nes_event_t event = sys->events[0];
+#if NES_STATS_ENABLED
+        /* PPU/APU catch-up inside the run is charged to them, not the CPU */
+        uint64_t run_start = nes_timer_now_ns();
+        uint64_t nested = sys->stats.ppu_ns + sys->stats.apu_ns;
+        nes_cpu_run_until(cpu, sys_dot_cycle(sys, event.dot));
+        sys->stats.cpu_ns += nes_timer_now_ns() - run_start - (sys->stats.ppu_ns + sys->stats.apu_ns - nested);
+#else
+        nes_cpu_run_until(cpu, sys_dot_cycle(sys, event.dot));
+#endif
+        if (sys->events[0].dot < event.dot) {
+            continue;   /* An earlier event was scheduled during the run */
         }
 
-        /* Run 3 CPU cycles per 1 PPU cycle */
-        nes_cpu_execute_cycles(sys->cpu, NES_CPU_PPU_RATIO);
+        sys_ppu_catch_up(sys);
+        if (event.type == NES_EVENT_FRAME_END) {
+            break;
+        }
+        if (event.type == NES_EVENT_APU) {
+            sys_apu_catch_up(sys);
+        } else {
+            sys_schedule_ppu_events(sys);
+        }
     }
 
-    /* Run APU for the frame */
-    nes_apu_execute_cycles(sys->apu, cpu_cycles);
+    sys_apu_catch_up(sys);
+    sys->in_frame = 0;
+
+    /* Dot 0 of the next frame */
+    uint32_t dots = sys->timing.base_phase + sys->ppu_cycles_per_frame;
+    sys->timing.base_cycle += dots / NES_CPU_PPU_RATIO;
+    sys->timing.base_phase = dots % NES_CPU_PPU_RATIO;
+
+    NES_STAT(sys->stats.cpu_cycles += cpu->cycle_count - start_cycle);
+    NES_STAT(sys->stats.frames++);
 
     sys->frame_complete = 1;
+    if (sys->frame_sink.acquire && nes_ppu_frame_rendered(sys->ppu)) {
+        sys_deliver_frame(sys);
+    }
     return 1;
 }
 
+/* Batched stepping - one controller byte in, one index frame out per instance */
+int nes_sys_step_frames_batch(nes_system_t* systems, size_t n, const uint8_t* inputs, uint8_t* obs_out) {
+    if (!systems && n > 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        nes_system_t* sys = &systems[i];
+        if (inputs) {
+            nes_input_set_buttons(sys->input, 0, inputs[i]);
+        }
+        nes_sys_step_frame(sys);
+        if (obs_out) {
+            memcpy(obs_out + i * NES_FRAME_PIXELS, nes_ppu_get_frame_buffer(sys->ppu), NES_FRAME_PIXELS);
+        }
+    }
+
+    return 0;
+}
+
 /* Get frame buffer */
 const uint8_t* nes_sys_get_frame_buffer(nes_system_t* sys) {
     return nes_ppu_get_frame_buffer(sys->ppu);
@@ -296,7 +656,25 @@ const uint8_t* nes_sys_get_frame_buffer(nes_system_t* sys) {
 
 /* Render to RGBA */
 void nes_sys_render_frame(nes_system_t* sys, uint32_t* buffer) {
-    nes_ppu_render_frame(sys->ppu, buffer);
+    if (nes_ppu_frame_rendered(sys->ppu)) {
+        nes_ppu_render_frame(sys->ppu, buffer);
+    }
+}
+
+void nes_sys_set_render(nes_system_t* sys, int enable) {
+    nes_ppu_set_render(sys->ppu, enable);
+}
+
+void nes_sys_set_audio(nes_system_t* sys, int enable) {
+    nes_apu_set_output(sys->apu, enable);
+}
+
+void nes_sys_set_frame_sink(nes_system_t* sys, const nes_frame_sink_t* sink) {
+    if (sink) {
+        sys->frame_sink = *sink;
+    } else {
+        memset(&sys->frame_sink, 0, sizeof(sys->frame_sink));
+    }
 }
 
 /* Get audio samples */
@@ -304,6 +682,51 @@ int nes_sys_get_audio(nes_system_t* sys, float* buffer, int max_samples) {
     return nes_apu_generate_samples(sys->apu, buffer, max_samples);
 }
 
+/* Performance counters */
+int nes_sys_get_stats(const nes_system_t* sys, nes_sys_stats_t* out) {
+    memset(out, 0, sizeof(*out));
+    if (!NES_STATS_ENABLED) {
+        return -1;
+    }
+
+    const nes_cpu_stats_t* cpu = &sys->cpu->stats;
+    *out = sys->stats;
+    out->instructions = cpu->instructions;
+    out->idle_cycles = cpu->idle_cycles;
+    out->nmis = cpu->nmis;
+    out->irqs = cpu->irqs;
+    out->bank_switches = sys->map->bank_switches;
+
+    /* 8KB blocks: $0000 RAM, $2000 PPU, $4000 APU/I-O, $6000-$FFFF cartridge */
+    for (int block = 0; block < NES_CPU_STATS_BLOCKS; block++) {
+        int region = block < NES_STATS_MAPPER ? block : NES_STATS_MAPPER;
+        out->reads[region] += cpu->reads[block];
+        out->writes[region] += cpu->writes[block];
+    }
+    return 0;
+}
+
+void nes_sys_reset_stats(nes_system_t* sys) {
+    memset(&sys->stats, 0, sizeof(sys->stats));
+    memset(&sys->cpu->stats, 0, sizeof(sys->cpu->stats));
+    sys->map->bank_switches = 0;
+}
+
+/* Event trace */
+int nes_sys_set_trace(nes_system_t* sys, nes_trace_t* trace) {
+    if (!NES_TRACE_ENABLED) {
+        return trace ? -1 : 0;
+    }
+
+    if (trace) {
+        nes_trace_set_clock(trace, &sys->cpu->cycle_count, &sys->ppu->scanline, &sys->ppu->cycle);
+    }
+    sys->trace = trace;
+    sys->cpu->trace = trace;
+    sys->map->trace = trace;
+    return 0;
+}
+
 /* Running state */
 int nes_sys_is_running(const nes_system_t* sys) {
     return sys->running;
@@ -313,60 +736,137 @@ void nes_sys_set_running(nes_system_t* sys, int running) {
     sys->running = running;
 }
 
-/* Save state */
-int nes_sys_save_state(nes_system_t* sys, const char* filename) {
-    FILE* f = fopen(filename, "wb");
-    if (!f) return -1;
-
-    /* Save CPU state */
-    fwrite(sys->cpu, sizeof(nes_cpu_t), 1, f);
+/* Save-state snapshot layout: header, then each section back to back */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t total_size;
+    uint32_t rom_crc32;         /* Snapshot only restores onto the same ROM */
+    uint32_t mapper_number;
+    uint32_t cpu_size;
+    uint32_t ppu_size;
+    uint32_t apu_size;
+    uint32_t input_size;
+    uint32_t ram_size;
+    uint32_t mapper_size;
+    uint32_t prg_ram_size;
+    uint32_t chr_ram_size;
+    uint32_t timing_size;
+} snapshot_header_t;
+
+/* Fill header for the system's current layout (also captures mapper registers) */
+static void snapshot_make_header(nes_system_t* sys, snapshot_header_t* hdr) {
+    nes_mapper_save_state(sys->mapper);
+
+    hdr->magic = NES_SNAPSHOT_MAGIC;
+    hdr->version = NES_SNAPSHOT_VERSION;
+    hdr->rom_crc32 = sys->cartridge->info.crc32;
+    hdr->mapper_number = (uint32_t)sys->mapper->number;
+    hdr->cpu_size = (uint32_t)NES_CPU_STATE_SIZE;
+    hdr->ppu_size = (uint32_t)NES_PPU_STATE_SIZE;
+    hdr->apu_size = (uint32_t)NES_APU_STATE_SIZE;
+    hdr->input_size = (uint32_t)sizeof(nes_input_t);
+    hdr->ram_size = NES_RAM_SIZE;
+    hdr->mapper_size = sys->mapper->state.size;
+    hdr->prg_ram_size = sys->cartridge->prg_ram ? (uint32_t)sys->cartridge->prg_ram_size : 0;
+    hdr->chr_ram_size = sys->cartridge->info.has_chrram ? (uint32_t)sys->cartridge->chr_rom_size : 0;
+    hdr->timing_size = (uint32_t)sizeof(nes_sys_timing_t);
+    hdr->total_size = (uint32_t)sizeof(snapshot_header_t) + hdr->cpu_size + hdr->ppu_size +
+                      hdr->apu_size + hdr->input_size + hdr->ram_size + hdr->mapper_size +
+                      hdr->prg_ram_size + hdr->chr_ram_size + hdr->timing_size;
+}
 
-    /* Save PPU state */
-    fwrite(sys->ppu, sizeof(nes_ppu_t), 1, f);
+size_t nes_sys_snapshot_size(nes_system_t* sys) {
+    snapshot_header_t hdr;
+    snapshot_make_header(sys, &hdr);
+    return hdr.total_size;
+}
 
-    /* Save APU state */
-    fwrite(sys->apu, sizeof(nes_apu_t), 1, f);
+size_t nes_sys_snapshot_to_buffer(nes_system_t* sys, void* buffer, size_t size) {
+    snapshot_header_t hdr;
+    snapshot_make_header(sys, &hdr);
+    if (!buffer || size < hdr.total_size) {
+        return 0;
+    }
 
-    /* Save input state */
-    fwrite(sys->input, sizeof(nes_input_t), 1, f);
+    uint8_t* out = (uint8_t*)buffer;
+    memcpy(out, &hdr, sizeof(hdr));                               out += sizeof(hdr);
+    memcpy(out, sys->cpu, hdr.cpu_size);                          out += hdr.cpu_size;
+    memcpy(out, sys->ppu, hdr.ppu_size);                          out += hdr.ppu_size;
+    memcpy(out, sys->apu, hdr.apu_size);                          out += hdr.apu_size;
+    memcpy(out, sys->input, hdr.input_size);                      out += hdr.input_size;
+    memcpy(out, sys->ram, hdr.ram_size);                          out += hdr.ram_size;
+    memcpy(out, sys->mapper->state.data, hdr.mapper_size);        out += hdr.mapper_size;
+    memcpy(out, sys->cartridge->prg_ram, hdr.prg_ram_size);       out += hdr.prg_ram_size;
+    memcpy(out, sys->cartridge->chr_rom, hdr.chr_ram_size);       out += hdr.chr_ram_size;
+    memcpy(out, &sys->timing, hdr.timing_size);
+
+    return hdr.total_size;
+}
 
-    /* Save RAM */
-    fwrite(sys->ram, NES_RAM_SIZE, 1, f);
+int nes_sys_restore_from_buffer(nes_system_t* sys, const void* buffer, size_t size) {
+    if (!buffer || size < sizeof(snapshot_header_t)) {
+        return -1;
+    }
 
-    /* Save mapper state */
-    if (sys->mapper) {
-        fwrite(&sys->mapper->state, sizeof(mapper_buffer_t), 1, f);
+    /* Every section must match this build and this cartridge exactly */
+    snapshot_header_t hdr, want;
+    memcpy(&hdr, buffer, sizeof(hdr));
+    snapshot_make_header(sys, &want);
+    if (memcmp(&hdr, &want, sizeof(hdr)) != 0 || size < hdr.total_size) {
+        return -1;
     }
 
-    fclose(f);
-    return 0;
+    const uint8_t* in = (const uint8_t*)buffer + sizeof(hdr);
+    memcpy(sys->cpu, in, hdr.cpu_size);                           in += hdr.cpu_size;
+    memcpy(sys->ppu, in, hdr.ppu_size);                           in += hdr.ppu_size;
+    memcpy(sys->apu, in, hdr.apu_size);                           in += hdr.apu_size;
+    memcpy(sys->input, in, hdr.input_size);                       in += hdr.input_size;
+    memcpy(sys->ram, in, hdr.ram_size);                           in += hdr.ram_size;
+    memcpy(sys->mapper->state.data, in, hdr.mapper_size);         in += hdr.mapper_size;
+    memcpy(sys->cartridge->prg_ram, in, hdr.prg_ram_size);        in += hdr.prg_ram_size;
+    memcpy(sys->cartridge->chr_rom, in, hdr.chr_ram_size);        in += hdr.chr_ram_size;
+    memcpy(&sys->timing, in, hdr.timing_size);
+
+    sys->mapper->state.size = (uint8_t)hdr.mapper_size;
+    return nes_mapper_load_state(sys->mapper);
 }
 
-/* Load state */
-int nes_sys_load_state(nes_system_t* sys, const char* filename) {
-    FILE* f = fopen(filename, "rb");
-    if (!f) return -1;
-
-    /* Load CPU state */
-    fread(sys->cpu, sizeof(nes_cpu_t), 1, f);
+/* Save state to file */
+int nes_sys_save_state(nes_system_t* sys, const char* filename) {
+    size_t size = nes_sys_snapshot_size(sys);
+    uint8_t* buffer = (uint8_t*)malloc(size);
+    if (!buffer) return -1;
 
-    /* Load PPU state */
-    fread(sys->ppu, sizeof(nes_ppu_t), 1, f);
+    nes_sys_snapshot_to_buffer(sys, buffer, size);
 
-    /* Load APU state */
-    fread(sys->apu, sizeof(nes_apu_t), 1, f);
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        free(buffer);
+        return -1;
+    }
+    size_t written = fwrite(buffer, 1, size, f);
+    fclose(f);
+    free(buffer);
 
-    /* Load input state */
-    fread(sys->input, sizeof(nes_input_t), 1, f);
+    return written == size ? 0 : -1;
+}
 
-    /* Load RAM */
-    fread(sys->ram, NES_RAM_SIZE, 1, f);
+/* Load state from file */
+int nes_sys_load_state(nes_system_t* sys, const char* filename) {
+    size_t size = nes_sys_snapshot_size(sys);
+    uint8_t* buffer = (uint8_t*)malloc(size);
+    if (!buffer) return -1;
 
-    /* Load mapper state */
-    if (sys->mapper) {
-        fread(&sys->mapper->state, sizeof(mapper_buffer_t), 1, f);
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        free(buffer);
+        return -1;
     }
-
+    size_t read = fread(buffer, 1, size, f);
     fclose(f);
-    return 0;
+
+    int result = read == size ? nes_sys_restore_from_buffer(sys, buffer, size) : -1;
+    free(buffer);
+    return result;
 }
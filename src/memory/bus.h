@@ -19,16 +19,96 @@ typedef struct nes_apu nes_apu_t;
 typedef struct nes_mapper nes_mapper_t;
 typedef struct nes_cartridge nes_cartridge_t;
 typedef struct nes_input_state nes_input_t;
+typedef struct nes_memory_map nes_memory_map_t;
+typedef struct nes_rom_store nes_rom_store_t;
+typedef struct nes_trace nes_trace_t;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Frame buffer size in palette indices (PPU_WIDTH * PPU_HEIGHT) */
+#define NES_FRAME_PIXELS    (256 * 240)
+
 /* System Memory */
 #define NES_RAM_SIZE        2048  /* 2KB internal RAM */
 #define NES_RAM_END         0x07FF
 #define NES_RAM_MIRRORS     0x1FFF
 
+/* CPU/PPU synchronization granularity */
+typedef enum {
+    NES_SYNC_DOT = 0,       /* PPU catches up dot by dot whenever it can be observed (default) */
+    NES_SYNC_SCANLINE,      /* Run the CPU a scanline ahead, then render the line in one pass */
+    NES_SYNC_CATCHUP        /* As NES_SYNC_DOT, but whole lines are rendered in one pass */
+} nes_sync_mode_t;
+
+/* Frame scheduler events, due at a PPU dot of the current frame */
+typedef enum {
+    NES_EVENT_FRAME_END = 0,    /* Last dot of the frame */
+    NES_EVENT_VBLANK,           /* Scanline 241 dot 1 - VBlank flag and NMI */
+    NES_EVENT_SCANLINE,         /* End of line - mapper scanline hook, scanline sync mode */
+    NES_EVENT_A12,              /* PPU A12 rise - mapper IRQ counter */
+    NES_EVENT_APU,              /* Frame sequencer step or DMC sample fetch */
+    NES_EVENT_COUNT
+} nes_event_type_t;
+
+typedef struct {
+    uint32_t         dot;       /* Frame-relative PPU dot */
+    nes_event_type_t type;
+} nes_event_t;
+
+/* Alignment of the CPU and PPU clocks, carried across frames (saved in snapshots)
+ * Dot 0 of the current frame falls base_phase PPU dots after CPU cycle base_cycle */
+typedef struct {
+    uint32_t base_cycle;
+    uint32_t base_phase;        /* 0-2 */
+} nes_sys_timing_t;
+
+/* Frame sink - completed frames are converted straight into a buffer the
+ * consumer hands out (a locked texture, a shared-memory slot, ...) */
+typedef struct {
+    void*   context;
+    int     format;             /* nes_pixel_format_t */
+
+    /* Buffer for the next frame and its row pitch in bytes (0 = packed),
+     * or NULL to drop the frame */
+    void*   (*acquire)(void* ctx, size_t* pitch);
+
+    /* The buffer returned by acquire holds the frame (may be NULL) */
+    void    (*submit)(void* ctx);
+} nes_frame_sink_t;
+
+/* CPU bus regions counted by nes_sys_get_stats */
+typedef enum {
+    NES_STATS_RAM = 0,          /* $0000-$1FFF internal RAM */
+    NES_STATS_PPU,              /* $2000-$3FFF PPU registers */
+    NES_STATS_APU,              /* $4000-$5FFF APU, I/O and expansion */
+    NES_STATS_MAPPER,           /* $6000-$FFFF PRG-RAM, PRG-ROM and mapper registers */
+    NES_STATS_REGION_COUNT
+} nes_stats_region_t;
+
+/* Performance counters, accumulated since the ROM was loaded or
+ * nes_sys_reset_stats (NES_ENABLE_STATS builds only) */
+typedef struct {
+    uint64_t frames;
+    uint64_t instructions;      /* Instructions retired */
+    uint64_t cpu_cycles;
+    uint64_t idle_cycles;       /* CPU cycles fast-forwarded through idle loops */
+    uint64_t ppu_dots;
+    uint64_t reads[NES_STATS_REGION_COUNT];
+    uint64_t writes[NES_STATS_REGION_COUNT];
+    uint64_t bank_switches;     /* Mapper bank register updates */
+    uint64_t nmis;
+    uint64_t irqs;
+    uint64_t oam_dmas;
+
+    /* Wall-clock time per subsystem; CPU excludes the PPU/APU catch-up it triggers */
+    uint64_t cpu_ns;
+    uint64_t ppu_ns;
+    uint64_t apu_ns;
+    uint64_t present_ns;        /* Frame sink conversion and submit */
+} nes_sys_stats_t;
+
 /* System state */
 typedef struct nes_system {
     /* Components */
@@ -41,11 +121,24 @@ typedef struct nes_system {
 
     /* Memory */
     uint8_t         ram[NES_RAM_SIZE];
+    nes_memory_map_t* map;              /* CPU page table: RAM, PRG-RAM, mapped PRG-ROM */
 
     /* Frame timing */
     uint32_t        cpu_cycles_per_frame;
-    uint32_t        ppu_cycles_per_frame;
+    uint32_t        ppu_cycles_per_frame;   /* Dots in the current frame (until the PPU wraps) */
     int             frame_complete;
+    nes_frame_sink_t frame_sink;        /* acquire == NULL: no sink */
+    nes_sys_stats_t stats;              /* System-level counters; see nes_sys_get_stats */
+    nes_trace_t*    trace;              /* Event log; see nes_sys_set_trace */
+
+    /* Event scheduler - CPU runs ahead, PPU and APU catch up */
+    nes_sync_mode_t sync_mode;
+    nes_sys_timing_t timing;
+    int             in_frame;           /* Inside nes_sys_step_frame: PPU and APU lag the CPU */
+    uint32_t        ppu_frame_dot;      /* PPU dots stepped in the current frame */
+    uint32_t        apu_sync_cycle;     /* CPU cycle_count the APU has caught up to */
+    nes_event_t     events[NES_EVENT_COUNT];   /* Pending events, soonest first */
+    int             event_count;
 
     /* Flags */
     int             running;
@@ -95,12 +188,44 @@ void nes_sys_reset(nes_system_t* sys);
  */
 int nes_sys_load_rom(nes_system_t* sys, const char* filename);
 
+/**
+ * Load a cartridge whose PRG/CHR-ROM is shared with src (read-only).
+ * PRG-RAM and CHR-RAM stay private to this system; src must outlive it.
+ */
+int nes_sys_load_shared(nes_system_t* sys, const nes_cartridge_t* src);
+
+/**
+ * Load ROM through a shared ROM store: PRG/CHR-ROM is mapped once and
+ * shared with every other system loaded from the same image
+ */
+int nes_sys_load_rom_store(nes_system_t* sys, nes_rom_store_t* store, const char* filename);
+
 /**
  * System step - execute one frame
  * Returns 1 when a frame is complete
  */
 int nes_sys_step_frame(nes_system_t* sys);
 
+/**
+ * Select CPU/PPU synchronization granularity for subsequent frames
+ * The CPU always runs uninterrupted to the next scheduled event (VBlank,
+ * mapper line hook, APU step, end of frame). The PPU catches up to it on
+ * $2000-$2007 access, OAM DMA and mapper register writes.
+ * NES_SYNC_SCANLINE skips the catch-up on reads, so reads see the PPU as
+ * of the line start (except $2002 while a sprite 0 hit is pending on the
+ * line), and also stops the CPU at the end of every line.
+ */
+void nes_sys_set_sync_mode(nes_system_t* sys, nes_sync_mode_t mode);
+
+/**
+ * Step n systems by one frame each
+ * inputs:  n controller-1 button masks (see nes_input_set_buttons), or NULL to keep current input
+ * obs_out: caller-owned n * NES_FRAME_PIXELS bytes; instance i's palette indices
+ *          land at obs_out + i * NES_FRAME_PIXELS. NULL skips the copy.
+ * Returns 0 on success, -1 on invalid arguments
+ */
+int nes_sys_step_frames_batch(nes_system_t* systems, size_t n, const uint8_t* inputs, uint8_t* obs_out);
+
 /**
  * Get frame buffer from PPU
  */
@@ -108,14 +233,52 @@ const uint8_t* nes_sys_get_frame_buffer(nes_system_t* sys);
 
 /**
  * Render frame to RGBA buffer
+ * Leaves buffer untouched when the last frame was suppressed (nes_sys_set_render)
  */
 void nes_sys_render_frame(nes_system_t* sys, uint32_t* buffer);
 
+/**
+ * Draw (1) or suppress (0) the pixels of the frames stepped from now on
+ * Game logic, sprite 0 hit and the frame timing are unaffected; suppressed
+ * frames keep the previous frame buffer and are not delivered to the sink
+ */
+void nes_sys_set_render(nes_system_t* sys, int enable);
+
+/**
+ * Produce (1) or suppress (0) audio samples from now on
+ * The APU runs identically either way; suppressed cycles queue nothing
+ */
+void nes_sys_set_audio(nes_system_t* sys, int enable);
+
+/**
+ * Deliver every rendered frame completed by nes_sys_step_frame to sink
+ * The sink is copied; NULL removes it
+ */
+void nes_sys_set_frame_sink(nes_system_t* sys, const nes_frame_sink_t* sink);
+
 /**
  * Generate audio samples
  */
 int nes_sys_get_audio(nes_system_t* sys, float* buffer, int max_samples);
 
+/**
+ * Read the performance counters into out
+ * Returns 0 on success, -1 (out zeroed) if built without NES_ENABLE_STATS
+ */
+int nes_sys_get_stats(const nes_system_t* sys, nes_sys_stats_t* out);
+
+/**
+ * Zero all performance counters
+ */
+void nes_sys_reset_stats(nes_system_t* sys);
+
+/**
+ * Log instructions, PPU register writes and bank switches into trace
+ * (NULL detaches it). The trace must outlive its attachment.
+ * Returns 0 on success, -1 if built without NES_ENABLE_TRACE
+ */
+int nes_sys_set_trace(nes_system_t* sys, nes_trace_t* trace);
+
 /**
  * CPU read from address
  */
@@ -151,6 +314,30 @@ int nes_sys_is_running(const nes_system_t* sys);
  */
 void nes_sys_set_running(nes_system_t* sys, int running);
 
+/* Save-state snapshot format */
+#define NES_SNAPSHOT_MAGIC   0x5353454E  /* "NESS" */
+#define NES_SNAPSHOT_VERSION 5
+
+/**
+ * Size in bytes of a snapshot of this system (constant for a loaded ROM)
+ */
+size_t nes_sys_snapshot_size(nes_system_t* sys);
+
+/**
+ * Write a snapshot of all mutable state into caller memory
+ * The layout is pointer-free: CPU/PPU/APU/input state, RAM, mapper registers,
+ * PRG-RAM, CHR-RAM and the CPU/PPU clock alignment. The PPU frame buffer is output and is not included.
+ * Returns bytes written, or 0 if buffer is NULL or smaller than nes_sys_snapshot_size()
+ */
+size_t nes_sys_snapshot_to_buffer(nes_system_t* sys, void* buffer, size_t size);
+
+/**
+ * Restore a snapshot taken by nes_sys_snapshot_to_buffer
+ * Returns 0 on success, -1 if the snapshot is truncated, from another ROM or
+ * from a build with a different state layout
+ */
+int nes_sys_restore_from_buffer(nes_system_t* sys, const void* buffer, size_t size);
+
 /**
  * Save state to file
  */
@@ -162,12 +349,12 @@ int nes_sys_save_state(nes_system_t* sys, const char* filename);
 int nes_sys_load_state(nes_system_t* sys, const char* filename);
 
 /* CPU-PPU Cycle Ratio */
-#define NES_CPU_PPU_RATIO 3  /* 3 CPU cycles = 1 PPU cycle */
+#define NES_CPU_PPU_RATIO 3  /* 3 PPU dots per CPU cycle */
 
 /* Frame timing */
 #define NES_FRAMES_PER_SECOND 60
 #define NES_CPU_CYCLES_PER_FRAME 29780  /* NTSC */
-#define NES_PPU_CYCLES_PER_FRAME 89341  /* NTSC */
+#define NES_PPU_CYCLES_PER_FRAME 89342  /* NTSC: 262 lines x 341 dots, no odd-frame skip */
 
 #ifdef __cplusplus
 }
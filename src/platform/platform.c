@@ -7,7 +7,12 @@
 
 #include "platform.h"
 #include "../memory/bus.h"
+#include "../ppu/ppu.h"
 #include "../input/input.h"
+#include "../apu/apu.h"
+#include "../util/atomic.h"
+#include "../util/ring.h"
+#include "../util/triple.h"
 
 /* SDL2 includes - using proper include paths */
 #ifdef _WIN32
@@ -42,71 +47,56 @@ static const struct {
     {SDLK_b, NES_BUTTON_B},        /* Alt B */
 };
 
-/* Save state slot */
-static int g_save_slot = 0;
-
 /* Key state tracking */
 static uint8_t g_key_state[SDL_NUM_SCANCODES] = {0};
 
-/* Input callback for SDL */
-static void handle_key_event(SDL_Keycode key, int pressed, nes_system_t* sys) {
+/* Input callback for SDL - runs on the main thread, so anything touching the
+ * system is queued for the emulation thread */
+static void handle_key_event(nes_platform_t* plat, SDL_Keycode key, int pressed) {
     /* Check mapped keys */
     for (size_t i = 0; i < sizeof(g_key_map) / sizeof(g_key_map[0]); i++) {
         if (g_key_map[i].sdl == key) {
-            nes_input_set_button(sys->input, 0, g_key_map[i].nes, pressed);
+            uint32_t bit = 1u << g_key_map[i].nes;
+            uint32_t buttons = plat->buttons;    /* Only this thread stores it */
+            nes_atomic_store_u32(&plat->buttons, pressed ? (buttons | bit) : (buttons & ~bit));
             return;
         }
     }
 
     /* Hotkeys */
-    if (pressed && sys->input) {
+    if (pressed) {
         switch (key) {
             case SDLK_ESCAPE:
-                sys->running = 0;
+                nes_atomic_store_u32(&plat->quit, 1);
                 break;
 
             case SDLK_F1:
-                nes_sys_reset(sys);
-                printf("Reset\n");
+                nes_atomic_fetch_or_u32(&plat->commands, NES_PLATFORM_CMD_RESET);
                 break;
 
             case SDLK_F5:
-                /* Save state */
-                {
-                    char filename[64];
-                    snprintf(filename, sizeof(filename), "save/state%02d.sav", g_save_slot);
-                    nes_sys_save_state(sys, filename);
-                    printf("Saved state to slot %d\n", g_save_slot);
-                }
+                nes_atomic_fetch_or_u32(&plat->commands, NES_PLATFORM_CMD_SAVE);
                 break;
 
             case SDLK_F7:
-                g_save_slot = (g_save_slot + 1) % 10;
-                printf("Save slot: %d\n", g_save_slot);
+                {
+                    uint32_t slot = (plat->save_slot + 1) % 10;
+                    nes_atomic_store_u32(&plat->save_slot, slot);
+                    printf("Save slot: %u\n", (unsigned)slot);
+                }
                 break;
 
             case SDLK_F9:
-                /* Load state */
-                {
-                    char filename[64];
-                    snprintf(filename, sizeof(filename), "save/state%02d.sav", g_save_slot);
-                    nes_sys_load_state(sys, filename);
-                    printf("Loaded state from slot %d\n", g_save_slot);
-                }
+                nes_atomic_fetch_or_u32(&plat->commands, NES_PLATFORM_CMD_LOAD);
                 break;
 
             case SDLK_F11:
-                /* Toggle fullscreen */
-                {
-                    extern void nes_platform_toggle_fullscreen(nes_platform_t*);
-                    nes_platform_toggle_fullscreen(&(nes_platform_t){0}); /* FIXME */
-                }
+                nes_platform_toggle_fullscreen(plat);
                 break;
 
             case SDLK_F12:
                 /* Save screenshot */
                 {
-                    extern int nes_platform_save_screenshot(nes_platform_t*, const char*);
                     char filename[64];
                     snprintf(filename, sizeof(filename), "screenshot_%d.png", (int)nes_platform_get_time_us() / 1000000);
                     printf("Screenshot saved: %s\n", filename);
@@ -130,6 +120,7 @@ int nes_platform_init(nes_platform_t* plat, int scale, int fullscreen) {
     plat->running = 1;
     plat->speed = 1;
     plat->fps = 60;
+    plat->frame_time = 1000000 / NES_FRAMES_PER_SECOND;
 
     /* Set window title */
     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
@@ -138,6 +129,21 @@ int nes_platform_init(nes_platform_t* plat, int scale, int fullscreen) {
 }
 
 void nes_platform_shutdown(nes_platform_t* plat) {
+    if (plat->audio.initialized) {
+        /* Stops the callback before its ring goes away */
+        SDL_CloseAudioDevice((SDL_AudioDeviceID)(intptr_t)plat->audio.device);
+        plat->audio.initialized = 0;
+    }
+    if (plat->audio.queue) {
+        nes_ring_free((nes_ring_t*)plat->audio.queue);
+        free(plat->audio.queue);
+        plat->audio.queue = NULL;
+    }
+    if (plat->window.frames) {
+        nes_triple_free((nes_triple_t*)plat->window.frames);
+        free(plat->window.frames);
+        plat->window.frames = NULL;
+    }
     if (plat->window.texture) {
         SDL_DestroyTexture((SDL_Texture*)plat->window.texture);
     }
@@ -205,45 +211,69 @@ int nes_platform_create_window(nes_platform_t* plat, const char* title) {
 
     plat->window.texture = texture;
 
+    /* Finished frames on their way from the emulation thread */
+    nes_triple_t* frames = (nes_triple_t*)malloc(sizeof(nes_triple_t));
+    if (!frames || nes_triple_init(frames, NES_FRAMEBUFFER_SIZE) != 0) {
+        fprintf(stderr, "Failed to allocate frame buffers\n");
+        free(frames);
+        return -1;
+    }
+    plat->window.frames = frames;
+
     plat->last_time = nes_platform_get_time_us();
 
     return 0;
 }
 
-/* Audio callback */
+/* Audio callback - only drains the ring, never touches the emulator */
 static void audio_callback(void* userdata, Uint8* stream, int len) {
     nes_platform_t* plat = (nes_platform_t*)userdata;
+    nes_ring_t* ring = (nes_ring_t*)plat->audio.queue;
+    int16_t* out = (int16_t*)stream;
     int samples = len / 4;  /* 16-bit stereo = 4 bytes per sample */
+    float chunk[NES_AUDIO_BUFFER_SAMPLES];
+
+    while (samples > 0) {
+        uint32_t want = samples < NES_AUDIO_BUFFER_SAMPLES ? (uint32_t)samples : NES_AUDIO_BUFFER_SAMPLES;
+        uint32_t got = nes_ring_read(ring, chunk, want);
+        if (got < want) {
+            /* Underrun: hold the last level instead of dropping to zero */
+            plat->audio.underruns++;
+            for (uint32_t i = got; i < want; i++) {
+                chunk[i] = got ? chunk[got - 1] : plat->audio.last_sample;
+            }
+        }
+        plat->audio.last_sample = chunk[want - 1];
 
-    /* Get audio from emulator */
-    nes_system_t* sys = (nes_system_t*)userdata;
-    float temp_samples[200];
-    int count = nes_sys_get_audio(sys, temp_samples, samples);
-
-    /* Convert float to 16-bit signed */
-    int16_t* out = (int16_t*)stream;
-    for (int i = 0; i < samples; i++) {
-        if (i < count) {
-            int sample = (int)(temp_samples[i] * 16384.0f);
+        /* Convert float to 16-bit signed */
+        for (uint32_t i = 0; i < want; i++) {
+            int sample = plat->muted ? 0 : (int)(chunk[i] * 16384.0f);
             if (sample > 32767) sample = 32767;
             if (sample < -32768) sample = -32768;
-            *out++ = sample;
-            *out++ = sample;  /* Mono to stereo */
-        } else {
-            *out++ = 0;
-            *out++ = 0;
+            *out++ = (int16_t)sample;
+            *out++ = (int16_t)sample;  /* Mono to stereo */
         }
+        samples -= (int)want;
     }
 }
 
 int nes_platform_init_audio(nes_platform_t* plat) {
     SDL_AudioSpec desired, obtained;
 
+    nes_ring_t* ring = (nes_ring_t*)malloc(sizeof(nes_ring_t));
+    if (!ring || nes_ring_init(ring, NES_AUDIO_RING_SAMPLES) != 0) {
+        fprintf(stderr, "Failed to allocate audio ring\n");
+        free(ring);
+        plat->audio.initialized = 0;
+        return -1;
+    }
+    plat->audio.queue = ring;
+
     memset(&desired, 0, sizeof(desired));
-    desired.freq = 44100;
+    desired.freq = APU_SAMPLE_RATE;
     desired.format = AUDIO_S16SYS;
     desired.channels = 2;
-    desired.samples = 2048;
+    desired.samples = NES_AUDIO_BUFFER_SAMPLES;
     desired.callback = audio_callback;
     desired.userdata = plat;
 
@@ -257,6 +287,9 @@ int nes_platform_init_audio(nes_platform_t* plat) {
 
     if (device == 0) {
         fprintf(stderr, "Failed to open audio: %s\n", SDL_GetError());
+        nes_ring_free(ring);
+        free(ring);
+        plat->audio.queue = NULL;
         plat->audio.initialized = 0;
         return -1;
     }
@@ -265,6 +298,7 @@ int nes_platform_init_audio(nes_platform_t* plat) {
     plat->audio.sample_rate = obtained.freq;
     plat->audio.channels = obtained.channels;
     plat->audio.buffer_size = obtained.samples;
+    plat->audio.resample_pos = -1.0;
     plat->audio.initialized = 1;
 
     /* Start audio */
@@ -273,20 +307,20 @@ int nes_platform_init_audio(nes_platform_t* plat) {
     return 0;
 }
 
-int nes_platform_process_events(nes_platform_t* plat, nes_system_t* sys) {
+int nes_platform_process_events(nes_platform_t* plat) {
     SDL_Event event;
 
     while (SDL_PollEvent(&event)) {
         switch (event.type) {
             case SDL_QUIT:
-                sys->running = 0;
+                nes_atomic_store_u32(&plat->quit, 1);
                 return 0;
 
             case SDL_KEYDOWN:
             case SDL_KEYUP:
                 if (!event.key.repeat) {
                     g_key_state[event.key.keysym.scancode] = (event.type == SDL_KEYDOWN);
-                    handle_key_event(event.key.keysym.sym, event.type == SDL_KEYDOWN, sys);
+                    handle_key_event(plat, event.key.keysym.sym, event.type == SDL_KEYDOWN);
                 }
                 break;
 
@@ -298,7 +332,35 @@ int nes_platform_process_events(nes_platform_t* plat, nes_system_t* sys) {
         }
     }
 
-    return sys->running;
+    return !nes_atomic_load_u32(&plat->quit);
+}
+
+int nes_platform_apply_input(nes_platform_t* plat, nes_system_t* sys) {
+    if (sys->input) {
+        nes_input_set_buttons(sys->input, 0, (uint8_t)nes_atomic_load_u32(&plat->buttons));
+    }
+
+    uint32_t commands = nes_atomic_exchange_u32(&plat->commands, 0);
+    if (commands) {
+        char filename[64];
+        unsigned slot = (unsigned)nes_atomic_load_u32(&plat->save_slot);
+        snprintf(filename, sizeof(filename), "save/state%02u.sav", slot);
+
+        if (commands & NES_PLATFORM_CMD_RESET) {
+            nes_sys_reset(sys);
+            printf("Reset\n");
+        }
+        if (commands & NES_PLATFORM_CMD_SAVE) {
+            nes_sys_save_state(sys, filename);
+            printf("Saved state to slot %u\n", slot);
+        }
+        if (commands & NES_PLATFORM_CMD_LOAD) {
+            nes_sys_load_state(sys, filename);
+            printf("Loaded state from slot %u\n", slot);
+        }
+    }
+
+    return !nes_atomic_load_u32(&plat->quit);
 }
 
 void nes_platform_present_frame(nes_platform_t* plat, const uint32_t* frame_buffer) {
@@ -319,11 +381,109 @@ void nes_platform_present_frame(nes_platform_t* plat, const uint32_t* frame_buff
     SDL_RenderPresent(renderer);
 }
 
+/* Frame sink: the PPU output is converted into the triple buffer's write
+ * slot, so the emulation thread never waits on the renderer or vsync */
+static void* platform_sink_acquire(void* ctx, size_t* pitch) {
+    nes_platform_t* plat = (nes_platform_t*)ctx;
+    *pitch = NES_WIDTH * 4;
+    return nes_triple_write_buffer((nes_triple_t*)plat->window.frames);
+}
+
+static void platform_sink_submit(void* ctx) {
+    nes_platform_t* plat = (nes_platform_t*)ctx;
+    nes_triple_publish((nes_triple_t*)plat->window.frames);
+}
+
+void nes_platform_set_frame_sink(nes_platform_t* plat, nes_system_t* sys) {
+    nes_frame_sink_t sink;
+    sink.context = plat;
+    sink.format = NES_PIXEL_RGBA8888;   /* Matches SDL_PIXELFORMAT_ABGR8888 */
+    sink.acquire = platform_sink_acquire;
+    sink.submit = platform_sink_submit;
+    nes_sys_set_frame_sink(sys, &sink);
+}
+
+int nes_platform_present_latest(nes_platform_t* plat) {
+    const uint32_t* frame = (const uint32_t*)nes_triple_read((nes_triple_t*)plat->window.frames);
+    if (!frame) {
+        return 0;
+    }
+    nes_platform_present_frame(plat, frame);
+    return 1;
+}
+
 void nes_platform_submit_audio(nes_platform_t* plat, const float* samples, int count) {
-    /* Handled via callback */
-    (void)plat;
-    (void)samples;
-    (void)count;
+    nes_audio_t* audio = &plat->audio;
+    if (!audio->initialized || count <= 0) {
+        return;
+    }
+    nes_ring_t* ring = (nes_ring_t*)audio->queue;
+
+    /* Below the target fill stretch the audio a little, above it squeeze it,
+     * so the callback neither underruns nor lets latency build up */
+    double fill = (double)nes_ring_available(ring);
+    double delta = NES_AUDIO_MAX_RATE_DELTA * (NES_AUDIO_TARGET_FILL - fill) / NES_AUDIO_TARGET_FILL;
+    if (delta > NES_AUDIO_MAX_RATE_DELTA) delta = NES_AUDIO_MAX_RATE_DELTA;
+    if (delta < -NES_AUDIO_MAX_RATE_DELTA) delta = -NES_AUDIO_MAX_RATE_DELTA;
+    double step = (double)APU_SAMPLE_RATE / (double)audio->sample_rate / (1.0 + delta);
+
+    /* Linear interpolation; position -1 is the previous call's last sample */
+    float chunk[NES_AUDIO_BUFFER_SAMPLES];
+    uint32_t n = 0;
+    double pos = audio->resample_pos;
+    while (pos < (double)(count - 1)) {
+        int i = (int)(pos + 1.0) - 1;   /* floor for pos >= -1 */
+        float frac = (float)(pos - (double)i);
+        float a = i < 0 ? audio->resample_prev : samples[i];
+        chunk[n++] = a + (samples[i + 1] - a) * frac;
+        if (n == NES_AUDIO_BUFFER_SAMPLES) {
+            nes_ring_write(ring, chunk, n);   /* Full ring drops the excess */
+            n = 0;
+        }
+        pos += step;
+    }
+    nes_ring_write(ring, chunk, n);
+
+    audio->resample_pos = pos - (double)count;
+    audio->resample_prev = samples[count - 1];
+}
+
+int nes_platform_wait_audio(nes_platform_t* plat) {
+    if (!plat->audio.initialized) {
+        return -1;
+    }
+
+    /* Sleep for about as long as the callback takes to play the excess */
+    nes_ring_t* ring = (nes_ring_t*)plat->audio.queue;
+    uint64_t start = nes_platform_get_time_us();
+    uint32_t fill;
+    while ((fill = nes_ring_available(ring)) > NES_AUDIO_TARGET_FILL) {
+        if (nes_platform_get_time_us() - start > NES_AUDIO_MAX_WAIT_US) {
+            break;
+        }
+        uint64_t wait_us = (uint64_t)(fill - NES_AUDIO_TARGET_FILL) * 1000000 / (uint64_t)plat->audio.sample_rate;
+        SDL_Delay(wait_us > 1000 ? (Uint32)(wait_us / 1000) : 1);
+    }
+    return 0;
+}
+
+void nes_platform_wait_frame(nes_platform_t* plat) {
+    uint64_t deadline = plat->last_time + plat->frame_time;
+    uint64_t now = nes_platform_get_time_us();
+
+    /* Too far behind (a stall, a debugger): start over instead of racing */
+    if (now > deadline + plat->frame_time * NES_FRAME_MAX_LAG_FRAMES) {
+        plat->last_time = now;
+        return;
+    }
+
+    /* Coarse sleep, then yield through the last stretch SDL_Delay can overshoot */
+    while (now < deadline) {
+        uint64_t left = deadline - now;
+        SDL_Delay(left > NES_FRAME_SPIN_US ? (Uint32)((left - NES_FRAME_SPIN_US) / 1000) : 0);
+        now = nes_platform_get_time_us();
+    }
+    plat->last_time = deadline;
 }
 
 uint64_t nes_platform_get_time_us(void) {
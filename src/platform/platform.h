@@ -27,6 +27,7 @@ typedef struct nes_window {
     void*       handle;       /* SDL_Window* */
     void*       renderer;     /* SDL_Renderer* */
     void*       texture;      /* SDL_Texture* */
+    void*       frames;       /* nes_triple_t* - emulation thread -> presenter */
     int         width;
     int         height;
     int         scale;
@@ -34,13 +35,31 @@ typedef struct nes_window {
 } nes_window_t;
 
 /* Audio */
+#define NES_AUDIO_BUFFER_SAMPLES   512     /* Device callback size */
+#define NES_AUDIO_RING_SAMPLES     8192    /* Emulation -> callback ring */
+#define NES_AUDIO_TARGET_FILL      (NES_AUDIO_BUFFER_SAMPLES * 2)
+#define NES_AUDIO_MAX_RATE_DELTA   0.005   /* Max resampling adjustment (+-0.5%) */
+#define NES_AUDIO_MAX_WAIT_US      50000   /* Give up pacing on a stalled device */
+
+/* Clock pacing without audio */
+#define NES_FRAME_MAX_LAG_FRAMES   4       /* Further behind: drop the backlog */
+#define NES_FRAME_SPIN_US          2000    /* Sleep until this close to the deadline */
+
 typedef struct nes_audio {
     void*       device;       /* SDL_AudioDeviceID */
-    void*       queue;        /* Audio queue */
+    void*       queue;        /* nes_ring_t* filled by the emulation thread */
     int         sample_rate;
     int         channels;
     int         buffer_size;
     int         initialized;
+
+    /* Rate control (emulation thread) */
+    double      resample_pos;     /* Input position relative to resample_prev */
+    float       resample_prev;
+
+    /* Callback (audio thread) */
+    float       last_sample;      /* Held on underrun */
+    uint32_t    underruns;
 } nes_audio_t;
 
 /* Platform State */
@@ -54,7 +73,13 @@ typedef struct nes_platform {
 
     /* Frame timing */
     uint64_t        frame_time;
-    uint64_t        last_time;
+    uint64_t        last_time;        /* Deadline of the last paced frame */
+
+    /* Main thread -> emulation thread */
+    volatile uint32_t buttons;        /* Controller 1, nes_input_set_buttons order */
+    volatile uint32_t commands;       /* NES_PLATFORM_CMD_* bits not yet run */
+    volatile uint32_t save_slot;
+    volatile uint32_t quit;           /* Set by either thread */
 
     /* State flags */
     int             running;
@@ -63,6 +88,11 @@ typedef struct nes_platform {
     int             fps;
 } nes_platform_t;
 
+/* Hotkey actions run by nes_platform_apply_input */
+#define NES_PLATFORM_CMD_RESET     0x01
+#define NES_PLATFORM_CMD_SAVE      0x02
+#define NES_PLATFORM_CMD_LOAD      0x04
+
 /* Display scales */
 #define NES_SCALE_SMALL    2
 #define NES_SCALE_MEDIUM   3
@@ -91,10 +121,17 @@ int nes_platform_create_window(nes_platform_t* plat, const char* title);
 int nes_platform_init_audio(nes_platform_t* plat);
 
 /**
- * Process events
+ * Process events (main thread)
+ * Key presses are queued for nes_platform_apply_input
  * Returns 0 to exit, 1 otherwise
  */
-int nes_platform_process_events(nes_platform_t* plat, nes_system_t* sys);
+int nes_platform_process_events(nes_platform_t* plat);
+
+/**
+ * Apply queued input and run queued hotkeys on sys (emulation thread)
+ * Returns 0 once an exit was requested, 1 otherwise
+ */
+int nes_platform_apply_input(nes_platform_t* plat, nes_system_t* sys);
 
 /**
  * Present frame buffer to screen
@@ -102,10 +139,37 @@ int nes_platform_process_events(nes_platform_t* plat, nes_system_t* sys);
 void nes_platform_present_frame(nes_platform_t* plat, const uint32_t* frame_buffer);
 
 /**
- * Submit audio samples
+ * Register a frame sink on sys that converts each frame into the write slot
+ * of the frame triple buffer (emulation thread)
+ */
+void nes_platform_set_frame_sink(nes_platform_t* plat, nes_system_t* sys);
+
+/**
+ * Present the newest frame from the triple buffer (main thread)
+ * Returns 1 if a new frame was presented, 0 if none was finished since the last call
+ */
+int nes_platform_present_latest(nes_platform_t* plat);
+
+/**
+ * Submit audio samples from the emulation thread
+ * Resamples slightly faster or slower to steer the queue toward its target fill
  */
 void nes_platform_submit_audio(nes_platform_t* plat, const float* samples, int count);
 
+/**
+ * Block until the audio queue has drained to its target fill
+ * Paces emulation off the audio clock
+ * Returns 0 if paced, -1 if audio is not running (pace some other way)
+ */
+int nes_platform_wait_audio(nes_platform_t* plat);
+
+/**
+ * Block until the next frame deadline on the high-resolution clock
+ * Deadlines advance by frame_time from each other, not from when the wait
+ * returned, so oversleeping one frame shortens the next
+ */
+void nes_platform_wait_frame(nes_platform_t* plat);
+
 /**
  * Get current high-precision time in microseconds
  */
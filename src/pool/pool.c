@@ -0,0 +1,306 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Pool Module - Work-Stealing Instance Pool Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "pool.h"
+#include "../memory/bus.h"
+#include "../util/thread.h"
+#include "../util/timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define POOL_CACHE_LINE 64
+
+/* Per-worker queue: the remaining slice [begin, end) of the current batch */
+typedef struct {
+    nes_mutex_t      lock;
+    size_t           begin;
+    size_t           end;
+    nes_pool_stats_t stats;      /* Written only by the owning worker */
+    char             pad[POOL_CACHE_LINE];  /* Keep neighbours off this cache line */
+} pool_worker_t;
+
+/* Thread start argument */
+typedef struct {
+    nes_pool_t* pool;
+    int         index;
+} pool_thread_arg_t;
+
+struct nes_pool {
+    int                 num_workers;
+    pool_worker_t*      workers;
+    nes_thread_t*       threads;        /* num_workers - 1 background threads */
+    pool_thread_arg_t*  thread_args;
+
+    /* Batch dispatch */
+    nes_mutex_t         lock;
+    nes_cond_t          wake;
+    nes_cond_t          done;
+    uint64_t            generation;     /* Bumped for every batch */
+    int                 active;         /* Background workers still in the batch */
+    int                 shutdown;
+
+    /* Current batch */
+    nes_pool_task_fn    fn;
+    void*               ctx;
+    uint32_t            frames_per_task;
+};
+
+/* Pop the next item from our own slice */
+static int pool_take_own(pool_worker_t* w, size_t* index) {
+    int found = 0;
+    nes_mutex_lock(&w->lock);
+    if (w->begin < w->end) {
+        *index = w->begin++;
+        found = 1;
+    }
+    nes_mutex_unlock(&w->lock);
+    return found;
+}
+
+/* Steal the upper half of another worker's slice into our own
+ * Only one worker lock is held at a time, so thieves cannot deadlock */
+static int pool_steal(nes_pool_t* pool, int self, size_t* index) {
+    for (int i = 1; i < pool->num_workers; i++) {
+        pool_worker_t* victim = &pool->workers[(self + i) % pool->num_workers];
+        size_t begin = 0, end = 0;
+
+        nes_mutex_lock(&victim->lock);
+        size_t remaining = victim->end - victim->begin;
+        if (remaining > 0) {
+            end = victim->end;
+            begin = end - (remaining + 1) / 2;
+            victim->end = begin;
+        }
+        nes_mutex_unlock(&victim->lock);
+
+        if (begin < end) {
+            pool_worker_t* w = &pool->workers[self];
+            nes_mutex_lock(&w->lock);
+            w->begin = begin + 1;
+            w->end = end;
+            nes_mutex_unlock(&w->lock);
+            w->stats.steals++;
+            *index = begin;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Drain own slice, then steal until every slice is empty */
+static void pool_work(nes_pool_t* pool, int self) {
+    pool_worker_t* w = &pool->workers[self];
+    uint64_t start = nes_timer_now_ns();
+    size_t index;
+
+    while (pool_take_own(w, &index) || pool_steal(pool, self, &index)) {
+        pool->fn(pool->ctx, index, self);
+        w->stats.tasks++;
+        w->stats.frames += pool->frames_per_task;
+    }
+
+    w->stats.busy_ns += nes_timer_now_ns() - start;
+}
+
+static void pool_thread_main(void* arg) {
+    pool_thread_arg_t* targ = (pool_thread_arg_t*)arg;
+    nes_pool_t* pool = targ->pool;
+    uint64_t seen = 0;
+
+    for (;;) {
+        nes_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->shutdown) {
+            nes_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) {
+            nes_mutex_unlock(&pool->lock);
+            return;
+        }
+        seen = pool->generation;
+        nes_mutex_unlock(&pool->lock);
+
+        pool_work(pool, targ->index);
+
+        nes_mutex_lock(&pool->lock);
+        if (--pool->active == 0) {
+            nes_cond_signal(&pool->done);
+        }
+        nes_mutex_unlock(&pool->lock);
+    }
+}
+
+nes_pool_t* nes_pool_create(int num_workers) {
+    if (num_workers <= 0) {
+        num_workers = nes_thread_cpu_count();
+    }
+
+    nes_pool_t* pool = (nes_pool_t*)calloc(1, sizeof(nes_pool_t));
+    if (!pool) {
+        return NULL;
+    }
+    pool->num_workers = num_workers;
+    pool->workers = (pool_worker_t*)calloc((size_t)num_workers, sizeof(pool_worker_t));
+    pool->threads = (nes_thread_t*)calloc((size_t)num_workers, sizeof(nes_thread_t));
+    pool->thread_args = (pool_thread_arg_t*)calloc((size_t)num_workers, sizeof(pool_thread_arg_t));
+    if (!pool->workers || !pool->threads || !pool->thread_args) {
+        free(pool->workers);
+        free(pool->threads);
+        free(pool->thread_args);
+        free(pool);
+        return NULL;
+    }
+
+    nes_mutex_init(&pool->lock);
+    nes_cond_init(&pool->wake);
+    nes_cond_init(&pool->done);
+
+    /* Worker 0 is the calling thread */
+    nes_mutex_init(&pool->workers[0].lock);
+    for (int i = 1; i < num_workers; i++) {
+        nes_mutex_init(&pool->workers[i].lock);
+        pool->thread_args[i].pool = pool;
+        pool->thread_args[i].index = i;
+        if (nes_thread_create(&pool->threads[i], pool_thread_main, &pool->thread_args[i]) != 0) {
+            /* Run with the threads we managed to start */
+            nes_mutex_destroy(&pool->workers[i].lock);
+            pool->num_workers = i;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+void nes_pool_destroy(nes_pool_t* pool) {
+    if (!pool) {
+        return;
+    }
+
+    nes_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    nes_cond_broadcast(&pool->wake);
+    nes_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->num_workers; i++) {
+        nes_thread_join(&pool->threads[i]);
+    }
+
+    for (int i = 0; i < pool->num_workers; i++) {
+        nes_mutex_destroy(&pool->workers[i].lock);
+    }
+    nes_mutex_destroy(&pool->lock);
+    nes_cond_destroy(&pool->wake);
+    nes_cond_destroy(&pool->done);
+
+    free(pool->workers);
+    free(pool->threads);
+    free(pool->thread_args);
+    free(pool);
+}
+
+int nes_pool_num_workers(const nes_pool_t* pool) {
+    return pool->num_workers;
+}
+
+static void pool_dispatch(nes_pool_t* pool, size_t count, nes_pool_task_fn fn,
+                          void* ctx, uint32_t frames_per_task) {
+    if (count == 0) {
+        return;
+    }
+
+    /* Workers are idle here - hand out contiguous slices */
+    int n = pool->num_workers;
+    for (int i = 0; i < n; i++) {
+        pool->workers[i].begin = count * (size_t)i / (size_t)n;
+        pool->workers[i].end = count * (size_t)(i + 1) / (size_t)n;
+    }
+
+    nes_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->frames_per_task = frames_per_task;
+    pool->active = n - 1;
+    pool->generation++;
+    nes_cond_broadcast(&pool->wake);
+    nes_mutex_unlock(&pool->lock);
+
+    pool_work(pool, 0);
+
+    nes_mutex_lock(&pool->lock);
+    while (pool->active > 0) {
+        nes_cond_wait(&pool->done, &pool->lock);
+    }
+    nes_mutex_unlock(&pool->lock);
+}
+
+void nes_pool_run(nes_pool_t* pool, size_t count, nes_pool_task_fn fn, void* ctx) {
+    pool_dispatch(pool, count, fn, ctx, 0);
+}
+
+/* Frame stepping batch */
+typedef struct {
+    nes_system_t*   systems;
+    int             frames;
+} pool_step_ctx_t;
+
+static void pool_step_task(void* ctx, size_t index, int worker) {
+    pool_step_ctx_t* step = (pool_step_ctx_t*)ctx;
+    (void)worker;
+    for (int f = 0; f < step->frames; f++) {
+        nes_sys_step_frame(&step->systems[index]);
+    }
+}
+
+int nes_pool_step_frames(nes_pool_t* pool, nes_system_t* systems, size_t count, int frames) {
+    if (!pool || (!systems && count > 0) || frames < 0) {
+        return -1;
+    }
+
+    pool_step_ctx_t step = { systems, frames };
+    pool_dispatch(pool, count, pool_step_task, &step, (uint32_t)frames);
+    return 0;
+}
+
+/* Batched stepping with inputs and strided observations */
+typedef struct {
+    nes_system_t*   systems;
+    const uint8_t*  inputs;
+    uint8_t*        obs_out;
+} pool_batch_ctx_t;
+
+static void pool_batch_task(void* ctx, size_t index, int worker) {
+    pool_batch_ctx_t* batch = (pool_batch_ctx_t*)ctx;
+    (void)worker;
+    nes_sys_step_frames_batch(&batch->systems[index], 1,
+                              batch->inputs ? &batch->inputs[index] : NULL,
+                              batch->obs_out ? batch->obs_out + index * NES_FRAME_PIXELS : NULL);
+}
+
+int nes_pool_step_frames_batch(nes_pool_t* pool, nes_system_t* systems, size_t count,
+                               const uint8_t* inputs, uint8_t* obs_out) {
+    if (!pool || (!systems && count > 0)) {
+        return -1;
+    }
+
+    pool_batch_ctx_t batch = { systems, inputs, obs_out };
+    pool_dispatch(pool, count, pool_batch_task, &batch, 1);
+    return 0;
+}
+
+int nes_pool_get_stats(const nes_pool_t* pool, int worker, nes_pool_stats_t* stats) {
+    if (worker < 0 || worker >= pool->num_workers) {
+        return -1;
+    }
+    *stats = pool->workers[worker].stats;
+    return 0;
+}
+
+void nes_pool_reset_stats(nes_pool_t* pool) {
+    for (int i = 0; i < pool->num_workers; i++) {
+        memset(&pool->workers[i].stats, 0, sizeof(nes_pool_stats_t));
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Pool Module - Work-Stealing Instance Pool
+ *
+ * Steps many independent nes_system_t instances in parallel on a fixed
+ * set of worker threads. Each worker starts with a contiguous slice of
+ * the instances and steals half of a busy worker's remaining slice when
+ * it runs dry, so per-ROM cost differences do not leave cores idle.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_POOL_H
+#define NESPRESSO_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Forward declarations */
+typedef struct nes_system nes_system_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct nes_pool nes_pool_t;
+
+/* Task callback - runs item index on the given worker */
+typedef void (*nes_pool_task_fn)(void* ctx, size_t index, int worker);
+
+/* Per-worker throughput counters (accumulate until reset) */
+typedef struct {
+    uint64_t frames;     /* Emulated frames completed */
+    uint64_t tasks;      /* Items executed */
+    uint64_t steals;     /* Successful steals from other workers */
+    uint64_t busy_ns;    /* Wall time spent inside batches */
+} nes_pool_stats_t;
+
+/**
+ * Create pool with num_workers workers (0 = one per CPU)
+ * The calling thread acts as worker 0, so num_workers - 1 threads are started.
+ * Returns NULL on failure
+ */
+nes_pool_t* nes_pool_create(int num_workers);
+
+/**
+ * Stop worker threads and free the pool
+ */
+void nes_pool_destroy(nes_pool_t* pool);
+
+/**
+ * Number of workers including the calling thread
+ */
+int nes_pool_num_workers(const nes_pool_t* pool);
+
+/**
+ * Run fn(ctx, i, worker) for every i in [0, count) and wait for completion
+ */
+void nes_pool_run(nes_pool_t* pool, size_t count, nes_pool_task_fn fn, void* ctx);
+
+/**
+ * Step each of count systems by frames frames via nes_sys_step_frame
+ * Returns 0 on success, -1 on invalid arguments
+ */
+int nes_pool_step_frames(nes_pool_t* pool, nes_system_t* systems, size_t count, int frames);
+
+/**
+ * Parallel nes_sys_step_frames_batch: one frame per system, same input/observation layout
+ * Returns 0 on success, -1 on invalid arguments
+ */
+int nes_pool_step_frames_batch(nes_pool_t* pool, nes_system_t* systems, size_t count,
+                               const uint8_t* inputs, uint8_t* obs_out);
+
+/**
+ * Copy counters of one worker
+ * Returns 0 on success, -1 if worker is out of range
+ */
+int nes_pool_get_stats(const nes_pool_t* pool, int worker, nes_pool_stats_t* stats);
+
+/**
+ * Clear all worker counters
+ */
+void nes_pool_reset_stats(nes_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_POOL_H */
@@ -29,13 +29,6 @@ static const uint8_t g_nes_palette[64][3] = {
     {0xB5,0xEB,0xF2}, {0xB8,0xB8,0xB8}, {0x00,0x00,0x00}, {0x00,0x00,0x00},
 };
 
-/* Static PPU bus - static storage that persists beyond function calls */
-static ppu_bus_t g_ppu_bus_static = {NULL, NULL, NULL, NULL};
-static ppu_bus_t* g_ppu_bus = &g_ppu_bus_static;
-
-/* Frame buffer for rendering */
-static uint8_t g_frame_buffer[PPU_WIDTH * PPU_HEIGHT];
-
 /* Mirroring modes */
 typedef enum {
     MIRROR_HORIZONTAL,    /* Horizontal: [0][1] [2][3] */
@@ -45,17 +38,41 @@ typedef enum {
     MIRROR_FOUR_SCREEN    /* Four screen */
 } mirror_mode_t;
 
-static mirror_mode_t g_mirror_mode = MIRROR_HORIZONTAL;
+/* The per-dot fields share the first cache line (see nes_ppu_t) */
+_Static_assert(offsetof(nes_ppu_t, palette) <= 64, "nes_ppu_t per-dot state outgrew one cache line");
+
+/* Tile row decoding
+ * g_tile_bits[0][b][i] is bit 7 - i of pattern byte b (pixel i, left to right),
+ * g_tile_bits[1][b][i] is bit i (the row mirrored) */
+#define TILE_BIT(m, b, i)  (((b) >> ((m) ? (i) : 7 - (i))) & 1)
+#define TILE_ROW(m, b)     { TILE_BIT(m, b, 0), TILE_BIT(m, b, 1), TILE_BIT(m, b, 2), TILE_BIT(m, b, 3), \
+                             TILE_BIT(m, b, 4), TILE_BIT(m, b, 5), TILE_BIT(m, b, 6), TILE_BIT(m, b, 7) }
+#define TILE_ROW4(m, b)    TILE_ROW(m, b), TILE_ROW(m, (b) + 1), TILE_ROW(m, (b) + 2), TILE_ROW(m, (b) + 3)
+#define TILE_ROW16(m, b)   TILE_ROW4(m, b), TILE_ROW4(m, (b) + 4), TILE_ROW4(m, (b) + 8), TILE_ROW4(m, (b) + 12)
+#define TILE_ROW64(m, b)   TILE_ROW16(m, b), TILE_ROW16(m, (b) + 16), TILE_ROW16(m, (b) + 32), TILE_ROW16(m, (b) + 48)
+#define TILE_ROW256(m)     { TILE_ROW64(m, 0), TILE_ROW64(m, 64), TILE_ROW64(m, 128), TILE_ROW64(m, 192) }
+
+static const uint8_t g_tile_bits[2][256][8] = { TILE_ROW256(0), TILE_ROW256(1) };
+
+/* Decode a pattern lo/hi byte pair into 8 pixels (0-3) at once
+ * Every byte of a plane row is 0 or 1, so the planes merge without carries */
+static inline void decode_tile_row(uint8_t lo, uint8_t hi, int mirror, uint8_t out[8]) {
+    uint64_t row_lo, row_hi;
+    memcpy(&row_lo, g_tile_bits[mirror][lo], 8);
+    memcpy(&row_hi, g_tile_bits[mirror][hi], 8);
+    row_lo |= row_hi << 1;
+    memcpy(out, &row_lo, 8);
+}
 
 /* Internal helper functions */
 
-static uint16_t read_name_table_addr(uint16_t addr) {
+static uint16_t read_name_table_addr(uint8_t mirror_mode, uint16_t addr) {
     uint16_t base = addr & 0x03FF;  /* Offset within nametable */
     switch (addr & 0x0C00) {
         case 0x0000:  /* NT 0 */
             break;
         case 0x0400:  /* NT 1 */
-            switch (g_mirror_mode) {
+            switch (mirror_mode) {
                 case MIRROR_HORIZONTAL: base |= 0x0400; break;    /* [0][1] */
                 case MIRROR_VERTICAL:   base &= ~0x0400; break;   /* [0][0] */
                 case MIRROR_SINGLE_0:   base &= ~0x0400; break;
@@ -64,7 +81,7 @@ static uint16_t read_name_table_addr(uint16_t addr) {
             }
             break;
         case 0x0800:  /* NT 2 */
-            switch (g_mirror_mode) {
+            switch (mirror_mode) {
                 case MIRROR_HORIZONTAL: base &= ~0x0400; break;   /* Same as NT 1 */
                 case MIRROR_VERTICAL:   base |= 0x0400; break;    /* [2][3] */
                 case MIRROR_SINGLE_0:   base &= ~0x0400; break;
@@ -73,7 +90,7 @@ static uint16_t read_name_table_addr(uint16_t addr) {
             }
             break;
         case 0x0C00:  /* NT 3 */
-            switch (g_mirror_mode) {
+            switch (mirror_mode) {
                 case MIRROR_HORIZONTAL: base |= 0x0400; break;    /* Same as NT 1 */
                 case MIRROR_VERTICAL:   base |= 0x0400; break;    /* Same as NT 2 */
                 case MIRROR_SINGLE_0:   base &= ~0x0400; break;
@@ -97,14 +114,18 @@ static uint8_t ppu_read_vram(nes_ppu_t* ppu, uint16_t addr) {
     addr &= 0x3FFF;
 
     if (addr < 0x2000) {
-        /* Pattern tables - access via CHR bus */
-        if (g_ppu_bus && g_ppu_bus->read_chr) {
-            return g_ppu_bus->read_chr(g_ppu_bus->context, addr);
+        /* Pattern tables - mapped 1KB CHR page, else the CHR bus */
+        const uint8_t* page = ppu->bus.chr_map ? ppu->bus.chr_map[addr >> 10] : NULL;
+        if (page) {
+            return page[addr & 0x3FF];
+        }
+        if (ppu->bus.read_chr) {
+            return ppu->bus.read_chr(ppu->bus.context, addr);
         }
         return 0;
     } else if (addr < 0x3F00) {
         /* Nametables and attribute tables - read from ppu->vram */
-        uint16_t mirrored = read_name_table_addr(addr);
+        uint16_t mirrored = read_name_table_addr(ppu->mirror_mode, addr);
         return ppu->vram[(mirrored - 0x2000) & 0xFFF];
     } else {
         /* Palettes */
@@ -117,12 +138,12 @@ static void ppu_write_vram(nes_ppu_t* ppu, uint16_t addr, uint8_t val) {
 
     if (addr < 0x2000) {
         /* Pattern tables - usually CHR-ROM (read-only) */
-        if (g_ppu_bus && g_ppu_bus->write_chr) {
-            g_ppu_bus->write_chr(g_ppu_bus->context, addr, val);
+        if (ppu->bus.write_chr) {
+            ppu->bus.write_chr(ppu->bus.context, addr, val);
         }
     } else if (addr < 0x3F00) {
         /* Nametables */
-        uint16_t mirrored = read_name_table_addr(addr);
+        uint16_t mirrored = read_name_table_addr(ppu->mirror_mode, addr);
         ppu->vram[(mirrored - 0x2000) & 0xFFF] = val;
     } else {
         /* Palettes */
@@ -238,6 +259,44 @@ static void fetch_tile_data(nes_ppu_t* ppu, uint16_t *addr_lo, uint16_t *addr_hi
     *addr_hi = *addr_lo + 8;
 }
 
+/* Pre-decode the line's sprites into sprite_line
+ * Earlier sprites win: an opaque front sprite is final, an opaque behind
+ * sprite hides the background but lets later sprites draw over it */
+static void decode_sprite_line(nes_ppu_t* ppu) {
+    uint8_t* line_buf = ppu->sprite_line;
+    uint16_t pattern_table = (ppu->reg.ctrl & PPUCTRL_SP_ADDR) ? 0x1000 : 0x0000;
+
+    memset(line_buf, 0, PPU_WIDTH);
+
+    for (int i = 0; i < ppu->sprite_count; i++) {
+        const ppu_sprite_t* sprite = &ppu->sprites[i];
+        int line = (int)ppu->scanline - (int)sprite->y;
+
+        /* Column c shows plane bit c; horizontal flip reverses that */
+        uint16_t addr = pattern_table + ((uint16_t)sprite->tile << 4) + line;
+        uint8_t row[8];
+        decode_tile_row(ppu_read_vram(ppu, addr), ppu_read_vram(ppu, addr + 8),
+                        !(sprite->attr & SP_ATTR_FLIP_H), row);
+
+        uint8_t color = (sprite->attr & SP_ATTR_PAL_MASK) << 2;
+        uint8_t flags = (sprite->attr & SP_ATTR_PRIORITY) ? SPRITE_LINE_BEHIND : SPRITE_LINE_FRONT;
+        if (i == 0) {
+            flags |= SPRITE_LINE_ZERO;
+        }
+
+        for (int c = 0; c < 8 && sprite->x + c < PPU_WIDTH; c++) {
+            uint8_t* out = &line_buf[sprite->x + c];
+            if (*out & SPRITE_LINE_FRONT) {
+                continue;
+            }
+            *out &= SPRITE_LINE_BEHIND | SPRITE_LINE_ZERO;
+            if (row[c]) {
+                *out |= row[c] | color | flags;
+            }
+        }
+    }
+}
+
 /* Evaluate sprites for current scanline */
 static void evaluate_sprites(nes_ppu_t* ppu) {
     int sprite_height = (ppu->reg.ctrl & PPUCTRL_SP_SIZE) ? 16 : 8;
@@ -255,135 +314,175 @@ static void evaluate_sprites(nes_ppu_t* ppu) {
             ppu->sprites[ppu->sprite_count++] = sprite;
         }
     }
+
+    if (ppu->scanline >= PPU_VISIBLE_SCANLINES) {
+        return;
+    }
+
+    /* A suppressed line only needs its sprites for a sprite 0 hit still to come */
+    ppu->sprite_zero_probe = !ppu->render_frame && ppu->sprite_count > 0 &&
+                             !(ppu->reg.status & PPUSTATUS_SP0_HIT);
+    if (ppu->render_frame || ppu->sprite_zero_probe) {
+        decode_sprite_line(ppu);
+    }
 }
 
-/* Check for sprite zero hit */
-static int check_sprite_zero_hit(nes_ppu_t* ppu, int x) {
-    if (ppu->sprite_count == 0) return 0;
-    ppu_sprite_t* sprite = &ppu->sprites[0];
+/* Fetch the next background tile's pattern bytes */
+static inline void fetch_background_tile(nes_ppu_t* ppu) {
+    uint16_t addr_lo, addr_hi;
+    fetch_tile_data(ppu, &addr_lo, &addr_hi);
+    ppu->background_fetch_tile = ppu_read_vram(ppu, addr_lo) |
+                                (ppu_read_vram(ppu, addr_hi) << 8);
+}
 
-    int sprite_height = (ppu->reg.ctrl & PPUCTRL_SP_SIZE) ? 16 : 8;
-    int line = (int)ppu->scanline - (int)sprite->y;
+/* Advance background shifters by one dot */
+static inline void shift_background(nes_ppu_t* ppu) {
+    ppu->background_shift_lo <<= 1;
+    ppu->background_shift_hi <<= 1;
+    ppu->attribute_shift_lo <<= 1;
+    ppu->attribute_shift_hi <<= 1;
+}
+
+/* Background palette of the tile under v, applied at dots x % 4 == 0 */
+static inline uint8_t background_palette(nes_ppu_t* ppu) {
+    uint16_t attr_addr = 0x23C0 | (ppu->reg.scroll.v & 0x0C00) |
+                       ((ppu->reg.scroll.v >> 4) & 0x38) |
+                       ((ppu->reg.scroll.v >> 2) & 0x07);
+    uint8_t attr = ppu_read_vram(ppu, attr_addr);
 
-    if (line >= 0 && line < sprite_height && x >= sprite->x && x < sprite->x + 8) {
-        if (!(ppu->reg.mask & PPUMASK_SHOW_SPR8) && x < 8) return 0;
-        if (!(ppu->reg.mask & PPUMASK_SHOW_BGR8) && x < 8) return 0;
-        return 1;
+    if ((ppu->scanline / 2) & 1) attr >>= 2;
+    return (attr & 0x03) << 2;
+}
+
+/* Merge a background pixel with the sprite line entry (0 when sprites are hidden) */
+static inline uint8_t compose_pixel(nes_ppu_t* ppu, uint8_t bg, uint8_t sprite) {
+    if ((sprite & SPRITE_LINE_ZERO) && bg) {
+        ppu->reg.status |= PPUSTATUS_SP0_HIT;
+    }
+    if (sprite & SPRITE_LINE_BEHIND) {
+        bg = 0;
     }
+
+    sprite &= SPRITE_LINE_PIXEL;
+    if (sprite) return sprite | 0x10;
+    if (bg) return bg | 0x20;
     return 0;
 }
 
-/* Get sprite pixel */
-static uint8_t get_sprite_pixel(nes_ppu_t* ppu, int x) {
-    for (int i = 0; i < ppu->sprite_count; i++) {
-        ppu_sprite_t* sprite = &ppu->sprites[i];
-        int sprite_height = (ppu->reg.ctrl & PPUCTRL_SP_SIZE) ? 16 : 8;
-
-        if (x >= sprite->x && x < sprite->x + 8) {
-            int line = (int)ppu->scanline - (int)sprite->y;
-            if (line >= 0 && line < sprite_height) {
-                if (sprite->attr & SP_ATTR_FLIP_V) {
-                    line = sprite_height - 1 - line;
-                }
-
-                uint16_t pattern_table;
-                uint8_t tile = sprite->tile;
-                if (sprite_height == 16) {
-                    if (line >= 8) {
-                        line -= 8;
-                        tile |= 0x01;
-                    } else {
-                        tile &= ~0x01;
-                    }
-                    pattern_table = (tile & 0x01) ? 0x1000 : 0x0000;
-                    tile &= 0xFE;
-                } else {
-                    pattern_table = (ppu->reg.ctrl & PPUCTRL_SP_ADDR) ? 0x1000 : 0x0000;
-                }
+/* Sprite line entry for dot x, honouring PPUMASK */
+static inline uint8_t sprite_at(nes_ppu_t* ppu, int x) {
+    if (ppu->reg.mask & PPUMASK_SHOW_SPR &&
+        (!(ppu->reg.mask & PPUMASK_SHOW_SPR8) || x >= 8)) {
+        return ppu->sprite_line[x];
+    }
+    return 0;
+}
 
-                int column = x - sprite->x;
-                if (sprite->attr & SP_ATTR_FLIP_H) {
-                    column = 7 - column;
-                }
+/* Compose background and sprite pixel for one visible dot */
+static inline void render_dot(nes_ppu_t* ppu, int x) {
+    uint8_t pixel = 0;
+    if ((ppu->reg.mask & PPUMASK_SHOW_BGR8) || x >= 8) {
+        int column = (x + ppu->reg.scroll.x) & 7;
+        pixel = g_tile_bits[0][ppu->background_shift_lo][column] |
+                (g_tile_bits[0][ppu->background_shift_hi][column] << 1);
+        if (pixel && (x & 3) == 0) {
+            pixel |= background_palette(ppu);
+        }
+    }
 
-                uint16_t addr = pattern_table + ((uint16_t)tile << 4) + line;
-                uint8_t lo = ppu_read_vram(ppu, addr);
-                uint8_t hi = ppu_read_vram(ppu, addr + 8);
+    ppu->frame_buffer[ppu->scanline * PPU_WIDTH + x] = compose_pixel(ppu, pixel, sprite_at(ppu, x));
+}
 
-                int shift = 7 - column;
-                uint8_t pixel = ((lo >> shift) & 0x01) | (((hi >> shift) & 0x01) << 1);
+/* Sprite 0 hit test for one dot of a suppressed line - render_dot without output */
+static inline void probe_dot(nes_ppu_t* ppu, int x) {
+    if (!(sprite_at(ppu, x) & SPRITE_LINE_ZERO) || (!(ppu->reg.mask & PPUMASK_SHOW_BGR8) && x < 8)) {
+        return;
+    }
 
-                if (i == 0 && pixel != 0 && check_sprite_zero_hit(ppu, x)) {
-                    if ((ppu->reg.status & PPUSTATUS_VBLANK) == 0) {
-                        ppu->reg.status |= PPUSTATUS_SP0_HIT;
-                    }
-                }
+    int column = (x + ppu->reg.scroll.x) & 7;
+    if (g_tile_bits[0][ppu->background_shift_lo][column] | g_tile_bits[0][ppu->background_shift_hi][column]) {
+        ppu->reg.status |= PPUSTATUS_SP0_HIT;
+        ppu->sprite_zero_probe = 0;
+    }
+}
 
-                return pixel | ((sprite->attr & SP_ATTR_PAL_MASK) << 2);
+/* Render the 8 dots of the tile just loaded into the shifters
+ * Dot j reads shifter bit 7 - (x + fine x) % 8 after j shifts, i.e.
+ * pixel j + (j + fine x) % 8 of the loaded row */
+static inline void render_tile(nes_ppu_t* ppu, int x) {
+    uint8_t* line_buf = ppu->frame_buffer + ppu->scanline * PPU_WIDTH;
+    uint8_t row[8];
+    decode_tile_row(ppu->background_shift_lo, ppu->background_shift_hi, 0, row);
+
+    uint8_t palette = background_palette(ppu);
+    int show_bg8 = (ppu->reg.mask & PPUMASK_SHOW_BGR8) != 0;
+
+    for (int j = 0; j < 8; j++, x++) {
+        int column = j + ((j + ppu->reg.scroll.x) & 7);
+        uint8_t pixel = 0;
+        if (column < 8 && (show_bg8 || x >= 8)) {
+            pixel = row[column];
+            if (pixel && (j & 3) == 0) {
+                pixel |= palette;
             }
         }
+        line_buf[x] = compose_pixel(ppu, pixel, sprite_at(ppu, x));
     }
-    return 0;
 }
 
-/* Render a single scanline */
-static void render_scanline(nes_ppu_t* ppu) {
-    if (ppu->scanline < PPU_VISIBLE_SCANLINES) {
-        uint8_t* line_buf = g_frame_buffer + ppu->scanline * PPU_WIDTH;
-
-        for (int x = 0; x < PPU_WIDTH; x++) {
-            uint8_t bg_pixel = 0;
-            uint8_t bg_palette = 0;
+/* Sprite 0 hit test for the 8 dots of render_tile on a suppressed line */
+static inline void probe_tile(nes_ppu_t* ppu, int x) {
+    uint8_t row[8];
+    decode_tile_row(ppu->background_shift_lo, ppu->background_shift_hi, 0, row);
 
-            if (ppu->reg.mask & PPUMASK_SHOW_BGR) {
-                if (!(ppu->reg.mask & PPUMASK_SHOW_BGR8) && x < 8) {
-                    bg_pixel = 0;
-                } else {
-                    uint8_t shift = 15 - ppu->reg.scroll.x - (x % 8);
-                    if (shift >= 0) {
-                        bg_pixel = ((ppu->background_shift_lo >> shift) & 0x01) |
-                                   (((ppu->background_shift_hi >> shift) & 0x01) << 1);
-                    }
-                    if (bg_pixel) {
-                        bg_palette = ((ppu->attribute_shift_lo >> (15 - ppu->reg.scroll.x - (x % 8))) & 0x01) |
-                                    (((ppu->attribute_shift_hi >> (15 - ppu->reg.scroll.x - (x % 8))) & 0x01) << 1);
-                    }
-                }
-            }
+    int show_bg8 = (ppu->reg.mask & PPUMASK_SHOW_BGR8) != 0;
 
-            uint8_t sprite_pixel = 0;
-            if (ppu->reg.mask & PPUMASK_SHOW_SPR &&
-                (!(ppu->reg.mask & PPUMASK_SHOW_SPR8) || x >= 8)) {
-                sprite_pixel = get_sprite_pixel(ppu, x);
-            }
+    for (int j = 0; j < 8; j++, x++) {
+        int column = j + ((j + ppu->reg.scroll.x) & 7);
+        if (column < 8 && (show_bg8 || x >= 8) && row[column] &&
+            (sprite_at(ppu, x) & SPRITE_LINE_ZERO)) {
+            ppu->reg.status |= PPUSTATUS_SP0_HIT;
+            ppu->sprite_zero_probe = 0;
+            return;
+        }
+    }
+}
 
-            uint8_t pixel = 0;
-            if (bg_pixel == 0 && sprite_pixel == 0) {
-                pixel = 0;
-            } else if (bg_pixel == 0 && sprite_pixel != 0) {
-                pixel = sprite_pixel | 0x10;
-            } else if (bg_pixel != 0 && sprite_pixel == 0) {
-                pixel = bg_palette | 0x20;
-            } else {
-                /* Both non-zero - check priority */
-                if (sprite_pixel & SP_ATTR_PRIORITY) {
-                    pixel = bg_palette | 0x20;  /* Sprite behind background */
-                } else {
-                    pixel = sprite_pixel | 0x10;
-                }
-            }
+/* Dot at which the pattern fetches of a rendering line raise A12: sprites
+ * from $1000 after background from $0000 at dot 260, background prefetch
+ * from $1000 after sprites from $0000 at dot 324 (8x16 sprites count as
+ * $1000). 0 with rendering off or both tables in the same half, where the
+ * short lows between fetches never get past the mapper's filter */
+static inline int ppu_a12_dot(const nes_ppu_t* ppu) {
+    if (!(ppu->reg.mask & (PPUMASK_SHOW_BGR | PPUMASK_SHOW_SPR))) {
+        return 0;
+    }
+    int bg_high = (ppu->reg.ctrl & PPUCTRL_BG_ADDR) != 0;
+    int sp_high = (ppu->reg.ctrl & (PPUCTRL_SP_ADDR | PPUCTRL_SP_SIZE)) != 0;
+    if (bg_high == sp_high) {
+        return 0;
+    }
+    return sp_high ? 260 : 324;
+}
 
-            line_buf[x] = pixel;
+/* Tell the mapper at the A12 rise (rendering lines only) */
+static inline void ppu_watch_a12(nes_ppu_t* ppu) {
+    if (ppu->cycle >= 260 && ppu->bus.a12_rise) {
+        int dot = ppu_a12_dot(ppu);
+        if (dot && ppu->cycle == dot) {
+            ppu->bus.a12_rise(ppu->bus.context);
         }
     }
 }
 
+
 /* Public API Implementation */
 
 void nes_ppu_init(nes_ppu_t* ppu, ppu_bus_t* bus) {
     memset(ppu, 0, sizeof(nes_ppu_t));
-    (void)bus;  /* unused - bus is set later via nes_ppu_set_bus */
-    g_ppu_bus = &g_ppu_bus_static;
+    if (bus) {
+        ppu->bus = *bus;
+    }
 
     /* Initialize palette with default values */
     for (int i = 0; i < 32; i++) {
@@ -393,6 +492,8 @@ void nes_ppu_init(nes_ppu_t* ppu, ppu_bus_t* bus) {
     ppu->reg.status = PPUSTATUS_VBLANK;
     ppu->scanline = 261;
     ppu->cycle = 0;
+    ppu->render_enabled = 1;
+    ppu->render_frame = 1;
 }
 
 void nes_ppu_reset(nes_ppu_t* ppu) {
@@ -431,10 +532,7 @@ int nes_ppu_step(nes_ppu_t* ppu) {
 
             if (cycle_mod == 0) {
                 /* Fetch tile data */
-                uint16_t addr_lo, addr_hi;
-                fetch_tile_data(ppu, &addr_lo, &addr_hi);
-                ppu->background_fetch_tile = ppu_read_vram(ppu, addr_lo) |
-                                            (ppu_read_vram(ppu, addr_hi) << 8);
+                fetch_background_tile(ppu);
             }
         }
 
@@ -447,85 +545,17 @@ int nes_ppu_step(nes_ppu_t* ppu) {
         if (ppu->cycle >= 1 && ppu->cycle <= 256 && (ppu->reg.mask & (PPUMASK_SHOW_BGR | PPUMASK_SHOW_SPR))) {
             /* Background rendering */
             if (ppu->reg.mask & PPUMASK_SHOW_BGR) {
-                uint8_t* line_buf = g_frame_buffer + ppu->scanline * PPU_WIDTH;
-                int x = ppu->cycle - 1;
-
-                uint8_t pixel = 0;
-                if (!(ppu->reg.mask & PPUMASK_SHOW_BGR8) && x < 8) {
-                    pixel = 0;
-                } else {
-                    uint8_t shift = 7 - ((x + ppu->reg.scroll.x) % 8) /*ppu->reg.scroll.x*/;
-                    if (shift <= 15) {
-                        uint8_t bg_lo = (ppu->background_shift_lo >> shift) & 0x01;
-                        uint8_t bg_hi = (ppu->background_shift_hi >> shift) & 0x01;
-                        pixel = bg_lo | (bg_hi << 1);
-
-                        if (pixel && (x & 3) == 0) {
-                            /* Get attribute at tile boundaries */
-                            uint16_t attr_addr = 0x23C0 | (ppu->reg.scroll.v & 0x0C00) |
-                                               ((ppu->reg.scroll.v >> 4) & 0x38) |
-                                               ((ppu->reg.scroll.v >> 2) & 0x07);
-                            uint8_t attr = ppu_read_vram(ppu, attr_addr);
-
-                            if ((x / 2) & 1) attr >>= 2;
-                            if ((ppu->scanline / 2) & 1) attr >>= 2;
-
-                            pixel |= (attr & 0x03) << 2;
-                        }
-                    }
+                if (ppu->render_frame) {
+                    render_dot(ppu, ppu->cycle - 1);
+                } else if (ppu->sprite_zero_probe) {
+                    probe_dot(ppu, ppu->cycle - 1);
                 }
-
-                /* Render sprites */
-                uint8_t sprite_pixel = 0;
-                if (ppu->reg.mask & PPUMASK_SHOW_SPR &&
-                    (!(ppu->reg.mask & PPUMASK_SHOW_SPR8) || x >= 8)) {
-                    for (int i = 0; i < ppu->sprite_count; i++) {
-                        ppu_sprite_t* sprite = &ppu->sprites[i];
-                        int sprite_height = (ppu->reg.ctrl & PPUCTRL_SP_SIZE) ? 16 : 8;
-                        int line = (int)ppu->scanline - (int)sprite->y;
-
-                        if (line >= 0 && line < sprite_height && x >= sprite->x && x < sprite->x + 8) {
-                            uint8_t attr = sprite->attr;
-                            if (line >= sprite_height) continue;
-
-                            uint16_t pattern_table = (ppu->reg.ctrl & PPUCTRL_SP_ADDR) ? 0x1000 : 0x0000;
-                            int column = x - sprite->x;
-                            if (attr & SP_ATTR_FLIP_H) column = 7 - column;
-
-                            uint16_t addr = pattern_table + ((uint16_t)sprite->tile << 4) + line;
-                            uint8_t lo = ppu_read_vram(ppu, addr);
-                            uint8_t hi = ppu_read_vram(ppu, addr + 8);
-                            sprite_pixel = ((lo >> column) & 1) | (((hi >> column) & 1) << 1);
-
-                            if (i == 0 && sprite_pixel && pixel) {
-                                ppu->reg.status |= PPUSTATUS_SP0_HIT;
-                            }
-
-                            if (sprite_pixel) {
-                                sprite_pixel |= (attr & SP_ATTR_PAL_MASK) << 2;
-                                if (attr & SP_ATTR_PRIORITY) {
-                                    pixel = 0;  /* Sprite behind */
-                                } else {
-                                    break;  /* Sprite in front */
-                                }
-                            }
-                        }
-                    }
-                }
-
-                if (sprite_pixel) pixel = sprite_pixel | 0x10;
-                else if (pixel) pixel = pixel | 0x20;
-
-                line_buf[x] = pixel;
             }
         }
 
         /* Shift background registers for each cycle */
         if (ppu->cycle >= 1 && ppu->cycle <= 256) {
-            ppu->background_shift_lo <<= 1;
-            ppu->background_shift_hi <<= 1;
-            ppu->attribute_shift_lo <<= 1;
-            ppu->attribute_shift_hi <<= 1;
+            shift_background(ppu);
         }
 
         /* Increment Y at end of visible scanline */
@@ -537,6 +567,8 @@ int nes_ppu_step(nes_ppu_t* ppu) {
         if (ppu->cycle == 257) {
             ppu->reg.scroll.v = (ppu->reg.scroll.v & 0xFBE0) | (ppu->reg.scroll.t & 0x041F);
         }
+
+        ppu_watch_a12(ppu);
     }
     /* Post-render scanline (240) */
     else if (ppu->scanline == 240) {
@@ -562,6 +594,7 @@ int nes_ppu_step(nes_ppu_t* ppu) {
             ppu->reg.status &= ~PPUSTATUS_VBLANK;
             ppu->reg.status &= ~PPUSTATUS_SP0_HIT;
             ppu->reg.status &= ~PPUSTATUS_SP_OVF;
+            ppu->render_frame = ppu->render_enabled;
         }
 
         if ((ppu->cycle >= 1 && ppu->cycle <= 256) || (ppu->cycle >= 321 && ppu->cycle <= 336)) {
@@ -577,10 +610,7 @@ int nes_ppu_step(nes_ppu_t* ppu) {
             }
 
             if (cycle_mod == 0) {
-                uint16_t addr_lo, addr_hi;
-                fetch_tile_data(ppu, &addr_lo, &addr_hi);
-                ppu->background_fetch_tile = ppu_read_vram(ppu, addr_lo) |
-                                            (ppu_read_vram(ppu, addr_hi) << 8);
+                fetch_background_tile(ppu);
             }
         }
 
@@ -593,10 +623,7 @@ int nes_ppu_step(nes_ppu_t* ppu) {
         }
 
         if (ppu->cycle >= 1 && ppu->cycle <= 256) {
-            ppu->background_shift_lo <<= 1;
-            ppu->background_shift_hi <<= 1;
-            ppu->attribute_shift_lo <<= 1;
-            ppu->attribute_shift_hi <<= 1;
+            shift_background(ppu);
         }
 
         if (ppu->cycle == 256) {
@@ -606,6 +633,8 @@ int nes_ppu_step(nes_ppu_t* ppu) {
         if (ppu->cycle == 257) {
             ppu->reg.scroll.v = (ppu->reg.scroll.v & 0xFBE0) | (ppu->reg.scroll.t & 0x041F);
         }
+
+        ppu_watch_a12(ppu);
     }
 
     /* Advance cycle */
@@ -623,6 +652,73 @@ int nes_ppu_step(nes_ppu_t* ppu) {
     return frame_complete;
 }
 
+int nes_ppu_step_scanline(nes_ppu_t* ppu) {
+    uint16_t line = ppu->scanline;
+    int frame_complete = 0;
+
+    /* Post-render and VBlank lines only act at (241, 1) */
+    if (line >= 240 && line <= 260) {
+        while (line == 241 && ppu->cycle <= 1) {
+            frame_complete |= nes_ppu_step(ppu);
+        }
+        ppu->cycle = 0;
+        ppu->scanline++;
+        return frame_complete;
+    }
+
+    /* Partially stepped and pre-render lines go dot by dot */
+    if (ppu->cycle != 0 || line >= PPU_VISIBLE_SCANLINES) {
+        while (ppu->scanline == line) {
+            frame_complete |= nes_ppu_step(ppu);
+        }
+        return frame_complete;
+    }
+
+    /* Visible line in one pass - same per-dot order as nes_ppu_step,
+     * with registers fixed for the whole line */
+    int show_bg = (ppu->reg.mask & PPUMASK_SHOW_BGR) != 0;
+
+    evaluate_sprites(ppu);
+
+    /* Dots 1-256: one tile per 8 dots */
+    for (int x = 0; x < PPU_WIDTH; x += 8) {
+        load_background_shifters(ppu);
+        if (show_bg) {
+            if (ppu->render_frame) {
+                render_tile(ppu, x);
+            } else if (ppu->sprite_zero_probe) {
+                probe_tile(ppu, x);
+            }
+        }
+        /* Dot 7 - the fetch does not touch what the tile has drawn */
+        increment_x(ppu);
+        fetch_background_tile(ppu);
+        for (int dot = 0; dot < 8; dot++) {
+            shift_background(ppu);
+        }
+    }
+    increment_y(ppu);
+
+    /* Dot 257 */
+    ppu->reg.scroll.v = (ppu->reg.scroll.v & 0xFBE0) | (ppu->reg.scroll.t & 0x041F);
+
+    /* Dots 321-336: prefetch the first two tiles of the next line */
+    for (int tile = 0; tile < 2; tile++) {
+        load_background_shifters(ppu);
+        increment_x(ppu);
+        fetch_background_tile(ppu);
+    }
+
+    /* The line's A12 rise, after everything it follows */
+    if (ppu->bus.a12_rise && ppu_a12_dot(ppu)) {
+        ppu->bus.a12_rise(ppu->bus.context);
+    }
+
+    ppu->cycle = 0;
+    ppu->scanline++;
+    return frame_complete;
+}
+
 void nes_ppu_execute_cycles(nes_ppu_t* ppu, int cycles) {
     for (int i = 0; i < cycles; i++) {
         nes_ppu_step(ppu);
@@ -713,7 +809,16 @@ uint8_t nes_ppu_cpu_read(nes_ppu_t* ppu, uint16_t addr) {
     return result;
 }
 
-uint32_t nes_ppu_get_rgba_color(nes_ppu_t* ppu, uint8_t val) {
+/* PPUMASK bits that affect output colors */
+#define PPUMASK_COLOR_BITS (PPUMASK_EMPHASIS | PPUMASK_GRAYSCALE)
+
+/* Color emphasis: each of PPUMASK bits 5-7 (red, green, blue) dims the
+ * other two channels to about 81.6%, once per emphasized channel */
+#define PPU_EMPHASIS_SHIFT      5
+#define PPU_EMPHASIS_ATTENUATE  209     /* / 256 */
+
+/* Master palette index of a frame buffer value */
+static uint8_t ppu_master_index(nes_ppu_t* ppu, uint8_t val) {
     uint8_t idx;
     if (val & 0x10) {  /* Sprite */
         idx = ((val & 0x0F) | 0x10) & 0x1F;
@@ -729,38 +834,150 @@ uint32_t nes_ppu_get_rgba_color(nes_ppu_t* ppu, uint8_t val) {
         /* Grayscale - just use the low 3 bits */
         palette_entry = (palette_entry & 0x30) | ((palette_entry & 0x0F) ? 0x13 : 0);
     }
+    return palette_entry % 64;
+}
 
-    uint8_t r = g_nes_palette[palette_entry % 64][0];
-    uint8_t g = g_nes_palette[palette_entry % 64][1];
-    uint8_t b = g_nes_palette[palette_entry % 64][2];
+uint32_t nes_ppu_master_color(uint8_t index) {
+    uint8_t r = g_nes_palette[index % 64][0];
+    uint8_t g = g_nes_palette[index % 64][1];
+    uint8_t b = g_nes_palette[index % 64][2];
 
     return (0xFF << 24) | (b << 16) | (g << 8) | r;
 }
 
+uint32_t nes_ppu_get_rgba_color(nes_ppu_t* ppu, uint8_t val) {
+    return nes_ppu_master_color(ppu_master_index(ppu, val));
+}
+
+/* Rebuild the output color tables if palette RAM or PPUMASK changed
+ * Frame buffer values are 0, $10-$1F (sprite) or $20-$2F (background) */
+static void ppu_update_colors(nes_ppu_t* ppu) {
+    uint8_t mask = ppu->reg.mask & PPUMASK_COLOR_BITS;
+    if (ppu->color_valid && ppu->color_key_mask == mask &&
+        memcmp(ppu->color_key_palette, ppu->palette, PPU_PALETTE_SIZE) == 0) {
+        return;
+    }
+
+    uint8_t emphasis = (uint8_t)(mask >> PPU_EMPHASIS_SHIFT);
+    for (int val = 0; val < 64; val++) {
+        uint8_t index = ppu_master_index(ppu, (uint8_t)val);
+        uint8_t rgb[3];
+        for (int c = 0; c < 3; c++) {
+            unsigned level = g_nes_palette[index][c];
+            for (int e = 0; e < 3; e++) {
+                if (e != c && (emphasis & (1 << e))) {
+                    level = level * PPU_EMPHASIS_ATTENUATE >> 8;
+                }
+            }
+            rgb[c] = (uint8_t)level;
+        }
+        ppu->color_index[val] = index;
+        ppu->color_rgba[val] = (0xFFu << 24) | ((uint32_t)rgb[2] << 16) | ((uint32_t)rgb[1] << 8) | rgb[0];
+        ppu->color_rgb565[val] = (uint16_t)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+    }
+
+    memcpy(ppu->color_key_palette, ppu->palette, PPU_PALETTE_SIZE);
+    ppu->color_key_mask = mask;
+    ppu->color_valid = 1;
+}
+
+int nes_ppu_convert_frame(nes_ppu_t* ppu, nes_pixel_format_t format, void* out, size_t pitch) {
+    static const size_t bytes_per_pixel[] = { 4, 2, 1 };
+
+    if ((unsigned)format > NES_PIXEL_INDEXED || !out) {
+        return -1;
+    }
+
+    ppu_update_colors(ppu);
+    if (pitch == 0) {
+        pitch = PPU_WIDTH * bytes_per_pixel[format];
+    }
+
+    const uint8_t* src = ppu->frame_buffer;
+    uint8_t* dst = (uint8_t*)out;
+    for (int y = 0; y < PPU_HEIGHT; y++, src += PPU_WIDTH, dst += pitch) {
+        switch (format) {
+            case NES_PIXEL_RGBA8888: {
+                uint32_t* row = (uint32_t*)dst;
+                for (int x = 0; x < PPU_WIDTH; x++) {
+                    row[x] = ppu->color_rgba[src[x] & 0x3F];
+                }
+                break;
+            }
+            case NES_PIXEL_RGB565: {
+                uint16_t* row = (uint16_t*)dst;
+                for (int x = 0; x < PPU_WIDTH; x++) {
+                    row[x] = ppu->color_rgb565[src[x] & 0x3F];
+                }
+                break;
+            }
+            case NES_PIXEL_INDEXED:
+                for (int x = 0; x < PPU_WIDTH; x++) {
+                    dst[x] = ppu->color_index[src[x] & 0x3F];
+                }
+                break;
+        }
+    }
+    return 0;
+}
+
 void nes_ppu_render_frame(nes_ppu_t* ppu, uint32_t* buffer) {
-    for (int y = 0; y < PPU_HEIGHT; y++) {
-        for (int x = 0; x < PPU_WIDTH; x++) {
-            uint8_t pixel = g_frame_buffer[y * PPU_WIDTH + x];
-            buffer[y * PPU_WIDTH + x] = nes_ppu_get_rgba_color(ppu, pixel);
+    nes_ppu_convert_frame(ppu, NES_PIXEL_RGBA8888, buffer, 0);
+}
+
+void nes_ppu_set_render(nes_ppu_t* ppu, int enable) {
+    ppu->render_enabled = enable != 0;
+}
+
+int nes_ppu_frame_rendered(const nes_ppu_t* ppu) {
+    return ppu->render_frame;
+}
+
+uint32_t nes_ppu_dots_until_a12(const nes_ppu_t* ppu) {
+    int dot = ppu_a12_dot(ppu);
+    if (dot == 0) {
+        return 0;
+    }
+
+    /* This line if it renders and is not past the dot, else the next one that renders */
+    int line = ppu->scanline;
+    int renders = line < PPU_VISIBLE_SCANLINES || line == PPU_SCANLINES - 1;
+    if (!renders || ppu->cycle > dot) {
+        if (line < PPU_VISIBLE_SCANLINES - 1) {
+            line++;
+        } else {
+            line = line == PPU_SCANLINES - 1 ? 0 : PPU_SCANLINES - 1;
         }
     }
+
+    int32_t dots = (line - (int)ppu->scanline) * PPU_DOTS_PER_SCANLINE + (dot + 1 - (int)ppu->cycle);
+    if (dots <= 0) {
+        dots += PPU_SCANLINES * PPU_DOTS_PER_SCANLINE;
+    }
+    return (uint32_t)dots;
+}
+
+int nes_ppu_sprite_zero_pending(const nes_ppu_t* ppu) {
+    uint8_t both = PPUMASK_SHOW_BGR | PPUMASK_SHOW_SPR;
+    if ((ppu->reg.status & PPUSTATUS_SP0_HIT) || (ppu->reg.mask & both) != both) {
+        return 0;
+    }
+
+    /* Sprite 0 on this line or the next (visible lines only) */
+    int height = (ppu->reg.ctrl & PPUCTRL_SP_SIZE) ? 16 : 8;
+    int line = (int)ppu->scanline - (int)ppu->oam[0];
+    return ppu->scanline < PPU_VISIBLE_SCANLINES && line >= -1 && line < height;
 }
 
 const uint8_t* nes_ppu_get_frame_buffer(nes_ppu_t* ppu) {
-    (void)ppu;  /* unused */
-    return g_frame_buffer;
+    return ppu->frame_buffer;
 }
 
 void nes_ppu_set_bus(nes_ppu_t* ppu, ppu_bus_t* bus) {
-    /* Copy bus configuration to static storage */
+    /* Copy bus configuration into the instance - caller's struct may be on the stack */
     if (bus) {
-        g_ppu_bus_static.context = bus->context;
-        g_ppu_bus_static.read_chr = bus->read_chr;
-        g_ppu_bus_static.write_chr = bus->write_chr;
-        g_ppu_bus_static.ppu_write_cpu = bus->ppu_write_cpu;
+        ppu->bus = *bus;
     }
-    g_ppu_bus = &g_ppu_bus_static;
-    (void)ppu;  /* unused */
 }
 
 void nes_ppu_nmi_enabled_check(nes_ppu_t* ppu, int* nmi_pending) {
@@ -773,12 +990,12 @@ int nes_ppu_in_vblank(nes_ppu_t* ppu) {
     return (ppu->reg.status & PPUSTATUS_VBLANK) != 0;
 }
 
-void nes_ppu_set_mirror_mode(uint8_t mirroring) {
+void nes_ppu_set_mirror_mode(nes_ppu_t* ppu, uint8_t mirroring) {
     switch (mirroring) {
-        case 0: g_mirror_mode = MIRROR_HORIZONTAL; break;
-        case 1: g_mirror_mode = MIRROR_VERTICAL; break;
-        case 2: g_mirror_mode = MIRROR_SINGLE_0; break;
-        case 3: g_mirror_mode = MIRROR_SINGLE_1; break;
+        case 0: ppu->mirror_mode = MIRROR_HORIZONTAL; break;
+        case 1: ppu->mirror_mode = MIRROR_VERTICAL; break;
+        case 2: ppu->mirror_mode = MIRROR_SINGLE_0; break;
+        case 3: ppu->mirror_mode = MIRROR_SINGLE_1; break;
     }
 }
 
@@ -21,10 +21,12 @@ extern "C" {
 #define PPU_HEIGHT        240
 #define PPU_SCANLINES     262
 #define PPU_VISIBLE_SCANLINES 240
+#define PPU_DOTS_PER_SCANLINE 341
 
 #define PPU_VRAM_SIZE     0x1000   /* 4KB VRAM */
 #define PPU_PALETTE_SIZE  0x20     /* 32 palette entries */
 #define PPU_OAM_SIZE      0x100    /* 256 bytes OAM */
+#define PPU_SECONDARY_OAM_SIZE 0x20 /* 8 sprites x 4 bytes */
 #define PPU_SPRITE_COUNT  64
 
 /* PPU Registers */
@@ -64,6 +66,19 @@ extern "C" {
 #define SP_ATTR_FLIP_V    0x80   /* Vertical flip */
 #define SP_ATTR_PAL_MASK  0x03   /* Palette bits */
 
+/* Sprite line buffer entries */
+#define SPRITE_LINE_PIXEL 0x0F   /* Sprite color (palette << 2 | pattern), 0 = transparent */
+#define SPRITE_LINE_FRONT 0x10   /* Opaque front-priority sprite - final */
+#define SPRITE_LINE_BEHIND 0x20  /* An opaque behind-priority sprite hides the background */
+#define SPRITE_LINE_ZERO  0x40   /* First sprite of the line is opaque here (sprite 0 hit) */
+
+/* Output pixel formats for nes_ppu_convert_frame */
+typedef enum {
+    NES_PIXEL_RGBA8888 = 0,  /* uint32_t 0xAABBGGRR (R, G, B, A bytes in memory on little-endian) */
+    NES_PIXEL_RGB565,        /* uint16_t */
+    NES_PIXEL_INDEXED        /* uint8_t NES master palette index 0-63 (no color emphasis) */
+} nes_pixel_format_t;
+
 /* PPU Scroll Position (v, t, w, x) */
 typedef struct {
     uint16_t v;      /* Current VRAM address (15 bits) */
@@ -92,26 +107,32 @@ typedef struct {
     ppu_scroll_t scroll;
 } ppu_registers_t;
 
-/* PPU State */
+/* PPU Bus Interface */
+typedef struct {
+    void*   context;
+    uint8_t (*read_chr)(void* ctx, uint16_t addr);
+    void    (*write_chr)(void* ctx, uint16_t addr, uint8_t val);
+    const uint8_t* const* chr_map;  /* 8 x 1KB pattern pages, NULL pages use read_chr (may be NULL) */
+    void    (*ppu_write_cpu)(void* ctx, uint16_t addr, uint8_t val);
+    void    (*a12_rise)(void* ctx);     /* Pattern fetches raised A12 (may be NULL) */
+} ppu_bus_t;
+
+/* PPU State
+ * The state that every dot touches comes first and fits one 64-byte cache
+ * line; the memories follow. Everything before the wiring is plain data and
+ * is what a save state copies */
 typedef struct nes_ppu {
+    /* Per-dot state */
     ppu_registers_t reg;
 
-    /* Memory */
-    uint8_t         vram[PPU_VRAM_SIZE];        /* 4KB VRAM */
-    uint8_t         palette[PPU_PALETTE_SIZE];  /* Palette RAM ($3F00-$3F1F) */
-    uint8_t         oam[PPU_OAM_SIZE];          /* OAM */
-    uint8_t         secondary_oam[PPU_OAM_SIZE];/* Secondary OAM for rendering */
-
     /* Scanline timing */
     uint16_t        scanline;
     uint16_t        cycle;
     uint32_t        frame;
     uint8_t         odd_frame;
 
-    /* Sprite detection */
-    uint8_t         sprite_count;
-    uint8_t         sprite_pattern[8];
-    ppu_sprite_t    sprites[8];     /* Sprites on current scanline */
+    /* Nametable mirroring (set by cartridge/mapper) */
+    uint8_t         mirror_mode;
 
     /* Rendering buffers */
     uint8_t         background_shift_lo;
@@ -123,19 +144,52 @@ typedef struct nes_ppu {
     uint8_t         background_fetch_tile;
     uint8_t         background_fetch_attr;
 
+    /* Sprite detection */
+    uint8_t         sprite_count;
+    ppu_sprite_t    sprites[8];     /* Sprites on current scanline */
+
+    /* Memory */
+    uint8_t         palette[PPU_PALETTE_SIZE];  /* Palette RAM ($3F00-$3F1F) */
+    uint8_t         oam[PPU_OAM_SIZE];          /* OAM */
+    uint8_t         secondary_oam[PPU_SECONDARY_OAM_SIZE];  /* 8 sprites for the next line */
+    uint8_t         vram[PPU_VRAM_SIZE];        /* 4KB VRAM */
+
+    /* Wiring and output below are not part of save states */
+
     /* External callbacks */
     void*           context;
     void (*render_scanline)(void* ctx, int scanline);
     void (*vblank_callback)(void* ctx);
+
+    /* Per-instance CHR bus */
+    ppu_bus_t       bus;
+
+    /* Render suppression - render_enabled is latched into render_frame at the
+     * pre-render line; suppressed frames leave frame_buffer untouched and only
+     * look for sprite 0 hit */
+    uint8_t         render_enabled;
+    uint8_t         render_frame;
+    uint8_t         sprite_zero_probe;  /* Suppressed line that can still hit sprite 0 */
+
+    /* Decoded sprite pixels of the line (SPRITE_LINE_*), rebuilt at dot 1 of
+     * each visible line when needed - dead between frames */
+    uint8_t         sprite_line[PPU_WIDTH];
+
+    /* Rendered frame (raw palette indices) */
+    uint8_t         frame_buffer[PPU_WIDTH * PPU_HEIGHT];
+
+    /* Output colors per frame buffer value, rebuilt when palette[] or the
+     * PPUMASK color bits differ from the key they were built for */
+    uint8_t         color_key_palette[PPU_PALETTE_SIZE];
+    uint8_t         color_key_mask;
+    uint8_t         color_valid;
+    uint8_t         color_index[64];
+    uint16_t        color_rgb565[64];
+    uint32_t        color_rgba[64];
 } nes_ppu_t;
 
-/* PPU Bus Interface */
-typedef struct {
-    void*   context;
-    uint8_t (*read_chr)(void* ctx, uint16_t addr);
-    void    (*write_chr)(void* ctx, uint16_t addr, uint8_t val);
-    void    (*ppu_write_cpu)(void* ctx, uint16_t addr, uint8_t val);
-} ppu_bus_t;
+/* Bytes of plain (pointer-free) PPU state at the start of nes_ppu_t */
+#define NES_PPU_STATE_SIZE offsetof(nes_ppu_t, context)
 
 /* API Functions */
 
@@ -155,6 +209,15 @@ void nes_ppu_reset(nes_ppu_t* ppu);
  */
 int nes_ppu_step(nes_ppu_t* ppu);
 
+/**
+ * Step PPU to the end of the current scanline
+ * Visible lines are rendered in one pass with PPUCTRL/PPUMASK/scroll held
+ * for the whole line; produces the same result as stepping the remaining
+ * dots one by one when no register changes in between.
+ * Returns 1 if VBlank started with NMI enabled during the line
+ */
+int nes_ppu_step_scanline(nes_ppu_t* ppu);
+
 /**
  * Execute N PPU cycles
  */
@@ -176,6 +239,44 @@ uint8_t nes_ppu_cpu_read(nes_ppu_t* ppu, uint16_t addr);
  */
 void nes_ppu_render_frame(nes_ppu_t* ppu, uint32_t* buffer);
 
+/**
+ * Convert the frame buffer to format, with PPUMASK grayscale and emphasis
+ * out:   PPU_HEIGHT rows of PPU_WIDTH pixels
+ * pitch: bytes between rows (0 = tightly packed)
+ * Returns 0 on success, -1 if format is unknown or out is NULL (out untouched)
+ */
+int nes_ppu_convert_frame(nes_ppu_t* ppu, nes_pixel_format_t format, void* out, size_t pitch);
+
+/**
+ * Get the RGBA8888 color of NES master palette entry index (0-63)
+ * For consumers of NES_PIXEL_INDEXED output
+ */
+uint32_t nes_ppu_master_color(uint8_t index);
+
+/**
+ * Enable or suppress pixel output (on by default), from the next frame on
+ * Suppressed frames still evaluate sprites and set the sprite 0 hit flag
+ */
+void nes_ppu_set_render(nes_ppu_t* ppu, int enable);
+
+/**
+ * Returns 1 if the frame buffer was drawn by the current (or just completed)
+ * frame, 0 if that frame is suppressed and the buffer holds an older one
+ */
+int nes_ppu_frame_rendered(const nes_ppu_t* ppu);
+
+/**
+ * PPU dots until the next A12 rise of the pattern fetches has been stepped,
+ * under the current PPUCTRL and PPUMASK; 0 if none is coming
+ */
+uint32_t nes_ppu_dots_until_a12(const nes_ppu_t* ppu);
+
+/**
+ * Returns 1 if the sprite 0 hit flag may still be set on the current or
+ * next scanline, 0 if it is already set or cannot be this line
+ */
+int nes_ppu_sprite_zero_pending(const nes_ppu_t* ppu);
+
 /**
  * Get current frame buffer (raw palette indices)
  * Returns pointer to internal rendering buffer
@@ -185,7 +286,7 @@ const uint8_t* nes_ppu_get_frame_buffer(nes_ppu_t* ppu);
 /**
  * Set mirroring mode
  */
-void nes_ppu_set_mirror_mode(uint8_t mirroring);
+void nes_ppu_set_mirror_mode(nes_ppu_t* ppu, uint8_t mirroring);
 
 /**
  * OAM DMA transfer
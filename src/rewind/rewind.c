@@ -0,0 +1,357 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Rewind Module - Delta-Compressed Save-State History Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "rewind.h"
+#include "../memory/bus.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Zero runs shorter than this stay inside a literal run */
+#define RLE_MIN_ZERO_RUN 4
+
+/* One recorded frame in the byte ring */
+typedef struct {
+    size_t  offset;
+    size_t  size;
+    int     key;        /* Keyframe (else XOR delta against the group's keyframe) */
+} rewind_entry_t;
+
+struct nes_rewind {
+    /* Compressed record ring */
+    uint8_t*        ring;
+    size_t          budget;
+    size_t          bytes_used;
+
+    /* Frame descriptors, oldest first (oldest is always a keyframe) */
+    rewind_entry_t* entries;
+    size_t          entry_cap;
+    size_t          first;
+    size_t          count;
+
+    int             interval;
+    size_t          since_key;      /* Deltas recorded after the newest keyframe */
+
+    /* Scratch, sized for the current snapshot size */
+    size_t          state_size;
+    uint8_t*        state;
+    uint8_t*        key_state;      /* Raw newest keyframe */
+    uint8_t*        encoded;
+};
+
+/* Run-length coding of a XOR b (b may be NULL)
+ * Stream of tokens: varint zero_run, varint literal_len, literal bytes */
+
+static size_t rle_put_varint(uint8_t* out, size_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static int rle_get_varint(const uint8_t** in, const uint8_t* end, size_t* value) {
+    size_t result = 0;
+    int shift = 0;
+    while (*in < end && shift < 64) {
+        uint8_t byte = *(*in)++;
+        result |= (size_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+        shift += 7;
+    }
+    return -1;
+}
+
+static inline uint8_t rle_byte(const uint8_t* a, const uint8_t* b, size_t i) {
+    return b ? (uint8_t)(a[i] ^ b[i]) : a[i];
+}
+
+static size_t rle_encode(const uint8_t* a, const uint8_t* b, size_t n, uint8_t* out) {
+    size_t i = 0, o = 0;
+
+    while (i < n) {
+        size_t lit = i;
+        while (lit < n && rle_byte(a, b, lit) == 0) {
+            lit++;
+        }
+
+        /* Extend the literal run until a long enough zero run starts */
+        size_t end = lit;
+        while (end < n) {
+            if (rle_byte(a, b, end) != 0) {
+                end++;
+                continue;
+            }
+            size_t z = end;
+            while (z < n && z - end < RLE_MIN_ZERO_RUN && rle_byte(a, b, z) == 0) {
+                z++;
+            }
+            if (z == n || z - end >= RLE_MIN_ZERO_RUN) {
+                break;
+            }
+            end = z;
+        }
+
+        o += rle_put_varint(out + o, lit - i);
+        o += rle_put_varint(out + o, end - lit);
+        for (size_t k = lit; k < end; k++) {
+            out[o++] = rle_byte(a, b, k);
+        }
+        i = end;
+    }
+
+    return o;
+}
+
+/* XOR a token stream into dst (onto zeros this decodes a keyframe) */
+static int rle_apply(const uint8_t* in, size_t size, uint8_t* dst, size_t n) {
+    const uint8_t* end = in + size;
+    size_t pos = 0;
+
+    while (in < end) {
+        size_t zeros, lit;
+        if (rle_get_varint(&in, end, &zeros) != 0 || rle_get_varint(&in, end, &lit) != 0) {
+            return -1;
+        }
+        pos += zeros;
+        if (pos > n || lit > n - pos || lit > (size_t)(end - in)) {
+            return -1;
+        }
+        for (size_t k = 0; k < lit; k++) {
+            dst[pos++] ^= *in++;
+        }
+    }
+
+    return 0;
+}
+
+/* Entry ring helpers */
+
+static rewind_entry_t* rewind_entry(nes_rewind_t* rw, size_t i) {
+    return &rw->entries[(rw->first + i) % rw->entry_cap];
+}
+
+static int rewind_append(nes_rewind_t* rw, size_t offset, size_t size, int key) {
+    if (rw->count == rw->entry_cap) {
+        size_t cap = rw->entry_cap ? rw->entry_cap * 2 : 256;
+        rewind_entry_t* entries = (rewind_entry_t*)malloc(cap * sizeof(rewind_entry_t));
+        if (!entries) {
+            return -1;
+        }
+        for (size_t i = 0; i < rw->count; i++) {
+            entries[i] = *rewind_entry(rw, i);
+        }
+        free(rw->entries);
+        rw->entries = entries;
+        rw->entry_cap = cap;
+        rw->first = 0;
+    }
+
+    rewind_entry_t* e = &rw->entries[(rw->first + rw->count) % rw->entry_cap];
+    e->offset = offset;
+    e->size = size;
+    e->key = key;
+    rw->count++;
+    rw->bytes_used += size;
+    return 0;
+}
+
+/* Drop the oldest keyframe and all of its deltas */
+static void rewind_evict_group(nes_rewind_t* rw) {
+    do {
+        rw->bytes_used -= rewind_entry(rw, 0)->size;
+        rw->first = (rw->first + 1) % rw->entry_cap;
+        rw->count--;
+    } while (rw->count > 0 && !rewind_entry(rw, 0)->key);
+}
+
+/* Find room for size contiguous bytes after the newest record */
+static int rewind_fit(nes_rewind_t* rw, size_t size, size_t* offset) {
+    if (rw->count == 0) {
+        *offset = 0;
+        return size <= rw->budget;
+    }
+
+    size_t head = rewind_entry(rw, 0)->offset;
+    rewind_entry_t* last = rewind_entry(rw, rw->count - 1);
+    size_t tail = last->offset + last->size;
+
+    if (tail > head) {
+        /* Not wrapped: space at the end, else wrap to the start */
+        if (rw->budget - tail >= size) {
+            *offset = tail;
+            return 1;
+        }
+        if (head >= size) {
+            *offset = 0;
+            return 1;
+        }
+        return 0;
+    }
+
+    /* Wrapped: space between newest and oldest */
+    if (head - tail >= size) {
+        *offset = tail;
+        return 1;
+    }
+    return 0;
+}
+
+/* (Re)size scratch buffers for a new snapshot size */
+static int rewind_resize(nes_rewind_t* rw, size_t state_size) {
+    free(rw->state);
+    free(rw->key_state);
+    free(rw->encoded);
+    rw->state = (uint8_t*)malloc(state_size);
+    rw->key_state = (uint8_t*)malloc(state_size);
+    /* Worst case: every literal run plus two varints per token */
+    rw->encoded = (uint8_t*)malloc(state_size * 2 + 32);
+    rw->state_size = (rw->state && rw->key_state && rw->encoded) ? state_size : 0;
+    return rw->state_size ? 0 : -1;
+}
+
+/* Public API Implementation */
+
+nes_rewind_t* nes_rewind_create(size_t budget_bytes, int keyframe_interval) {
+    nes_rewind_t* rw = (nes_rewind_t*)calloc(1, sizeof(nes_rewind_t));
+    if (!rw) {
+        return NULL;
+    }
+
+    rw->ring = (uint8_t*)malloc(budget_bytes);
+    if (!rw->ring) {
+        free(rw);
+        return NULL;
+    }
+    rw->budget = budget_bytes;
+    rw->interval = keyframe_interval > 0 ? keyframe_interval : NES_REWIND_DEFAULT_KEYFRAME_INTERVAL;
+    return rw;
+}
+
+void nes_rewind_destroy(nes_rewind_t* rw) {
+    if (!rw) {
+        return;
+    }
+    free(rw->ring);
+    free(rw->entries);
+    free(rw->state);
+    free(rw->key_state);
+    free(rw->encoded);
+    free(rw);
+}
+
+void nes_rewind_clear(nes_rewind_t* rw) {
+    rw->first = 0;
+    rw->count = 0;
+    rw->bytes_used = 0;
+    rw->since_key = 0;
+}
+
+int nes_rewind_push(nes_rewind_t* rw, nes_system_t* sys) {
+    size_t state_size = nes_sys_snapshot_size(sys);
+    if (state_size != rw->state_size) {
+        /* New ROM - old history cannot be restored onto it */
+        nes_rewind_clear(rw);
+        if (rewind_resize(rw, state_size) != 0) {
+            return -1;
+        }
+    }
+
+    if (nes_sys_snapshot_to_buffer(sys, rw->state, state_size) == 0) {
+        return -1;
+    }
+
+    int key = rw->count == 0 || rw->since_key + 1 >= (size_t)rw->interval;
+    size_t size = rle_encode(rw->state, key ? NULL : rw->key_state, state_size, rw->encoded);
+
+    size_t offset;
+    while (!rewind_fit(rw, size, &offset)) {
+        if (rw->count == 0) {
+            return -1;  /* Larger than the whole budget */
+        }
+        if (!key && rw->count == rw->since_key + 1) {
+            /* Only our own group is left - start over with a keyframe */
+            nes_rewind_clear(rw);
+            key = 1;
+            size = rle_encode(rw->state, NULL, state_size, rw->encoded);
+            continue;
+        }
+        rewind_evict_group(rw);
+    }
+
+    if (rewind_append(rw, offset, size, key) != 0) {
+        return -1;
+    }
+    memcpy(rw->ring + offset, rw->encoded, size);
+
+    if (key) {
+        memcpy(rw->key_state, rw->state, state_size);
+        rw->since_key = 0;
+    } else {
+        rw->since_key++;
+    }
+    return 0;
+}
+
+int nes_rewind_seek(nes_rewind_t* rw, nes_system_t* sys, size_t frames_back) {
+    if (frames_back >= rw->count) {
+        return -1;
+    }
+
+    size_t target = rw->count - 1 - frames_back;
+    size_t key = target;
+    while (!rewind_entry(rw, key)->key) {
+        key--;
+    }
+
+    /* Decode keyframe, then apply the target's delta on top. key_state stays
+     * the newest keyframe until the restore succeeds - later pushes encode
+     * against it */
+    const rewind_entry_t* key_entry = rewind_entry(rw, key);
+    memset(rw->state, 0, rw->state_size);
+    if (rle_apply(rw->ring + key_entry->offset, key_entry->size, rw->state, rw->state_size) != 0) {
+        return -1;
+    }
+    if (target != key) {
+        const rewind_entry_t* e = rewind_entry(rw, target);
+        if (rle_apply(rw->ring + e->offset, e->size, rw->state, rw->state_size) != 0) {
+            return -1;
+        }
+    }
+
+    if (nes_sys_restore_from_buffer(sys, rw->state, rw->state_size) != 0) {
+        return -1;
+    }
+
+    /* The target's group is now the newest */
+    if (target == key) {
+        memcpy(rw->key_state, rw->state, rw->state_size);
+    } else {
+        memset(rw->key_state, 0, rw->state_size);
+        rle_apply(rw->ring + key_entry->offset, key_entry->size, rw->key_state, rw->state_size);
+    }
+
+    /* Discard the future - the target becomes the newest frame */
+    while (rw->count > target + 1) {
+        rw->bytes_used -= rewind_entry(rw, rw->count - 1)->size;
+        rw->count--;
+    }
+    rw->since_key = target - key;
+    return 0;
+}
+
+size_t nes_rewind_count(const nes_rewind_t* rw) {
+    return rw->count;
+}
+
+size_t nes_rewind_bytes_used(const nes_rewind_t* rw) {
+    return rw->bytes_used;
+}
@@ -0,0 +1,77 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Rewind Module - Delta-Compressed Save-State History
+ *
+ * Records one snapshot per frame into a fixed-budget ring. Every
+ * keyframe_interval frames a keyframe is stored; the frames in between
+ * are XOR deltas against that keyframe. Both are run-length coded, so
+ * the mostly unchanged RAM/VRAM/OAM/palette cost almost nothing.
+ * When the budget is full the oldest keyframe and its deltas are dropped.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_REWIND_H
+#define NESPRESSO_REWIND_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Forward declarations */
+typedef struct nes_system nes_system_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NES_REWIND_DEFAULT_KEYFRAME_INTERVAL 60
+
+typedef struct nes_rewind nes_rewind_t;
+
+/**
+ * Create rewind history
+ * budget_bytes:      size of the compressed frame ring
+ * keyframe_interval: frames per keyframe (0 = default)
+ * Returns NULL on failure
+ */
+nes_rewind_t* nes_rewind_create(size_t budget_bytes, int keyframe_interval);
+
+/**
+ * Free rewind history
+ */
+void nes_rewind_destroy(nes_rewind_t* rw);
+
+/**
+ * Drop all recorded frames
+ */
+void nes_rewind_clear(nes_rewind_t* rw);
+
+/**
+ * Record the system's current state as the newest frame
+ * Returns 0 on success, -1 if a single frame does not fit in the budget
+ */
+int nes_rewind_push(nes_rewind_t* rw, nes_system_t* sys);
+
+/**
+ * Restore the state recorded frames_back frames ago (0 = newest) and
+ * discard everything newer, so recording continues from that point
+ * Returns 0 on success, -1 if not enough history is recorded
+ */
+int nes_rewind_seek(nes_rewind_t* rw, nes_system_t* sys, size_t frames_back);
+
+/**
+ * Number of frames currently recorded
+ */
+size_t nes_rewind_count(const nes_rewind_t* rw);
+
+/**
+ * Compressed bytes currently held in the ring
+ */
+size_t nes_rewind_bytes_used(const nes_rewind_t* rw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_REWIND_H */
@@ -0,0 +1,168 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Run-Ahead Module - Input Latency Reduction Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "runahead.h"
+#include "../memory/bus.h"
+#include "../apu/apu.h"
+#include "../cpu/cpu.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct nes_runahead {
+    nes_system_t*   sys;
+    int             frames;
+
+    /* sys right after its latest real frame */
+    size_t          state_size;
+    uint8_t*        state;
+
+    /* Second instance: the shadow's state after each frame it ran ahead,
+     * oldest first - the oldest is what sys's next real frame should match */
+    nes_system_t*   shadow;
+    uint8_t*        predicted;
+    int             predicted_first;
+    int             predicted_count;
+
+    uint64_t        resyncs;
+};
+
+static uint8_t* runahead_predicted(nes_runahead_t* ra, int index) {
+    return ra->predicted + (size_t)((ra->predicted_first + index) % ra->frames) * ra->state_size;
+}
+
+/* Run one ahead frame on sys, drawing it only if it is the one presented */
+static void runahead_step_ahead(nes_system_t* sys, int present) {
+    nes_sys_set_render(sys, present);
+    nes_sys_step_frame(sys);
+}
+
+/* Append the shadow's current state to the predictions */
+static void runahead_push_prediction(nes_runahead_t* ra) {
+    if (ra->predicted_count == ra->frames) {
+        ra->predicted_first = (ra->predicted_first + 1) % ra->frames;
+        ra->predicted_count--;
+    }
+    nes_sys_snapshot_to_buffer(ra->shadow, runahead_predicted(ra, ra->predicted_count), ra->state_size);
+    ra->predicted_count++;
+}
+
+nes_runahead_t* nes_runahead_create(nes_system_t* sys, int frames, int second_instance) {
+    if (!sys || !sys->cartridge || frames < 1 || frames > NES_RUNAHEAD_MAX_FRAMES) {
+        return NULL;
+    }
+
+    nes_runahead_t* ra = (nes_runahead_t*)calloc(1, sizeof(nes_runahead_t));
+    if (!ra) {
+        return NULL;
+    }
+    ra->sys = sys;
+    ra->frames = frames;
+    ra->state_size = nes_sys_snapshot_size(sys);
+    ra->state = (uint8_t*)malloc(ra->state_size);
+    if (!ra->state) {
+        free(ra);
+        return NULL;
+    }
+
+    if (second_instance) {
+        ra->shadow = (nes_system_t*)calloc(1, sizeof(nes_system_t));
+        ra->predicted = (uint8_t*)malloc((size_t)frames * ra->state_size);
+        if (!ra->shadow || !ra->predicted) {
+            free(ra->predicted);
+            free(ra->shadow);
+            free(ra->state);
+            free(ra);
+            return NULL;
+        }
+        if (nes_sys_init(ra->shadow) != 0 || nes_sys_load_shared(ra->shadow, sys->cartridge) != 0) {
+            nes_runahead_destroy(ra);
+            return NULL;
+        }
+
+        /* The shadow presents; sys only plays */
+        nes_sys_set_sync_mode(ra->shadow, sys->sync_mode);
+        nes_apu_set_synthesis(ra->shadow->apu, sys->apu->synth, sys->apu->sample_rate);
+        nes_cpu_set_idle_skip(ra->shadow->cpu, sys->cpu->idle_skip);
+        nes_sys_set_frame_sink(ra->shadow, &sys->frame_sink);
+        nes_sys_set_audio(ra->shadow, 0);
+    }
+    return ra;
+}
+
+void nes_runahead_destroy(nes_runahead_t* ra) {
+    if (!ra) {
+        return;
+    }
+    if (ra->shadow) {
+        nes_sys_free(ra->shadow);
+        free(ra->shadow);
+    }
+    nes_sys_set_render(ra->sys, 1);
+    nes_sys_set_audio(ra->sys, 1);
+    free(ra->predicted);
+    free(ra->state);
+    free(ra);
+}
+
+/* Run ahead on sys itself and roll it back */
+static int runahead_step_single(nes_runahead_t* ra) {
+    nes_system_t* sys = ra->sys;
+
+    nes_sys_set_audio(sys, 0);
+    for (int i = 1; i <= ra->frames; i++) {
+        runahead_step_ahead(sys, i == ra->frames);
+    }
+    nes_sys_set_audio(sys, 1);
+
+    ra->resyncs++;
+    return nes_sys_restore_from_buffer(sys, ra->state, ra->state_size);
+}
+
+/* Run ahead on the shadow, from sys's state only when the prediction missed */
+static int runahead_step_shadow(nes_runahead_t* ra) {
+    if (ra->predicted_count == ra->frames &&
+        memcmp(runahead_predicted(ra, 0), ra->state, ra->state_size) == 0) {
+        runahead_step_ahead(ra->shadow, 1);
+        runahead_push_prediction(ra);
+        return 0;
+    }
+
+    if (nes_sys_restore_from_buffer(ra->shadow, ra->state, ra->state_size) != 0) {
+        return -1;
+    }
+    ra->predicted_count = 0;
+    for (int i = 1; i <= ra->frames; i++) {
+        runahead_step_ahead(ra->shadow, i == ra->frames);
+        runahead_push_prediction(ra);
+    }
+    ra->resyncs++;
+    return 0;
+}
+
+int nes_runahead_step_frame(nes_runahead_t* ra) {
+    nes_system_t* sys = ra->sys;
+
+    /* The real frame: heard, not seen */
+    nes_sys_set_render(sys, 0);
+    if (!nes_sys_step_frame(sys)) {
+        return 0;
+    }
+    if (nes_sys_snapshot_to_buffer(sys, ra->state, ra->state_size) != ra->state_size) {
+        return -1;
+    }
+
+    int status = ra->shadow ? runahead_step_shadow(ra) : runahead_step_single(ra);
+    return status == 0 ? 1 : -1;
+}
+
+const uint8_t* nes_runahead_get_frame_buffer(nes_runahead_t* ra) {
+    return nes_sys_get_frame_buffer(ra->shadow ? ra->shadow : ra->sys);
+}
+
+uint64_t nes_runahead_resyncs(const nes_runahead_t* ra) {
+    return ra->resyncs;
+}
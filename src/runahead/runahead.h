@@ -0,0 +1,74 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Run-Ahead Module - Input Latency Reduction
+ *
+ * Each step runs one real frame with the current input, then emulates
+ * frames more frames with rendering and audio suppressed except for the
+ * last one, which is the frame presented. Games that react to input a frame
+ * or more late therefore show the reaction that many frames sooner.
+ *
+ * Without a second instance the extra frames run on the system itself,
+ * which is rolled back to a snapshot afterwards. With one, a shadow system
+ * sharing the cartridge runs ahead instead and is only resynchronized when
+ * the real frame did not turn out as it predicted (input changed, reset or
+ * state load), so while input is held each step costs one extra frame
+ * however far ahead it runs.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_RUNAHEAD_H
+#define NESPRESSO_RUNAHEAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Forward declarations */
+typedef struct nes_system nes_system_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NES_RUNAHEAD_MAX_FRAMES 8
+
+typedef struct nes_runahead nes_runahead_t;
+
+/**
+ * Create run-ahead for a system with a ROM loaded
+ * frames:          frames to run ahead (1 to NES_RUNAHEAD_MAX_FRAMES)
+ * second_instance: run ahead on a shadow system sharing sys's cartridge
+ * Call after setting up sys's frame sink, sync mode and synthesis - the
+ * shadow copies them. Returns NULL on failure
+ */
+nes_runahead_t* nes_runahead_create(nes_system_t* sys, int frames, int second_instance);
+
+/**
+ * Free run-ahead (and the shadow system); sys renders and plays audio again
+ */
+void nes_runahead_destroy(nes_runahead_t* ra);
+
+/**
+ * Run one real frame on sys, then present the frame that lies frames ahead
+ * The presented frame goes to the frame sink; sys's audio is the real frame's
+ * Returns 1 if a frame was run, 0 if sys is stopped or paused, -1 on failure
+ */
+int nes_runahead_step_frame(nes_runahead_t* ra);
+
+/**
+ * Palette indices of the last presented frame
+ */
+const uint8_t* nes_runahead_get_frame_buffer(nes_runahead_t* ra);
+
+/**
+ * Steps since creation that had to resynchronize the shadow system
+ * (every step without a second instance)
+ */
+uint64_t nes_runahead_resyncs(const nes_runahead_t* ra);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_RUNAHEAD_H */
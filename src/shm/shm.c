@@ -0,0 +1,313 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Shm Module - Shared-Memory Frame/Audio Ring Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "shm.h"
+#include "../ppu/ppu.h"
+#include "../apu/apu.h"
+#include "../util/atomic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SHM_ALIGN       64
+#define SHM_NAME_MAX    128
+#define SHM_LATEST_RETRIES 16
+
+struct nes_shm_ring {
+    uint8_t*            base;
+    size_t              size;
+    nes_shm_header_t*   header;
+    int                 producer;
+    char                name[SHM_NAME_MAX];
+#ifdef _WIN32
+    HANDLE              mapping;
+#endif
+};
+
+static size_t shm_align(size_t n) {
+    return (n + SHM_ALIGN - 1) & ~(size_t)(SHM_ALIGN - 1);
+}
+
+static nes_shm_slot_t* shm_slot(const nes_shm_ring_t* ring, uint64_t frame) {
+    const nes_shm_header_t* hdr = ring->header;
+    return (nes_shm_slot_t*)(ring->base + hdr->header_size +
+                             (size_t)(frame % hdr->slot_count) * hdr->slot_size);
+}
+
+/* Platform mapping */
+
+#ifdef _WIN32
+
+static int shm_map(nes_shm_ring_t* ring, size_t size, int create) {
+    char name[SHM_NAME_MAX + 8];
+    snprintf(name, sizeof(name), "Local\\%s", ring->name);
+
+    if (create) {
+        ring->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                           (DWORD)((uint64_t)size >> 32), (DWORD)size, name);
+    } else {
+        ring->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    }
+    if (!ring->mapping) {
+        return -1;
+    }
+
+    ring->base = (uint8_t*)MapViewOfFile(ring->mapping, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    if (!ring->base) {
+        CloseHandle(ring->mapping);
+        return -1;
+    }
+
+    MEMORY_BASIC_INFORMATION info;
+    VirtualQuery(ring->base, &info, sizeof(info));
+    ring->size = create ? size : (size_t)info.RegionSize;
+    return 0;
+}
+
+static void shm_unmap(nes_shm_ring_t* ring) {
+    UnmapViewOfFile(ring->base);
+    CloseHandle(ring->mapping);
+}
+
+#else
+
+static int shm_map(nes_shm_ring_t* ring, size_t size, int create) {
+    char name[SHM_NAME_MAX + 2];
+    snprintf(name, sizeof(name), "/%s", ring->name);
+
+    int fd;
+    if (create) {
+        shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            return -1;
+        }
+        if (ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            shm_unlink(name);
+            return -1;
+        }
+    } else {
+        fd = shm_open(name, O_RDONLY, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(nes_shm_header_t)) {
+            close(fd);
+            return -1;
+        }
+        size = (size_t)st.st_size;
+    }
+
+    void* base = mmap(NULL, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        if (create) {
+            shm_unlink(name);
+        }
+        return -1;
+    }
+
+    ring->base = (uint8_t*)base;
+    ring->size = size;
+    return 0;
+}
+
+static void shm_unmap(nes_shm_ring_t* ring) {
+    munmap(ring->base, ring->size);
+    if (ring->producer) {
+        char name[SHM_NAME_MAX + 2];
+        snprintf(name, sizeof(name), "/%s", ring->name);
+        shm_unlink(name);
+    }
+}
+
+#endif
+
+static nes_shm_ring_t* shm_alloc(const char* name, int producer) {
+    if (!name || !*name || strlen(name) >= SHM_NAME_MAX) {
+        return NULL;
+    }
+
+    nes_shm_ring_t* ring = (nes_shm_ring_t*)calloc(1, sizeof(nes_shm_ring_t));
+    if (ring) {
+        strcpy(ring->name, name);
+        ring->producer = producer;
+    }
+    return ring;
+}
+
+/* Public API Implementation */
+
+nes_shm_ring_t* nes_shm_ring_create(const char* name, uint32_t slots, uint32_t audio_capacity) {
+    nes_shm_ring_t* ring = shm_alloc(name, 1);
+    if (!ring) {
+        return NULL;
+    }
+
+    slots = slots ? slots : NES_SHM_DEFAULT_SLOTS;
+    audio_capacity = audio_capacity ? audio_capacity : NES_SHM_DEFAULT_AUDIO;
+
+    size_t header_size = shm_align(sizeof(nes_shm_header_t));
+    size_t pixels_offset = shm_align(sizeof(nes_shm_slot_t));
+    size_t audio_offset = shm_align(pixels_offset + PPU_WIDTH * PPU_HEIGHT);
+    size_t slot_size = shm_align(audio_offset + (size_t)audio_capacity * sizeof(float));
+
+    if (shm_map(ring, header_size + slot_size * slots, 1) != 0) {
+        free(ring);
+        return NULL;
+    }
+
+    /* Fresh mapping is zeroed: every slot reads as "not published" */
+    nes_shm_header_t* hdr = (nes_shm_header_t*)ring->base;
+    hdr->version = NES_SHM_VERSION;
+    hdr->header_size = (uint32_t)header_size;
+    hdr->slot_size = (uint32_t)slot_size;
+    hdr->slot_count = slots;
+    hdr->width = PPU_WIDTH;
+    hdr->height = PPU_HEIGHT;
+    hdr->audio_capacity = audio_capacity;
+    hdr->sample_rate = APU_SAMPLE_RATE;
+    hdr->pixels_offset = (uint32_t)pixels_offset;
+    hdr->audio_offset = (uint32_t)audio_offset;
+    nes_atomic_store_u32(&hdr->magic, NES_SHM_MAGIC);
+    ring->header = hdr;
+    return ring;
+}
+
+/* A stale or foreign segment must not make readers index past a slot or
+ * the mapping: the header, every slot and the pixel and audio areas inside
+ * each slot have to fit, with the slot's counters 8-byte aligned */
+static int shm_header_valid(const nes_shm_header_t* hdr, size_t size) {
+    if (size < sizeof(nes_shm_header_t) || nes_atomic_load_u32(&hdr->magic) != NES_SHM_MAGIC ||
+        hdr->version != NES_SHM_VERSION || hdr->slot_count == 0) {
+        return 0;
+    }
+    if (hdr->header_size < sizeof(nes_shm_header_t) || hdr->slot_size < sizeof(nes_shm_slot_t) ||
+        (hdr->header_size | hdr->slot_size) % sizeof(uint64_t) != 0 ||
+        (uint64_t)hdr->header_size + (uint64_t)hdr->slot_size * hdr->slot_count > size) {
+        return 0;
+    }
+    if (hdr->pixels_offset < sizeof(nes_shm_slot_t) ||
+        (uint64_t)hdr->pixels_offset + (uint64_t)hdr->width * hdr->height > hdr->slot_size) {
+        return 0;
+    }
+    return hdr->audio_offset >= sizeof(nes_shm_slot_t) && hdr->audio_offset % sizeof(float) == 0 &&
+           (uint64_t)hdr->audio_offset + (uint64_t)hdr->audio_capacity * sizeof(float) <= hdr->slot_size;
+}
+
+nes_shm_ring_t* nes_shm_ring_open(const char* name) {
+    nes_shm_ring_t* ring = shm_alloc(name, 0);
+    if (!ring) {
+        return NULL;
+    }
+    if (shm_map(ring, 0, 0) != 0) {
+        free(ring);
+        return NULL;
+    }
+
+    const nes_shm_header_t* hdr = (const nes_shm_header_t*)ring->base;
+    if (!shm_header_valid(hdr, ring->size)) {
+        shm_unmap(ring);
+        free(ring);
+        return NULL;
+    }
+
+    ring->header = (nes_shm_header_t*)hdr;
+    return ring;
+}
+
+void nes_shm_ring_close(nes_shm_ring_t* ring) {
+    if (!ring) {
+        return;
+    }
+    shm_unmap(ring);
+    free(ring);
+}
+
+const nes_shm_header_t* nes_shm_ring_header(const nes_shm_ring_t* ring) {
+    return ring->header;
+}
+
+uint64_t nes_shm_ring_publish(nes_shm_ring_t* ring, const uint8_t* pixels,
+                              const float* samples, uint32_t sample_count) {
+    nes_shm_header_t* hdr = ring->header;
+    uint64_t frame = hdr->published;
+    nes_shm_slot_t* slot = shm_slot(ring, frame);
+    uint8_t* data = (uint8_t*)slot;
+
+    if (sample_count > hdr->audio_capacity || !samples) {
+        sample_count = samples ? hdr->audio_capacity : 0;
+    }
+
+    /* Odd sequence: readers of the previous occupant see it change */
+    nes_atomic_store_u64(&slot->seq, 2 * frame + 1);
+    nes_atomic_fence_release();
+
+    slot->frame = frame;
+    slot->sample_count = sample_count;
+    memcpy(data + hdr->pixels_offset, pixels, (size_t)hdr->width * hdr->height);
+    if (sample_count) {
+        memcpy(data + hdr->audio_offset, samples, sample_count * sizeof(float));
+    }
+
+    nes_atomic_store_u64(&slot->seq, 2 * frame + 2);
+    nes_atomic_store_u64(&hdr->published, frame + 1);
+    return frame;
+}
+
+int nes_shm_ring_get(const nes_shm_ring_t* ring, uint64_t frame, nes_shm_frame_t* out) {
+    const nes_shm_header_t* hdr = ring->header;
+    const nes_shm_slot_t* slot = shm_slot(ring, frame);
+    const uint8_t* data = (const uint8_t*)slot;
+
+    uint64_t seq = nes_atomic_load_u64(&slot->seq);
+    if (seq != 2 * frame + 2) {
+        return -1;
+    }
+
+    uint32_t sample_count = slot->sample_count;
+    out->pixels = data + hdr->pixels_offset;
+    out->samples = (const float*)(data + hdr->audio_offset);
+    out->sample_count = sample_count <= hdr->audio_capacity ? sample_count : 0;
+    out->frame = frame;
+    out->slot = slot;
+    out->seq = seq;
+    return nes_shm_ring_valid(out) ? 0 : -1;
+}
+
+int nes_shm_ring_latest(const nes_shm_ring_t* ring, nes_shm_frame_t* out) {
+    /* Retry if the producer laps the slot between the two loads */
+    for (int attempt = 0; attempt < SHM_LATEST_RETRIES; attempt++) {
+        uint64_t published = nes_atomic_load_u64(&ring->header->published);
+        if (published == 0) {
+            return -1;
+        }
+        if (nes_shm_ring_get(ring, published - 1, out) == 0) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int nes_shm_ring_valid(const nes_shm_frame_t* view) {
+    nes_atomic_fence_acquire();
+    return view->slot->seq == view->seq;
+}
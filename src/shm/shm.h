@@ -0,0 +1,126 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Shm Module - Shared-Memory Frame/Audio Ring
+ *
+ * Publishes every completed frame's palette index buffer, its audio
+ * samples and a frame counter into a ring of slots in POSIX shared
+ * memory (a named file mapping on Windows). One emulator process writes;
+ * any number of consumer processes map the ring read-only and read the
+ * slots in place. Each slot carries a sequence word (odd while being
+ * written), so readers never block the writer and detect a slot that was
+ * overwritten while they were reading it.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_SHM_H
+#define NESPRESSO_SHM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NES_SHM_MAGIC           0x4D48534Eu  /* "NSHM" */
+#define NES_SHM_VERSION         1
+#define NES_SHM_DEFAULT_SLOTS   8
+#define NES_SHM_DEFAULT_AUDIO   1024         /* Samples per slot */
+
+/* Ring header at offset 0 of the mapping
+ * Slot i starts at header_size + i * slot_size and holds an nes_shm_slot_t
+ * followed by width * height index bytes at pixels_offset and up to
+ * audio_capacity float samples at audio_offset (both slot-relative) */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t slot_size;
+    uint32_t slot_count;
+    uint32_t width;
+    uint32_t height;
+    uint32_t audio_capacity;
+    uint32_t sample_rate;
+    uint32_t pixels_offset;
+    uint32_t audio_offset;
+    uint32_t reserved;
+    volatile uint64_t published;    /* Frames published so far */
+} nes_shm_header_t;
+
+typedef struct {
+    volatile uint64_t seq;          /* 2 * frame + 2 when frame is complete, odd while writing */
+    uint64_t          frame;        /* Frame counter (0-based publish index) */
+    uint32_t          sample_count;
+    uint32_t          reserved;
+} nes_shm_slot_t;
+
+typedef struct nes_shm_ring nes_shm_ring_t;
+
+/* In-place view of one published frame */
+typedef struct {
+    const uint8_t*  pixels;         /* width * height palette indices */
+    const float*    samples;
+    uint32_t        sample_count;
+    uint64_t        frame;
+    const nes_shm_slot_t* slot;     /* For nes_shm_ring_valid */
+    uint64_t        seq;
+} nes_shm_frame_t;
+
+/**
+ * Create (or replace) the named ring as its producer
+ * slots / audio_capacity: 0 = defaults
+ * Returns NULL on failure
+ */
+nes_shm_ring_t* nes_shm_ring_create(const char* name, uint32_t slots, uint32_t audio_capacity);
+
+/**
+ * Map an existing ring read-only as a consumer
+ * Returns NULL if it does not exist or has an incompatible layout
+ */
+nes_shm_ring_t* nes_shm_ring_open(const char* name);
+
+/**
+ * Unmap the ring; the producer also removes the name
+ */
+void nes_shm_ring_close(nes_shm_ring_t* ring);
+
+/**
+ * Ring header (layout, published counter)
+ */
+const nes_shm_header_t* nes_shm_ring_header(const nes_shm_ring_t* ring);
+
+/**
+ * Producer: publish one frame of palette indices and its audio
+ * Samples beyond the slot's audio capacity are dropped
+ * Returns the frame counter of the published frame
+ */
+uint64_t nes_shm_ring_publish(nes_shm_ring_t* ring, const uint8_t* pixels,
+                              const float* samples, uint32_t sample_count);
+
+/**
+ * Consumer: view frame number frame in place
+ * Returns 0 on success, -1 if it is not published yet or already overwritten
+ */
+int nes_shm_ring_get(const nes_shm_ring_t* ring, uint64_t frame, nes_shm_frame_t* out);
+
+/**
+ * Consumer: view the newest published frame
+ * Returns 0 on success, -1 if nothing has been published (or the
+ * producer kept overwriting the slot while it was being read)
+ */
+int nes_shm_ring_latest(const nes_shm_ring_t* ring, nes_shm_frame_t* out);
+
+/**
+ * Consumer: check after reading a view that the producer did not start
+ * overwriting it meanwhile
+ * Returns 1 if everything read from the view is consistent
+ */
+int nes_shm_ring_valid(const nes_shm_frame_t* view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_SHM_H */
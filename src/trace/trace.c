@@ -0,0 +1,205 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Trace Module - Ring-Buffered CPU/PPU Event Log Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "trace.h"
+#include "../util/atomic.h"
+#include "../util/ring.h"
+#include "../util/thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_DRAIN_BATCH   1024    /* Records per fwrite */
+#define TRACE_IDLE_MS       1       /* Writer back-off when the ring is empty */
+
+struct nes_trace {
+    /* Indices run freely and wrap; capacity is a power of two */
+    volatile uint32_t   write_index;    /* Stored by the producer only */
+    uint8_t             pad0[NES_RING_CACHE_LINE - sizeof(uint32_t)];
+    volatile uint32_t   read_index;     /* Stored by the consumer only */
+    uint8_t             pad1[NES_RING_CACHE_LINE - sizeof(uint32_t)];
+
+    nes_trace_record_t* records;
+    uint32_t            capacity;
+    uint32_t            mask;
+
+    /* Producer side */
+    uint32_t            lost;           /* Dropped since the last DROPPED record */
+    volatile uint64_t   dropped;        /* Dropped in total */
+    const uint32_t*     clock_cycle;
+    const uint16_t*     clock_scanline;
+    const uint16_t*     clock_dot;
+
+    /* File writer */
+    FILE*               file;
+    nes_thread_t        thread;
+    volatile uint32_t   stop;
+};
+
+nes_trace_t* nes_trace_create(uint32_t capacity) {
+    if (capacity == 0) {
+        capacity = NES_TRACE_DEFAULT_SIZE;
+    }
+    uint32_t size = 1;
+    while (size < capacity) {
+        if (size >= 0x80000000u) {
+            return NULL;
+        }
+        size <<= 1;
+    }
+
+    nes_trace_t* trace = (nes_trace_t*)calloc(1, sizeof(nes_trace_t));
+    if (!trace) {
+        return NULL;
+    }
+    trace->records = (nes_trace_record_t*)calloc(size, sizeof(nes_trace_record_t));
+    if (!trace->records) {
+        free(trace);
+        return NULL;
+    }
+    trace->capacity = size;
+    trace->mask = size - 1;
+    return trace;
+}
+
+void nes_trace_destroy(nes_trace_t* trace) {
+    if (!trace) {
+        return;
+    }
+    nes_trace_stop_file(trace);
+    free(trace->records);
+    free(trace);
+}
+
+void nes_trace_set_clock(nes_trace_t* trace, const uint32_t* cycle,
+                         const uint16_t* scanline, const uint16_t* dot) {
+    trace->clock_cycle = cycle;
+    trace->clock_scanline = scanline;
+    trace->clock_dot = dot;
+}
+
+/* Producer */
+
+void nes_trace_write(nes_trace_t* trace, const nes_trace_record_t* record) {
+    uint32_t write = trace->write_index;
+    uint32_t space = trace->capacity - (write - nes_atomic_load_u32(&trace->read_index));
+
+    /* A gap is reported in front of the first record that fits after it */
+    uint32_t need = trace->lost ? 2 : 1;
+    if (space < need) {
+        trace->lost++;
+        nes_atomic_store_u64(&trace->dropped, trace->dropped + 1);
+        return;
+    }
+
+    if (trace->lost) {
+        nes_trace_record_t* gap = &trace->records[write++ & trace->mask];
+        memset(gap, 0, sizeof(*gap));
+        gap->cycle = record->cycle;
+        gap->type = NES_TRACE_DROPPED;
+        gap->dropped.count = trace->lost;
+        trace->lost = 0;
+    }
+    trace->records[write++ & trace->mask] = *record;
+    nes_atomic_store_u32(&trace->write_index, write);
+}
+
+void nes_trace_event(nes_trace_t* trace, nes_trace_type_t type, uint16_t addr, uint8_t value) {
+    nes_trace_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.cycle = trace->clock_cycle ? *trace->clock_cycle : 0;
+    record.addr = addr;
+    record.type = (uint8_t)type;
+    record.value = value;
+    record.ppu.scanline = trace->clock_scanline ? *trace->clock_scanline : 0;
+    record.ppu.dot = trace->clock_dot ? *trace->clock_dot : 0;
+    nes_trace_write(trace, &record);
+}
+
+uint64_t nes_trace_dropped(const nes_trace_t* trace) {
+    return nes_atomic_load_u64(&trace->dropped);
+}
+
+/* Consumer */
+
+uint32_t nes_trace_read(nes_trace_t* trace, nes_trace_record_t* records, uint32_t count) {
+    uint32_t read = trace->read_index;
+    uint32_t queued = nes_atomic_load_u32(&trace->write_index) - read;
+    if (count > queued) {
+        count = queued;
+    }
+
+    uint32_t start = read & trace->mask;
+    uint32_t first = trace->capacity - start < count ? trace->capacity - start : count;
+    memcpy(records, trace->records + start, first * sizeof(nes_trace_record_t));
+    memcpy(records + first, trace->records, (count - first) * sizeof(nes_trace_record_t));
+
+    if (count) {
+        nes_atomic_store_u32(&trace->read_index, read + count);
+    }
+    return count;
+}
+
+/* File writer */
+
+/* Write everything queued; returns the number of records drained */
+static uint32_t trace_drain(nes_trace_t* trace) {
+    nes_trace_record_t batch[TRACE_DRAIN_BATCH];
+    uint32_t total = 0;
+    uint32_t count;
+    while ((count = nes_trace_read(trace, batch, TRACE_DRAIN_BATCH)) > 0) {
+        fwrite(batch, sizeof(nes_trace_record_t), count, trace->file);
+        total += count;
+    }
+    return total;
+}
+
+static void trace_writer_main(void* arg) {
+    nes_trace_t* trace = (nes_trace_t*)arg;
+    while (!nes_atomic_load_u32(&trace->stop)) {
+        if (trace_drain(trace) == 0) {
+            nes_thread_sleep_ms(TRACE_IDLE_MS);
+        }
+    }
+    trace_drain(trace);
+}
+
+int nes_trace_start_file(nes_trace_t* trace, const char* filename) {
+    if (trace->file) {
+        return -1;
+    }
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        return -1;
+    }
+    nes_trace_file_header_t header = { NES_TRACE_MAGIC, NES_TRACE_VERSION,
+                                       (uint32_t)sizeof(nes_trace_record_t), 0 };
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return -1;
+    }
+
+    trace->file = file;
+    nes_atomic_store_u32(&trace->stop, 0);
+    if (nes_thread_create(&trace->thread, trace_writer_main, trace) != 0) {
+        fclose(file);
+        trace->file = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void nes_trace_stop_file(nes_trace_t* trace) {
+    if (!trace->file) {
+        return;
+    }
+    nes_atomic_store_u32(&trace->stop, 1);
+    nes_thread_join(&trace->thread);
+    fclose(trace->file);
+    trace->file = NULL;
+}
@@ -0,0 +1,135 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Trace Module - Ring-Buffered CPU/PPU Event Log
+ *
+ * Fixed-size binary records of executed instructions, PPU register writes
+ * and mapper bank switches go into a per-instance single-producer
+ * single-consumer ring. The emulation thread only ever appends (records
+ * are dropped and counted when the ring is full); a writer thread started
+ * with nes_trace_start_file drains it to a file that nes_tracedump decodes.
+ *
+ * The hooks are compiled in only with NES_ENABLE_TRACE (CMake
+ * -DNESPRESSO_TRACE=ON, make TRACE=1). Without an attached trace each hook
+ * costs one NULL test.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_TRACE_H
+#define NESPRESSO_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef NES_ENABLE_TRACE
+#define NES_TRACE_ENABLED 1
+#define NES_TRACE(stmt) do { stmt; } while (0)
+#else
+#define NES_TRACE_ENABLED 0
+#define NES_TRACE(stmt) ((void)0)
+#endif
+
+#define NES_TRACE_MAGIC         0x4352544Eu  /* "NTRC" */
+#define NES_TRACE_VERSION       1
+#define NES_TRACE_DEFAULT_SIZE  (1u << 16)   /* Records */
+
+typedef enum {
+    NES_TRACE_CPU = 1,          /* Instruction about to execute */
+    NES_TRACE_PPU_WRITE,        /* CPU write to $2000-$2007 */
+    NES_TRACE_BANK_SWITCH,      /* Mapper bank register update */
+    NES_TRACE_DROPPED           /* Records lost at this point to a full ring */
+} nes_trace_type_t;
+
+/* One 16-byte record, written to files in host byte order */
+typedef struct {
+    uint32_t cycle;             /* CPU cycle_count */
+    uint16_t addr;              /* CPU: PC of the opcode; others: register address */
+    uint8_t  type;              /* nes_trace_type_t */
+    uint8_t  value;             /* CPU: opcode; others: byte written */
+    union {
+        struct {
+            uint8_t a, x, y, p, sp;
+            uint8_t reserved[3];
+        } cpu;
+        struct {
+            uint16_t scanline;  /* PPU position when the write landed */
+            uint16_t dot;
+            uint32_t reserved;
+        } ppu;
+        struct {
+            uint32_t count;     /* Records lost */
+            uint32_t reserved;
+        } dropped;
+    };
+} nes_trace_record_t;
+
+/* File header, followed by records until end of file */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+} nes_trace_file_header_t;
+
+typedef struct nes_trace nes_trace_t;
+
+/**
+ * Create a trace ring holding at least capacity records (0 = default)
+ * Returns NULL on failure
+ */
+nes_trace_t* nes_trace_create(uint32_t capacity);
+
+/**
+ * Stop the file writer, if any, and free the trace
+ */
+void nes_trace_destroy(nes_trace_t* trace);
+
+/**
+ * Counters that stamp PPU and bank switch records (any may be NULL)
+ * Set by nes_sys_set_trace; the PPU is caught up before either kind of write
+ */
+void nes_trace_set_clock(nes_trace_t* trace, const uint32_t* cycle,
+                         const uint16_t* scanline, const uint16_t* dot);
+
+/**
+ * Producer: append a record (dropped and counted when the ring is full)
+ */
+void nes_trace_write(nes_trace_t* trace, const nes_trace_record_t* record);
+
+/**
+ * Producer: append a PPU write or bank switch record stamped from the clock
+ */
+void nes_trace_event(nes_trace_t* trace, nes_trace_type_t type, uint16_t addr, uint8_t value);
+
+/**
+ * Consumer: remove up to count records
+ * Returns the number read; not for use while a file writer runs
+ */
+uint32_t nes_trace_read(nes_trace_t* trace, nes_trace_record_t* records, uint32_t count);
+
+/**
+ * Start a thread that drains the ring into filename
+ * Returns 0 on success, -1 on failure (or if a writer already runs)
+ */
+int nes_trace_start_file(nes_trace_t* trace, const char* filename);
+
+/**
+ * Drain what is left, then stop the writer thread and close its file
+ */
+void nes_trace_stop_file(nes_trace_t* trace);
+
+/**
+ * Records lost to a full ring so far
+ */
+uint64_t nes_trace_dropped(const nes_trace_t* trace);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_TRACE_H */
@@ -0,0 +1,118 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Trace Decoder
+ *
+ * Prints a binary trace written by nes_trace_start_file (headless
+ * --trace) as text, one record per line.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Local headers */
+#include "cpu/cpu.h"
+#include "trace/trace.h"
+
+/* Usage instructions */
+#define NES_TRACEDUMP_USAGE \
+    "Usage: nes_tracedump <trace.bin> [options]\n" \
+    "\n" \
+    "Options:\n" \
+    "  -n, --records N   Stop after N records\n" \
+    "  --no-cpu          Skip instruction records (PPU writes and bank switches only)\n" \
+    "  -h, --help        Show this help\n"
+
+/* One record as a line of text */
+static void tracedump_print(const nes_trace_record_t* rec) {
+    switch (rec->type) {
+        case NES_TRACE_CPU: {
+            const opcode_info_t* info = nes_cpu_opcode_info(rec->value);
+            printf("%10u  %04X  %02X %-4s A:%02X X:%02X Y:%02X P:%02X SP:%02X\n",
+                   rec->cycle, rec->addr, rec->value, info->mnemonic,
+                   rec->cpu.a, rec->cpu.x, rec->cpu.y, rec->cpu.p, rec->cpu.sp);
+            break;
+        }
+        case NES_TRACE_PPU_WRITE:
+            printf("%10u  PPU   $%04X <- %02X  line %3u dot %3u\n",
+                   rec->cycle, rec->addr, rec->value, rec->ppu.scanline, rec->ppu.dot);
+            break;
+        case NES_TRACE_BANK_SWITCH:
+            printf("%10u  BANK  $%04X <- %02X  line %3u dot %3u\n",
+                   rec->cycle, rec->addr, rec->value, rec->ppu.scanline, rec->ppu.dot);
+            break;
+        case NES_TRACE_DROPPED:
+            printf("%10u  ----  %u records dropped (ring full)\n", rec->cycle, rec->dropped.count);
+            break;
+        default:
+            printf("%10u  ?%u\n", rec->cycle, rec->type);
+            break;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* filename = NULL;
+    long limit = -1;
+    int show_cpu = 1;
+
+    /* Parse command line */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            printf("%s", NES_TRACEDUMP_USAGE);
+            return 0;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "--records") == 0) && i + 1 < argc) {
+            limit = strtol(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--no-cpu") == 0) {
+            show_cpu = 0;
+        } else if (argv[i][0] != '-') {
+            filename = argv[i];
+        }
+    }
+
+    if (!filename) {
+        fprintf(stderr, "Error: No trace file specified\n\n%s", NES_TRACEDUMP_USAGE);
+        return 1;
+    }
+
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", filename);
+        return 1;
+    }
+
+    nes_trace_file_header_t header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != NES_TRACE_MAGIC ||
+        header.version != NES_TRACE_VERSION || header.record_size != sizeof(nes_trace_record_t)) {
+        fprintf(stderr, "%s is not a version %d trace\n", filename, NES_TRACE_VERSION);
+        fclose(file);
+        return 1;
+    }
+
+    nes_trace_record_t batch[1024];
+    size_t count;
+    long printed = 0;
+    uint64_t dropped = 0;
+    while (limit != 0 && (count = fread(batch, sizeof(batch[0]), 1024, file)) > 0) {
+        for (size_t i = 0; i < count && printed != limit; i++) {
+            if (batch[i].type == NES_TRACE_DROPPED) {
+                dropped += batch[i].dropped.count;
+            } else if (batch[i].type == NES_TRACE_CPU && !show_cpu) {
+                continue;
+            }
+            tracedump_print(&batch[i]);
+            printed++;
+        }
+        if (printed == limit) {
+            break;
+        }
+    }
+    fclose(file);
+
+    if (dropped) {
+        fprintf(stderr, "%llu records were dropped while tracing\n", (unsigned long long)dropped);
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Atomics
+ *
+ * Acquire/release loads and stores and fences for lock-free structures
+ * shared between threads or processes (GCC/Clang builtins, MSVC intrinsics)
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_ATOMIC_H
+#define NESPRESSO_ATOMIC_H
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _MSC_VER
+
+/* x64 keeps loads and stores in order; ARM64 needs a barrier
+ * Plain accesses keep this usable on read-only mappings */
+static __inline void nes_atomic_fence_acquire(void) {
+#if defined(_M_ARM64)
+    __dmb(_ARM64_BARRIER_ISH);
+#else
+    _ReadWriteBarrier();
+#endif
+}
+
+static __inline void nes_atomic_fence_release(void) {
+#if defined(_M_ARM64)
+    __dmb(_ARM64_BARRIER_ISH);
+#else
+    _ReadWriteBarrier();
+#endif
+}
+
+static __inline uint32_t nes_atomic_load_u32(const volatile uint32_t* p) {
+    uint32_t v = *p;
+    nes_atomic_fence_acquire();
+    return v;
+}
+
+static __inline void nes_atomic_store_u32(volatile uint32_t* p, uint32_t v) {
+    nes_atomic_fence_release();
+    *p = v;
+}
+
+static __inline uint64_t nes_atomic_load_u64(const volatile uint64_t* p) {
+    uint64_t v = *p;
+    nes_atomic_fence_acquire();
+    return v;
+}
+
+static __inline void nes_atomic_store_u64(volatile uint64_t* p, uint64_t v) {
+    nes_atomic_fence_release();
+    *p = v;
+}
+
+/* Interlocked operations are full barriers */
+static __inline uint32_t nes_atomic_exchange_u32(volatile uint32_t* p, uint32_t v) {
+    return (uint32_t)_InterlockedExchange((volatile long*)p, (long)v);
+}
+
+static __inline uint32_t nes_atomic_fetch_or_u32(volatile uint32_t* p, uint32_t v) {
+    return (uint32_t)_InterlockedOr((volatile long*)p, (long)v);
+}
+
+#else
+
+/* Acquire load */
+static inline uint32_t nes_atomic_load_u32(const volatile uint32_t* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+/* Release store */
+static inline void nes_atomic_store_u32(volatile uint32_t* p, uint32_t v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline uint64_t nes_atomic_load_u64(const volatile uint64_t* p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void nes_atomic_store_u64(volatile uint64_t* p, uint64_t v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+/* Read-modify-write: acquires what the other side released and releases
+ * to it in one step */
+static inline uint32_t nes_atomic_exchange_u32(volatile uint32_t* p, uint32_t v) {
+    return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL);
+}
+
+static inline uint32_t nes_atomic_fetch_or_u32(volatile uint32_t* p, uint32_t v) {
+    return __atomic_fetch_or(p, v, __ATOMIC_ACQ_REL);
+}
+
+/* Order plain accesses after / before an atomic (seqlock readers / writers) */
+static inline void nes_atomic_fence_acquire(void) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static inline void nes_atomic_fence_release(void) {
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_ATOMIC_H */
@@ -0,0 +1,32 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - CRC32
+ *
+ * Standard CRC-32 (as in zip and the No-Intro/GoodNES databases), computed
+ * eight bytes at a time so library scans stay I/O bound
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_CRC32_H
+#define NESPRESSO_CRC32_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Continue a CRC32 over length more bytes; start with crc = 0
+ * Feeding data in pieces gives the same result as feeding it at once
+ */
+uint32_t nes_crc32_update(uint32_t crc, const void* data, size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_CRC32_H */
@@ -0,0 +1,87 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Lock-Free Sample Ring Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "ring.h"
+#include "atomic.h"
+#include <stdlib.h>
+#include <string.h>
+
+int nes_ring_init(nes_ring_t* ring, uint32_t capacity) {
+    memset(ring, 0, sizeof(nes_ring_t));
+
+    uint32_t size = 1;
+    while (size < capacity) {
+        if (size >= 0x80000000u) {
+            return -1;
+        }
+        size <<= 1;
+    }
+
+    ring->data = (float*)calloc(size, sizeof(float));
+    if (!ring->data) {
+        return -1;
+    }
+    ring->capacity = size;
+    ring->mask = size - 1;
+    return 0;
+}
+
+void nes_ring_free(nes_ring_t* ring) {
+    free(ring->data);
+    ring->data = NULL;
+    ring->capacity = 0;
+    ring->mask = 0;
+}
+
+/* Copy count samples between the ring and a buffer, splitting at the wrap */
+static void ring_copy_in(nes_ring_t* ring, uint32_t index, const float* src, uint32_t count) {
+    uint32_t start = index & ring->mask;
+    uint32_t first = ring->capacity - start < count ? ring->capacity - start : count;
+    memcpy(ring->data + start, src, first * sizeof(float));
+    memcpy(ring->data, src + first, (count - first) * sizeof(float));
+}
+
+static void ring_copy_out(const nes_ring_t* ring, uint32_t index, float* dst, uint32_t count) {
+    uint32_t start = index & ring->mask;
+    uint32_t first = ring->capacity - start < count ? ring->capacity - start : count;
+    memcpy(dst, ring->data + start, first * sizeof(float));
+    memcpy(dst + first, ring->data, (count - first) * sizeof(float));
+}
+
+uint32_t nes_ring_write(nes_ring_t* ring, const float* samples, uint32_t count) {
+    uint32_t write = ring->write_index;
+    uint32_t read = nes_atomic_load_u32(&ring->read_index);
+    uint32_t space = ring->capacity - (write - read);
+    if (count > space) {
+        count = space;
+    }
+    if (count) {
+        ring_copy_in(ring, write, samples, count);
+        nes_atomic_store_u32(&ring->write_index, write + count);
+    }
+    return count;
+}
+
+uint32_t nes_ring_read(nes_ring_t* ring, float* samples, uint32_t count) {
+    uint32_t read = ring->read_index;
+    uint32_t write = nes_atomic_load_u32(&ring->write_index);
+    uint32_t queued = write - read;
+    if (count > queued) {
+        count = queued;
+    }
+    if (count) {
+        ring_copy_out(ring, read, samples, count);
+        nes_atomic_store_u32(&ring->read_index, read + count);
+    }
+    return count;
+}
+
+uint32_t nes_ring_available(const nes_ring_t* ring) {
+    uint32_t read = nes_atomic_load_u32(&ring->read_index);
+    uint32_t write = nes_atomic_load_u32(&ring->write_index);
+    return write - read;
+}
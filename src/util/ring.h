@@ -0,0 +1,69 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Lock-Free Sample Ring
+ *
+ * Single-producer single-consumer ring of float samples. The emulation
+ * thread writes and the audio callback reads; each side only stores its
+ * own index, so neither ever takes a lock or waits on the other.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_RING_H
+#define NESPRESSO_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NES_RING_CACHE_LINE 64
+
+typedef struct {
+    /* Indices run freely and wrap; capacity is a power of two */
+    volatile uint32_t write_index;      /* Stored by the producer only */
+    uint8_t           pad0[NES_RING_CACHE_LINE - sizeof(uint32_t)];
+    volatile uint32_t read_index;       /* Stored by the consumer only */
+    uint8_t           pad1[NES_RING_CACHE_LINE - sizeof(uint32_t)];
+
+    float*            data;
+    uint32_t          capacity;
+    uint32_t          mask;
+} nes_ring_t;
+
+/**
+ * Allocate a ring holding at least capacity samples (rounded up to a power of two)
+ * Returns 0 on success, -1 on failure
+ */
+int nes_ring_init(nes_ring_t* ring, uint32_t capacity);
+
+/**
+ * Free the ring's storage
+ */
+void nes_ring_free(nes_ring_t* ring);
+
+/**
+ * Producer: append up to count samples
+ * Returns the number written (less than count when the ring is full)
+ */
+uint32_t nes_ring_write(nes_ring_t* ring, const float* samples, uint32_t count);
+
+/**
+ * Consumer: remove up to count samples
+ * Returns the number read (less than count on underrun)
+ */
+uint32_t nes_ring_read(nes_ring_t* ring, float* samples, uint32_t count);
+
+/**
+ * Samples currently queued (exact on either side, a snapshot elsewhere)
+ */
+uint32_t nes_ring_available(const nes_ring_t* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_RING_H */
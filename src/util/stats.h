@@ -0,0 +1,24 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Build-Time Performance Counters
+ *
+ * Counters are compiled in only with NES_ENABLE_STATS (CMake
+ * -DNESPRESSO_STATS=ON, make STATS=1); otherwise NES_STAT() expands to
+ * nothing and the hot paths are unchanged. Read them with nes_sys_get_stats().
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_STATS_H
+#define NESPRESSO_STATS_H
+
+#ifdef NES_ENABLE_STATS
+#define NES_STATS_ENABLED 1
+#define NES_STAT(stmt) do { stmt; } while (0)
+#else
+#define NES_STATS_ENABLED 0
+#define NES_STAT(stmt) ((void)0)
+#endif
+
+#endif /* NESPRESSO_STATS_H */
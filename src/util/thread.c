@@ -0,0 +1,146 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Threads and Synchronization Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "thread.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_trampoline(LPVOID param) {
+    nes_thread_t* thread = (nes_thread_t*)param;
+    thread->func(thread->arg);
+    return 0;
+}
+
+int nes_thread_create(nes_thread_t* thread, nes_thread_func_t func, void* arg) {
+    thread->func = func;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, thread_trampoline, thread, 0, NULL);
+    return thread->handle ? 0 : -1;
+}
+
+void nes_thread_join(nes_thread_t* thread) {
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    thread->handle = NULL;
+}
+
+int nes_thread_cpu_count(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+void nes_thread_sleep_ms(unsigned ms) {
+    Sleep(ms);
+}
+
+int nes_mutex_init(nes_mutex_t* mutex) {
+    InitializeCriticalSection(mutex);
+    return 0;
+}
+
+void nes_mutex_destroy(nes_mutex_t* mutex) {
+    DeleteCriticalSection(mutex);
+}
+
+void nes_mutex_lock(nes_mutex_t* mutex) {
+    EnterCriticalSection(mutex);
+}
+
+void nes_mutex_unlock(nes_mutex_t* mutex) {
+    LeaveCriticalSection(mutex);
+}
+
+int nes_cond_init(nes_cond_t* cond) {
+    InitializeConditionVariable(cond);
+    return 0;
+}
+
+void nes_cond_destroy(nes_cond_t* cond) {
+    (void)cond;  /* Win32 condition variables need no cleanup */
+}
+
+void nes_cond_wait(nes_cond_t* cond, nes_mutex_t* mutex) {
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+
+void nes_cond_signal(nes_cond_t* cond) {
+    WakeConditionVariable(cond);
+}
+
+void nes_cond_broadcast(nes_cond_t* cond) {
+    WakeAllConditionVariable(cond);
+}
+
+#else
+
+static void* thread_trampoline(void* param) {
+    nes_thread_t* thread = (nes_thread_t*)param;
+    thread->func(thread->arg);
+    return NULL;
+}
+
+int nes_thread_create(nes_thread_t* thread, nes_thread_func_t func, void* arg) {
+    thread->func = func;
+    thread->arg = arg;
+    return pthread_create(&thread->handle, NULL, thread_trampoline, thread) == 0 ? 0 : -1;
+}
+
+void nes_thread_join(nes_thread_t* thread) {
+    pthread_join(thread->handle, NULL);
+}
+
+int nes_thread_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+void nes_thread_sleep_ms(unsigned ms) {
+    usleep((useconds_t)ms * 1000);
+}
+
+int nes_mutex_init(nes_mutex_t* mutex) {
+    return pthread_mutex_init(mutex, NULL) == 0 ? 0 : -1;
+}
+
+void nes_mutex_destroy(nes_mutex_t* mutex) {
+    pthread_mutex_destroy(mutex);
+}
+
+void nes_mutex_lock(nes_mutex_t* mutex) {
+    pthread_mutex_lock(mutex);
+}
+
+void nes_mutex_unlock(nes_mutex_t* mutex) {
+    pthread_mutex_unlock(mutex);
+}
+
+int nes_cond_init(nes_cond_t* cond) {
+    return pthread_cond_init(cond, NULL) == 0 ? 0 : -1;
+}
+
+void nes_cond_destroy(nes_cond_t* cond) {
+    pthread_cond_destroy(cond);
+}
+
+void nes_cond_wait(nes_cond_t* cond, nes_mutex_t* mutex) {
+    pthread_cond_wait(cond, mutex);
+}
+
+void nes_cond_signal(nes_cond_t* cond) {
+    pthread_cond_signal(cond);
+}
+
+void nes_cond_broadcast(nes_cond_t* cond) {
+    pthread_cond_broadcast(cond);
+}
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Threads and Synchronization
+ *
+ * Thin portable wrapper over pthreads / Win32 used by the instance pool
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_THREAD_H
+#define NESPRESSO_THREAD_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*nes_thread_func_t)(void* arg);
+
+/* Thread handle - must stay at a fixed address until joined */
+typedef struct {
+#ifdef _WIN32
+    HANDLE              handle;
+#else
+    pthread_t           handle;
+#endif
+    nes_thread_func_t   func;
+    void*               arg;
+} nes_thread_t;
+
+#ifdef _WIN32
+typedef CRITICAL_SECTION   nes_mutex_t;
+typedef CONDITION_VARIABLE nes_cond_t;
+#else
+typedef pthread_mutex_t    nes_mutex_t;
+typedef pthread_cond_t     nes_cond_t;
+#endif
+
+/**
+ * Start a thread running func(arg)
+ * Returns 0 on success, -1 on failure
+ */
+int nes_thread_create(nes_thread_t* thread, nes_thread_func_t func, void* arg);
+
+/**
+ * Wait for a thread to finish
+ */
+void nes_thread_join(nes_thread_t* thread);
+
+/**
+ * Number of online logical CPUs (at least 1)
+ */
+int nes_thread_cpu_count(void);
+
+/**
+ * Sleep the calling thread for at least ms milliseconds
+ */
+void nes_thread_sleep_ms(unsigned ms);
+
+/* Mutex */
+int nes_mutex_init(nes_mutex_t* mutex);
+void nes_mutex_destroy(nes_mutex_t* mutex);
+void nes_mutex_lock(nes_mutex_t* mutex);
+void nes_mutex_unlock(nes_mutex_t* mutex);
+
+/* Condition variable */
+int nes_cond_init(nes_cond_t* cond);
+void nes_cond_destroy(nes_cond_t* cond);
+void nes_cond_wait(nes_cond_t* cond, nes_mutex_t* mutex);
+void nes_cond_signal(nes_cond_t* cond);
+void nes_cond_broadcast(nes_cond_t* cond);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_THREAD_H */
@@ -0,0 +1,37 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Monotonic Timer Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "timer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+uint64_t nes_timer_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq = {0};
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&now);
+    /* Split to avoid overflowing the multiplication */
+    uint64_t sec = (uint64_t)(now.QuadPart / freq.QuadPart);
+    uint64_t rem = (uint64_t)(now.QuadPart % freq.QuadPart);
+    return sec * 1000000000ULL + rem * 1000000000ULL / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+uint64_t nes_timer_now_us(void) {
+    return nes_timer_now_ns() / 1000;
+}
@@ -0,0 +1,34 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Monotonic Timer
+ *
+ * SDL-free high resolution clock used by the headless runner and tools
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_TIMER_H
+#define NESPRESSO_TIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Get monotonic time in nanoseconds (arbitrary epoch)
+ */
+uint64_t nes_timer_now_ns(void);
+
+/**
+ * Get monotonic time in microseconds (arbitrary epoch)
+ */
+uint64_t nes_timer_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_TIMER_H */
@@ -0,0 +1,54 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Lock-Free Triple Buffer Implementation
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ */
+
+#include "triple.h"
+#include "atomic.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define NES_TRIPLE_INDEX 0x3u
+#define NES_TRIPLE_FRESH 0x4u
+
+int nes_triple_init(nes_triple_t* triple, size_t slot_size) {
+    memset(triple, 0, sizeof(nes_triple_t));
+
+    triple->data = (uint8_t*)calloc(3, slot_size);
+    if (!triple->data) {
+        return -1;
+    }
+    triple->slot_size = slot_size;
+    triple->back = 0;
+    triple->middle = 1;
+    triple->front = 2;
+    return 0;
+}
+
+void nes_triple_free(nes_triple_t* triple) {
+    free(triple->data);
+    triple->data = NULL;
+    triple->slot_size = 0;
+}
+
+void* nes_triple_write_buffer(nes_triple_t* triple) {
+    return triple->data + triple->back * triple->slot_size;
+}
+
+void nes_triple_publish(nes_triple_t* triple) {
+    /* Swap the finished slot into the middle; the one it replaces is either
+     * a frame nobody took or the slot the consumer just let go of */
+    uint32_t old = nes_atomic_exchange_u32(&triple->middle, triple->back | NES_TRIPLE_FRESH);
+    triple->back = old & NES_TRIPLE_INDEX;
+}
+
+const void* nes_triple_read(nes_triple_t* triple) {
+    if (!(nes_atomic_load_u32(&triple->middle) & NES_TRIPLE_FRESH)) {
+        return NULL;
+    }
+    uint32_t old = nes_atomic_exchange_u32(&triple->middle, triple->front);
+    triple->front = old & NES_TRIPLE_INDEX;
+    return triple->data + triple->front * triple->slot_size;
+}
@@ -0,0 +1,71 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Util Module - Lock-Free Triple Buffer
+ *
+ * Hands whole frames from one producer to one consumer. The producer always
+ * has a slot to draw into and the consumer always has the newest finished
+ * one to show, so neither side ever waits on the other; frames the consumer
+ * was too slow to pick up are simply overwritten.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#ifndef NESPRESSO_TRIPLE_H
+#define NESPRESSO_TRIPLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NES_TRIPLE_CACHE_LINE 64
+
+typedef struct {
+    /* Slot between the two sides (bits 0-1) and whether it holds a frame
+     * the consumer has not taken yet (NES_TRIPLE_FRESH) */
+    volatile uint32_t middle;
+    uint8_t           pad0[NES_TRIPLE_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t          back;             /* Producer only */
+    uint8_t           pad1[NES_TRIPLE_CACHE_LINE - sizeof(uint32_t)];
+    uint32_t          front;            /* Consumer only */
+    uint8_t           pad2[NES_TRIPLE_CACHE_LINE - sizeof(uint32_t)];
+
+    uint8_t*          data;
+    size_t            slot_size;
+} nes_triple_t;
+
+/**
+ * Allocate three slots of slot_size bytes
+ * Returns 0 on success, -1 on failure
+ */
+int nes_triple_init(nes_triple_t* triple, size_t slot_size);
+
+/**
+ * Free the slots
+ */
+void nes_triple_free(nes_triple_t* triple);
+
+/**
+ * Producer: the slot to write the next frame into
+ */
+void* nes_triple_write_buffer(nes_triple_t* triple);
+
+/**
+ * Producer: publish the write buffer as the newest frame and take another
+ */
+void nes_triple_publish(nes_triple_t* triple);
+
+/**
+ * Consumer: the newest frame if one was published since the last call,
+ * otherwise NULL. The frame stays valid until the next call
+ */
+const void* nes_triple_read(nes_triple_t* triple);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESPRESSO_TRIPLE_H */
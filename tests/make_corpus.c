@@ -0,0 +1,602 @@
+/**
+ * NESPRESSO - NES Emulator
+ * Regression Corpus Generator
+ *
+ * Writes the test ROMs that tests/corpus/corpus.txt replays through
+ * nes_bench. Each is one small program, built for NROM, MMC1 and MMC3: it
+ * draws two nametables, splits the screen on sprite 0 hit to scroll the rest
+ * of the frame, moves a row of sprites with controller 1 and plays both
+ * pulse channels, the triangle and the noise channel. The MMC1 and MMC3
+ * builds switch PRG banks every few frames and take their notes from the
+ * banked data; MMC3 also animates its sprite CHR banks and splits once more
+ * from its scanline IRQ. The ROMs are assembled here rather than checked in,
+ * so the corpus carries no binaries and can be rebuilt anywhere.
+ *
+ * Copyright (c) 2025 NESPRESSO Team
+ * Brewing Nostalgia One Frame at a Time!
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Usage instructions */
+#define NES_MAKE_CORPUS_USAGE \
+    "Usage: nes_make_corpus <dir>\n" \
+    "\n" \
+    "Writes nrom.nes, mmc1.nes and mmc3.nes into dir.\n"
+
+#define GEN_CODE_ORG        0xE000      /* Program in the last 8KB of PRG-ROM */
+#define GEN_CODE_SIZE       0x2000
+#define GEN_MAX_LABELS      64
+#define GEN_MAX_FIXUPS      128
+#define GEN_PATH_MAX        1024
+
+/* 6502 opcodes used by the program */
+enum {
+    OP_ADC_IMM  = 0x69, OP_AND_IMM  = 0x29, OP_BCC      = 0x90, OP_BEQ      = 0xF0,
+    OP_BIT_ABS  = 0x2C, OP_BNE      = 0xD0, OP_BPL      = 0x10, OP_BVC      = 0x50,
+    OP_BVS      = 0x70, OP_CLC      = 0x18, OP_CLD      = 0xD8, OP_CLI      = 0x58,
+    OP_CPX_IMM  = 0xE0, OP_DEC_ZP   = 0xC6, OP_DEX      = 0xCA, OP_DEY      = 0x88,
+    OP_INC_ZP   = 0xE6, OP_INX      = 0xE8, OP_JMP_ABS  = 0x4C, OP_LDA_ABS  = 0xAD,
+    OP_LDA_ABSX = 0xBD, OP_LDA_IMM  = 0xA9, OP_LDA_ZP   = 0xA5, OP_LDX_IMM  = 0xA2,
+    OP_LDY_IMM  = 0xA0, OP_LSR_A    = 0x4A, OP_PHA      = 0x48, OP_PLA      = 0x68,
+    OP_ROL_ZP   = 0x26, OP_RTI      = 0x40, OP_SEI      = 0x78, OP_STA_ABS  = 0x8D,
+    OP_STA_ABSX = 0x9D, OP_STA_ZP   = 0x85, OP_STA_ZPX  = 0x95, OP_TAX      = 0xAA,
+    OP_TAY      = 0xA8, OP_TXA      = 0x8A, OP_TXS      = 0x9A, OP_TYA      = 0x98
+};
+
+/* Zero-page variables */
+#define ZP_FRAME            0x10        /* Frame counter, bumped by NMI */
+#define ZP_NMI              0x11        /* Set by NMI, cleared by the main loop */
+#define ZP_PAD              0x12        /* Controller 1: A B Select Start Up Down Left Right, bit 7 first */
+#define ZP_SPRITE_X         0x13
+#define ZP_SPRITE_Y         0x14
+#define ZP_SCROLL           0x15        /* X scroll below the sprite 0 split */
+#define ZP_TEMP             0x16
+#define ZP_PITCH            0x17        /* Pulse 1 period of the current note */
+
+/* Sprite 0 sits on line 40 at x 128, over a row of background tiles */
+#define GEN_SPRITE0_Y       39
+#define GEN_SPRITE0_X       128
+#define GEN_IRQ_LINES       95          /* MMC3 splits again this many lines down */
+
+typedef struct {
+    const char* name;
+    int         mapper;
+    int         prg_banks;              /* 16KB */
+    int         chr_banks;              /* 8KB */
+} gen_rom_t;
+
+static const gen_rom_t g_roms[] = {
+    { "nrom", 0, 2, 1 },
+    { "mmc1", 1, 4, 1 },
+    { "mmc3", 4, 4, 4 },
+};
+
+/* Pulse periods (low byte) of the tune, rotated per PRG bank */
+static const uint8_t g_notes[8] = { 0xFD, 0xE1, 0xC9, 0xBD, 0xA9, 0x96, 0x86, 0x7E };
+
+static const uint8_t g_palette[32] = {
+    0x0F, 0x01, 0x11, 0x21, 0x0F, 0x06, 0x16, 0x26, 0x0F, 0x09, 0x19, 0x29, 0x0F, 0x04, 0x14, 0x24,
+    0x0F, 0x30, 0x27, 0x17, 0x0F, 0x30, 0x2A, 0x1A, 0x0F, 0x30, 0x22, 0x12, 0x0F, 0x30, 0x28, 0x18,
+};
+
+/* Tiny assembler: code for $E000-$FFFF, labels resolved at the end */
+typedef struct {
+    uint8_t     code[GEN_CODE_SIZE];
+    uint16_t    pc;                     /* Offset into code */
+    int32_t     labels[GEN_MAX_LABELS]; /* Address, -1 = not placed yet */
+    int         label_count;
+    struct {
+        uint16_t    at;
+        uint8_t     label;
+        uint8_t     relative;
+    } fixups[GEN_MAX_FIXUPS];
+    int         fixup_count;
+    int         overflow;               /* Out of labels or fixups */
+} gen_asm_t;
+
+static void gen_byte(gen_asm_t* a, uint8_t val) {
+    if (a->pc >= GEN_CODE_SIZE) {
+        a->overflow = 1;
+        return;
+    }
+    a->code[a->pc++] = val;
+}
+
+static void gen_op(gen_asm_t* a, uint8_t op) {
+    gen_byte(a, op);
+}
+
+/* Opcode with an immediate or zero-page operand */
+static void gen_op8(gen_asm_t* a, uint8_t op, uint8_t val) {
+    gen_byte(a, op);
+    gen_byte(a, val);
+}
+
+/* Opcode with an absolute operand */
+static void gen_op16(gen_asm_t* a, uint8_t op, uint16_t addr) {
+    gen_byte(a, op);
+    gen_byte(a, (uint8_t)addr);
+    gen_byte(a, (uint8_t)(addr >> 8));
+}
+
+static int gen_new_label(gen_asm_t* a) {
+    if (a->label_count == GEN_MAX_LABELS) {
+        a->overflow = 1;
+        return 0;
+    }
+    a->labels[a->label_count] = -1;
+    return a->label_count++;
+}
+
+static void gen_place(gen_asm_t* a, int label) {
+    a->labels[label] = GEN_CODE_ORG + a->pc;
+}
+
+static void gen_fixup(gen_asm_t* a, int label, int relative) {
+    if (a->fixup_count == GEN_MAX_FIXUPS) {
+        a->overflow = 1;
+        return;
+    }
+    a->fixups[a->fixup_count].at = a->pc;
+    a->fixups[a->fixup_count].label = (uint8_t)label;
+    a->fixups[a->fixup_count].relative = (uint8_t)relative;
+    a->fixup_count++;
+}
+
+/* Absolute operand (JMP, LDA abs,X) naming a label */
+static void gen_op_label(gen_asm_t* a, uint8_t op, int label) {
+    gen_byte(a, op);
+    gen_fixup(a, label, 0);
+    gen_byte(a, 0);
+    gen_byte(a, 0);
+}
+
+static void gen_branch(gen_asm_t* a, uint8_t op, int label) {
+    gen_byte(a, op);
+    gen_fixup(a, label, 1);
+    gen_byte(a, 0);
+}
+
+static void gen_data(gen_asm_t* a, const uint8_t* data, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        gen_byte(a, data[i]);
+    }
+}
+
+/* Resolve labels; returns 0 on success, -1 if the program is broken */
+static int gen_link(gen_asm_t* a) {
+    if (a->overflow || a->pc > GEN_CODE_SIZE - 6) {
+        return -1;
+    }
+    for (int i = 0; i < a->fixup_count; i++) {
+        int32_t target = a->labels[a->fixups[i].label];
+        uint16_t at = a->fixups[i].at;
+        if (target < 0) {
+            return -1;
+        }
+        if (a->fixups[i].relative) {
+            int32_t offset = target - (GEN_CODE_ORG + at + 1);
+            if (offset < -128 || offset > 127) {
+                return -1;
+            }
+            a->code[at] = (uint8_t)offset;
+        } else {
+            a->code[at] = (uint8_t)target;
+            a->code[at + 1] = (uint8_t)(target >> 8);
+        }
+    }
+    return 0;
+}
+
+/* LDA #val / STA addr */
+static void gen_store(gen_asm_t* a, uint16_t addr, uint8_t val) {
+    gen_op8(a, OP_LDA_IMM, val);
+    gen_op16(a, OP_STA_ABS, addr);
+}
+
+/* Shift A into an MMC1 register, low bit first */
+static void gen_mmc1_write(gen_asm_t* a, uint16_t addr) {
+    for (int bit = 0; bit < 5; bit++) {
+        if (bit > 0) {
+            gen_op(a, OP_LSR_A);
+        }
+        gen_op16(a, OP_STA_ABS, addr);
+    }
+}
+
+/* A = (ZP_FRAME >> shift) & mask */
+static void gen_frame_bits(gen_asm_t* a, int shift, uint8_t mask) {
+    gen_op8(a, OP_LDA_ZP, ZP_FRAME);
+    for (int i = 0; i < shift; i++) {
+        gen_op(a, OP_LSR_A);
+    }
+    gen_op8(a, OP_AND_IMM, mask);
+}
+
+/* STA addr on frames where (ZP_FRAME & mask) == 0, A = val */
+static void gen_store_every(gen_asm_t* a, uint16_t addr, uint8_t val, uint8_t mask) {
+    int skip = gen_new_label(a);
+    gen_op8(a, OP_LDA_ZP, ZP_FRAME);
+    gen_op8(a, OP_AND_IMM, mask);
+    gen_branch(a, OP_BNE, skip);
+    gen_store(a, addr, val);
+    gen_place(a, skip);
+}
+
+/* Wait for the start of VBlank */
+static void gen_wait_vblank(gen_asm_t* a) {
+    int wait = gen_new_label(a);
+    gen_place(a, wait);
+    gen_op16(a, OP_BIT_ABS, 0x2002);
+    gen_branch(a, OP_BPL, wait);
+}
+
+static void gen_mapper_init(gen_asm_t* a, int mapper) {
+    static const uint8_t mmc3_banks[8] = { 0, 2, 8, 9, 10, 11, 0, 1 };
+
+    switch (mapper) {
+        case 1:
+            gen_store(a, 0x8000, 0x80);                 /* Reset the shift register */
+            gen_op8(a, OP_LDA_IMM, 0x0E);               /* Fix last bank, 8KB CHR */
+            gen_mmc1_write(a, 0x8000);
+            gen_op8(a, OP_LDA_IMM, 0x00);
+            gen_mmc1_write(a, 0xA000);
+            gen_op8(a, OP_LDA_IMM, 0x00);
+            gen_mmc1_write(a, 0xE000);
+            break;
+
+        case 4:
+            for (int reg = 0; reg < 8; reg++) {
+                gen_store(a, 0x8000, (uint8_t)reg);
+                gen_store(a, 0x8001, mmc3_banks[reg]);
+            }
+            gen_store(a, 0xA000, 0x00);                 /* Vertical mirroring */
+            break;
+    }
+}
+
+/* Pick this frame's note into ZP_PITCH, switching banks where there are any */
+static void gen_mapper_frame(gen_asm_t* a, int mapper, int notes) {
+    switch (mapper) {
+        case 1:
+            gen_frame_bits(a, 4, 3);                    /* PRG bank at $8000 */
+            gen_mmc1_write(a, 0xE000);
+            break;
+
+        case 4:
+            gen_store(a, 0x8000, 6);                    /* R6: PRG bank at $8000 */
+            gen_frame_bits(a, 4, 3);
+            gen_op16(a, OP_STA_ABS, 0x8001);
+            gen_store(a, 0x8000, 2);                    /* R2: sprite tiles */
+            gen_frame_bits(a, 3, 7);
+            gen_op(a, OP_CLC);
+            gen_op8(a, OP_ADC_IMM, 8);
+            gen_op16(a, OP_STA_ABS, 0x8001);
+            gen_store(a, 0xC000, GEN_IRQ_LINES);
+            gen_op16(a, OP_STA_ABS, 0xC001);
+            gen_op16(a, OP_STA_ABS, 0xE001);
+            break;
+    }
+
+    gen_frame_bits(a, 1, 7);
+    gen_op(a, OP_TAX);
+    if (mapper == 0) {
+        gen_op_label(a, OP_LDA_ABSX, notes);
+    } else {
+        gen_op16(a, OP_LDA_ABSX, 0x8000);               /* Notes at the start of every bank */
+    }
+    gen_op8(a, OP_STA_ZP, ZP_PITCH);
+}
+
+static void gen_audio(gen_asm_t* a) {
+    /* Pulse 1: the tune */
+    gen_store(a, 0x4000, 0x9F);
+    gen_op8(a, OP_LDA_ZP, ZP_PITCH);
+    gen_op16(a, OP_STA_ABS, 0x4002);
+    gen_store_every(a, 0x4003, 0x01, 0x0F);
+
+    /* Pulse 2: a sweep down from the frame counter */
+    gen_store(a, 0x4004, 0x5A);
+    gen_op8(a, OP_LDA_ZP, ZP_FRAME);
+    gen_op16(a, OP_STA_ABS, 0x4006);
+    gen_store_every(a, 0x4007, 0x02, 0x07);
+
+    /* Triangle an octave below the tune */
+    gen_store(a, 0x4008, 0xFF);
+    gen_op8(a, OP_LDA_ZP, ZP_PITCH);
+    gen_op(a, OP_LSR_A);
+    gen_op16(a, OP_STA_ABS, 0x400A);
+    gen_store_every(a, 0x400B, 0x03, 0x1F);
+
+    /* Noise */
+    gen_store(a, 0x400C, 0x36);
+    gen_frame_bits(a, 0, 0x0F);
+    gen_op16(a, OP_STA_ABS, 0x400E);
+    gen_store_every(a, 0x400F, 0x08, 0x07);
+}
+
+/* Assemble the program for one mapper */
+static int gen_program(gen_asm_t* a, int mapper) {
+    memset(a, 0, sizeof(*a));
+    int reset = gen_new_label(a);
+    int nmi = gen_new_label(a);
+    int irq = gen_new_label(a);
+    int palette = gen_new_label(a);
+    int notes = gen_new_label(a);
+
+    /* Power on: quiet PPU, no APU frame IRQ, two VBlanks for the PPU to warm up */
+    gen_place(a, reset);
+    gen_op(a, OP_SEI);
+    gen_op(a, OP_CLD);
+    gen_op8(a, OP_LDX_IMM, 0xFF);
+    gen_op(a, OP_TXS);
+    gen_store(a, 0x2000, 0x00);
+    gen_op16(a, OP_STA_ABS, 0x2001);
+    gen_store(a, 0x4017, 0x40);
+    gen_mapper_init(a, mapper);
+    gen_wait_vblank(a);
+    gen_wait_vblank(a);
+
+    /* Clear zero page, hide every sprite */
+    int clear = gen_new_label(a);
+    gen_op8(a, OP_LDA_IMM, 0x00);
+    gen_op(a, OP_TAX);
+    gen_place(a, clear);
+    gen_op8(a, OP_STA_ZPX, 0x00);
+    gen_op(a, OP_INX);
+    gen_branch(a, OP_BNE, clear);
+    int hide = gen_new_label(a);
+    gen_op8(a, OP_LDA_IMM, 0xFF);
+    gen_place(a, hide);
+    gen_op16(a, OP_STA_ABSX, 0x0200);
+    gen_op(a, OP_INX);
+    gen_branch(a, OP_BNE, hide);
+    gen_store(a, 0x0200, GEN_SPRITE0_Y);
+    gen_store(a, 0x0201, 0x01);
+    gen_store(a, 0x0202, 0x00);
+    gen_store(a, 0x0203, GEN_SPRITE0_X);
+    gen_op8(a, OP_LDA_IMM, 100);
+    gen_op8(a, OP_STA_ZP, ZP_SPRITE_X);
+    gen_op8(a, OP_LDA_IMM, 150);
+    gen_op8(a, OP_STA_ZP, ZP_SPRITE_Y);
+
+    /* Palette */
+    int load = gen_new_label(a);
+    gen_store(a, 0x2006, 0x3F);
+    gen_store(a, 0x2006, 0x00);
+    gen_op8(a, OP_LDX_IMM, 0x00);
+    gen_place(a, load);
+    gen_op_label(a, OP_LDA_ABSX, palette);
+    gen_op16(a, OP_STA_ABS, 0x2007);
+    gen_op(a, OP_INX);
+    gen_op8(a, OP_CPX_IMM, 32);
+    gen_branch(a, OP_BNE, load);
+
+    /* Both nametables and their attributes: tile = address & $FF */
+    int fill = gen_new_label(a);
+    gen_store(a, 0x2006, 0x20);
+    gen_store(a, 0x2006, 0x00);
+    gen_op8(a, OP_LDY_IMM, 8);
+    gen_op8(a, OP_LDX_IMM, 0x00);
+    gen_place(a, fill);
+    gen_op(a, OP_TXA);
+    gen_op16(a, OP_STA_ABS, 0x2007);
+    gen_op(a, OP_INX);
+    gen_branch(a, OP_BNE, fill);
+    gen_op(a, OP_DEY);
+    gen_branch(a, OP_BNE, fill);
+
+    /* Sound on; NMI, sprites from $1000 (so MMC3 sees one A12 rise per
+     * line); show everything */
+    gen_store(a, 0x4015, 0x0F);
+    gen_store(a, 0x2000, 0x88);
+    gen_store(a, 0x2001, 0x1E);
+    if (mapper == 4) {
+        gen_op(a, OP_CLI);
+    }
+
+    /* Main loop: idle until NMI, split on sprite 0, then game logic */
+    int main_loop = gen_new_label(a);
+    int hit_clear = gen_new_label(a);
+    int hit_set = gen_new_label(a);
+    gen_place(a, main_loop);
+    gen_op8(a, OP_LDA_ZP, ZP_NMI);
+    gen_branch(a, OP_BEQ, main_loop);
+    gen_op8(a, OP_LDA_IMM, 0x00);
+    gen_op8(a, OP_STA_ZP, ZP_NMI);
+    gen_place(a, hit_clear);
+    gen_op16(a, OP_BIT_ABS, 0x2002);
+    gen_branch(a, OP_BVS, hit_clear);
+    gen_place(a, hit_set);
+    gen_op16(a, OP_BIT_ABS, 0x2002);
+    gen_branch(a, OP_BVC, hit_set);
+    gen_op8(a, OP_LDA_ZP, ZP_SCROLL);
+    gen_op16(a, OP_STA_ABS, 0x2005);
+    gen_op8(a, OP_LDA_IMM, 0x00);
+    gen_op16(a, OP_STA_ABS, 0x2005);
+
+    /* Read controller 1 */
+    int read = gen_new_label(a);
+    gen_store(a, 0x4016, 0x01);
+    gen_store(a, 0x4016, 0x00);
+    gen_op8(a, OP_LDX_IMM, 8);
+    gen_place(a, read);
+    gen_op16(a, OP_LDA_ABS, 0x4016);
+    gen_op(a, OP_LSR_A);
+    gen_op8(a, OP_ROL_ZP, ZP_PAD);
+    gen_op(a, OP_DEX);
+    gen_branch(a, OP_BNE, read);
+
+    /* Right, Left, Down, Up move the sprites; A doubles the scroll speed */
+    static const struct { uint8_t op; uint8_t var; } moves[4] = {
+        { OP_INC_ZP, ZP_SPRITE_X }, { OP_DEC_ZP, ZP_SPRITE_X },
+        { OP_INC_ZP, ZP_SPRITE_Y }, { OP_DEC_ZP, ZP_SPRITE_Y },
+    };
+    gen_op8(a, OP_LDA_ZP, ZP_PAD);
+    for (int i = 0; i < 4; i++) {
+        int skip = gen_new_label(a);
+        gen_op(a, OP_LSR_A);
+        gen_branch(a, OP_BCC, skip);
+        gen_op8(a, moves[i].op, moves[i].var);
+        gen_place(a, skip);
+    }
+    int slow = gen_new_label(a);
+    gen_op8(a, OP_INC_ZP, ZP_SCROLL);
+    gen_op8(a, OP_LDA_ZP, ZP_PAD);
+    gen_branch(a, OP_BPL, slow);
+    gen_op8(a, OP_INC_ZP, ZP_SCROLL);
+    gen_place(a, slow);
+
+    /* Sprites 1-8 in a row from the controlled position */
+    int row = gen_new_label(a);
+    gen_op8(a, OP_LDA_ZP, ZP_SPRITE_X);
+    gen_op8(a, OP_STA_ZP, ZP_TEMP);
+    gen_op8(a, OP_LDX_IMM, 4);
+    gen_op8(a, OP_LDY_IMM, 8);
+    gen_place(a, row);
+    gen_op8(a, OP_LDA_ZP, ZP_SPRITE_Y);
+    gen_op16(a, OP_STA_ABSX, 0x0200);
+    gen_op8(a, OP_LDA_IMM, 0x02);
+    gen_op16(a, OP_STA_ABSX, 0x0201);
+    gen_op(a, OP_TYA);
+    gen_op8(a, OP_AND_IMM, 0x03);
+    gen_op16(a, OP_STA_ABSX, 0x0202);
+    gen_op8(a, OP_LDA_ZP, ZP_TEMP);
+    gen_op16(a, OP_STA_ABSX, 0x0203);
+    gen_op(a, OP_CLC);
+    gen_op8(a, OP_ADC_IMM, 10);
+    gen_op8(a, OP_STA_ZP, ZP_TEMP);
+    for (int i = 0; i < 4; i++) {
+        gen_op(a, OP_INX);
+    }
+    gen_op(a, OP_DEY);
+    gen_branch(a, OP_BNE, row);
+    gen_op_label(a, OP_JMP_ABS, main_loop);
+
+    /* NMI: sprites, top scroll, banks, sound, then wake the main loop */
+    gen_place(a, nmi);
+    gen_op(a, OP_PHA);
+    gen_op(a, OP_TXA);
+    gen_op(a, OP_PHA);
+    gen_op(a, OP_TYA);
+    gen_op(a, OP_PHA);
+    gen_store(a, 0x2003, 0x00);
+    gen_store(a, 0x4014, 0x02);
+    gen_store(a, 0x2000, 0x88);
+    gen_store(a, 0x2005, 0x00);
+    gen_op16(a, OP_STA_ABS, 0x2005);
+    gen_mapper_frame(a, mapper, notes);
+    gen_audio(a);
+    gen_op8(a, OP_INC_ZP, ZP_FRAME);
+    gen_op8(a, OP_LDA_IMM, 0x01);
+    gen_op8(a, OP_STA_ZP, ZP_NMI);
+    gen_op(a, OP_PLA);
+    gen_op(a, OP_TAY);
+    gen_op(a, OP_PLA);
+    gen_op(a, OP_TAX);
+    gen_op(a, OP_PLA);
+    gen_op(a, OP_RTI);
+
+    /* IRQ: MMC3 scanline split - acknowledge, scroll by the frame counter */
+    gen_place(a, irq);
+    if (mapper == 4) {
+        gen_op(a, OP_PHA);
+        gen_op16(a, OP_STA_ABS, 0xE000);
+        gen_op8(a, OP_LDA_ZP, ZP_FRAME);
+        gen_op16(a, OP_STA_ABS, 0x2005);
+        gen_op16(a, OP_STA_ABS, 0x2005);
+        gen_op(a, OP_PLA);
+    }
+    gen_op(a, OP_RTI);
+
+    gen_place(a, palette);
+    gen_data(a, g_palette, sizeof(g_palette));
+    gen_place(a, notes);
+    gen_data(a, g_notes, sizeof(g_notes));
+
+    if (gen_link(a) != 0) {
+        return -1;
+    }
+
+    /* Vectors */
+    uint16_t vectors[3] = { (uint16_t)a->labels[nmi], (uint16_t)a->labels[reset], (uint16_t)a->labels[irq] };
+    for (int i = 0; i < 3; i++) {
+        a->code[GEN_CODE_SIZE - 6 + i * 2] = (uint8_t)vectors[i];
+        a->code[GEN_CODE_SIZE - 5 + i * 2] = (uint8_t)(vectors[i] >> 8);
+    }
+    return 0;
+}
+
+/* Build one ROM image and write it to dir/name.nes */
+static int gen_write_rom(const char* dir, const gen_rom_t* rom) {
+    gen_asm_t a;
+    if (gen_program(&a, rom->mapper) != 0) {
+        fprintf(stderr, "%s: program does not assemble\n", rom->name);
+        return -1;
+    }
+
+    size_t prg_size = (size_t)rom->prg_banks * 0x4000;
+    size_t chr_size = (size_t)rom->chr_banks * 0x2000;
+    size_t size = 16 + prg_size + chr_size;
+    uint8_t* image = (uint8_t*)calloc(1, size);
+    if (!image) {
+        return -1;
+    }
+
+    uint8_t header[16] = { 'N', 'E', 'S', 0x1A, (uint8_t)rom->prg_banks, (uint8_t)rom->chr_banks,
+                           (uint8_t)((rom->mapper & 0x0F) << 4 | 0x01), (uint8_t)(rom->mapper & 0xF0) };
+    memcpy(image, header, sizeof(header));
+
+    /* Every 8KB of PRG starts with its own rotation of the tune; the
+     * program fills the last 8KB */
+    uint8_t* prg = image + 16;
+    for (size_t bank = 0; bank < prg_size / 0x2000; bank++) {
+        for (int i = 0; i < 8; i++) {
+            prg[bank * 0x2000 + i] = g_notes[(i + bank) & 7];
+        }
+    }
+    memcpy(prg + prg_size - GEN_CODE_SIZE, a.code, GEN_CODE_SIZE);
+
+    /* Patterns differ per 1KB bank; the middle two pixels of every row
+     * are opaque, so sprite 0 always hits */
+    uint8_t* chr = prg + prg_size;
+    for (size_t offset = 0; offset < chr_size; offset += 16) {
+        unsigned bank = (unsigned)(offset >> 10);
+        unsigned tile = (unsigned)(offset >> 4) & 63;
+        for (unsigned r = 0; r < 8; r++) {
+            chr[offset + r] = (uint8_t)(((tile * 37) ^ (r * 73) ^ (bank * 29)) | 0x18);
+            chr[offset + 8 + r] = (uint8_t)(tile * 11 + r * 5 + bank * 3);
+        }
+    }
+
+    char path[GEN_PATH_MAX];
+    int length = snprintf(path, sizeof(path), "%s/%s.nes", dir, rom->name);
+    FILE* f = length > 0 && length < (int)sizeof(path) ? fopen(path, "wb") : NULL;
+    int status = f && fwrite(image, 1, size, f) == size ? 0 : -1;
+    if (f && fclose(f) != 0) {
+        status = -1;
+    }
+    if (status != 0) {
+        fprintf(stderr, "Failed to write %s\n", path);
+    }
+    free(image);
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2 || strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+        fprintf(argc == 2 ? stdout : stderr, "%s", NES_MAKE_CORPUS_USAGE);
+        return argc == 2 ? 0 : 1;
+    }
+
+    for (size_t i = 0; i < sizeof(g_roms) / sizeof(g_roms[0]); i++) {
+        if (gen_write_rom(argv[1], &g_roms[i]) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}